@@ -0,0 +1,147 @@
+# LTO + PGO build of tetris and a throughput report against the plain Release build.
+#
+#   cmake [-DBUILD_ROOT=_pgo] [-DTRAIN_GAMES=40] [-DREPORT_GAMES=40] [-DREPORT_RUNS=3] -P cmake/pgo.cmake
+#
+# 1. BUILD_ROOT/release: plain Release build, the baseline.
+# 2. BUILD_ROOT/pgo: Release + LTO, instrumented, trained on headless self-play (tetris --selfplay).
+# 3. BUILD_ROOT/pgo: reconfigured to use the profiles and rebuilt in place.
+# 4. Both builds play the same report games on a different seed than training,
+#    BUILD_ROOT/pgo-report.md gets the best of REPORT_RUNS for each.
+#
+# Extra configure arguments (generator, compiler) can be passed in CONFIGURE_ARGS as a ;-list.
+
+cmake_minimum_required(VERSION 3.16)
+
+get_filename_component(SOURCE_DIR "${CMAKE_CURRENT_LIST_DIR}/.." ABSOLUTE)
+
+if(NOT BUILD_ROOT)
+    set(BUILD_ROOT "${SOURCE_DIR}/_pgo")
+endif()
+
+get_filename_component(BUILD_ROOT "${BUILD_ROOT}" ABSOLUTE BASE_DIR "${SOURCE_DIR}")
+
+foreach(setting TRAIN_GAMES:40 REPORT_GAMES:40 REPORT_RUNS:3 TRAIN_SEED:1 REPORT_SEED:1000)
+    string(REPLACE ":" ";" setting "${setting}")
+    list(GET setting 0 name)
+    list(GET setting 1 value)
+
+    if(NOT ${name})
+        set(${name} ${value})
+    endif()
+endforeach()
+
+set(RELEASE_DIR "${BUILD_ROOT}/release")
+set(PGO_DIR "${BUILD_ROOT}/pgo")
+set(PROFILE_DIR "${BUILD_ROOT}/profiles")
+
+function(run_step)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Step failed (${result}): ${ARGN}")
+    endif()
+endfunction()
+
+function(build_tetris binaryDir)
+    run_step(${CMAKE_COMMAND} -S "${SOURCE_DIR}" -B "${binaryDir}" -DCMAKE_BUILD_TYPE=Release ${CONFIGURE_ARGS} ${ARGN})
+    run_step(${CMAKE_COMMAND} --build "${binaryDir}" --config Release --target tetris)
+endfunction()
+
+# Runs self-play from the build's output directory, where res/ is copied, and returns the two throughputs.
+function(play_tetris binaryDir seed games outSim outRender)
+    execute_process(COMMAND "${binaryDir}/Release/tetris" --selfplay ${games} --seed ${seed}
+                    WORKING_DIRECTORY "${binaryDir}/Release"
+                    RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+
+    if(NOT result EQUAL 0 OR NOT output MATCHES "sim ([0-9.]+) locks/s")
+        message(FATAL_ERROR "Self-play failed in ${binaryDir}:\n${output}")
+    endif()
+
+    set(sim ${CMAKE_MATCH_1})
+    string(REGEX MATCH "render ([0-9.]+) frames/s" unused "${output}")
+    set(${outSim} ${sim} PARENT_SCOPE)
+    set(${outRender} ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction()
+
+function(best_of binaryDir outSim outRender)
+    set(bestSim 0)
+    set(bestRender 0)
+
+    foreach(run RANGE 1 ${REPORT_RUNS})
+        play_tetris("${binaryDir}" ${REPORT_SEED} ${REPORT_GAMES} sim render)
+
+        if(sim GREATER bestSim)
+            set(bestSim ${sim})
+        endif()
+
+        if(render GREATER bestRender)
+            set(bestRender ${render})
+        endif()
+    endforeach()
+
+    set(${outSim} ${bestSim} PARENT_SCOPE)
+    set(${outRender} ${bestRender} PARENT_SCOPE)
+endfunction()
+
+# Percent change with one decimal, CMake math is integer only.
+function(percent_change base value outVar)
+    string(REGEX REPLACE "\\..*" "" base "${base}")
+    string(REGEX REPLACE "\\..*" "" value "${value}")
+
+    if(base EQUAL 0)
+        set(${outVar} "n/a" PARENT_SCOPE)
+        return()
+    endif()
+
+    math(EXPR permille "(${value} - ${base}) * 1000 / ${base}")
+
+    if(permille LESS 0)
+        set(sign "-")
+        math(EXPR permille "-${permille}")
+    else()
+        set(sign "+")
+    endif()
+
+    math(EXPR whole "${permille} / 10")
+    math(EXPR tenth "${permille} % 10")
+    set(${outVar} "${sign}${whole}.${tenth}%" PARENT_SCOPE)
+endfunction()
+
+message(STATUS "Release build in ${RELEASE_DIR}")
+build_tetris("${RELEASE_DIR}" -DTETRIS_LTO=OFF -DTETRIS_PGO=OFF)
+
+message(STATUS "Instrumented LTO build in ${PGO_DIR}")
+file(REMOVE_RECURSE "${PROFILE_DIR}")
+build_tetris("${PGO_DIR}" -DTETRIS_LTO=ON -DTETRIS_PGO=GENERATE "-DTETRIS_PGO_DIR=${PROFILE_DIR}")
+
+message(STATUS "Training on ${TRAIN_GAMES} self-play games")
+play_tetris("${PGO_DIR}" ${TRAIN_SEED} ${TRAIN_GAMES} trainSim trainRender)
+
+message(STATUS "Optimised LTO + PGO build in ${PGO_DIR}")
+build_tetris("${PGO_DIR}" -DTETRIS_LTO=ON -DTETRIS_PGO=USE "-DTETRIS_PGO_DIR=${PROFILE_DIR}")
+
+message(STATUS "Comparing on ${REPORT_GAMES} games, best of ${REPORT_RUNS} runs")
+best_of("${RELEASE_DIR}" releaseSim releaseRender)
+best_of("${PGO_DIR}" pgoSim pgoRender)
+percent_change(${releaseSim} ${pgoSim} simChange)
+percent_change(${releaseRender} ${pgoRender} renderChange)
+
+string(TIMESTAMP now "%Y-%m-%d %H:%M")
+set(report "# LTO + PGO report (${now})
+
+Workload: `tetris --selfplay ${REPORT_GAMES} --seed ${REPORT_SEED}`, best of ${REPORT_RUNS} runs.
+Profiles were trained on ${TRAIN_GAMES} games with seed ${TRAIN_SEED}.
+
+| Build | Simulation (locks/s) | Render (frames/s) |
+| --- | --- | --- |
+| Release | ${releaseSim} | ${releaseRender} |
+| Release + LTO + PGO | ${pgoSim} | ${pgoRender} |
+| Change | ${simChange} | ${renderChange} |
+
+Simulation is bot move search, drops and line clears. Render is one 1920x1080 software-rendered frame per lock,
+most of which is spent inside SDL, which is not built with these flags.
+")
+
+file(WRITE "${BUILD_ROOT}/pgo-report.md" "${report}")
+message("${report}")
+message(STATUS "Report written to ${BUILD_ROOT}/pgo-report.md")
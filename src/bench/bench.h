@@ -0,0 +1,29 @@
+#if !defined(TETRIS_BENCH_H)
+
+#include <SDL3/SDL.h>
+#include "../tetris_typedefs.h"
+
+/**
+ * @brief Keeps benchmarked results observable so the compiler can't drop the work.
+ */
+static volatile uint64 benchSink;
+
+struct bench_t
+{
+    const char *name;
+    const char *description;
+    bool (*run)(int argc, char **argv);
+};
+
+inline uint64 BeginBenchTimer()
+{
+    return SDL_GetPerformanceCounter();
+}
+
+inline real64 GetBenchSeconds(uint64 startCounter)
+{
+    return (real64)(SDL_GetPerformanceCounter() - startCounter) / (real64)SDL_GetPerformanceFrequency();
+}
+
+#define TETRIS_BENCH_H
+#endif
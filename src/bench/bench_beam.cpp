@@ -0,0 +1,196 @@
+#include "bench.h"
+
+#define BENCH_BEAM_POSITIONS 24
+#define BENCH_BEAM_QUALITY_GAMES 3
+#define BENCH_BEAM_QUALITY_PIECES 200
+
+static const uint32 kBenchBeamWidths[] = {1, 4, 16, 64, 256};
+/**
+ * @brief Whole games are slow at the widest beam, quality stops at 64.
+ */
+static const uint32 kBenchBeamQualityWidths[] = {1, 4, 16, 64};
+
+/**
+ * @brief Mid-game positions from a greedy game, so searches see stacks with holes and near-full rows.
+ */
+static bool InitBenchBeamPositions(level_t *positions)
+{
+    level_t level{};
+
+    if (!InitBenchLevel(&level, 39))
+    {
+        return false;
+    }
+
+    for (uint32 i = 0; i < BENCH_BEAM_POSITIONS; ++i)
+    {
+        for (uint32 lock = 0; lock < 5; ++lock)
+        {
+            bot_move_t move = PickBotMove(&level);
+
+            if (!DropBotPiece(&level, move.rotations, move.x))
+            {
+                InitBenchLevel(&level, 39 + i);
+            }
+        }
+
+        CopyLevel(&positions[i], &level);
+    }
+
+    return true;
+}
+
+struct bench_beam_quality_t
+{
+    uint32 pieces;
+    uint32 rows;
+    uint32 toppedOut;
+    /**
+     * @brief GetBotStackCost summed after every placement, lower means flatter stacks with fewer holes.
+     */
+    uint64 stackCost;
+};
+
+/**
+ * @param planner nullptr plays the greedy PickBotMove.
+ */
+static bench_beam_quality_t PlayBenchBeamGames(planner_t *planner, job_pool_t *jobs)
+{
+    bench_beam_quality_t quality{};
+    level_t level{};
+
+    for (uint32 game = 0; game < BENCH_BEAM_QUALITY_GAMES; ++game)
+    {
+        InitBenchLevel(&level, 100 + game);
+
+        for (uint32 piece = 0; piece < BENCH_BEAM_QUALITY_PIECES && !level.gameOver; ++piece)
+        {
+            bot_move_t move = planner ? PlanBotMove(planner, jobs, &level) : PickBotMove(&level);
+            level_events_t events;
+            events.flags = 0;
+
+            if (!DropBotPiece(&level, move.rotations, move.x, &events) && !(events.flags & LEVEL_EVENT_PIECE_LOCKED))
+            {
+                LockLevelPlayer(&level, &events);
+            }
+
+            quality.pieces++;
+            quality.rows += CountSetBits32(events.clearedRowsMask);
+            quality.stackCost += (uint64)SDL_max(GetBotStackCost(&level.world), 0);
+        }
+
+        quality.toppedOut += level.gameOver ? 1 : 0;
+    }
+
+    return quality;
+}
+
+static void LogBenchBeamQuality(const char *name, const bench_beam_quality_t *quality)
+{
+    uint32 pieces = SDL_max(quality->pieces, 1u);
+    SDL_Log("%-10s %5u pieces, %.1f rows per 100 pieces, mean stack cost %.1f, topped out in %u of %d games", name,
+            quality->pieces, 100.0 * quality->rows / pieces, (real64)quality->stackCost / pieces, quality->toppedOut,
+            BENCH_BEAM_QUALITY_GAMES);
+}
+
+static bool RunBeamBench(int argc, char **argv)
+{
+    level_t *positions = (level_t *)SDL_calloc(BENCH_BEAM_POSITIONS, sizeof(level_t));
+    planner_t planner;
+    job_pool_t *jobs = (job_pool_t *)SDL_calloc(1, sizeof(job_pool_t));
+    bool success = positions && jobs && InitBenchBeamPositions(positions);
+    /* tetris_bench beam [threads] overrides the core count, to oversubscribe small machines. */
+    uint32 maxThreads = argc > 1 ? (uint32)SDL_atoi(argv[1]) : (uint32)SDL_GetNumLogicalCPUCores();
+    maxThreads = SDL_clamp(maxThreads, 1u, (uint32)JOB_MAX_THREADS);
+
+    /* Throughput by beam width and thread count over the same positions at full preview depth. */
+    for (uint32 width : kBenchBeamWidths)
+    {
+        if (!success || !InitPlanner(&planner, width, PLANNER_MAX_DEPTH))
+        {
+            success = false;
+            break;
+        }
+
+        bot_move_t singleMoves[BENCH_BEAM_POSITIONS];
+        real64 singleSeconds = 0.0;
+
+        for (uint32 step = 1;; step *= 2)
+        {
+            uint32 threads = SDL_min(step, maxThreads);
+
+            if (!InitJobPool(jobs, threads))
+            {
+                success = false;
+                break;
+            }
+
+            planner.stats = {};
+            uint32 mismatches = 0;
+            uint64 timer = BeginBenchTimer();
+
+            for (uint32 i = 0; i < BENCH_BEAM_POSITIONS; ++i)
+            {
+                bot_move_t move = PlanBotMove(&planner, jobs, &positions[i]);
+
+                if (threads == 1)
+                {
+                    singleMoves[i] = move;
+                }
+
+                mismatches += (move.rotations != singleMoves[i].rotations || move.x != singleMoves[i].x) ? 1 : 0;
+            }
+
+            real64 seconds = GetBenchSeconds(timer);
+            singleSeconds = threads == 1 ? seconds : singleSeconds;
+            uint64 steals = 0;
+
+            for (uint32 thread = 0; thread < threads; ++thread)
+            {
+                steals += jobs->stats[thread].steals;
+            }
+
+            SDL_Log("width %3u, %2u threads: %6.2f Mnodes/s, %8.2f ms per move, x%.2f, %llu steals, %llu duplicates%s",
+                    width, threads, planner.stats.nodes / seconds / 1e6, seconds * 1e3 / BENCH_BEAM_POSITIONS,
+                    singleSeconds / seconds, (unsigned long long)steals, (unsigned long long)planner.stats.duplicates,
+                    mismatches ? ", MOVES DIFFER FROM 1 THREAD" : "");
+            success = success && !mismatches;
+            FreeJobPool(jobs);
+
+            if (threads == maxThreads)
+            {
+                break;
+            }
+        }
+
+        FreePlanner(&planner);
+    }
+
+    /* Move quality: whole games against the greedy bot, on all threads. */
+    if (success && InitJobPool(jobs, maxThreads))
+    {
+        bench_beam_quality_t greedy = PlayBenchBeamGames(nullptr, nullptr);
+        LogBenchBeamQuality("greedy", &greedy);
+
+        for (uint32 width : kBenchBeamQualityWidths)
+        {
+            if (!InitPlanner(&planner, width, PLANNER_MAX_DEPTH))
+            {
+                success = false;
+                break;
+            }
+
+            char name[32];
+            SDL_snprintf(name, sizeof(name), "width %u", width);
+            bench_beam_quality_t quality = PlayBenchBeamGames(&planner, jobs);
+            LogBenchBeamQuality(name, &quality);
+            FreePlanner(&planner);
+        }
+
+        FreeJobPool(jobs);
+    }
+
+    SDL_free(jobs);
+    SDL_free(positions);
+    return success;
+}
@@ -0,0 +1,88 @@
+#include "bench.h"
+
+#define BENCH_FEED_NAME "/tetris_feed_bench"
+#define BENCH_FEED_FRAMES 2000000
+
+struct bench_feed_reader_t
+{
+    const feed_header_t *header;
+    std::atomic<bool> done;
+    uint64 reads;
+    uint64 retries;
+    uint64 torn;
+};
+
+static int RunFeedReaderThread(void *data)
+{
+    bench_feed_reader_t *reader = (bench_feed_reader_t *)data;
+    feed_frame_t frame;
+
+    while (!reader->done.load(std::memory_order_relaxed))
+    {
+        uint32 retries;
+
+        if (ReadLatestFeedFrame(reader->header, &frame, &retries))
+        {
+            reader->reads++;
+            reader->retries += retries;
+
+            /* The producer stamps every frame, a mixed frame breaks the stamps. */
+            if (frame.score != (uint32)frame.frameIndex || frame.stepAccumulator != frame.frameIndex ||
+                frame.worldCells[0] != (uint8)frame.frameIndex)
+            {
+                reader->torn++;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static bool RunFeedBench(int argc, char **argv)
+{
+    feed_t feed;
+
+    if (!OpenFeed(&feed, BENCH_FEED_NAME))
+    {
+        SDL_Log("Couldn't open feed: %s", SDL_GetError());
+        return false;
+    }
+
+    level_t level{};
+    InitBenchLevel(&level, 3);
+
+    bench_feed_reader_t reader{};
+    reader.header = MapFeed(BENCH_FEED_NAME);
+
+    if (!reader.header)
+    {
+        SDL_Log("Couldn't map feed: %s", SDL_GetError());
+        CloseFeed(&feed);
+        return false;
+    }
+
+    SDL_Thread *thread = SDL_CreateThread(RunFeedReaderThread, "bench_feed", &reader);
+    uint64 timer = BeginBenchTimer();
+
+    for (uint64 i = 0; i < BENCH_FEED_FRAMES; ++i)
+    {
+        level.score = (uint32)i;
+        level.stepAccumulator = i;
+        level.world.data[0] = (uint8)i;
+        PublishFeedFrame(&feed, &level, i);
+    }
+
+    real64 seconds = GetBenchSeconds(timer);
+    reader.done.store(true, std::memory_order_relaxed);
+    SDL_WaitThread(thread, nullptr);
+
+    SDL_Log("publish %.1f ns/frame (%llu byte frames) with a reader spinning on the feed",
+            seconds * 1e9 / BENCH_FEED_FRAMES, (unsigned long long)sizeof(feed_frame_t));
+    SDL_Log("reader: %llu reads, %.3f retries/read, %llu torn frames",
+            (unsigned long long)reader.reads, (real64)reader.retries / SDL_max(reader.reads, 1ull),
+            (unsigned long long)reader.torn);
+
+    UnmapFeed(reader.header);
+    CloseFeed(&feed);
+    return reader.torn == 0;
+}
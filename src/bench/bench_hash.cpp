@@ -0,0 +1,187 @@
+#include "bench.h"
+
+#define BENCH_HASH_GAMES 200
+#define BENCH_HASH_MAX_PIECES 400
+#define BENCH_HASH_TABLE_BYTES (64ull * 1024 * 1024)
+#define BENCH_HASH_PROBES_PER_THREAD 4000000
+#define BENCH_HASH_MAX_THREADS 16
+
+struct bench_hash_thread_t
+{
+    transposition_table_t *table;
+    uint64 seed;
+    transposition_stats_t stats;
+};
+
+static int RunHashProbeThread(void *data)
+{
+    bench_hash_thread_t *thread = (bench_hash_thread_t *)data;
+    random_t random;
+    SeedRandom(&random, thread->seed);
+
+    for (int32 i = 0; i < BENCH_HASH_PROBES_PER_THREAD; ++i)
+    {
+        /* A small key space so threads keep hitting each other's entries. */
+        uint64 key = ((uint64)NextRandomBelow(&random, 1 << 22) + 1) * 0x9E3779B97F4A7C15ull;
+        uint64 data;
+
+        if (!ProbeTranspositionTable(thread->table, key, &data, &thread->stats))
+        {
+            StoreTranspositionTable(thread->table, key, (key & ~0xFFull) | 1, &thread->stats);
+        }
+        else if ((data & ~0xFFull) != (key & ~0xFFull))
+        {
+            SDL_Log("Torn transposition entry");
+        }
+    }
+
+    return 0;
+}
+
+static bool RunHashBench(int argc, char **argv)
+{
+    level_t level{};
+    uint64 locks = 0;
+    real64 incrementalSeconds = 0.0;
+    real64 rehashSeconds = 0.0;
+
+    /* Incremental hash must always equal a full rehash. */
+    for (int32 game = 0; game < BENCH_HASH_GAMES; ++game)
+    {
+        if (!InitBenchLevel(&level, game + 1))
+        {
+            return false;
+        }
+
+        random_t random;
+        SeedRandom(&random, game);
+
+        for (int32 piece = 0; piece < BENCH_HASH_MAX_PIECES; ++piece)
+        {
+            int32 rotations = NextRandomBelow(&random, 4);
+            int32 x = NextRandomBelow(&random, level.world.size.x);
+
+            uint64 timer = BeginBenchTimer();
+            bool alive = DropBotPiece(&level, rotations, x);
+            incrementalSeconds += GetBenchSeconds(timer);
+
+            timer = BeginBenchTimer();
+            uint64 fullHash = ComputeWorldHash(&level.world);
+            rehashSeconds += GetBenchSeconds(timer);
+            locks++;
+
+            if (fullHash != level.world.hash)
+            {
+                SDL_Log("Incremental hash diverged in game %d piece %d", game, piece);
+                return false;
+            }
+
+            if (!alive)
+            {
+                break;
+            }
+        }
+    }
+
+    SDL_Log("%llu locks checked, drop and lock keeping the hash %.1f ns, full rehash alone %.1f ns",
+            (unsigned long long)locks, incrementalSeconds * 1e9 / locks, rehashSeconds * 1e9 / locks);
+
+    /* Two-ply placement search: placing A then B often equals B then A. */
+    transposition_table_t table;
+
+    if (!InitTranspositionTable(&table, BENCH_HASH_TABLE_BYTES))
+    {
+        return false;
+    }
+
+    transposition_stats_t stats{};
+    uint64 searchTimer = BeginBenchTimer();
+    real64 probeSeconds = 0.0;
+
+    for (int32 position = 0; position < 20; ++position)
+    {
+        level_t root{};
+
+        if (!InitBenchLevel(&root, 1000 + position))
+        {
+            return false;
+        }
+
+        for (int32 i = 0; i < 8; ++i)
+        {
+            DropBotPiece(&root, i % 4, (i * 3) % root.world.size.x);
+        }
+
+        for (int32 firstMove = 0; firstMove < 4 * root.world.size.x; ++firstMove)
+        {
+            level_t first;
+            CopyLevel(&first, &root);
+
+            if (!DropBotPiece(&first, firstMove / root.world.size.x, firstMove % root.world.size.x))
+            {
+                continue;
+            }
+
+            for (int32 secondMove = 0; secondMove < 4 * root.world.size.x; ++secondMove)
+            {
+                level_t second;
+                CopyLevel(&second, &first);
+
+                if (!DropBotPiece(&second, secondMove / root.world.size.x, secondMove % root.world.size.x))
+                {
+                    continue;
+                }
+
+                uint64 key = second.world.hash;
+                uint64 data;
+                uint64 timer = BeginBenchTimer();
+
+                if (!ProbeTranspositionTable(&table, key, &data, &stats))
+                {
+                    StoreTranspositionTable(&table, key, ((uint64)(firstMove + 1) << 8) | 1, &stats);
+                }
+
+                probeSeconds += GetBenchSeconds(timer);
+            }
+        }
+    }
+
+    SDL_Log("two-ply search: %llu probes, hit rate %.1f%%, probe+store %.1f ns, search %.2f ms",
+            (unsigned long long)stats.probes, 100.0 * stats.hits / SDL_max(stats.probes, 1ull),
+            probeSeconds * 1e9 / SDL_max(stats.probes, 1ull), GetBenchSeconds(searchTimer) * 1e3);
+
+    /* Shared table under contention. */
+    int32 maxThreads = SDL_min(SDL_GetNumLogicalCPUCores(), BENCH_HASH_MAX_THREADS);
+
+    for (int32 threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        bench_hash_thread_t threads[BENCH_HASH_MAX_THREADS]{};
+        SDL_Thread *handles[BENCH_HASH_MAX_THREADS];
+        ClearTranspositionTable(&table);
+        uint64 timer = BeginBenchTimer();
+
+        for (int32 i = 0; i < threadCount; ++i)
+        {
+            threads[i].table = &table;
+            threads[i].seed = i + 1;
+            handles[i] = SDL_CreateThread(RunHashProbeThread, "bench_hash", &threads[i]);
+        }
+
+        transposition_stats_t total{};
+
+        for (int32 i = 0; i < threadCount; ++i)
+        {
+            SDL_WaitThread(handles[i], nullptr);
+            total.probes += threads[i].stats.probes;
+            total.hits += threads[i].stats.hits;
+        }
+
+        real64 seconds = GetBenchSeconds(timer);
+        SDL_Log("%2d threads: %.1f Mprobes/s total, %.1f ns/probe per thread, hit rate %.1f%%",
+                threadCount, total.probes / seconds / 1e6, seconds * 1e9 / BENCH_HASH_PROBES_PER_THREAD,
+                100.0 * total.hits / total.probes);
+    }
+
+    FreeTranspositionTable(&table);
+    return true;
+}
@@ -0,0 +1,15 @@
+#include "bench.h"
+
+static bool InitBenchLevel(level_t *level, uint64 seed)
+{
+    ResetLevel(level);
+
+    if (!InitWorld(&level->world) || !InitPlayer(&level->player))
+    {
+        return false;
+    }
+
+    InitPieceQueue(&level->pieceQueue, seed, PIECE_RANDOMIZER_BAG);
+    SpawnLevelPlayer(level);
+    return true;
+}
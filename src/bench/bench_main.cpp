@@ -0,0 +1,101 @@
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <SDL3_mixer/SDL_mixer.h>
+
+#include "../tetris_typedefs.h"
+#include "../tetris_math.h"
+#include "../tetris_arena.cpp"
+#include "../tetris_world_kernels.cpp"
+#include "../tetris_world.cpp"
+#include "../tetris_random.cpp"
+#include "../tetris_piece_set.cpp"
+#include "../tetris_player.cpp"
+#include "../tetris_hash.cpp"
+#include "../tetris_input.cpp"
+#include "../tetris_assets.cpp"
+#include "../tetris_sfx.cpp"
+#include "../tetris_level.cpp"
+#include "../tetris_bot.cpp"
+#include "../tetris_jobs.cpp"
+#include "../tetris_planner.cpp"
+#include "../tetris_perfect_clear.cpp"
+#include "../tetris_save.cpp"
+#include "../tetris_rewind.cpp"
+#include "../tetris_versus.cpp"
+#include "../tetris_rollback.cpp"
+#include "../tetris_opponent.cpp"
+#include "../tetris_net.cpp"
+#include "../tetris_feed.cpp"
+#include "../tetris_replay.cpp"
+#include "../tetris_metrics.cpp"
+#include "../tetris_particles.cpp"
+
+#include "bench.h"
+#include "bench_level.cpp"
+#include "bench_world_kernels.cpp"
+#include "bench_world_shape.cpp"
+#include "bench_hash.cpp"
+#include "bench_save.cpp"
+#include "bench_rewind.cpp"
+#include "bench_rollback.cpp"
+#include "bench_feed.cpp"
+#include "bench_sfx.cpp"
+#include "bench_metrics.cpp"
+#include "bench_beam.cpp"
+#include "bench_perfect_clear.cpp"
+#include "bench_particles.cpp"
+#include "bench_piece_set.cpp"
+#include "bench_opponent.cpp"
+
+static const bench_t kBenches[] = {
+    {"world-kernels", "scalar vs SIMD world plane kernels across board widths", RunWorldKernelsBench},
+    {"world-shape", "engine loops compiled for 10x20 and 16x24 vs the generic runtime-sized ones", RunWorldShapeBench},
+    {"hash", "incremental Zobrist hashing and transposition table hit rate and probe cost", RunHashBench},
+    {"save", "binary save/load of one game and checkpoints of thousands of headless games", RunSaveBench},
+    {"rewind", "rewind recording cost per lock, seek latency and history covered by a memory budget", RunRewindBench},
+    {"rollback", "versus save/restore/step cost and rollback depth against frame time by latency and loss", RunRollbackBench},
+    {"feed", "shared memory state feed publish cost and seqlock retries under a spinning reader", RunFeedBench},
+    {"sfx", "sound effect trigger and mix cost and event to mix latency at the device period", RunSfxBench},
+    {"metrics", "gameplay metrics record cost per frame, JSONL formatting and writer queue under a burst", RunMetricsBench},
+    {"beam", "beam search planner nodes/s and move quality by beam width and thread count", RunBeamBench},
+    {"perfect-clear", "perfect clear solve time per position, solvable and not, by thread count", RunPerfectClearBench},
+    {"particles", "particle update cost scalar vs SIMD, swap-remove and one-call draw by particle count", RunParticlesBench},
+    {"piece-sets", "piece set compile time, grid scan vs cell list collision checks and bot speed, classic vs large pieces", RunPieceSetBench},
+    {"opponent", "bot opponent main thread cost per versus tick and decision latency by difficulty", RunOpponentBench},
+};
+
+int main(int argc, char **argv)
+{
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    bool success = true;
+
+    if (!SDL_Init(0))
+    {
+        SDL_Log("Couldn't init sdl: %s", SDL_GetError());
+        return 1;
+    }
+
+    SDL_srand(1);
+    InitWorldKernels();
+
+    for (int i = 0; i < (int)SDL_arraysize(kBenches); ++i)
+    {
+        const bench_t *bench = &kBenches[i];
+
+        if (filter && SDL_strcmp(filter, bench->name) != 0)
+        {
+            continue;
+        }
+
+        SDL_Log("== %s: %s", bench->name, bench->description);
+
+        if (!bench->run(argc - 1, argv + 1))
+        {
+            SDL_Log("== %s FAILED", bench->name);
+            success = false;
+        }
+    }
+
+    SDL_Quit();
+    return success ? 0 : 1;
+}
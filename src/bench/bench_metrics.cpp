@@ -0,0 +1,164 @@
+#include "bench.h"
+
+#define BENCH_METRICS_PATH "tetris_bench_metrics.jsonl"
+#define BENCH_METRICS_GAMES 20
+#define BENCH_METRICS_MAX_LOCKS 1000
+/**
+ * @brief Falling frames between two locks, ~16 ms each like a 60 Hz player.
+ */
+#define BENCH_METRICS_FRAMES_PER_PIECE 30
+#define BENCH_METRICS_BURST 1000
+#define BENCH_METRICS_PACED 200
+
+/**
+ * @brief Plays a bot game and runs every frame of it through the session, returns the time spent recording.
+ */
+static uint64 PlayBenchMetricsGame(metrics_session_t *session, level_t *level, random_t *random, uint64 seed)
+{
+    uint64 recordCounter = 0;
+    InitBenchLevel(level, seed);
+    BeginMetricsGame(session, level, seed);
+
+    for (uint32 lock = 0; lock < BENCH_METRICS_MAX_LOCKS && !level->gameOver; ++lock)
+    {
+        bot_move_t move = PickBotMove(level);
+        level_events_t lockEvents;
+        lockEvents.flags = 0;
+
+        if (!DropBotPiece(level, move.rotations, move.x, &lockEvents) && !(lockEvents.flags & LEVEL_EVENT_PIECE_LOCKED))
+        {
+            LockLevelPlayer(level, &lockEvents);
+        }
+
+        level_events_t noEvents;
+        noEvents.flags = 0;
+        uint64 timer = BeginBenchTimer();
+
+        for (uint32 i = 0; i <= BENCH_METRICS_FRAMES_PER_PIECE; ++i)
+        {
+            game_input_t input{};
+            SetInputButtonDown(&input.buttons[NextRandomBelow(random, 4)], (i & 3) == 0);
+            replay_frame_t frame = MakeReplayFrame(16, &input, 0);
+            const level_events_t *events = i == BENCH_METRICS_FRAMES_PER_PIECE ? &lockEvents : &noEvents;
+            RecordMetricsFrame(session, level, &frame, events, true, 16000000 + NextRandomBelow(random, 2000000));
+        }
+
+        recordCounter += SDL_GetPerformanceCounter() - timer;
+    }
+
+    EndMetricsGame(session, level, level->gameOver ? METRICS_GAME_END_GAME_OVER : METRICS_GAME_END_QUIT);
+    return recordCounter;
+}
+
+static uint32 CountBenchMetricsLines(const char *path, uint32 *malformed)
+{
+    size_t size = 0;
+    char *data = (char *)SDL_LoadFile(path, &size);
+    uint32 lines = 0;
+    *malformed = 0;
+
+    for (size_t start = 0, i = 0; data && i < size; ++i)
+    {
+        if (data[i] == '\n')
+        {
+            *malformed += (data[start] != '{' || i < start + 2 || data[i - 1] != '}') ? 1 : 0;
+            start = i + 1;
+            lines++;
+        }
+    }
+
+    SDL_free(data);
+    return lines;
+}
+
+static bool RunMetricsBench(int argc, char **argv)
+{
+    level_t *level = (level_t *)SDL_calloc(1, sizeof(level_t));
+    metrics_session_t *session = (metrics_session_t *)SDL_calloc(1, sizeof(metrics_session_t));
+    metrics_log_t *log = (metrics_log_t *)SDL_calloc(1, sizeof(metrics_log_t));
+
+    if (!level || !session || !log)
+    {
+        return false;
+    }
+
+    random_t random;
+    SeedRandom(&random, 38);
+
+    /* Game thread cost per frame, locks and step changes included. */
+    uint64 recordCounter = 0;
+    uint64 frames = 0;
+    uint64 pieces = 0;
+
+    for (uint32 game = 0; game < BENCH_METRICS_GAMES; ++game)
+    {
+        recordCounter += PlayBenchMetricsGame(session, level, &random, 1 + game);
+        frames += session->game.frameCount;
+        pieces += session->game.pieces;
+    }
+
+    real64 recordNs = (real64)recordCounter / SDL_GetPerformanceFrequency() * 1e9 / frames;
+    SDL_Log("record %.1f ns per frame over %llu frames, %llu pieces", recordNs, (unsigned long long)frames,
+            (unsigned long long)pieces);
+
+    uint64 timer = BeginBenchTimer();
+    uint32 length = 0;
+
+    for (uint32 i = 0; i < BENCH_METRICS_BURST; ++i)
+    {
+        length = FormatMetricsGame(&session->game, log->line, sizeof(log->line));
+        benchSink += length;
+    }
+
+    SDL_Log("format %.2f us per game, %u bytes: %.*s", GetBenchSeconds(timer) * 1e6 / BENCH_METRICS_BURST, length,
+            (int)(length ? length - 1 : 0), log->line);
+
+    SDL_RemovePath(BENCH_METRICS_PATH);
+
+    if (!OpenMetricsLog(log, BENCH_METRICS_PATH))
+    {
+        SDL_Log("Couldn't open metrics log: %s", SDL_GetError());
+        return false;
+    }
+
+    /* A burst far past the queue: the game thread must never wait, the overflow is dropped. */
+    uint64 submitNsMax = 0;
+    timer = BeginBenchTimer();
+
+    for (uint32 i = 0; i < BENCH_METRICS_BURST; ++i)
+    {
+        uint64 start = SDL_GetTicksNS();
+        SubmitMetricsGame(log, &session->game);
+        submitNsMax = SDL_max(submitNsMax, SDL_GetTicksNS() - start);
+    }
+
+    real64 submitNs = GetBenchSeconds(timer) * 1e9 / BENCH_METRICS_BURST;
+    SDL_Log("burst of %d: submit %.0f ns average, %.1f us worst, %llu dropped", BENCH_METRICS_BURST, submitNs,
+            submitNsMax / 1e3, (unsigned long long)log->dropped);
+
+    /* One game every few milliseconds is already far more than a player finishes. */
+    uint64 droppedBefore = log->dropped;
+    SDL_Delay(100);
+
+    for (uint32 i = 0; i < BENCH_METRICS_PACED; ++i)
+    {
+        SubmitMetricsGame(log, &session->game);
+        SDL_Delay(2);
+    }
+
+    uint64 pacedDropped = log->dropped - droppedBefore;
+    uint64 submitted = log->submitted;
+    CloseMetricsLog(log);
+
+    uint32 malformed;
+    uint32 lines = CountBenchMetricsLines(BENCH_METRICS_PATH, &malformed);
+    SDL_Log("paced: %llu dropped; file has %u lines for %llu submitted, %u malformed", (unsigned long long)pacedDropped,
+            lines, (unsigned long long)submitted, malformed);
+    SDL_RemovePath(BENCH_METRICS_PATH);
+
+    bool success = length && lines == submitted && !malformed && !log->failed;
+    SDL_free(level);
+    SDL_free(session);
+    SDL_free(log);
+    return success;
+}
@@ -0,0 +1,103 @@
+#include "bench.h"
+
+#define BENCH_OPPONENT_TICKS 300
+
+static int CompareBenchOpponentNs(const void *a, const void *b)
+{
+    uint64 left = *(const uint64 *)a;
+    uint64 right = *(const uint64 *)b;
+    return left < right ? -1 : left > right;
+}
+
+/**
+ * @brief Real time versus ticks, player 0 idle and player 1 the bot when there is one.
+ * @param tickNs Main thread time per tick, the human's frame would pay exactly this.
+ * @return Pieces the bot locked.
+ */
+static uint32 RunBenchOpponentTicks(versus_t *versus, opponent_t *opponent, uint64 *tickNs)
+{
+    uint32 locks = 0;
+    uint64 next = SDL_GetTicksNS();
+
+    for (uint32 tick = 0; tick < BENCH_OPPONENT_TICKS; ++tick)
+    {
+        uint64 start = SDL_GetTicksNS();
+        uint16 inputs[VERSUS_PLAYER_COUNT] = {0, 0};
+        inputs[1] = opponent ? TickOpponent(opponent, &versus->levels[1]) : 0;
+        level_events_t events[VERSUS_PLAYER_COUNT];
+        StepVersus(versus, inputs, events);
+        tickNs[tick] = SDL_GetTicksNS() - start;
+        locks += (events[1].flags & LEVEL_EVENT_PIECE_LOCKED) ? 1 : 0;
+
+        /* The search thread gets the rest of the tick, like it would between two frames. */
+        next += VERSUS_TICK_MS * SDL_NS_PER_MS;
+        uint64 now = SDL_GetTicksNS();
+        SDL_DelayPrecise(next > now ? next - now : 0);
+    }
+
+    SDL_qsort(tickNs, BENCH_OPPONENT_TICKS, sizeof(uint64), CompareBenchOpponentNs);
+    return locks;
+}
+
+static void LogBenchOpponentTicks(const char *name, const uint64 *tickNs, uint32 locks, const char *detail)
+{
+    SDL_Log("%-8s tick p50 %6.1f us, p99 %6.1f, max %7.1f, %3u bot pieces%s", name,
+            tickNs[BENCH_OPPONENT_TICKS / 2] / 1e3, tickNs[BENCH_OPPONENT_TICKS * 99 / 100] / 1e3,
+            tickNs[BENCH_OPPONENT_TICKS - 1] / 1e3, locks, detail);
+}
+
+static bool RunOpponentBench(int argc, char **argv)
+{
+    versus_t *versus = (versus_t *)SDL_malloc(sizeof(versus_t));
+    opponent_t *opponent = (opponent_t *)SDL_malloc(sizeof(opponent_t));
+    uint64 *tickNs = (uint64 *)SDL_malloc(BENCH_OPPONENT_TICKS * sizeof(uint64));
+    bool success = versus && opponent && tickNs && InitVersus(versus, 1, PIECE_RANDOMIZER_BAG);
+
+    if (!success)
+    {
+        SDL_Log("Couldn't set up the opponent bench: %s", SDL_GetError());
+    }
+    else
+    {
+        /* The frame cost of versus without a bot, what every difficulty is held against. */
+        uint32 locks = RunBenchOpponentTicks(versus, nullptr, tickNs);
+        LogBenchOpponentTicks("no bot", tickNs, locks, "");
+    }
+
+    for (uint32 difficulty = 1; difficulty <= OPPONENT_DIFFICULTY_COUNT && success; ++difficulty)
+    {
+        success = InitVersus(versus, 1, PIECE_RANDOMIZER_BAG) && StartOpponent(opponent, difficulty);
+
+        if (!success)
+        {
+            SDL_Log("Couldn't start the bot: %s", SDL_GetError());
+            break;
+        }
+
+        uint32 locks = RunBenchOpponentTicks(versus, opponent, tickNs);
+        StopOpponent(opponent);
+
+        const opponent_stats_t *stats = &opponent->stats;
+        char name[16];
+        char detail[OPPONENT_STATS_SIZE];
+        SDL_snprintf(name, sizeof(name), "bot %u", difficulty);
+        SDL_snprintf(detail, sizeof(detail),
+                     ", search %5.1f ms, decision mean %5.1f, max %5.1f (budget %3u), %llu/%llu cut, %llu discarded",
+                     stats->searchNs / (real64)SDL_max(stats->searches, (uint64)1) / 1e6,
+                     stats->decisionNs / (real64)SDL_max(stats->decisions, (uint64)1) / 1e6,
+                     stats->maxDecisionNs / 1e6, opponent->difficulty.budgetMs, (unsigned long long)stats->stopped,
+                     (unsigned long long)stats->searches, (unsigned long long)stats->discarded);
+        LogBenchOpponentTicks(name, tickNs, locks, detail);
+
+        if (!stats->decisions)
+        {
+            SDL_Log("bot %u never decided a move", difficulty);
+            success = false;
+        }
+    }
+
+    SDL_free(tickNs);
+    SDL_free(opponent);
+    SDL_free(versus);
+    return success;
+}
@@ -0,0 +1,151 @@
+#include "bench.h"
+
+#define BENCH_PARTICLES_STEPS 240
+#define BENCH_PARTICLES_DRAWS 30
+#define BENCH_PARTICLES_DT (1.0f / 120.0f)
+/**
+ * @brief Seconds, long enough that nothing dies while the update is timed.
+ */
+#define BENCH_PARTICLES_LIFETIME 1.0e6f
+
+/**
+ * @brief Refills system with count particles over the whole board, the same ones for the same seed.
+ */
+static void FillBenchParticles(particle_system_t *system, vec2i_t worldSize, uint32 count)
+{
+    SDL_FRect board{0.0f, 0.0f, (real32)worldSize.x, (real32)worldSize.y};
+    SDL_FColor color{1.0f, 0.95f, 0.75f, 1.0f};
+    system->count = 0;
+    SeedRandom(&system->random, 1);
+    EmitParticles(system, board, vec2_t{0.0f, -6.0f}, 8.0f, BENCH_PARTICLES_LIFETIME, color, count);
+}
+
+static real64 TimeBenchParticleUpdates(particle_system_t *system)
+{
+    uint64 timer = BeginBenchTimer();
+
+    for (uint32 step = 0; step < BENCH_PARTICLES_STEPS; ++step)
+    {
+        UpdateParticles(system, BENCH_PARTICLES_DT);
+    }
+
+    return GetBenchSeconds(timer);
+}
+
+/**
+ * @brief SSE2 and NEON don't fuse the multiply-add, compilers may fuse the scalar loop, so allow rounding.
+ */
+static bool DoBenchParticlesMatch(const particle_system_t *a, const particle_system_t *b)
+{
+    if (a->count != b->count)
+    {
+        return false;
+    }
+
+    const real32 *fieldsA[] = {a->x, a->y, a->vx, a->vy, a->life};
+    const real32 *fieldsB[] = {b->x, b->y, b->vx, b->vy, b->life};
+
+    for (uint32 field = 0; field < SDL_arraysize(fieldsA); ++field)
+    {
+        for (uint32 i = 0; i < a->count; ++i)
+        {
+            if (SDL_fabsf(fieldsA[field][i] - fieldsB[field][i]) > 1e-3f * (1.0f + SDL_fabsf(fieldsA[field][i])))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool RunParticlesBench(int argc, char **argv)
+{
+    static const uint32 kCounts[] = {1024, 4096, 16384, PARTICLE_MAX_COUNT};
+    vec2i_t renderSize{1920, 1080};
+    uint64 memorySize = 2 * GetParticleSystemSize(PARTICLE_MAX_COUNT);
+    void *memory = SDL_malloc(memorySize);
+    SDL_Surface *surface = SDL_CreateSurface(renderSize.w, renderSize.h, SDL_PIXELFORMAT_XRGB8888);
+    SDL_Renderer *renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+    particle_system_t scalar;
+    particle_system_t simd;
+    arena_t arena;
+    world_t world;
+
+    bool success = memory && renderer && InitWorld(&world);
+
+    if (success)
+    {
+        InitArena(&arena, memory, memorySize);
+        success = InitParticleSystem(&scalar, &arena, PARTICLE_MAX_COUNT, 1) &&
+                  InitParticleSystem(&simd, &arena, PARTICLE_MAX_COUNT, 1);
+        scalar.simd = false;
+    }
+
+    if (!success)
+    {
+        SDL_Log("Couldn't set up the particle bench: %s", SDL_GetError());
+    }
+
+    vec2i_t worldSize = world.size;
+    SDL_FRect board = GetLevelBoardRect(&world, renderSize);
+
+    for (uint32 c = 0; c < SDL_arraysize(kCounts) && success; ++c)
+    {
+        uint32 count = kCounts[c];
+        FillBenchParticles(&scalar, worldSize, count);
+        FillBenchParticles(&simd, worldSize, count);
+        real64 scalarSeconds = TimeBenchParticleUpdates(&scalar);
+        real64 simdSeconds = TimeBenchParticleUpdates(&simd);
+        bool match = DoBenchParticlesMatch(&scalar, &simd);
+
+        /* Every other particle dies, the next update swap-removes half of them. */
+        for (uint32 i = 0; i < simd.count; i += 2)
+        {
+            simd.life[i] = 0.0f;
+        }
+
+        uint64 timer = BeginBenchTimer();
+        UpdateParticles(&simd, BENCH_PARTICLES_DT);
+        real64 removeSeconds = GetBenchSeconds(timer);
+        bool removed = simd.count == count / 2;
+        FillBenchParticles(&simd, worldSize, count);
+
+        real64 submitSeconds = 0.0;
+        real64 rasterSeconds = 0.0;
+
+        for (uint32 draw = 0; draw < BENCH_PARTICLES_DRAWS; ++draw)
+        {
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xFF);
+            SDL_RenderClear(renderer);
+            SDL_FlushRenderer(renderer);
+
+            timer = BeginBenchTimer();
+            benchSink += RenderParticles(renderer, &simd, board, worldSize);
+            submitSeconds += GetBenchSeconds(timer);
+
+            timer = BeginBenchTimer();
+            SDL_FlushRenderer(renderer);
+            rasterSeconds += GetBenchSeconds(timer);
+        }
+
+        real64 scalarNs = scalarSeconds * 1e9 / ((real64)BENCH_PARTICLES_STEPS * count);
+        real64 simdNs = simdSeconds * 1e9 / ((real64)BENCH_PARTICLES_STEPS * count);
+        SDL_Log("%5u particles: update %.2f ns scalar, %.2f ns %s per particle (x%.1f), half removed in %.3f ms, "
+                "draw %.3f ms building + submitting, %.3f ms software raster%s%s",
+                count, scalarNs, simdNs, SDL_HasSSE2() ? "sse2" : (SDL_HasNEON() ? "neon" : "scalar"),
+                scalarNs / SDL_max(simdNs, 1e-9), removeSeconds * 1e3, submitSeconds * 1e3 / BENCH_PARTICLES_DRAWS,
+                rasterSeconds * 1e3 / BENCH_PARTICLES_DRAWS, match ? "" : ", SIMD DIFFERS FROM SCALAR",
+                removed ? "" : ", WRONG COUNT AFTER REMOVAL");
+        success = match && removed;
+    }
+
+    if (renderer)
+    {
+        SDL_DestroyRenderer(renderer);
+    }
+
+    SDL_DestroySurface(surface);
+    SDL_free(memory);
+    return success;
+}
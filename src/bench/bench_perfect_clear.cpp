@@ -0,0 +1,260 @@
+#include "bench.h"
+
+/**
+ * @brief Positions of each kind, ones that clear and ones the solver has to prove don't.
+ */
+#define BENCH_PC_POSITIONS 16
+#define BENCH_PC_MAX_SEEDS 20000
+#define BENCH_PC_HEIGHT 3
+/**
+ * @brief Random placements from the empty board, the rest of BENCH_PC_HEIGHT rows is left to the queue.
+ */
+#define BENCH_PC_PLACED 3
+/**
+ * @brief Pieces to go, further than the preview reaches like a training tool knows them.
+ */
+#define BENCH_PC_QUEUE ((16 * BENCH_PC_HEIGHT) / 4 - BENCH_PC_PLACED)
+#define BENCH_PC_PLACEMENT_TRIES 64
+#define BENCH_PC_MAX_NODES 2000000
+
+/**
+ * @brief The queue from the active piece on.
+ */
+static uint32 GetBenchPcQueue(const level_t *level, const player_data_t **pieces)
+{
+    pieces[0] = &level->player.data;
+
+    for (uint32 i = 1; i < BENCH_PC_QUEUE; ++i)
+    {
+        pieces[i] = GetPlayerKind(PeekPieceQueue(&level->pieceQueue, i - 1).kindId);
+    }
+
+    return BENCH_PC_QUEUE;
+}
+
+/**
+ * @brief True if the stack is at most BENCH_PC_HEIGHT rows and no empty cell has a filled one above it.
+ */
+static bool IsBenchPcStackOpen(const world_t *world)
+{
+    for (int32 x = 0; x < world->size.x; ++x)
+    {
+        bool covered = false;
+
+        for (int32 y = 0; y < world->size.y; ++y)
+        {
+            bool empty = IsValueEmpty(world->data[y * world->size.x + x]);
+
+            if ((!empty && y < world->size.y - BENCH_PC_HEIGHT) || (empty && covered))
+            {
+                return false;
+            }
+
+            covered = covered || !empty;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Plays moves with DropBotPiece on a copy of level, true if the board ends up empty.
+ */
+static bool CheckBenchPcMoves(const level_t *level, const bot_move_t *moves, uint32 moveCount)
+{
+    level_t trial;
+    CopyLevel(&trial, level);
+
+    for (uint32 i = 0; i < moveCount; ++i)
+    {
+        if (!DropBotPiece(&trial, moves[i].rotations, moves[i].x))
+        {
+            return false;
+        }
+    }
+
+    for (int32 i = 0; i < trial.world.size.x * trial.world.size.y; ++i)
+    {
+        if (!IsValueEmpty(trial.world.data[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Random hole-free openings, BENCH_PC_POSITIONS that their queue clears and as many it doesn't.
+ * @note Positions the cell counts rule out without a search are skipped, they'd time nothing.
+ */
+static uint32 InitBenchPcPositions(perfect_clear_solver_t *solver, level_t *positions, uint8 *expected)
+{
+    uint32 counts[2] = {};
+    level_t level;
+    level_t trial;
+
+    for (uint32 seed = 1; seed <= BENCH_PC_MAX_SEEDS && counts[0] + counts[1] < 2 * BENCH_PC_POSITIONS; ++seed)
+    {
+        random_t random;
+        SeedRandom(&random, seed);
+        bool open = InitBenchLevel(&level, seed);
+
+        for (uint32 i = 0; i < BENCH_PC_PLACED && open; ++i)
+        {
+            open = false;
+
+            for (uint32 attempt = 0; attempt < BENCH_PC_PLACEMENT_TRIES && !open; ++attempt)
+            {
+                CopyLevel(&trial, &level);
+                int32 rotations = (int32)NextRandomBelow(&random, 4);
+                int32 x = (int32)NextRandomBelow(&random, (uint32)level.world.size.x + 2) - 2;
+                open = DropBotPiece(&trial, rotations, x) && IsBenchPcStackOpen(&trial.world);
+            }
+
+            if (open)
+            {
+                CopyLevel(&level, &trial);
+            }
+        }
+
+        if (!open)
+        {
+            continue;
+        }
+
+        const player_data_t *pieces[BENCH_PC_QUEUE];
+        bot_move_t moves[BENCH_PC_QUEUE];
+        uint32 moveCount;
+        solver->stats = {};
+        ePerfectClearResult result = SolvePerfectClear(solver, nullptr, &level.world, pieces,
+                                                       GetBenchPcQueue(&level, pieces), BENCH_PC_HEIGHT, moves,
+                                                       &moveCount);
+        uint32 kind = result == PERFECT_CLEAR_SOLVED ? 0 : 1;
+
+        if (result == PERFECT_CLEAR_GAVE_UP || !solver->stats.nodes || counts[kind] == BENCH_PC_POSITIONS)
+        {
+            continue;
+        }
+
+        expected[counts[0] + counts[1]] = (uint8)result;
+        CopyLevel(&positions[counts[0] + counts[1]], &level);
+        counts[kind]++;
+    }
+
+    return counts[0] == BENCH_PC_POSITIONS && counts[1] == BENCH_PC_POSITIONS ? 2 * BENCH_PC_POSITIONS : 0;
+}
+
+struct bench_pc_run_t
+{
+    uint32 results[3];
+    uint32 invalid;
+    uint32 changed;
+    real64 maxSeconds;
+    bot_move_t firstMoves[2 * BENCH_PC_POSITIONS];
+};
+
+static bench_pc_run_t SolveBenchPcPositions(perfect_clear_solver_t *solver, job_pool_t *jobs, level_t *positions,
+                                            const uint8 *expected, uint32 count)
+{
+    bench_pc_run_t run{};
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        const player_data_t *pieces[BENCH_PC_QUEUE];
+        bot_move_t moves[BENCH_PC_QUEUE];
+        uint32 moveCount;
+        uint32 pieceCount = GetBenchPcQueue(&positions[i], pieces);
+
+        uint64 timer = BeginBenchTimer();
+        ePerfectClearResult result = SolvePerfectClear(solver, jobs, &positions[i].world, pieces, pieceCount,
+                                                       BENCH_PC_HEIGHT, moves, &moveCount);
+        run.maxSeconds = SDL_max(run.maxSeconds, GetBenchSeconds(timer));
+        run.results[result]++;
+        run.changed += result != expected[i] ? 1 : 0;
+        run.firstMoves[i] = result == PERFECT_CLEAR_SOLVED ? moves[0] : bot_move_t{-1, -1};
+
+        if (result == PERFECT_CLEAR_SOLVED && !CheckBenchPcMoves(&positions[i], moves, moveCount))
+        {
+            run.invalid++;
+        }
+    }
+
+    return run;
+}
+
+static bool RunPerfectClearBench(int argc, char **argv)
+{
+    level_t *positions = (level_t *)SDL_calloc(2 * BENCH_PC_POSITIONS, sizeof(level_t));
+    uint8 expected[2 * BENCH_PC_POSITIONS];
+    perfect_clear_solver_t *solver = (perfect_clear_solver_t *)SDL_calloc(1, sizeof(perfect_clear_solver_t));
+    job_pool_t *jobs = (job_pool_t *)SDL_calloc(1, sizeof(job_pool_t));
+    /* tetris_bench perfect-clear [threads] overrides the core count. */
+    uint32 maxThreads = argc > 1 ? (uint32)SDL_atoi(argv[1]) : (uint32)SDL_GetNumLogicalCPUCores();
+    maxThreads = SDL_clamp(maxThreads, 1u, (uint32)JOB_MAX_THREADS);
+    bool success = positions && solver && jobs && InitPerfectClearSolver(solver, maxThreads, BENCH_PC_MAX_NODES);
+    uint32 count = success ? InitBenchPcPositions(solver, positions, expected) : 0;
+    success = success && count;
+
+    if (success)
+    {
+        SDL_Log("%u positions: %d random pieces on the empty board, %d to go to clear %d rows", count,
+                BENCH_PC_PLACED, BENCH_PC_QUEUE, BENCH_PC_HEIGHT);
+    }
+
+    bench_pc_run_t single{};
+
+    for (uint32 step = 1; success; step *= 2)
+    {
+        uint32 threads = SDL_min(step, maxThreads);
+
+        if (!InitJobPool(jobs, threads))
+        {
+            success = false;
+            break;
+        }
+
+        solver->stats = {};
+        uint64 timer = BeginBenchTimer();
+        bench_pc_run_t run = SolveBenchPcPositions(solver, jobs, positions, expected, count);
+        real64 seconds = GetBenchSeconds(timer);
+        const perfect_clear_stats_t *stats = &solver->stats;
+        uint32 mismatches = 0;
+
+        if (threads == 1)
+        {
+            single = run;
+        }
+
+        for (uint32 i = 0; i < count; ++i)
+        {
+            mismatches += (run.firstMoves[i].rotations != single.firstMoves[i].rotations ||
+                           run.firstMoves[i].x != single.firstMoves[i].x) ? 1 : 0;
+        }
+
+        SDL_Log("%2u threads: %u solved, %u impossible, %u gave up; %.3f ms mean, %.3f ms max per position, "
+                "%.2f Mnodes/s, %llu memo hits, %llu parity cuts%s%s%s",
+                threads, run.results[PERFECT_CLEAR_SOLVED], run.results[PERFECT_CLEAR_IMPOSSIBLE],
+                run.results[PERFECT_CLEAR_GAVE_UP], seconds * 1e3 / count, run.maxSeconds * 1e3,
+                stats->nodes / seconds / 1e6, (unsigned long long)stats->memoHits,
+                (unsigned long long)stats->parityCuts, run.invalid ? ", SOLUTIONS DON'T CLEAR" : "",
+                run.changed ? ", RESULTS DIFFER FROM SETUP" : "", mismatches ? ", MOVES DIFFER FROM 1 THREAD" : "");
+        success = !run.invalid && !run.changed && !mismatches;
+        FreeJobPool(jobs);
+
+        if (threads == maxThreads)
+        {
+            break;
+        }
+    }
+
+    if (solver)
+    {
+        FreePerfectClearSolver(solver);
+    }
+
+    SDL_free(jobs);
+    SDL_free(solver);
+    SDL_free(positions);
+    return success;
+}
@@ -0,0 +1,237 @@
+#include "bench.h"
+
+#define BENCH_PIECE_SET_COMPILES 200
+#define BENCH_PIECE_SET_SWEEPS 20
+#define BENCH_PIECE_SET_BOT_PIECES 2000
+#define BENCH_PIECE_SET_TEXT_SIZE Kilobytes(8)
+
+static const char kBenchPentominoes[] =
+    "piece F\n.##\n##.\n.#.\n\npiece F'\n##.\n.##\n.#.\n\npiece I\n#####\n\n"
+    "piece L\n#...\n####\n\npiece L'\n...#\n####\n\npiece N\n##..\n.###\n\npiece N'\n..##\n###.\n\n"
+    "piece P\n##\n##\n#.\n\npiece P'\n##\n##\n.#\n\npiece T\n###\n.#.\n.#.\n\npiece U\n#.#\n###\n\n"
+    "piece V\n#..\n#..\n###\n\npiece W\n#..\n##.\n.##\n\npiece X\n.#.\n###\n.#.\n\n"
+    "piece Y\n.#..\n####\n\npiece Y'\n..#.\n####\n\npiece Z\n##.\n.#.\n.##\n\npiece Z'\n.##\n.#.\n##.\n";
+
+/**
+ * @brief Hollow squares from 4x4 up to the largest grid, up to 60 cells on 256 grid bytes.
+ */
+static uint64 WriteBenchFramePieces(char *text, uint64 capacity)
+{
+    uint64 used = 0;
+
+    for (int32 size = 4; size <= PLAYER_DATA_GRID_MAX_SIZE; ++size)
+    {
+        used += SDL_snprintf(text + used, capacity - used, "piece frame%d\n", size);
+
+        for (int32 y = 0; y < size; ++y)
+        {
+            for (int32 x = 0; x < size; ++x)
+            {
+                bool edge = x == 0 || y == 0 || x == size - 1 || y == size - 1;
+                text[used++] = edge ? '#' : '.';
+            }
+
+            text[used++] = '\n';
+        }
+
+        text[used++] = '\n';
+    }
+
+    return used;
+}
+
+/**
+ * @brief IsPlayerPositionValid as it was before piece sets were compiled, a scan over the whole grid.
+ */
+static bool IsBenchGridPositionValid(world_t *world, const player_data_t *playerData, vec2i_t testPosition)
+{
+    for (int32 y = 0; y < playerData->dim.y; ++y)
+    {
+        for (int32 x = 0; x < playerData->dim.x; ++x)
+        {
+            if (playerData->grid[y * playerData->dim.x + x])
+            {
+                vec2i_t position = testPosition + vec2i_t{x, y};
+
+                if (!IsWorldPositionValid(world, position) || !IsValueEmpty(GetWorldValue(world, position)))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Tests every rotation of every kind at every position that overlaps the world.
+ * @return Valid positions found.
+ */
+static uint64 SweepBenchPieceSet(world_t *world, const piece_set_t *set, bool cells, uint64 *checks)
+{
+    uint64 valid = 0;
+
+    for (uint32 kind = 0; kind < set->kindCount; ++kind)
+    {
+        for (uint32 rotation = 0; rotation < PLAYER_DATA_ROTATION_COUNT; ++rotation)
+        {
+            const player_data_t *data = &set->rotations[kind][rotation];
+
+            for (int32 y = -data->dim.y; y < world->size.y; ++y)
+            {
+                for (int32 x = -data->dim.x; x < world->size.x; ++x)
+                {
+                    bool fits = cells ? IsPlayerPositionValid(world, data, {x, y})
+                                      : IsBenchGridPositionValid(world, data, {x, y});
+                    valid += fits;
+                    (*checks)++;
+                }
+            }
+        }
+    }
+
+    return valid;
+}
+
+/**
+ * @brief Bot games on the set until pieces have locked, restarting at a top out.
+ * @return Pieces per second.
+ */
+static real64 PlayBenchPieceSet(level_t *level, uint32 pieces, uint32 *games)
+{
+    *games = 0;
+    uint64 timer = BeginBenchTimer();
+
+    for (uint32 piece = 0; piece < pieces; ++piece)
+    {
+        if (piece == 0 || level->gameOver)
+        {
+            InitBenchLevel(level, 1 + *games);
+            (*games)++;
+        }
+
+        bot_move_t move = PickBotMove(level);
+        level_events_t events;
+        events.flags = 0;
+        DropBotPiece(level, move.rotations, move.x, &events);
+
+        if (!(events.flags & LEVEL_EVENT_PIECE_LOCKED))
+        {
+            LockLevelPlayer(level, &events);
+        }
+    }
+
+    return pieces / GetBenchSeconds(timer);
+}
+
+static bool RunPieceSetBench(int argc, char **argv)
+{
+    char frames[BENCH_PIECE_SET_TEXT_SIZE];
+    uint64 framesSize = WriteBenchFramePieces(frames, sizeof(frames));
+    const char *names[] = {"classic", "pentominoes", "frames"};
+    const char *texts[] = {nullptr, kBenchPentominoes, frames};
+    uint64 sizes[] = {0, sizeof(kBenchPentominoes) - 1, framesSize};
+    piece_set_t *set = (piece_set_t *)SDL_malloc(sizeof(piece_set_t));
+    level_t *level = (level_t *)SDL_malloc(sizeof(level_t));
+    world_t world;
+    bool success = set && level && InitWorld(&world);
+
+    if (!success)
+    {
+        SDL_Log("Couldn't set up the piece set bench: %s", SDL_GetError());
+    }
+
+    /* The lower half is a random stack, so some positions fit and some don't. */
+    random_t random;
+    SeedRandom(&random, 1);
+
+    for (int32 y = world.size.y / 2; y < world.size.y && success; ++y)
+    {
+        for (int32 x = 0; x < world.size.x; ++x)
+        {
+            SetWorldValue(&world, {x, y}, NextRandomBelow(&random, 2) ? (uint8)1 : (uint8)0);
+        }
+    }
+
+    for (uint32 s = 0; s < SDL_arraysize(names) && success; ++s)
+    {
+        real64 compileSeconds = 0.0;
+
+        if (texts[s])
+        {
+            uint64 timer = BeginBenchTimer();
+
+            for (uint32 i = 0; i < BENCH_PIECE_SET_COMPILES && success; ++i)
+            {
+                success = ParsePieceSet(set, texts[s], sizes[s]);
+            }
+
+            compileSeconds = GetBenchSeconds(timer) / BENCH_PIECE_SET_COMPILES;
+
+            if (!success)
+            {
+                SDL_Log("Couldn't parse the %s set: %s", names[s], SDL_GetError());
+                break;
+            }
+        }
+        else
+        {
+            *set = *GetClassicPieceSet();
+        }
+
+        uint32 maxCells = 0;
+        int32 maxSize = 0;
+
+        for (uint32 kind = 0; kind < set->kindCount; ++kind)
+        {
+            maxCells = SDL_max(maxCells, (uint32)set->rotations[kind][0].cellCount);
+            maxSize = SDL_max(maxSize, set->rotations[kind][0].dim.x);
+        }
+
+        uint64 gridChecks = 0;
+        uint64 cellChecks = 0;
+        uint64 gridValid = 0;
+        uint64 cellValid = 0;
+        uint64 timer = BeginBenchTimer();
+
+        for (uint32 sweep = 0; sweep < BENCH_PIECE_SET_SWEEPS; ++sweep)
+        {
+            gridValid += SweepBenchPieceSet(&world, set, false, &gridChecks);
+        }
+
+        real64 gridSeconds = GetBenchSeconds(timer);
+        timer = BeginBenchTimer();
+
+        for (uint32 sweep = 0; sweep < BENCH_PIECE_SET_SWEEPS; ++sweep)
+        {
+            cellValid += SweepBenchPieceSet(&world, set, true, &cellChecks);
+        }
+
+        real64 cellSeconds = GetBenchSeconds(timer);
+        benchSink += gridValid + cellValid;
+
+        if (gridValid != cellValid)
+        {
+            SDL_Log("%s: the cell list found %llu valid positions, the grid scan %llu", names[s],
+                    (unsigned long long)cellValid, (unsigned long long)gridValid);
+            success = false;
+        }
+
+        UsePieceSet(set);
+        uint32 games = 0;
+        real64 botRate = PlayBenchPieceSet(level, BENCH_PIECE_SET_BOT_PIECES, &games);
+        UsePieceSet(nullptr);
+
+        SDL_Log("%-12s %2u kinds, up to %2dx%-2d %2u cells: compile %7.1f us, grid scan %7.2f, cells %7.2f M checks/s "
+                "(%.1fx), bot %7.0f pieces/s over %u games",
+                names[s], set->kindCount, maxSize, maxSize, maxCells, compileSeconds * 1e6,
+                gridChecks / gridSeconds / 1e6, cellChecks / cellSeconds / 1e6,
+                (cellChecks / cellSeconds) / (gridChecks / gridSeconds), botRate, games);
+    }
+
+    UsePieceSet(nullptr);
+    SDL_free(level);
+    SDL_free(set);
+    return success;
+}
@@ -0,0 +1,130 @@
+#include "bench.h"
+
+#define BENCH_REWIND_BUDGET Kilobytes(256)
+#define BENCH_REWIND_LOCKS 20000
+#define BENCH_REWIND_SEEKS 20000
+#define BENCH_REWIND_BACKTRACK 24
+/* A human drops roughly one piece per second. */
+#define BENCH_REWIND_LOCKS_PER_MINUTE 60
+
+struct bench_rewind_check_t
+{
+    uint64 hash;
+    uint64 randomState;
+    uint32 score;
+};
+
+static bench_rewind_check_t GetRewindCheck(level_t *level)
+{
+    return {HashPosition(&level->world, &level->player, &level->pieceQueue),
+            level->pieceQueue.random.state, level->score};
+}
+
+static bool RunRewindBench(int argc, char **argv)
+{
+    uint64 arenaSize = BENCH_REWIND_BUDGET + Kilobytes(64);
+    void *memory = SDL_malloc(arenaSize);
+    bench_rewind_check_t *checks = (bench_rewind_check_t *)SDL_malloc((BENCH_REWIND_LOCKS + 1) * sizeof(bench_rewind_check_t));
+
+    if (!memory || !checks)
+    {
+        return false;
+    }
+
+    arena_t arena;
+    InitArena(&arena, memory, arenaSize);
+    rewind_t rewind;
+
+    if (!InitRewind(&rewind, &arena, BENCH_REWIND_BUDGET))
+    {
+        SDL_Log("Couldn't init rewind: %s", SDL_GetError());
+        return false;
+    }
+
+    level_t level{};
+    InitBenchLevel(&level, 31);
+    ResetRewind(&rewind, &level);
+    checks[0] = GetRewindCheck(&level);
+
+    random_t random;
+    SeedRandom(&random, 31);
+    level_events_t events;
+    real64 lockSeconds = 0.0;
+    real64 recordSeconds = 0.0;
+    uint32 truncations = 0;
+
+    /* One long practice session: on game over, rewind a few pieces and play on. */
+    for (uint32 i = 0; i < BENCH_REWIND_LOCKS;)
+    {
+        /* Mostly good moves with some noise, so games still end and get rewound. */
+        bot_move_t move{(int32)NextRandomBelow(&random, 4), (int32)NextRandomBelow(&random, level.world.size.x)};
+
+        if (NextRandomBelow(&random, 16))
+        {
+            move = PickBotMove(&level);
+        }
+
+        events.flags = 0;
+        uint64 timer = BeginBenchTimer();
+        DropBotPiece(&level, move.rotations, move.x, &events);
+        lockSeconds += GetBenchSeconds(timer);
+
+        if (!(events.flags & LEVEL_EVENT_PIECE_LOCKED))
+        {
+            continue;
+        }
+
+        timer = BeginBenchTimer();
+        RecordRewindLock(&rewind, &level, &events);
+        recordSeconds += GetBenchSeconds(timer);
+        checks[rewind.currentLock] = GetRewindCheck(&level);
+        ++i;
+
+        if (level.gameOver)
+        {
+            uint32 target = rewind.currentLock > BENCH_REWIND_BACKTRACK ? rewind.currentLock - BENCH_REWIND_BACKTRACK : 0;
+            SeekRewind(&rewind, &level, target);
+            truncations++;
+        }
+    }
+
+    uint32 coveredLocks = rewind.lastLock - rewind.firstLock;
+    SDL_Log("%u locks recorded, %u rewinds after game over, lock %.1f ns, record %.1f ns (%.1f%% of the lock)",
+            rewind.lastLock, truncations, lockSeconds * 1e9 / BENCH_REWIND_LOCKS,
+            recordSeconds * 1e9 / BENCH_REWIND_LOCKS, 100.0 * recordSeconds / lockSeconds);
+    SDL_Log("budget %llu KiB: %u keyframes of %llu bytes, %u deltas of %llu bytes, covers %u locks (%.1f min at %d pieces/min)",
+            (unsigned long long)(BENCH_REWIND_BUDGET / 1024), rewind.keyframeCapacity,
+            (unsigned long long)sizeof(rewind_keyframe_t), rewind.deltaCapacity, (unsigned long long)sizeof(rewind_delta_t),
+            coveredLocks, (real64)coveredLocks / BENCH_REWIND_LOCKS_PER_MINUTE, BENCH_REWIND_LOCKS_PER_MINUTE);
+
+    /* Seeking must land on exactly the recorded state. */
+    real64 seekSeconds = 0.0;
+    real64 worstSeekSeconds = 0.0;
+
+    for (uint32 i = 0; i < BENCH_REWIND_SEEKS; ++i)
+    {
+        uint32 target = rewind.firstLock + NextRandomBelow(&random, coveredLocks + 1);
+        uint64 timer = BeginBenchTimer();
+        SeekRewind(&rewind, &level, target);
+        real64 seconds = GetBenchSeconds(timer);
+        seekSeconds += seconds;
+        worstSeekSeconds = SDL_max(worstSeekSeconds, seconds);
+
+        bench_rewind_check_t check = GetRewindCheck(&level);
+
+        if (check.hash != checks[target].hash || check.randomState != checks[target].randomState ||
+            check.score != checks[target].score || ComputeWorldHash(&level.world) != level.world.hash)
+        {
+            SDL_Log("Seek to lock %u restored a different state", target);
+            return false;
+        }
+    }
+
+    SDL_Log("%d seeks: %.2f us average, %.2f us worst (keyframe copy + up to %d deltas)",
+            BENCH_REWIND_SEEKS, seekSeconds * 1e6 / BENCH_REWIND_SEEKS, worstSeekSeconds * 1e6,
+            REWIND_KEYFRAME_INTERVAL - 1);
+
+    SDL_free(checks);
+    SDL_free(memory);
+    return true;
+}
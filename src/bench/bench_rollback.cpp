@@ -0,0 +1,270 @@
+#include "bench.h"
+
+#define BENCH_ROLLBACK_TICKS 3600
+#define BENCH_ROLLBACK_ITERATIONS 20000
+#define BENCH_ROLLBACK_LINK_CAPACITY 64
+#define BENCH_ROLLBACK_LOOPBACK_TICKS 600
+#define BENCH_ROLLBACK_PORT 47000
+
+/**
+ * @brief One direction of a simulated network: fixed latency in ticks and random loss.
+ */
+struct bench_rollback_link_t
+{
+    net_packet_t packets[BENCH_ROLLBACK_LINK_CAPACITY];
+    uint32 deliverFrames[BENCH_ROLLBACK_LINK_CAPACITY];
+    uint32 head;
+    uint32 count;
+};
+
+struct bench_rollback_peer_t
+{
+    rollback_t rollback;
+    game_input_t input;
+    random_t random;
+};
+
+static void SendBenchRollbackLink(bench_rollback_link_t *link, const net_packet_t *packet, uint32 deliverFrame)
+{
+    if (link->count < BENCH_ROLLBACK_LINK_CAPACITY)
+    {
+        uint32 slot = (link->head + link->count++) % BENCH_ROLLBACK_LINK_CAPACITY;
+        link->packets[slot] = *packet;
+        link->deliverFrames[slot] = deliverFrame;
+    }
+}
+
+static void ReceiveBenchRollbackLink(bench_rollback_link_t *link, rollback_t *rollback, uint32 frame)
+{
+    while (link->count && link->deliverFrames[link->head] <= frame)
+    {
+        ReadRollbackPacket(rollback, &link->packets[link->head], sizeof(net_packet_t));
+        link->head = (link->head + 1) % BENCH_ROLLBACK_LINK_CAPACITY;
+        link->count--;
+    }
+}
+
+/**
+ * @brief Human-like input: buttons flip now and then and are held in between.
+ */
+static uint16 NextBenchRollbackInput(bench_rollback_peer_t *peer)
+{
+    for (int i = 0; i < (int)SDL_arraysize(peer->input.buttons); ++i)
+    {
+        if (NextRandomBelow(&peer->random, 24) == 0)
+        {
+            SetInputButtonDown(&peer->input.buttons[i], !peer->input.buttons[i].isDown);
+        }
+    }
+
+    return PackGameInput(&peer->input);
+}
+
+static bool InitBenchRollbackPeers(bench_rollback_peer_t *peers, uint64 seed)
+{
+    for (uint32 i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+    {
+        SDL_zerop(&peers[i].input);
+        SeedRandom(&peers[i].random, seed * 31 + i);
+
+        if (!InitRollback(&peers[i].rollback, i, seed, PIECE_RANDOMIZER_BAG))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void AdvanceBenchRollbackPeer(bench_rollback_peer_t *peer)
+{
+    /* The input is only consumed when the tick runs, like the game loop does. */
+    bench_rollback_peer_t next = *peer;
+    uint16 input = NextBenchRollbackInput(&next);
+
+    if (AdvanceRollback(&peer->rollback, input))
+    {
+        peer->input = next.input;
+        peer->random = next.random;
+        FlushInput(&peer->input);
+    }
+}
+
+static bool RunRollbackBench(int argc, char **argv)
+{
+    bench_rollback_peer_t *peers = (bench_rollback_peer_t *)SDL_malloc(VERSUS_PLAYER_COUNT * sizeof(bench_rollback_peer_t));
+    bench_rollback_link_t *links = (bench_rollback_link_t *)SDL_malloc(VERSUS_PLAYER_COUNT * sizeof(bench_rollback_link_t));
+
+    if (!peers || !links || !InitBenchRollbackPeers(peers, 5))
+    {
+        return false;
+    }
+
+    /* The three operations rollback is built from. */
+    versus_t *scratch = &peers[1].rollback.state;
+    uint16 inputs[VERSUS_PLAYER_COUNT] = {0x0003, 0x0010};
+    uint64 timer = BeginBenchTimer();
+
+    for (int32 i = 0; i < BENCH_ROLLBACK_ITERATIONS; ++i)
+    {
+        CopyVersus(&peers[0].rollback.saved[i & ROLLBACK_RING_MASK], scratch);
+    }
+
+    real64 saveUs = GetBenchSeconds(timer) * 1e6 / BENCH_ROLLBACK_ITERATIONS;
+    timer = BeginBenchTimer();
+
+    for (int32 i = 0; i < BENCH_ROLLBACK_ITERATIONS; ++i)
+    {
+        if (IsVersusOver(scratch))
+        {
+            InitVersus(scratch, i, PIECE_RANDOMIZER_BAG);
+        }
+
+        StepVersus(scratch, inputs, nullptr);
+    }
+
+    real64 stepUs = GetBenchSeconds(timer) * 1e6 / BENCH_ROLLBACK_ITERATIONS;
+    timer = BeginBenchTimer();
+
+    for (int32 i = 0; i < BENCH_ROLLBACK_ITERATIONS; ++i)
+    {
+        benchSink += GetVersusChecksum(scratch);
+    }
+
+    real64 checksumUs = GetBenchSeconds(timer) * 1e6 / BENCH_ROLLBACK_ITERATIONS;
+    SDL_Log("versus_t %llu bytes: save/restore %.3f us, step %.3f us, checksum %.3f us, %d tick budget %d ms",
+            (unsigned long long)sizeof(versus_t), saveUs, stepUs, checksumUs, ROLLBACK_MAX_TICKS, VERSUS_TICK_MS);
+
+    /* Rollback depth against frame time over a simulated network. */
+    static const uint32 kLatencies[] = {0, 1, 2, 4, 6, 8, 12};
+    SDL_Log("latency  loss  rollbacks  avg depth  max depth  avg us  worst us  stalls  compared");
+
+    for (uint32 lossPercent = 0; lossPercent <= 10; lossPercent += 10)
+    {
+        for (uint32 latency : kLatencies)
+        {
+            if (!InitBenchRollbackPeers(peers, 5 + latency))
+            {
+                return false;
+            }
+
+            SDL_memset(links, 0, VERSUS_PLAYER_COUNT * sizeof(bench_rollback_link_t));
+            random_t lossRandom;
+            SeedRandom(&lossRandom, latency);
+
+            for (uint32 frame = 0; frame < BENCH_ROLLBACK_TICKS; ++frame)
+            {
+                for (uint32 i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+                {
+                    ReceiveBenchRollbackLink(&links[i], &peers[i].rollback, frame);
+                    AdvanceBenchRollbackPeer(&peers[i]);
+
+                    net_packet_t packet;
+                    BuildRollbackPacket(&peers[i].rollback, &packet);
+
+                    if (NextRandomBelow(&lossRandom, 100) >= lossPercent)
+                    {
+                        SendBenchRollbackLink(&links[i ^ 1], &packet, frame + latency);
+                    }
+                }
+            }
+
+            rollback_stats_t *stats = &peers[0].rollback.stats;
+            real64 totalSeconds = 0.0;
+            real64 worstSeconds = 0.0;
+
+            for (int depth = 0; depth <= ROLLBACK_MAX_TICKS; ++depth)
+            {
+                totalSeconds += stats->depthSeconds[depth];
+                worstSeconds = SDL_max(worstSeconds, stats->depthMaxSeconds[depth]);
+            }
+
+            SDL_Log("%7u %4u%% %10llu %10.2f %10u %7.2f %9.2f %7llu %9llu", latency, lossPercent,
+                    (unsigned long long)stats->rollbacks, (real64)stats->resimulatedTicks / SDL_max(stats->rollbacks, 1ull),
+                    stats->maxDepth, totalSeconds * 1e6 / SDL_max(stats->ticks, 1ull), worstSeconds * 1e6,
+                    (unsigned long long)stats->stalls, (unsigned long long)stats->checksumsCompared);
+
+            if (IsRollbackDesynced(&peers[0].rollback) || IsRollbackDesynced(&peers[1].rollback) ||
+                !stats->checksumsCompared)
+            {
+                SDL_Log("Peers desynced or never compared checksums");
+                return false;
+            }
+        }
+    }
+
+    SDL_Log("cost by rollback depth for the last row:");
+    LogRollbackStats(&peers[0].rollback.stats);
+
+    /* A desync must be caught: corrupt one side and keep playing. */
+    InitBenchRollbackPeers(peers, 77);
+    SDL_memset(links, 0, VERSUS_PLAYER_COUNT * sizeof(bench_rollback_link_t));
+
+    for (uint32 frame = 0; frame < 120; ++frame)
+    {
+        if (frame == 60)
+        {
+            peers[1].rollback.state.levels[0].score += 1;
+        }
+
+        for (uint32 i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+        {
+            ReceiveBenchRollbackLink(&links[i], &peers[i].rollback, frame);
+            AdvanceBenchRollbackPeer(&peers[i]);
+            net_packet_t packet;
+            BuildRollbackPacket(&peers[i].rollback, &packet);
+            SendBenchRollbackLink(&links[i ^ 1], &packet, frame + 2);
+        }
+    }
+
+    if (!IsRollbackDesynced(&peers[0].rollback))
+    {
+        SDL_Log("Injected desync went unnoticed");
+        return false;
+    }
+
+    /* The real transport over loopback. */
+    net_socket_t sockets[VERSUS_PLAYER_COUNT];
+    InitBenchRollbackPeers(peers, 9);
+
+    if (!OpenNetSocket(&sockets[0], BENCH_ROLLBACK_PORT, "127.0.0.1", BENCH_ROLLBACK_PORT + 1) ||
+        !OpenNetSocket(&sockets[1], BENCH_ROLLBACK_PORT + 1, "127.0.0.1", BENCH_ROLLBACK_PORT))
+    {
+        SDL_Log("Skipping loopback: %s", SDL_GetError());
+    }
+    else
+    {
+        for (uint32 frame = 0; frame < BENCH_ROLLBACK_LOOPBACK_TICKS; ++frame)
+        {
+            for (uint32 i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+            {
+                net_packet_t packet;
+                int32 size;
+
+                while ((size = ReceiveNetPacket(&sockets[i], &packet, sizeof(packet))) > 0)
+                {
+                    ReadRollbackPacket(&peers[i].rollback, &packet, (uint32)size);
+                }
+
+                AdvanceBenchRollbackPeer(&peers[i]);
+                BuildRollbackPacket(&peers[i].rollback, &packet);
+                SendNetPacket(&sockets[i], &packet, sizeof(packet));
+            }
+        }
+
+        SDL_Log("loopback UDP: %u ticks, %llu checksums compared, %s", peers[0].rollback.currentTick,
+                (unsigned long long)peers[0].rollback.stats.checksumsCompared,
+                IsRollbackDesynced(&peers[0].rollback) ? "DESYNCED" : "in sync");
+        CloseNetSocket(&sockets[0]);
+        CloseNetSocket(&sockets[1]);
+
+        if (IsRollbackDesynced(&peers[0].rollback))
+        {
+            return false;
+        }
+    }
+
+    SDL_free(links);
+    SDL_free(peers);
+    return true;
+}
@@ -0,0 +1,136 @@
+#include "bench.h"
+
+#define BENCH_SAVE_ITERATIONS 2000
+#define BENCH_SAVE_CHECKPOINT_GAMES 10000
+#define BENCH_SAVE_PATH "bench_save.ttrs"
+#define BENCH_SAVE_CHECKPOINT_PATH "bench_save.ttck"
+
+static void PlayBenchGame(level_t *level, uint64 seed, int32 pieceCount)
+{
+    InitBenchLevel(level, seed);
+    random_t random;
+    SeedRandom(&random, seed);
+
+    for (int32 i = 0; i < pieceCount; ++i)
+    {
+        if (!DropBotPiece(level, NextRandomBelow(&random, 4), NextRandomBelow(&random, level->world.size.x)))
+        {
+            break;
+        }
+    }
+
+    level->score = (uint32)seed;
+    level->stepAccumulator = seed % 17;
+}
+
+static bool RunSaveBench(int argc, char **argv)
+{
+    level_t original{};
+    level_t loaded{};
+    save_level_t save;
+    PlayBenchGame(&original, 7, 40);
+
+    uint64 timer = BeginBenchTimer();
+    for (int32 i = 0; i < BENCH_SAVE_ITERATIONS; ++i)
+    {
+        PackLevelSave(&original, &save);
+        benchSink += save.header.checksum;
+    }
+    real64 packUs = GetBenchSeconds(timer) * 1e6 / BENCH_SAVE_ITERATIONS;
+
+    timer = BeginBenchTimer();
+    for (int32 i = 0; i < BENCH_SAVE_ITERATIONS; ++i)
+    {
+        if (!SaveLevel(&original, BENCH_SAVE_PATH))
+        {
+            SDL_Log("Couldn't save: %s", SDL_GetError());
+            return false;
+        }
+    }
+    real64 saveUs = GetBenchSeconds(timer) * 1e6 / BENCH_SAVE_ITERATIONS;
+
+    CopyLevel(&loaded, &original);
+    timer = BeginBenchTimer();
+    for (int32 i = 0; i < BENCH_SAVE_ITERATIONS; ++i)
+    {
+        if (!LoadLevel(&loaded, BENCH_SAVE_PATH))
+        {
+            SDL_Log("Couldn't load: %s", SDL_GetError());
+            return false;
+        }
+    }
+    real64 loadUs = GetBenchSeconds(timer) * 1e6 / BENCH_SAVE_ITERATIONS;
+
+    /* Round trip must restore the exact level. */
+    SDL_memset(loaded.world.data, 0, sizeof(loaded.world.data));
+    loaded.score = 0;
+    loaded.pieceQueue.random.state = 0;
+    LoadLevel(&loaded, BENCH_SAVE_PATH);
+
+    if (SDL_memcmp(&loaded, &original, sizeof(level_t)) != 0)
+    {
+        SDL_Log("Loaded level differs from the saved one");
+        return false;
+    }
+
+    SDL_Log("single game (%d bytes): pack %.2f us, save %.2f us, load %.2f us",
+            (int)sizeof(save_level_t), packUs, saveUs, loadUs);
+
+    /* Checkpoint thousands of headless games at once. */
+    level_t *levels = (level_t *)SDL_calloc(BENCH_SAVE_CHECKPOINT_GAMES, sizeof(level_t));
+
+    if (!levels)
+    {
+        return false;
+    }
+
+    for (uint32 i = 0; i < BENCH_SAVE_CHECKPOINT_GAMES; ++i)
+    {
+        PlayBenchGame(&levels[i], i + 1, 20);
+    }
+
+    timer = BeginBenchTimer();
+    bool saved = SaveLevelCheckpoint(levels, BENCH_SAVE_CHECKPOINT_GAMES, BENCH_SAVE_CHECKPOINT_PATH);
+    real64 checkpointMs = GetBenchSeconds(timer) * 1e3;
+
+    save_file_t file;
+    uint32 count = 0;
+    bool restored = saved;
+    timer = BeginBenchTimer();
+
+    if (saved && OpenSaveFile(&file, BENCH_SAVE_CHECKPOINT_PATH))
+    {
+        const save_level_t *records = GetCheckpointRecords(&file, &count);
+
+        for (uint32 i = 0; records && i < count; ++i)
+        {
+            if (!ValidateLevelSave(&records[i], sizeof(save_level_t)))
+            {
+                restored = false;
+                break;
+            }
+
+            CopyLevel(&loaded, &levels[i]);
+            UnpackLevelSave(&records[i], &loaded);
+            restored = restored && SDL_memcmp(&loaded, &levels[i], sizeof(level_t)) == 0;
+        }
+
+        CloseSaveFile(&file);
+    }
+
+    real64 restoreMs = GetBenchSeconds(timer) * 1e3;
+    SDL_free(levels);
+    SDL_RemovePath(BENCH_SAVE_PATH);
+    SDL_RemovePath(BENCH_SAVE_CHECKPOINT_PATH);
+
+    if (!restored || count != BENCH_SAVE_CHECKPOINT_GAMES)
+    {
+        SDL_Log("Checkpoint round trip failed: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_Log("checkpoint of %d games: write %.2f ms (%.2f us/game), map+validate+restore %.2f ms (%.2f us/game)",
+            BENCH_SAVE_CHECKPOINT_GAMES, checkpointMs, checkpointMs * 1e3 / BENCH_SAVE_CHECKPOINT_GAMES,
+            restoreMs, restoreMs * 1e3 / BENCH_SAVE_CHECKPOINT_GAMES);
+    return true;
+}
@@ -0,0 +1,135 @@
+#include "bench.h"
+
+#define BENCH_SFX_TRIGGERS 100000
+#define BENCH_SFX_PERIODS 20000
+#define BENCH_SFX_LATENCY_TRIGGERS 400
+
+struct bench_sfx_device_t
+{
+    sfx_t *sfx;
+    SDL_AtomicInt running;
+};
+
+/**
+ * @brief Stands in for the audio device: pulls one device buffer every period like SDL's audio thread.
+ */
+static int SDLCALL RunBenchSfxDevice(void *data)
+{
+    bench_sfx_device_t *device = (bench_sfx_device_t *)data;
+    uint64 periodNs = (uint64)SFX_DEVICE_SAMPLE_FRAMES * SDL_NS_PER_SECOND / SFX_FREQUENCY;
+    uint64 next = SDL_GetTicksNS();
+
+    while (SDL_GetAtomicInt(&device->running))
+    {
+        MixSfx(device->sfx, device->sfx->mixBuffer, SFX_DEVICE_SAMPLE_FRAMES);
+        next += periodNs;
+        uint64 now = SDL_GetTicksNS();
+        SDL_DelayPrecise(next > now ? next - now : 0);
+    }
+
+    return 0;
+}
+
+static void InitBenchSfxSound(sfx_sound_t *sound, uint32 frameCount, real32 hz)
+{
+    sound->samples = (float *)SDL_malloc(frameCount * SFX_CHANNELS * sizeof(float));
+    sound->frameCount = frameCount;
+
+    for (uint32 i = 0; i < frameCount; ++i)
+    {
+        float sample = 0.25f * SDL_sinf(2.0f * SDL_PI_F * hz * i / SFX_FREQUENCY);
+        sound->samples[i * SFX_CHANNELS] = sample;
+        sound->samples[i * SFX_CHANNELS + 1] = sample;
+    }
+}
+
+static bool RunSfxBench(int argc, char **argv)
+{
+    sfx_t *sfx = (sfx_t *)SDL_calloc(1, sizeof(sfx_t));
+
+    if (!sfx)
+    {
+        return false;
+    }
+
+    InitBenchSfxSound(&sfx->sounds[SFX_SOUND_PLACE], SFX_FREQUENCY / 5, 440.0f);
+    InitBenchSfxSound(&sfx->sounds[SFX_SOUND_GAME_OVER], SFX_FREQUENCY, 110.0f);
+
+    /* Game thread cost: a trigger is a ring write. */
+    uint64 timer = BeginBenchTimer();
+
+    for (uint32 i = 0; i < BENCH_SFX_TRIGGERS; ++i)
+    {
+        PlaySfx(sfx, SFX_SOUND_PLACE);
+
+        if ((i & (SFX_QUEUE_SIZE / 2 - 1)) == 0)
+        {
+            /* Drain without mixing so the ring never fills. */
+            sfx->queueRead.store(sfx->queueWrite.load());
+        }
+    }
+
+    real64 triggerNs = GetBenchSeconds(timer) * 1e9 / BENCH_SFX_TRIGGERS;
+    SDL_Log("trigger %.1f ns, %llu dropped", triggerNs, (unsigned long long)sfx->stats.dropped);
+
+    /* Audio thread cost per device period by voice count. */
+    static const uint32 kVoiceCounts[] = {1, 4, SFX_MAX_VOICES};
+    real64 periodUs = SFX_DEVICE_SAMPLE_FRAMES * 1e6 / SFX_FREQUENCY;
+
+    for (uint32 voices : kVoiceCounts)
+    {
+        sfx->voiceCount = 0;
+        timer = BeginBenchTimer();
+
+        for (uint32 period = 0; period < BENCH_SFX_PERIODS; ++period)
+        {
+            while (sfx->voiceCount < voices)
+            {
+                PlaySfx(sfx, SFX_SOUND_GAME_OVER);
+                StartSfxVoices(sfx);
+            }
+
+            MixSfx(sfx, sfx->mixBuffer, SFX_DEVICE_SAMPLE_FRAMES);
+            benchSink += (uint64)(sfx->mixBuffer[0] * 1000.0f);
+        }
+
+        real64 mixUs = GetBenchSeconds(timer) * 1e6 / BENCH_SFX_PERIODS;
+        SDL_Log("%2u voices: mix %.2f us per %d frame period (%.3f%% of %.0f us)", voices, mixUs,
+                SFX_DEVICE_SAMPLE_FRAMES, 100.0 * mixUs / periodUs, periodUs);
+    }
+
+    /* Event to mix latency against a thread pulling buffers at the device rate. */
+    SDL_zero(sfx->stats);
+    sfx->voiceCount = 0;
+    bench_sfx_device_t device;
+    device.sfx = sfx;
+    SDL_SetAtomicInt(&device.running, 1);
+    SDL_Thread *thread = SDL_CreateThread(RunBenchSfxDevice, "bench sfx", &device);
+
+    if (!thread)
+    {
+        return false;
+    }
+
+    random_t random;
+    SeedRandom(&random, 37);
+
+    for (uint32 i = 0; i < BENCH_SFX_LATENCY_TRIGGERS; ++i)
+    {
+        /* Game events land anywhere inside a device period. */
+        SDL_DelayNS(1000000 + NextRandomBelow(&random, 10000000));
+        PlaySfx(sfx, SFX_SOUND_PLACE);
+    }
+
+    SDL_Delay(50);
+    SDL_SetAtomicInt(&device.running, 0);
+    SDL_WaitThread(thread, nullptr);
+    sfx->stats.deviceFrames = SFX_DEVICE_SAMPLE_FRAMES;
+    LogSfxStats(sfx);
+
+    bool success = sfx->stats.started == BENCH_SFX_LATENCY_TRIGGERS && !sfx->stats.dropped;
+    SDL_free(sfx->sounds[SFX_SOUND_PLACE].samples);
+    SDL_free(sfx->sounds[SFX_SOUND_GAME_OVER].samples);
+    SDL_free(sfx);
+    return success;
+}
@@ -0,0 +1,128 @@
+#include "bench.h"
+
+#define BENCH_WORLD_KERNELS_MAX_WIDTH 64
+#define BENCH_WORLD_KERNELS_HEIGHT 24
+#define BENCH_WORLD_KERNELS_ITERATIONS 200000
+
+static void FillBenchCells(uint8 *cells, int32 count, int32 emptyPercent)
+{
+    for (int32 i = 0; i < count; ++i)
+    {
+        cells[i] = SDL_rand(100) < emptyPercent ? 0 : (uint8)(SDL_rand(PLAYER_VALUE_COUNT) + 1);
+    }
+}
+
+/**
+ * @brief Checks every kernel set against the scalar one on a half filled board.
+ */
+static bool ValidateWorldKernels(const world_kernels_t *kernels, const world_kernels_t *reference, int32 width)
+{
+    uint8 cells[BENCH_WORLD_KERNELS_MAX_WIDTH * BENCH_WORLD_KERNELS_HEIGHT];
+    uint8 copy[BENCH_WORLD_KERNELS_MAX_WIDTH];
+    uint16 indices[BENCH_WORLD_KERNELS_MAX_WIDTH * BENCH_WORLD_KERNELS_HEIGHT];
+    uint16 referenceIndices[BENCH_WORLD_KERNELS_MAX_WIDTH * BENCH_WORLD_KERNELS_HEIGHT];
+    int32 count = width * BENCH_WORLD_KERNELS_HEIGHT;
+
+    FillBenchCells(cells, count, 50);
+    SDL_memset(cells + width, 1, width);
+
+    for (int32 row = 0; row < BENCH_WORLD_KERNELS_HEIGHT; ++row)
+    {
+        if (kernels->isRowFilled(cells + row * width, width) != reference->isRowFilled(cells + row * width, width))
+        {
+            return false;
+        }
+    }
+
+    int32 compacted = kernels->compactCells(cells, count, indices);
+
+    if (compacted != reference->compactCells(cells, count, referenceIndices) ||
+        SDL_memcmp(indices, referenceIndices, compacted * sizeof(uint16)) != 0)
+    {
+        return false;
+    }
+
+    kernels->copyRow(copy, cells, width);
+
+    if (SDL_memcmp(copy, cells, width) != 0)
+    {
+        return false;
+    }
+
+    kernels->clearCells(cells, count);
+    return reference->compactCells(cells, count, indices) == 0;
+}
+
+static bool RunWorldKernelsBench(int argc, char **argv)
+{
+    const int32 widths[] = {10, 16, 24, 32, 64};
+    const world_kernels_t *reference = GetWorldKernels(WORLD_KERNELS_SCALAR);
+
+    SDL_Log("%-8s %6s %14s %14s %14s %14s", "kernels", "width",
+            "rowFilled ns", "copyRow ns", "compact ns", "reset ns");
+
+    for (int32 widthIndex = 0; widthIndex < (int32)SDL_arraysize(widths); ++widthIndex)
+    {
+        int32 width = widths[widthIndex];
+        int32 count = width * BENCH_WORLD_KERNELS_HEIGHT;
+
+        for (int kind = 0; kind < WORLD_KERNELS_COUNT; ++kind)
+        {
+            const world_kernels_t *kernels = GetWorldKernels((eWorldKernelsKind)kind);
+
+            if (!kernels)
+            {
+                continue;
+            }
+
+            if (!ValidateWorldKernels(kernels, reference, width))
+            {
+                SDL_Log("%s kernels disagree with scalar at width %d", kernels->name, width);
+                return false;
+            }
+
+            uint8 cells[BENCH_WORLD_KERNELS_MAX_WIDTH * BENCH_WORLD_KERNELS_HEIGHT];
+            uint16 indices[BENCH_WORLD_KERNELS_MAX_WIDTH * BENCH_WORLD_KERNELS_HEIGHT];
+            uint64 sink = 0;
+
+            /* Filled rows are the worst case: every cell has to be looked at. */
+            SDL_memset(cells, 1, count);
+            uint64 timer = BeginBenchTimer();
+            for (int32 i = 0; i < BENCH_WORLD_KERNELS_ITERATIONS; ++i)
+            {
+                sink += kernels->isRowFilled(cells + (i % BENCH_WORLD_KERNELS_HEIGHT) * width, width);
+            }
+            real64 rowFilledNs = GetBenchSeconds(timer) * 1e9 / BENCH_WORLD_KERNELS_ITERATIONS;
+
+            timer = BeginBenchTimer();
+            for (int32 i = 0; i < BENCH_WORLD_KERNELS_ITERATIONS; ++i)
+            {
+                int32 row = 1 + i % (BENCH_WORLD_KERNELS_HEIGHT - 1);
+                kernels->copyRow(cells + row * width, cells + (row - 1) * width, width);
+            }
+            real64 copyRowNs = GetBenchSeconds(timer) * 1e9 / BENCH_WORLD_KERNELS_ITERATIONS;
+
+            FillBenchCells(cells, count, 60);
+            timer = BeginBenchTimer();
+            for (int32 i = 0; i < BENCH_WORLD_KERNELS_ITERATIONS / 10; ++i)
+            {
+                sink += kernels->compactCells(cells, count, indices);
+            }
+            real64 compactNs = GetBenchSeconds(timer) * 1e9 / (BENCH_WORLD_KERNELS_ITERATIONS / 10);
+
+            timer = BeginBenchTimer();
+            for (int32 i = 0; i < BENCH_WORLD_KERNELS_ITERATIONS / 10; ++i)
+            {
+                kernels->clearCells(cells, count);
+                sink += cells[i % count];
+            }
+            real64 resetNs = GetBenchSeconds(timer) * 1e9 / (BENCH_WORLD_KERNELS_ITERATIONS / 10);
+
+            benchSink += sink;
+            SDL_Log("%-8s %6d %14.2f %14.2f %14.2f %14.2f", kernels->name, width,
+                    rowFilledNs, copyRowNs, compactNs, resetNs);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,171 @@
+#include "bench.h"
+
+#define BENCH_WORLD_SHAPE_SWEEPS 200
+#define BENCH_WORLD_SHAPE_ITERATIONS 200000
+#define BENCH_WORLD_SHAPE_FILLED_ROWS 2
+
+/**
+ * @brief A random stack over the lower half with a few filled rows, like a board mid-game.
+ */
+static void FillBenchShapeWorld(world_t *world, vec2i_t size)
+{
+    random_t random;
+    SeedRandom(&random, 1);
+    SetWorldSize(world, size);
+    ResetWorld(world);
+
+    for (int32 y = size.y / 2; y < size.y; ++y)
+    {
+        bool filled = y >= size.y - 2 * BENCH_WORLD_SHAPE_FILLED_ROWS && y % 2 == 0;
+
+        for (int32 x = 0; x < size.x; ++x)
+        {
+            bool occupied = filled || NextRandomBelow(&random, 4) != 0;
+            SetWorldValue(world, {x, y}, occupied ? (uint8)(1 + NextRandomBelow(&random, PLAYER_VALUE_COUNT)) : 0);
+        }
+    }
+}
+
+/**
+ * @brief Tests every rotation of every classic kind at every position that overlaps the world.
+ * @return Valid positions found.
+ */
+static uint64 SweepBenchShapeWorld(world_t *world, uint64 *checks)
+{
+    const piece_set_t *set = GetClassicPieceSet();
+    uint64 valid = 0;
+
+    for (uint32 kind = 0; kind < set->kindCount; ++kind)
+    {
+        for (uint32 rotation = 0; rotation < PLAYER_DATA_ROTATION_COUNT; ++rotation)
+        {
+            const player_data_t *data = &set->rotations[kind][rotation];
+
+            for (int32 y = -data->dim.y; y < world->size.y; ++y)
+            {
+                for (int32 x = -data->dim.x; x < world->size.x; ++x)
+                {
+                    valid += IsPlayerPositionValid(world, data, {x, y});
+                    (*checks)++;
+                }
+            }
+        }
+    }
+
+    return valid;
+}
+
+/**
+ * @brief Checks that the world's compiled loops give what the generic ones give.
+ */
+static bool ValidateBenchShapeWorld(const world_t *original)
+{
+    world_t worlds[2] = {*original, *original};
+    worlds[1].shape = WORLD_SHAPE_GENERIC;
+    uint64 checks = 0;
+
+    if (SweepBenchShapeWorld(&worlds[0], &checks) != SweepBenchShapeWorld(&worlds[1], &checks))
+    {
+        return false;
+    }
+
+    uint32 rowsMask = GetFilledRowsMask(&worlds[0]);
+
+    if (!rowsMask || rowsMask != GetFilledRowsMask(&worlds[1]))
+    {
+        return false;
+    }
+
+    for (int32 y = 0; y < original->size.y; ++y)
+    {
+        if (IsWorldRowFilled(&worlds[0], (uint8)y) != IsWorldRowFilled(&worlds[1], (uint8)y))
+        {
+            return false;
+        }
+    }
+
+    RemoveWorldRows(&worlds[0], rowsMask);
+    RemoveWorldRows(&worlds[1], rowsMask);
+    return SDL_memcmp(worlds[0].data, worlds[1].data, sizeof(worlds[0].data)) == 0 &&
+           worlds[0].hash == worlds[1].hash && worlds[0].hash == ComputeWorldHash(&worlds[0]);
+}
+
+static bool RunWorldShapeBench(int argc, char **argv)
+{
+    const vec2i_t sizes[] = {{10, 20}, {16, 24}};
+    world_t *original = (world_t *)SDL_malloc(sizeof(world_t));
+    world_t *world = (world_t *)SDL_malloc(sizeof(world_t));
+
+    if (!original || !world)
+    {
+        SDL_Log("Couldn't set up the world shape bench: %s", SDL_GetError());
+        SDL_free(original);
+        SDL_free(world);
+        return false;
+    }
+
+    bool success = true;
+    SDL_Log("%-6s %-8s %12s %12s %12s", "size", "loops", "position ns", "rowsMask ns", "clear ns");
+
+    for (uint32 s = 0; s < SDL_arraysize(sizes) && success; ++s)
+    {
+        FillBenchShapeWorld(original, sizes[s]);
+
+        if (!ValidateBenchShapeWorld(original))
+        {
+            SDL_Log("%s loops disagree with the generic ones", GetWorldShapeName((eWorldShape)original->shape));
+            success = false;
+            break;
+        }
+
+        const uint32 shapes[] = {original->shape, WORLD_SHAPE_GENERIC};
+        real64 results[2][3];
+        int32 cellCount = sizes[s].x * sizes[s].y;
+        uint32 rowsMask = GetFilledRowsMask(original);
+        uint64 sink = 0;
+
+        for (uint32 mode = 0; mode < SDL_arraysize(shapes); ++mode)
+        {
+            *world = *original;
+            world->shape = shapes[mode];
+
+            uint64 checks = 0;
+            uint64 timer = BeginBenchTimer();
+            for (uint32 i = 0; i < BENCH_WORLD_SHAPE_SWEEPS; ++i)
+            {
+                sink += SweepBenchShapeWorld(world, &checks);
+            }
+            results[mode][0] = GetBenchSeconds(timer) * 1e9 / checks;
+
+            timer = BeginBenchTimer();
+            for (uint32 i = 0; i < BENCH_WORLD_SHAPE_ITERATIONS; ++i)
+            {
+                world->data[i % cellCount] ^= (uint8)(i & 1);
+                sink += GetFilledRowsMask(world);
+            }
+            results[mode][1] = GetBenchSeconds(timer) * 1e9 / BENCH_WORLD_SHAPE_ITERATIONS;
+
+            /* Restoring the cells is part of every iteration, in both modes alike. */
+            timer = BeginBenchTimer();
+            for (uint32 i = 0; i < BENCH_WORLD_SHAPE_ITERATIONS; ++i)
+            {
+                SDL_memcpy(world->data, original->data, cellCount);
+                world->hash = original->hash;
+                RemoveWorldRows(world, rowsMask);
+                sink += world->hash;
+            }
+            results[mode][2] = GetBenchSeconds(timer) * 1e9 / BENCH_WORLD_SHAPE_ITERATIONS;
+
+            SDL_Log("%2dx%-3d %-8s %12.2f %12.2f %12.2f", sizes[s].x, sizes[s].y,
+                    GetWorldShapeName((eWorldShape)shapes[mode]), results[mode][0], results[mode][1], results[mode][2]);
+        }
+
+        benchSink += sink;
+        SDL_Log("%2dx%-3d speedup  %11.2fx %11.2fx %11.2fx", sizes[s].x, sizes[s].y,
+                results[1][0] / results[0][0], results[1][1] / results[0][1], results[1][2] / results[0][2]);
+    }
+
+    SDL_free(original);
+    SDL_free(world);
+    return success;
+}
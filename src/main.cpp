@@ -3,15 +3,39 @@
 #include <SDL3/SDL_main.h>
 #include <SDL3_image/SDL_image.h>
 #include <SDL3_mixer/SDL_mixer.h>
+#include <time.h>
 
 #include "tetris_typedefs.h"
 #include "tetris_math.h"
+#include "tetris_arena.cpp"
+#include "tetris_alloc.cpp"
+#include "tetris_world_kernels.cpp"
 #include "tetris_world.cpp"
+#include "tetris_random.cpp"
+#include "tetris_piece_set.cpp"
 #include "tetris_player.cpp"
+#include "tetris_hash.cpp"
 #include "tetris_fx.h"
 #include "tetris_input.cpp"
 #include "tetris_assets.cpp"
+#include "tetris_sfx.cpp"
 #include "tetris_level.cpp"
+#include "tetris_bot.cpp"
+#include "tetris_jobs.cpp"
+#include "tetris_planner.cpp"
+#include "tetris_selfplay.cpp"
+#include "tetris_save.cpp"
+#include "tetris_rewind.cpp"
+#include "tetris_versus.cpp"
+#include "tetris_rollback.cpp"
+#include "tetris_opponent.cpp"
+#include "tetris_net.cpp"
+#include "tetris_feed.cpp"
+#include "tetris_replay.cpp"
+#include "tetris_metrics.cpp"
+#include "tetris_latency.cpp"
+#include "tetris_particles.cpp"
+#include "tetris_render_bench.cpp"
 
 static constexpr uint64 kWidth = 1920;
 static constexpr uint64 kHeight = 1080;
@@ -19,6 +43,33 @@ static constexpr uint64 inputMs = 100;
 
 static uint64 fpsTimer{0};
 static uint64 lastTickMs{0};
+/**
+ * @brief Installed before SDL_Init with --alloc-track, it has to outlive the app arena.
+ */
+static alloc_tracker_t appAllocTracker;
+/**
+ * @brief Loaded with --pieces, every level uses it while the app runs.
+ */
+static piece_set_t appPieceSet;
+
+/**
+ * @brief Reasons the window can't be seen, nothing is rendered while any is set.
+ */
+enum eWindowObscuredFlags
+{
+    WINDOW_OBSCURED_HIDDEN = 1 << 0,
+    WINDOW_OBSCURED_MINIMIZED = 1 << 1,
+    WINDOW_OBSCURED_OCCLUDED = 1 << 2,
+    WINDOW_OBSCURED_BACKGROUND = 1 << 3,
+};
+
+/**
+ * @brief SDL_HINT_MAIN_CALLBACK_RATE values: uncapped while playing, only after events while idle.
+ * @note Versus can't stop ticking, it drops to its tick rate while obscured instead.
+ */
+#define APP_RATE_UNCAPPED "0"
+#define APP_RATE_WAIT_EVENT "waitevent"
+#define APP_RATE_VERSUS_OBSCURED "62"
 
 enum eSoundChannels
 {
@@ -27,8 +78,27 @@ enum eSoundChannels
     SOUND_CHANNEL_COUNT,
 };
 
+/**
+ * @brief Everything the app owns lives in one arena allocated at startup:
+ *
+ *   [app_state_t: window/renderer handles, input, level_t, fx pool, asset handles]
+ *   [particle arrays, vertex and index buffers]
+ *   [rewind keyframe and delta rings, practice mode only]
+ *   [replay frames, --record only]
+ *   [rollback_t, versus mode only]
+ *   [versus_t and opponent_t, --vs-bot only]
+ *   [benchmark frame times, --bench-render only]
+ *   [free space for later PushStruct/PushArray calls]
+ *
+ * The optional state feed lives in its own shared memory object, see tetris_feed.h.
+ * level_t is a self-contained block, nothing in the steady state touches the heap.
+ */
+#define APP_ARENA_SIZE Megabytes(4)
+
 struct app_state_t
 {
+    arena_t arena;
+
     SDL_Window *window;
     SDL_Renderer *renderer;
     SDL_AudioDeviceID audioDeviceId;
@@ -36,25 +106,236 @@ struct app_state_t
     level_t level;
 
     fx_pool_t cleanFxPool;
+    particle_system_t particles;
+    uint64 particlesTickNs;
+    sfx_t sfx;
+
+    char savePath[1024];
+
+    bool practice;
+    rewind_t rewind;
+
+    bool versus;
+    net_socket_t socket;
+    rollback_t *rollback;
+    uint64 versusAccumulator;
+    /**
+     * @brief --vs-bot: both boards are stepped here, without rollback or a socket.
+     */
+    versus_t *botVersus;
+    opponent_t *opponent;
+
+    feed_t feed;
+
+    uint64 seed;
+    metrics_session_t metrics;
+    metrics_log_t metricsLog;
+    /**
+     * @brief Single-player presses only, versus input goes through rollback.
+     */
+    latency_tracker_t latency;
+
+    /**
+     * @brief eReplayCommand flags from input events, applied at the start of the next frame.
+     */
+    uint16 pendingCommands;
+    bool recording;
+    replay_t replay;
+    char replayPath[1024];
+
+    /**
+     * @brief eWindowObscuredFlags.
+     */
+    uint32 obscured;
+    /**
+     * @brief Something visible changed while the game is idle, render one frame.
+     */
+    bool redraw;
+    const char *callbackRate;
+    /**
+     * @brief Callback rate while a game runs, APP_RATE_UNCAPPED unless --rate.
+     */
+    char playRate[16];
+    uint64 iterations;
+    uint64 renderedFrames;
+
+    /**
+     * @brief nullptr unless --alloc-track or --alloc-strict.
+     */
+    alloc_tracker_t *allocTracker;
+    /**
+     * @brief Ends the app with a failure on the first steady-state allocation.
+     */
+    bool allocStrict;
+
+    /**
+     * @brief --bench-render, frameCapacity is 0 in normal play.
+     */
+    render_bench_t renderBench;
 
     app_assets_t assets;
 };
 
-static void HandleKeyboardEvent(app_state_t *appState, SDL_Scancode scancode, bool isDown)
+static void ResetAppRewind(app_state_t *appState)
+{
+    if (appState->practice)
+    {
+        ResetRewind(&appState->rewind, &appState->level);
+    }
+}
+
+static void BeginAppMetricsGame(app_state_t *appState)
+{
+    if (appState->metricsLog.thread)
+    {
+        BeginMetricsGame(&appState->metrics, &appState->level, appState->seed);
+    }
+}
+
+/**
+ * @brief Hands the running game to the writer thread, games without a single lock aren't worth a record.
+ */
+static void EndAppMetricsGame(app_state_t *appState, eMetricsGameEnd end)
+{
+    if (EndMetricsGame(&appState->metrics, &appState->level, end) && appState->metrics.game.pieces)
+    {
+        SubmitMetricsGame(&appState->metricsLog, &appState->metrics.game);
+    }
+}
+
+static void SeekAppRewind(app_state_t *appState, int32 lockDelta)
+{
+    if (appState->practice)
+    {
+        EndAppMetricsGame(appState, METRICS_GAME_END_EDITED);
+        rewind_t *rewind = &appState->rewind;
+        uint32 lock = (lockDelta < 0 && (uint32)-lockDelta > rewind->currentLock) ? 0 : rewind->currentLock + lockDelta;
+        SeekRewind(rewind, &appState->level, lock);
+        PauseLevel(&appState->level);
+        BeginAppMetricsGame(appState);
+    }
+}
+
+static void StopAppRecording(app_state_t *appState, const char *reason)
+{
+    if (!appState->recording)
+    {
+        return;
+    }
+
+    appState->recording = false;
+
+    if (SaveReplay(&appState->replay, appState->replayPath))
+    {
+        SDL_Log("Saved %u replay frames to %s (%s)", appState->replay.frameCount, appState->replayPath, reason);
+    }
+    else
+    {
+        SDL_Log("Couldn't save replay: %s", SDL_GetError());
+    }
+}
+
+static void HandleLevelEvents(app_state_t *appState, const level_events_t *events)
+{
+    if (!(events->flags & LEVEL_EVENT_PIECE_LOCKED))
+    {
+        return;
+    }
+
+    if (appState->practice)
+    {
+        RecordRewindLock(&appState->rewind, &appState->level, events);
+    }
+
+    PlaySfx(&appState->sfx, (events->flags & LEVEL_EVENT_GAME_OVER) ? SFX_SOUND_GAME_OVER : SFX_SOUND_PLACE);
+    EmitLevelParticles(&appState->particles, &appState->level, events);
+
+    SDL_Gamepad *gamepad = appState->input.gamepadId ? SDL_GetGamepadFromID(appState->input.gamepadId) : nullptr;
+
+    if (gamepad)
+    {
+        uint16 strength = (events->flags & LEVEL_EVENT_ROWS_CLEARED) ? 0xFFFF : 0x1000;
+        SDL_RumbleGamepad(gamepad, strength, strength, 500);
+    }
+
+    if (events->flags & LEVEL_EVENT_GAME_OVER)
+    {
+        EndAppMetricsGame(appState, METRICS_GAME_END_GAME_OVER);
+        // Mix_HaltMusic();
+
+        if (gamepad)
+        {
+            SDL_RumbleGamepad(gamepad, 0xFFFF, 0xFFFF, 1000);
+            SDL_SetGamepadLED(gamepad, 0xFF, 0x00, 0x00);
+        }
+    }
+}
+
+/**
+ * @return The button went down, a key repeat or a second key for the same button isn't a press.
+ */
+static bool PressAppButton(game_input_button_t *button, bool isDown)
+{
+    bool pressed = isDown && !button->isDown;
+    SetInputButtonDown(button, isDown);
+    return pressed;
+}
+
+/**
+ * @brief Presses that visibly move the piece are followed until the frame that shows them.
+ */
+static void TagAppLatencyPress(app_state_t *appState, bool pressed, uint64 timestampNs)
+{
+    if (pressed && !appState->versus)
+    {
+        TagLatencyPress(&appState->latency, timestampNs);
+    }
+}
+
+static void HandleKeyboardEvent(app_state_t *appState, SDL_Scancode scancode, bool isDown, uint64 timestampNs)
 {
     game_input_t *input = &appState->input;
     input->gamepadId = 0;
 
-    if (isDown)
+    /* Versus games can't be paused, restarted or rewound by one side. */
+    if (isDown && !appState->versus)
     {
         switch (scancode)
         {
         case SDL_SCANCODE_R:
-            ResetLevel(&appState->level);
+            appState->pendingCommands |= REPLAY_COMMAND_RESET;
             break;
         case SDL_SCANCODE_ESCAPE:
         case SDL_SCANCODE_P:
-            ToggleLevelPaused(&appState->level);
+            appState->pendingCommands ^= REPLAY_COMMAND_TOGGLE_PAUSE;
+            break;
+        case SDL_SCANCODE_F5:
+            if (!SaveLevel(&appState->level, appState->savePath))
+            {
+                SDL_Log("Couldn't save game: %s", SDL_GetError());
+            }
+            break;
+        case SDL_SCANCODE_F9:
+            StopAppRecording(appState, "a saved game was loaded");
+            EndAppMetricsGame(appState, METRICS_GAME_END_EDITED);
+
+            if (!LoadLevel(&appState->level, appState->savePath))
+            {
+                SDL_Log("Couldn't load game: %s", SDL_GetError());
+            }
+            ResetAppRewind(appState);
+            BeginAppMetricsGame(appState);
+            break;
+        case SDL_SCANCODE_Z:
+            StopAppRecording(appState, "the game was rewound");
+            SeekAppRewind(appState, -1);
+            break;
+        case SDL_SCANCODE_X:
+            StopAppRecording(appState, "the game was rewound");
+            SeekAppRewind(appState, 1);
+            break;
+        case SDL_SCANCODE_L:
+            appState->latency.visible = !appState->latency.visible;
             break;
         }
     }
@@ -63,11 +344,11 @@ static void HandleKeyboardEvent(app_state_t *appState, SDL_Scancode scancode, bo
     {
     case SDL_SCANCODE_LEFT:
     case SDL_SCANCODE_A:
-        SetInputButtonDown(&input->left, isDown);
+        TagAppLatencyPress(appState, PressAppButton(&input->left, isDown), timestampNs);
         break;
     case SDL_SCANCODE_RIGHT:
     case SDL_SCANCODE_D:
-        SetInputButtonDown(&input->right, isDown);
+        TagAppLatencyPress(appState, PressAppButton(&input->right, isDown), timestampNs);
         break;
     case SDL_SCANCODE_DOWN:
     case SDL_SCANCODE_S:
@@ -76,25 +357,26 @@ static void HandleKeyboardEvent(app_state_t *appState, SDL_Scancode scancode, bo
     case SDL_SCANCODE_UP:
     case SDL_SCANCODE_W:
     case SDL_SCANCODE_SPACE:
-        SetInputButtonDown(&input->rotate, isDown);
+        TagAppLatencyPress(appState, PressAppButton(&input->rotate, isDown), timestampNs);
         break;
     }
 }
 
-static void HandleGamepadButtonEvent(app_state_t *appState, uint8 button, SDL_JoystickID gamepadId, bool isDown)
+static void HandleGamepadButtonEvent(app_state_t *appState, uint8 button, SDL_JoystickID gamepadId, bool isDown,
+                                     uint64 timestampNs)
 {
     game_input_t *input = &appState->input;
     input->gamepadId = gamepadId;
 
-    if (isDown)
+    if (isDown && !appState->versus)
     {
         switch (button)
         {
         case SDL_GAMEPAD_BUTTON_START:
-            ToggleLevelPaused(&appState->level);
+            appState->pendingCommands ^= REPLAY_COMMAND_TOGGLE_PAUSE;
             break;
         case SDL_GAMEPAD_BUTTON_BACK:
-            ResetLevel(&appState->level);
+            appState->pendingCommands |= REPLAY_COMMAND_RESET;
             break;
         }
     }
@@ -105,24 +387,160 @@ static void HandleGamepadButtonEvent(app_state_t *appState, uint8 button, SDL_Jo
     case SDL_GAMEPAD_BUTTON_LEFT_SHOULDER:
     case SDL_GAMEPAD_BUTTON_LEFT_PADDLE1:
     case SDL_GAMEPAD_BUTTON_LEFT_PADDLE2:
-        SetInputButtonDown(&input->left, isDown);
+        TagAppLatencyPress(appState, PressAppButton(&input->left, isDown), timestampNs);
         break;
     case SDL_GAMEPAD_BUTTON_DPAD_RIGHT:
     case SDL_GAMEPAD_BUTTON_RIGHT_SHOULDER:
     case SDL_GAMEPAD_BUTTON_RIGHT_PADDLE1:
     case SDL_GAMEPAD_BUTTON_RIGHT_PADDLE2:
-        SetInputButtonDown(&input->right, isDown);
+        TagAppLatencyPress(appState, PressAppButton(&input->right, isDown), timestampNs);
         break;
     case SDL_GAMEPAD_BUTTON_DPAD_DOWN:
         SetInputButtonDown(&input->down, isDown);
         break;
     case SDL_GAMEPAD_BUTTON_SOUTH:
     case SDL_GAMEPAD_BUTTON_DPAD_UP:
-        SetInputButtonDown(&input->rotate, isDown);
+        TagAppLatencyPress(appState, PressAppButton(&input->rotate, isDown), timestampNs);
         break;
     }
 }
 
+static void SetAppObscured(app_state_t *appState, uint32 flag, bool isSet)
+{
+    if (isSet)
+    {
+        appState->obscured |= flag;
+        appState->pendingCommands |= REPLAY_COMMAND_PAUSE;
+    }
+    else
+    {
+        appState->obscured &= ~flag;
+        appState->redraw = true;
+    }
+}
+
+/**
+ * @brief Only switches the hint when the rate changes, SDL re-reads it on every change.
+ */
+static void UpdateAppCallbackRate(app_state_t *appState)
+{
+    const char *rate = appState->playRate;
+
+    if (appState->versus)
+    {
+        rate = appState->obscured ? APP_RATE_VERSUS_OBSCURED : APP_RATE_UNCAPPED;
+    }
+    else if (appState->renderBench.frameCapacity)
+    {
+        /* The benchmark scene is paused, it still draws every frame. */
+        rate = APP_RATE_UNCAPPED;
+    }
+    else if (appState->obscured ||
+             ((appState->level.paused || appState->level.gameOver) && !appState->particles.count))
+    {
+        rate = APP_RATE_WAIT_EVENT;
+    }
+
+    if (rate != appState->callbackRate)
+    {
+        SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, rate);
+        appState->callbackRate = rate;
+    }
+}
+
+static void DoVersusFrame(app_state_t *appState, uint64 dt)
+{
+    rollback_t *rollback = appState->rollback;
+    net_packet_t packet;
+    int32 size;
+
+    while ((size = ReceiveNetPacket(&appState->socket, &packet, sizeof(packet))) > 0)
+    {
+        if (!ReadRollbackPacket(rollback, &packet, (uint32)size))
+        {
+            SDL_Log("Dropped packet: %s", SDL_GetError());
+        }
+    }
+
+    appState->versusAccumulator += dt;
+
+    while (appState->versusAccumulator >= VERSUS_TICK_MS)
+    {
+        if (!AdvanceRollback(rollback, PackGameInput(&appState->input)))
+        {
+            /* Waiting for the peer, don't fast-forward once it catches up. */
+            appState->versusAccumulator = VERSUS_TICK_MS;
+            break;
+        }
+
+        FlushInput(&appState->input);
+        appState->versusAccumulator -= VERSUS_TICK_MS;
+    }
+
+    BuildRollbackPacket(rollback, &packet);
+
+    if (!SendNetPacket(&appState->socket, &packet, sizeof(packet)))
+    {
+        SDL_Log("Couldn't send packet: %s", SDL_GetError());
+    }
+}
+
+/**
+ * @brief The bot is player 1 and plays on the same ticks, its search never holds up the frame.
+ */
+static void DoBotVersusFrame(app_state_t *appState, uint64 dt)
+{
+    versus_t *versus = appState->botVersus;
+    appState->versusAccumulator += dt;
+
+    while (appState->versusAccumulator >= VERSUS_TICK_MS)
+    {
+        uint16 inputs[VERSUS_PLAYER_COUNT];
+        inputs[0] = PackGameInput(&appState->input);
+        inputs[1] = TickOpponent(appState->opponent, &versus->levels[1]);
+        level_events_t events[VERSUS_PLAYER_COUNT];
+        StepVersus(versus, inputs, events);
+
+        FlushInput(&appState->input);
+        appState->versusAccumulator -= VERSUS_TICK_MS;
+    }
+}
+
+/**
+ * @brief The two boards as the local player sees them, their own first.
+ */
+static void GetAppVersusLevels(app_state_t *appState, level_t *levels[VERSUS_PLAYER_COUNT])
+{
+    if (appState->botVersus)
+    {
+        levels[0] = &appState->botVersus->levels[0];
+        levels[1] = &appState->botVersus->levels[1];
+    }
+    else
+    {
+        uint32 localPlayer = appState->rollback->localPlayer;
+        levels[0] = &appState->rollback->state.levels[localPlayer];
+        levels[1] = &appState->rollback->state.levels[localPlayer ^ 1];
+    }
+}
+
+static void RenderVersus(app_state_t *appState, vec2i_t renderSize)
+{
+    vec2i_t halfSize{renderSize.w / 2, renderSize.h};
+    level_t *levels[VERSUS_PLAYER_COUNT];
+    GetAppVersusLevels(appState, levels);
+
+    for (uint32 i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+    {
+        /* Local board on the left. */
+        SDL_Rect viewport{(int)(i * halfSize.w), 0, halfSize.w, halfSize.h};
+        SDL_SetRenderViewport(appState->renderer, &viewport);
+        RenderLevel(appState->renderer, &appState->assets, levels[i], halfSize);
+    }
+
+    SDL_SetRenderViewport(appState->renderer, nullptr);
+}
+
 /* This function runs once at startup. */
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
 {
@@ -133,21 +551,258 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
     SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_COPYRIGHT_STRING, "Copyright (c) 2025 Holzez");
     SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_TYPE_STRING, "game");
 
+    uint64 seed = 1;
+    ePieceRandomizerMode randomizerMode = PIECE_RANDOMIZER_UNIFORM;
+    bool practice = false;
+    uint64 rewindBudget = REWIND_DEFAULT_BUDGET;
+    bool versus = false;
+    bool vsBot = false;
+    uint32 botDifficulty = OPPONENT_DEFAULT_DIFFICULTY;
+    uint16 localPort = 0;
+    uint16 peerPort = 0;
+    const char *peerHost = nullptr;
+    const char *feedName = nullptr;
+    const char *recordPath = nullptr;
+    const char *metricsPath = nullptr;
+    bool metrics = true;
+    uint32 selfPlayGames = 0;
+    bool allocTrack = false;
+    bool allocStrict = false;
+    uint32 benchRenderFrames = 0;
+    const char *rendererName = nullptr;
+    int vsync = 0;
+    const char *playRate = APP_RATE_UNCAPPED;
+    uint32 latencySynthHz = 0;
+    const char *piecesPath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (SDL_strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = SDL_strtoull(argv[++i], nullptr, 10);
+        }
+        else if (SDL_strcmp(argv[i], "--bag") == 0)
+        {
+            randomizerMode = PIECE_RANDOMIZER_BAG;
+        }
+        else if (SDL_strcmp(argv[i], "--practice") == 0)
+        {
+            practice = true;
+        }
+        else if (SDL_strcmp(argv[i], "--rewind-mb") == 0 && i + 1 < argc)
+        {
+            practice = true;
+            rewindBudget = Megabytes(SDL_strtoull(argv[++i], nullptr, 10));
+        }
+        else if (SDL_strcmp(argv[i], "--feed") == 0)
+        {
+            feedName = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : FEED_DEFAULT_NAME;
+        }
+        else if (SDL_strcmp(argv[i], "--selfplay") == 0 && i + 1 < argc)
+        {
+            selfPlayGames = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+        {
+            metricsPath = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--no-metrics") == 0)
+        {
+            metrics = false;
+        }
+        else if (SDL_strcmp(argv[i], "--alloc-track") == 0)
+        {
+            allocTrack = true;
+        }
+        else if (SDL_strcmp(argv[i], "--alloc-strict") == 0)
+        {
+            allocTrack = true;
+            allocStrict = true;
+        }
+        else if (SDL_strcmp(argv[i], "--bench-render") == 0)
+        {
+            benchRenderFrames = (i + 1 < argc && argv[i + 1][0] != '-') ? (uint32)SDL_atoi(argv[++i])
+                                                                         : RENDER_BENCH_DEFAULT_FRAMES;
+        }
+        else if (SDL_strcmp(argv[i], "--renderer") == 0 && i + 1 < argc)
+        {
+            rendererName = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--vsync") == 0)
+        {
+            /* 1 syncs every refresh, 2 every other one, -1 is adaptive. */
+            bool hasValue = i + 1 < argc && (argv[i + 1][0] != '-' || SDL_strcmp(argv[i + 1], "-1") == 0);
+            vsync = hasValue ? SDL_atoi(argv[++i]) : 1;
+        }
+        else if (SDL_strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+        {
+            playRate = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--latency-synth") == 0)
+        {
+            latencySynthHz = (i + 1 < argc && argv[i + 1][0] != '-') ? (uint32)SDL_atoi(argv[++i])
+                                                                      : LATENCY_SYNTH_DEFAULT_HZ;
+        }
+        else if (SDL_strcmp(argv[i], "--pieces") == 0 && i + 1 < argc)
+        {
+            piecesPath = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--versus") == 0 && i + 3 < argc)
+        {
+            versus = true;
+            vsBot = false;
+            localPort = (uint16)SDL_atoi(argv[++i]);
+            peerHost = argv[++i];
+            peerPort = (uint16)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--vs-bot") == 0)
+        {
+            versus = true;
+            vsBot = true;
+
+            if (i + 1 < argc && SDL_isdigit(argv[i + 1][0]))
+            {
+                botDifficulty = SDL_clamp((uint32)SDL_atoi(argv[++i]), 1u, (uint32)OPPONENT_DIFFICULTY_COUNT);
+            }
+        }
+    }
+
+    /* Blocks SDL allocated before this free fine, the tracker passes everything to SDL's allocator. */
+    if (allocTrack && !InstallAllocTracker(&appAllocTracker))
+    {
+        SDL_Log("Couldn't install allocation tracker: %s", SDL_GetError());
+        allocTrack = false;
+        allocStrict = false;
+    }
+
+    if (piecesPath)
+    {
+        if (!LoadPieceSet(&appPieceSet, piecesPath))
+        {
+            SDL_Log("Couldn't load piece set %s: %s", piecesPath, SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        UsePieceSet(&appPieceSet);
+        SDL_Log("Piece set %s: %u kinds", piecesPath, appPieceSet.kindCount);
+    }
+
+    if (selfPlayGames)
+    {
+        /* Headless: no window, audio or app arena, so it runs on build machines. */
+        selfplay_stats_t stats;
+        InitWorldKernels();
+
+        if (!SDL_Init(0) || !RunSelfPlay(seed, selfPlayGames, vec2i_t{(int32)kWidth, (int32)kHeight}, &stats))
+        {
+            return SDL_APP_FAILURE;
+        }
+
+        LogSelfPlayStats(&stats);
+        return SDL_APP_SUCCESS;
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMEPAD | SDL_INIT_AUDIO))
     {
         SDL_Log("Couldn't init sdl: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    app_state_t *as = (app_state_t *)SDL_calloc(1, sizeof(app_state_t));
+    /* The benchmark draws a fixed scene, nothing is played. */
+    if (benchRenderFrames)
+    {
+        versus = false;
+        practice = false;
+        recordPath = nullptr;
+        metrics = false;
+        vsync = 0;
+    }
+
+    practice = practice && !versus;
+    recordPath = versus ? nullptr : recordPath;
+    uint64 versusSize = vsBot ? sizeof(versus_t) + sizeof(opponent_t) : sizeof(rollback_t);
+    uint64 appMemorySize = APP_ARENA_SIZE + (practice ? rewindBudget : 0) + (versus ? versusSize : 0) +
+                           (recordPath ? REPLAY_DEFAULT_CAPACITY * sizeof(replay_frame_t) : 0) +
+                           benchRenderFrames * (sizeof(render_bench_frame_t) + sizeof(uint64)) +
+                           GetParticleSystemSize(PARTICLE_MAX_COUNT);
+    void *appMemory = SDL_calloc(1, appMemorySize);
 
-    if (!as)
+    if (!appMemory)
     {
         SDL_Log("Couldn't allocate memory for app state: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
+    arena_t arena;
+    InitArena(&arena, appMemory, appMemorySize);
+    app_state_t *as = PushStruct(&arena, app_state_t);
+    as->arena = arena;
     *appstate = as;
+    as->practice = practice;
+    as->versus = versus;
+    as->socket.fd = -1;
+    as->seed = seed;
+    as->allocTracker = allocTrack ? &appAllocTracker : nullptr;
+    as->allocStrict = allocStrict;
+    SDL_strlcpy(as->playRate, playRate, sizeof(as->playRate));
+
+    char latencySettings[LATENCY_SETTINGS_SIZE];
+    SDL_snprintf(latencySettings, sizeof(latencySettings), "vsync %d, rate %s%s", vsync, playRate,
+                 latencySynthHz ? ", synthetic" : "");
+    InitLatencyTracker(&as->latency, latencySettings);
+
+    if (!InitParticleSystem(&as->particles, &as->arena, PARTICLE_MAX_COUNT, seed))
+    {
+        SDL_Log("Couldn't init particles: %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    if (practice && !InitRewind(&as->rewind, &as->arena, rewindBudget))
+    {
+        SDL_Log("Couldn't init rewind: %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    if (recordPath)
+    {
+        if (!InitReplay(&as->replay, &as->arena, REPLAY_DEFAULT_CAPACITY, seed, randomizerMode))
+        {
+            SDL_Log("Couldn't init replay: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        as->recording = true;
+        SDL_strlcpy(as->replayPath, recordPath, sizeof(as->replayPath));
+    }
+
+    char *prefPath = SDL_GetPrefPath("Holzez", "Tetris");
+    SDL_snprintf(as->savePath, sizeof(as->savePath), "%squicksave.ttrs", prefPath ? prefPath : "");
+
+    /* Versus games are two boards stepped by rollback, the log only covers single-player games. */
+    if (metrics && !versus)
+    {
+        char defaultMetricsPath[1024];
+        SDL_snprintf(defaultMetricsPath, sizeof(defaultMetricsPath), "%s" METRICS_DEFAULT_FILE_NAME,
+                     prefPath ? prefPath : "");
+        metricsPath = metricsPath ? metricsPath : defaultMetricsPath;
+
+        if (!OpenMetricsLog(&as->metricsLog, metricsPath))
+        {
+            SDL_Log("Couldn't open metrics log %s: %s", metricsPath, SDL_GetError());
+        }
+    }
+
+    SDL_free(prefPath);
+
+    /* e.g. "software" for machines without a GPU, with SDL_VIDEODRIVER=offscreen it needs no display either. */
+    if (rendererName)
+    {
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, rendererName);
+    }
 
     /* Create the window */
     if (!SDL_CreateWindowAndRenderer("Hello World", kWidth, kHeight, 0, &as->window, &as->renderer))
@@ -156,7 +811,7 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
         return SDL_APP_FAILURE;
     }
 
-    if (!SDL_SetRenderVSync(as->renderer, false))
+    if (!SDL_SetRenderVSync(as->renderer, vsync))
     {
         SDL_Log("Set vsync error: %s", SDL_GetError());
         return SDL_APP_FAILURE;
@@ -170,9 +825,14 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
 
     SDL_AudioSpec audioSpec;
     SDL_zero(audioSpec);
-    audioSpec.format = SDL_AUDIO_F32;
-    audioSpec.channels = 2;
-    audioSpec.freq = 44100;
+    audioSpec.format = SFX_FORMAT;
+    audioSpec.channels = SFX_CHANNELS;
+    audioSpec.freq = SFX_FREQUENCY;
+
+    /* A small device buffer keeps sound effects close to the events that trigger them. */
+    char sampleFrames[16];
+    SDL_snprintf(sampleFrames, sizeof(sampleFrames), "%d", SFX_DEVICE_SAMPLE_FRAMES);
+    SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, sampleFrames);
 
     as->audioDeviceId = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &audioSpec);
     if (!as->audioDeviceId)
@@ -193,7 +853,8 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
         return SDL_APP_FAILURE;
     }
 
-    SDL_srand(1);
+    const world_kernels_t *worldKernels = InitWorldKernels();
+    SDL_Log("World kernels: %s", worldKernels->name);
 
     ResetLevel(&as->level);
 
@@ -215,7 +876,95 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
         return SDL_APP_FAILURE;
     }
 
-    SpawnPlayer(&as->level.world, &as->level.player);
+    /* Decoded once here, the audio thread only adds floats. The game runs on without sound if this fails. */
+    if (!InitSfxSound(&as->sfx, SFX_SOUND_PLACE, as->assets.placeSfx) ||
+        !InitSfxSound(&as->sfx, SFX_SOUND_GAME_OVER, as->assets.gameOverMusic) ||
+        !OpenSfx(&as->sfx, as->audioDeviceId))
+    {
+        SDL_Log("Couldn't start sound effects: %s", SDL_GetError());
+    }
+
+    InitPieceQueue(&as->level.pieceQueue, seed, randomizerMode);
+    SpawnLevelPlayer(&as->level);
+    ResetAppRewind(as);
+    BeginAppMetricsGame(as);
+
+    if (versus && vsBot)
+    {
+        as->botVersus = PushStruct(&as->arena, versus_t);
+        as->opponent = PushStruct(&as->arena, opponent_t);
+
+        if (!as->botVersus || !as->opponent || !InitVersus(as->botVersus, seed, randomizerMode) ||
+            !StartOpponent(as->opponent, botDifficulty))
+        {
+            SDL_Log("Couldn't start the bot: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        SDL_Log("Versus against the bot at difficulty %u, seed %llu", as->opponent->difficultyIndex,
+                (unsigned long long)seed);
+    }
+    else if (versus)
+    {
+        /* Both sides must agree on who is player 0. */
+        as->rollback = PushStruct(&as->arena, rollback_t);
+        uint32 localPlayer = 0;
+
+        if (!as->rollback || !OpenNetSocket(&as->socket, localPort, peerHost, peerPort) ||
+            !GetNetLocalPlayer(&as->socket, &localPlayer) ||
+            !InitRollback(as->rollback, localPlayer, seed, randomizerMode))
+        {
+            SDL_Log("Couldn't start versus mode: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        SDL_Log("Versus on port %u against %s:%u, seed %llu", localPort, peerHost, peerPort, (unsigned long long)seed);
+    }
+
+    if (benchRenderFrames)
+    {
+        vec2i_t renderSize;
+        SDL_GetCurrentRenderOutputSize(as->renderer, &renderSize.w, &renderSize.h);
+
+        if (!InitRenderBench(&as->renderBench, &as->arena, benchRenderFrames))
+        {
+            SDL_Log("Couldn't start render benchmark: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        BuildRenderBenchScene(&as->level, &as->cleanFxPool, &as->assets, renderSize, SDL_GetTicks());
+        SDL_Log("Rendering %u benchmark frames on %s", benchRenderFrames, SDL_GetRendererName(as->renderer));
+    }
+
+    if (feedName)
+    {
+        if (!OpenFeed(&as->feed, feedName))
+        {
+            SDL_Log("Couldn't open state feed: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        SDL_Log("Publishing state feed to %s", feedName);
+    }
+
+    /* Presses come from SDL's timer thread from here on, the overlay shows what they measure. */
+    if (latencySynthHz && !versus && !benchRenderFrames)
+    {
+        if (!StartLatencySynth(&as->latency, latencySynthHz))
+        {
+            SDL_Log("Couldn't start synthetic presses: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        as->latency.visible = true;
+        SDL_Log("Pressing left and right %u times per second", latencySynthHz);
+    }
+
+    if (as->allocTracker)
+    {
+        SetAllocPhase(as->allocTracker, ALLOC_PHASE_EVENT);
+    }
+
     lastTickMs = SDL_GetTicks();
     // Mix_VolumeMusic(MIX_MAX_VOLUME / 2);
     // Mix_PlayMusic(as->assets.bgMusic, -1);
@@ -230,8 +979,40 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
 
     switch (event->type)
     {
-    case SDL_WINDOW_HIDDEN:
-        PauseLevel(&as->level);
+    case SDL_EVENT_WINDOW_HIDDEN:
+        SetAppObscured(as, WINDOW_OBSCURED_HIDDEN, true);
+        break;
+    case SDL_EVENT_WINDOW_SHOWN:
+        SetAppObscured(as, WINDOW_OBSCURED_HIDDEN, false);
+        break;
+    case SDL_EVENT_WINDOW_MINIMIZED:
+        SetAppObscured(as, WINDOW_OBSCURED_MINIMIZED, true);
+        break;
+    case SDL_EVENT_WINDOW_RESTORED:
+    case SDL_EVENT_WINDOW_MAXIMIZED:
+        SetAppObscured(as, WINDOW_OBSCURED_MINIMIZED, false);
+        break;
+    case SDL_EVENT_WINDOW_OCCLUDED:
+        SetAppObscured(as, WINDOW_OBSCURED_OCCLUDED, true);
+        break;
+    case SDL_EVENT_WINDOW_EXPOSED:
+        /* Exposed also means the contents were lost and need a redraw. */
+        SetAppObscured(as, WINDOW_OBSCURED_OCCLUDED, false);
+        break;
+    case SDL_EVENT_DID_ENTER_BACKGROUND:
+        SetAppObscured(as, WINDOW_OBSCURED_BACKGROUND, true);
+        break;
+    case SDL_EVENT_DID_ENTER_FOREGROUND:
+        SetAppObscured(as, WINDOW_OBSCURED_BACKGROUND, false);
+        break;
+    case SDL_EVENT_WINDOW_FOCUS_LOST:
+        as->pendingCommands |= REPLAY_COMMAND_PAUSE;
+        as->redraw = true;
+        break;
+    case SDL_EVENT_WINDOW_FOCUS_GAINED:
+    case SDL_EVENT_WINDOW_RESIZED:
+    case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+        as->redraw = true;
         break;
     case SDL_EVENT_QUIT:
         return SDL_APP_SUCCESS;
@@ -241,12 +1022,14 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
         case SDL_SCANCODE_Q:
             return SDL_APP_SUCCESS;
         default:
-            HandleKeyboardEvent(as, event->key.scancode, true);
+            HandleKeyboardEvent(as, event->key.scancode, true, event->key.timestamp);
+            as->redraw = true;
             break;
         }
         break;
     case SDL_EVENT_KEY_UP:
-        HandleKeyboardEvent(as, event->key.scancode, false);
+        HandleKeyboardEvent(as, event->key.scancode, false, event->key.timestamp);
+        as->redraw = true;
         break;
     case SDL_EVENT_GAMEPAD_ADDED:
     {
@@ -272,10 +1055,12 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
         break;
     }
     case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
-        HandleGamepadButtonEvent(as, event->gbutton.button, event->gdevice.which, true);
+        HandleGamepadButtonEvent(as, event->gbutton.button, event->gdevice.which, true, event->gbutton.timestamp);
+        as->redraw = true;
         break;
     case SDL_EVENT_GAMEPAD_BUTTON_UP:
-        HandleGamepadButtonEvent(as, event->gbutton.button, event->gdevice.which, false);
+        HandleGamepadButtonEvent(as, event->gbutton.button, event->gdevice.which, false, event->gbutton.timestamp);
+        as->redraw = true;
         break;
     }
 
@@ -295,6 +1080,11 @@ SDL_AppResult SDL_AppIterate(void *appstate)
     real32 textPaddingX = 16.0f;
     real32 textPaddingY = 16.0f;
 
+    if (as->allocTracker)
+    {
+        BeginAllocFrame(as->allocTracker);
+    }
+
     Uint64 lastFrameNS = fpsTimer;
     fpsTimer = SDL_GetTicksNS();
 
@@ -305,22 +1095,171 @@ SDL_AppResult SDL_AppIterate(void *appstate)
         SDL_snprintf(fpsString, 256, "FPS %d", fps);
     }
 
-    /* Draw the message */
-    SDL_SetRenderDrawColor(as->renderer, 0, 0, 0, 0xFF);
-    SDL_RenderClear(as->renderer);
-    SDL_RenderTextureTiled(as->renderer, as->assets.bgPatternTexture, nullptr, 2.0f, nullptr);
-
-    SDL_GetCurrentRenderOutputSize(as->renderer, &renderSize.w, &renderSize.h);
-
+    as->iterations++;
     uint64 now = SDL_GetTicks();
     uint64 dt = now - lastTickMs;
-    ApplyLevelInput(level, dt, &as->input);
-    FlushInput(&as->input);
-    DoLevelStep(level, &as->input, dt);
-    lastTickMs = SDL_GetTicks();
-    RenderLevel(as->renderer, &as->assets, level, renderSize);
+    bool running = as->versus || (!level->paused && !level->gameOver);
 
-    SDL_RenderPresent(as->renderer);
+    if (as->botVersus)
+    {
+        DoBotVersusFrame(as, dt);
+        lastTickMs = now;
+    }
+    else if (as->versus)
+    {
+        DoVersusFrame(as, dt);
+        lastTickMs = now;
+    }
+    else
+    {
+        /* Live play goes through the same frame a replay stores, so recordings are exact. */
+        replay_frame_t frame = MakeReplayFrame(dt, &as->input, as->pendingCommands);
+        as->pendingCommands = 0;
+        FlushInput(&as->input);
+
+        if (frame.commands & REPLAY_COMMAND_RESET)
+        {
+            EndAppMetricsGame(as, METRICS_GAME_END_RESTART);
+        }
+
+        ApplyReplayCommands(level, frame.commands);
+
+        if (frame.commands & REPLAY_COMMAND_RESET)
+        {
+            ResetAppRewind(as);
+            BeginAppMetricsGame(as);
+        }
+
+        bool playing = !level->paused && !level->gameOver;
+        level_events_t events;
+
+        if (playing)
+        {
+            ApplyLatencyInput(&as->latency);
+        }
+
+        StepReplayFrame(level, &frame, &events);
+        ResolveLatencyInput(&as->latency, events.flags & LEVEL_EVENT_PLAYER_MOVED);
+        /* The frame that unpauses carries the whole pause in its dt, only frames running at both ends count. */
+        RecordMetricsFrame(&as->metrics, level, &frame, &events, running && playing, nsPerFrame);
+        HandleLevelEvents(as, &events);
+
+        if (as->recording && !AppendReplayFrame(&as->replay, &frame))
+        {
+            StopAppRecording(as, "the replay is full");
+        }
+
+        lastTickMs = SDL_GetTicks();
+        as->redraw = as->redraw || frame.commands || (events.flags & LEVEL_EVENT_PIECE_LOCKED);
+    }
+
+    if (as->feed.header)
+    {
+        /* vDSO clock read and stores into the mapping, no syscalls on this path. */
+        SDL_Time time;
+        SDL_GetCurrentTime(&time);
+        const level_t *feedLevel = level;
+
+        if (as->versus)
+        {
+            level_t *levels[VERSUS_PLAYER_COUNT];
+            GetAppVersusLevels(as, levels);
+            feedLevel = levels[0];
+        }
+
+        PublishFeedFrame(&as->feed, feedLevel, (uint64)time);
+    }
+
+    bool benchDone = false;
+    as->redraw = as->redraw || as->renderBench.frameCapacity || as->particles.count;
+
+    /* Idle frames are only drawn when something changed, obscured ones never. */
+    if (!as->obscured && (running || as->redraw))
+    {
+        if (as->allocTracker)
+        {
+            SetAllocPhase(as->allocTracker, ALLOC_PHASE_RENDER);
+        }
+
+        UpdateFxPool(&as->cleanFxPool, now);
+        /* Frames aren't drawn while idle, a long gap is one short step rather than a jump. */
+        uint64 particlesNs = SDL_GetTicksNS();
+        UpdateParticles(&as->particles, SDL_min(particlesNs - as->particlesTickNs, PARTICLE_MAX_STEP_NS) / 1e9f);
+        as->particlesTickNs = particlesNs;
+        uint64 renderStartNs = SDL_GetTicksNS();
+        as->assets.renderCalls = 0;
+
+        /* Draw the message */
+        RenderBackground(as->renderer, &as->assets);
+        SDL_GetCurrentRenderOutputSize(as->renderer, &renderSize.w, &renderSize.h);
+
+        if (as->versus)
+        {
+            RenderVersus(as, renderSize);
+        }
+        else
+        {
+            RenderLevel(as->renderer, &as->assets, level, renderSize);
+            as->assets.renderCalls += RenderFxPool(as->renderer, &as->cleanFxPool);
+            as->assets.renderCalls += RenderParticles(as->renderer, &as->particles,
+                                                      GetLevelBoardRect(&level->world, renderSize), level->world.size);
+        }
+
+        if (as->allocTracker)
+        {
+            char allocString[ALLOC_OVERLAY_SIZE];
+            FormatAllocFrame(as->allocTracker, allocString, sizeof(allocString));
+            SDL_SetRenderDrawColor(as->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+            SDL_RenderDebugText(as->renderer, textPaddingX, textPaddingY, allocString);
+            textPaddingY += 16.0f;
+        }
+
+        if (as->opponent)
+        {
+            char opponentString[OPPONENT_STATS_SIZE];
+            FormatOpponentStats(as->opponent, opponentString, sizeof(opponentString));
+            SDL_SetRenderDrawColor(as->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+            SDL_RenderDebugText(as->renderer, textPaddingX, textPaddingY, opponentString);
+            textPaddingY += 16.0f;
+        }
+
+        if (as->latency.visible)
+        {
+            as->assets.renderCalls += RenderLatencyOverlay(as->renderer, &as->latency,
+                                                           vec2_t{textPaddingX, textPaddingY});
+        }
+
+        uint64 renderNs = SDL_GetTicksNS() - renderStartNs;
+        SDL_RenderPresent(as->renderer);
+        PresentLatencyFrame(&as->latency);
+        as->redraw = false;
+        as->renderedFrames++;
+
+        benchDone = as->renderBench.frameCapacity &&
+                    RecordRenderBenchFrame(&as->renderBench, renderNs, SDL_GetTicksNS() - renderStartNs,
+                                           as->assets.renderCalls);
+    }
+
+    UpdateAppCallbackRate(as);
+
+    if (as->allocTracker)
+    {
+        SetAllocPhase(as->allocTracker, ALLOC_PHASE_EVENT);
+        FlushAllocReports(as->allocTracker);
+
+        if (as->allocStrict && as->allocTracker->steadyAllocations)
+        {
+            SDL_Log("Allocated in the steady state with --alloc-strict, failing the run");
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    /* Logged after the allocation check, SDL_Log allocates. */
+    if (benchDone)
+    {
+        LogRenderBenchStats(&as->renderBench, SDL_GetRendererName(as->renderer), renderSize);
+        return SDL_APP_SUCCESS;
+    }
 
     return SDL_APP_CONTINUE;
 }
@@ -344,10 +1283,36 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result)
     if (appstate != nullptr)
     {
         app_state_t *as = (app_state_t *)appstate;
-        if (as->level.world.data != nullptr)
+        StopLatencySynth(&as->latency);
+
+        if (as->rollback)
+        {
+            LogRollbackStats(&as->rollback->stats);
+        }
+
+        if (as->opponent)
         {
-            SDL_free(as->level.world.data);
+            StopOpponent(as->opponent);
+            LogOpponentStats(as->opponent);
         }
+
+        /* Process CPU time against wall time, the idle throttling shows up here. */
+        SDL_Log("%llu iterations, %llu frames rendered, %.2f s CPU in %.2f s", (unsigned long long)as->iterations,
+                (unsigned long long)as->renderedFrames, (real64)clock() / CLOCKS_PER_SEC, SDL_GetTicks() / 1000.0);
+
+        if (as->allocTracker)
+        {
+            LogAllocStats(as->allocTracker);
+        }
+
+        LogLatencyStats(&as->latency);
+        StopAppRecording(as, "quit");
+        EndAppMetricsGame(as, METRICS_GAME_END_QUIT);
+        CloseMetricsLog(&as->metricsLog);
+        CloseNetSocket(&as->socket);
+        CloseFeed(&as->feed);
+        CloseSfx(&as->sfx);
+        LogSfxStats(&as->sfx);
         FreeAssets(&as->assets);
 
         Mix_CloseAudio();
@@ -355,7 +1320,7 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result)
 
         SDL_DestroyRenderer(as->renderer);
         SDL_DestroyWindow(as->window);
-        SDL_free(as);
+        SDL_free(as->arena.base);
 
         Mix_Quit();
         SDL_Quit();
@@ -0,0 +1,207 @@
+#include "tetris_alloc.h"
+
+static const char *kAllocPhaseNames[ALLOC_PHASE_COUNT] = {"init", "event", "simulate", "render", "threads"};
+static const char *kAllocKindNames[] = {"malloc", "calloc", "realloc"};
+
+/**
+ * @brief The memory functions take no userdata.
+ */
+static alloc_tracker_t *activeAllocTracker = nullptr;
+
+/**
+ * @brief Called for every allocation in the steady state, break here in a debugger to see the caller.
+ */
+static SDL_NOINLINE void ReportSteadyAllocation(alloc_tracker_t *tracker, eAllocKind kind, size_t size)
+{
+    if (tracker->steadyAllocations - tracker->loggedReports < ALLOC_MAX_REPORTS)
+    {
+        tracker->reports[tracker->steadyAllocations % ALLOC_MAX_REPORTS] = {tracker->iteration, tracker->phase,
+                                                                            (uint32)kind, (uint64)size};
+    }
+
+    tracker->steadyAllocations++;
+}
+
+static void CountAllocation(alloc_tracker_t *tracker, eAllocKind kind, size_t size)
+{
+    bool mainThread = SDL_GetCurrentThreadID() == tracker->mainThread;
+    uint32 phase = mainThread ? tracker->phase : (uint32)ALLOC_PHASE_THREADS;
+
+    tracker->allocations[phase].fetch_add(1, std::memory_order_relaxed);
+    tracker->bytes[phase].fetch_add(size, std::memory_order_relaxed);
+
+    if (mainThread && tracker->steady && (phase == ALLOC_PHASE_SIMULATE || phase == ALLOC_PHASE_RENDER))
+    {
+        ReportSteadyAllocation(tracker, kind, size);
+    }
+}
+
+static void *SDLCALL TrackedMalloc(size_t size)
+{
+    CountAllocation(activeAllocTracker, ALLOC_KIND_MALLOC, size);
+    return activeAllocTracker->originalMalloc(size);
+}
+
+static void *SDLCALL TrackedCalloc(size_t count, size_t size)
+{
+    CountAllocation(activeAllocTracker, ALLOC_KIND_CALLOC, count * size);
+    return activeAllocTracker->originalCalloc(count, size);
+}
+
+/**
+ * @brief A realloc counts as an allocation of the new size, growing a buffer is what we look for.
+ */
+static void *SDLCALL TrackedRealloc(void *memory, size_t size)
+{
+    CountAllocation(activeAllocTracker, ALLOC_KIND_REALLOC, size);
+    return activeAllocTracker->originalRealloc(memory, size);
+}
+
+static void SDLCALL TrackedFree(void *memory)
+{
+    if (memory)
+    {
+        activeAllocTracker->frees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    activeAllocTracker->originalFree(memory);
+}
+
+bool InstallAllocTracker(alloc_tracker_t *tracker)
+{
+    SDL_GetOriginalMemoryFunctions(&tracker->originalMalloc, &tracker->originalCalloc, &tracker->originalRealloc,
+                                   &tracker->originalFree);
+    tracker->mainThread = SDL_GetCurrentThreadID();
+    tracker->phase = ALLOC_PHASE_INIT;
+    activeAllocTracker = tracker;
+
+    if (!SDL_SetMemoryFunctions(TrackedMalloc, TrackedCalloc, TrackedRealloc, TrackedFree))
+    {
+        activeAllocTracker = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void SetAllocPhase(alloc_tracker_t *tracker, eAllocPhase phase)
+{
+    tracker->phase = phase;
+}
+
+void BeginAllocFrame(alloc_tracker_t *tracker)
+{
+    alloc_counters_t total{};
+
+    for (uint32 phase = 0; phase < ALLOC_PHASE_COUNT; ++phase)
+    {
+        alloc_counters_t now{tracker->allocations[phase].load(std::memory_order_relaxed),
+                             tracker->bytes[phase].load(std::memory_order_relaxed)};
+
+        /* Init has no frame of its own, it stays as the running count. */
+        if (phase == ALLOC_PHASE_INIT)
+        {
+            tracker->lastFrame[phase] = now;
+            continue;
+        }
+
+        tracker->lastFrame[phase] = {now.allocations - tracker->frameStart[phase].allocations,
+                                     now.bytes - tracker->frameStart[phase].bytes};
+        tracker->frameStart[phase] = now;
+
+        if (phase != ALLOC_PHASE_THREADS)
+        {
+            total.allocations += tracker->lastFrame[phase].allocations;
+            total.bytes += tracker->lastFrame[phase].bytes;
+        }
+    }
+
+    /* Main thread only, and only iterations after the warmup. */
+    if (tracker->steady)
+    {
+        tracker->maxFrame.allocations = SDL_max(tracker->maxFrame.allocations, total.allocations);
+        tracker->maxFrame.bytes = SDL_max(tracker->maxFrame.bytes, total.bytes);
+        tracker->framesWithAllocations += total.allocations ? 1 : 0;
+    }
+
+    tracker->iteration++;
+    tracker->steady = tracker->iteration > ALLOC_WARMUP_ITERATIONS;
+    tracker->phase = ALLOC_PHASE_SIMULATE;
+}
+
+void FlushAllocReports(alloc_tracker_t *tracker)
+{
+    if (tracker->loggedReports == tracker->steadyAllocations)
+    {
+        return;
+    }
+
+    uint64 pending = tracker->steadyAllocations - tracker->loggedReports;
+    uint64 kept = SDL_min(pending, (uint64)ALLOC_MAX_REPORTS);
+
+    /* Logging allocates, which must not count as another steady-state allocation. */
+    uint32 phase = tracker->phase;
+    tracker->phase = ALLOC_PHASE_EVENT;
+
+    for (uint64 i = tracker->loggedReports; i < tracker->loggedReports + kept; ++i)
+    {
+        const alloc_report_t *report = &tracker->reports[i % ALLOC_MAX_REPORTS];
+        SDL_Log("Steady-state allocation: %s of %llu bytes in %s, iteration %llu", kAllocKindNames[report->kind],
+                (unsigned long long)report->size, kAllocPhaseNames[report->phase],
+                (unsigned long long)report->iteration);
+    }
+
+    if (pending > kept)
+    {
+        SDL_Log("... and %llu more steady-state allocations", (unsigned long long)(pending - kept));
+    }
+
+    tracker->loggedReports = tracker->steadyAllocations;
+    tracker->phase = phase;
+}
+
+void FormatAllocFrame(const alloc_tracker_t *tracker, char *text, uint64 size)
+{
+    const alloc_counters_t *frame = tracker->lastFrame;
+    SDL_snprintf(text, size, "alloc/frame: event %llu (%llu B), simulate %llu (%llu B), render %llu (%llu B), "
+                             "threads %llu (%llu B); steady state %llu",
+                 (unsigned long long)frame[ALLOC_PHASE_EVENT].allocations,
+                 (unsigned long long)frame[ALLOC_PHASE_EVENT].bytes,
+                 (unsigned long long)frame[ALLOC_PHASE_SIMULATE].allocations,
+                 (unsigned long long)frame[ALLOC_PHASE_SIMULATE].bytes,
+                 (unsigned long long)frame[ALLOC_PHASE_RENDER].allocations,
+                 (unsigned long long)frame[ALLOC_PHASE_RENDER].bytes,
+                 (unsigned long long)frame[ALLOC_PHASE_THREADS].allocations,
+                 (unsigned long long)frame[ALLOC_PHASE_THREADS].bytes,
+                 (unsigned long long)tracker->steadyAllocations);
+}
+
+void LogAllocStats(const alloc_tracker_t *tracker)
+{
+    uint64 iterations = SDL_max(tracker->iteration, (uint64)1);
+
+    for (uint32 phase = 0; phase < ALLOC_PHASE_COUNT; ++phase)
+    {
+        uint64 allocations = tracker->allocations[phase].load(std::memory_order_relaxed);
+        uint64 bytes = tracker->bytes[phase].load(std::memory_order_relaxed);
+
+        /* Init is a one-off, per iteration it would only dilute. */
+        if (phase == ALLOC_PHASE_INIT)
+        {
+            SDL_Log("alloc %-8s %10llu allocations, %12llu bytes", kAllocPhaseNames[phase],
+                    (unsigned long long)allocations, (unsigned long long)bytes);
+            continue;
+        }
+
+        SDL_Log("alloc %-8s %10llu allocations, %12llu bytes, %.2f allocations and %.0f bytes per iteration",
+                kAllocPhaseNames[phase], (unsigned long long)allocations, (unsigned long long)bytes,
+                (real64)allocations / iterations, (real64)bytes / iterations);
+    }
+
+    SDL_Log("alloc: %llu frees, %llu iterations; past the first %d the main thread allocated in %llu, worst %llu "
+            "allocations (%llu bytes) in one, %llu steady-state allocations in SDL_AppIterate",
+            (unsigned long long)tracker->frees.load(std::memory_order_relaxed), (unsigned long long)tracker->iteration,
+            ALLOC_WARMUP_ITERATIONS, (unsigned long long)tracker->framesWithAllocations,
+            (unsigned long long)tracker->maxFrame.allocations, (unsigned long long)tracker->maxFrame.bytes,
+            (unsigned long long)tracker->steadyAllocations);
+}
@@ -0,0 +1,118 @@
+#if !defined(TETRIS_ALLOC_H)
+
+#include <atomic>
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+
+/**
+ * @brief Iterations before the steady state starts, the renderer grows its command buffers and
+ * builds the debug font texture on the first frames.
+ */
+#define ALLOC_WARMUP_ITERATIONS 120
+/**
+ * @brief Steady-state allocations kept for the log. The allocator can't log them itself, SDL_Log allocates.
+ */
+#define ALLOC_MAX_REPORTS 16
+#define ALLOC_OVERLAY_SIZE 256
+
+enum eAllocPhase
+{
+    ALLOC_PHASE_INIT = 0,
+    /**
+     * @brief Between iterations: SDL pumping events and SDL_AppEvent.
+     */
+    ALLOC_PHASE_EVENT,
+    ALLOC_PHASE_SIMULATE,
+    ALLOC_PHASE_RENDER,
+    /**
+     * @brief Any thread but the main one (audio, metrics writer), whatever phase the main thread is in.
+     */
+    ALLOC_PHASE_THREADS,
+    ALLOC_PHASE_COUNT,
+};
+
+enum eAllocKind
+{
+    ALLOC_KIND_MALLOC = 0,
+    ALLOC_KIND_CALLOC,
+    ALLOC_KIND_REALLOC,
+};
+
+struct alloc_counters_t
+{
+    uint64 allocations;
+    uint64 bytes;
+};
+
+/**
+ * @brief One allocation made in SDL_AppIterate after the warmup.
+ */
+struct alloc_report_t
+{
+    uint64 iteration;
+    uint32 phase;
+    uint32 kind;
+    uint64 size;
+};
+
+/**
+ * @brief Counting wrappers around SDL's own allocator, every call is tagged with the main thread's phase.
+ * @note The wrappers don't add headers, so blocks allocated before InstallAllocTracker free fine.
+ * Freed bytes aren't known without headers, only allocated bytes are counted.
+ */
+struct alloc_tracker_t
+{
+    SDL_malloc_func originalMalloc;
+    SDL_calloc_func originalCalloc;
+    SDL_realloc_func originalRealloc;
+    SDL_free_func originalFree;
+    SDL_ThreadID mainThread;
+
+    /* Main thread only. */
+    uint32 phase;
+    uint64 iteration;
+    bool steady;
+
+    /* Other threads add to these as well. */
+    std::atomic<uint64> allocations[ALLOC_PHASE_COUNT];
+    std::atomic<uint64> bytes[ALLOC_PHASE_COUNT];
+    std::atomic<uint64> frees;
+
+    /* Per iteration, from the difference of the running counts. */
+    alloc_counters_t frameStart[ALLOC_PHASE_COUNT];
+    alloc_counters_t lastFrame[ALLOC_PHASE_COUNT];
+    alloc_counters_t maxFrame;
+    uint64 framesWithAllocations;
+
+    uint64 steadyAllocations;
+    uint64 loggedReports;
+    alloc_report_t reports[ALLOC_MAX_REPORTS];
+};
+
+/**
+ * @brief Routes SDL_malloc and friends through tracker until exit, in phase ALLOC_PHASE_INIT.
+ * @note Only one tracker can be installed, it must outlive every SDL call.
+ */
+bool InstallAllocTracker(alloc_tracker_t *tracker);
+
+void SetAllocPhase(alloc_tracker_t *tracker, eAllocPhase phase);
+
+/**
+ * @brief Closes the previous iteration's counts and enters ALLOC_PHASE_SIMULATE, call first in SDL_AppIterate.
+ */
+void BeginAllocFrame(alloc_tracker_t *tracker);
+
+/**
+ * @brief Logs the steady-state allocations recorded since the last call.
+ */
+void FlushAllocReports(alloc_tracker_t *tracker);
+
+/**
+ * @brief Last full iteration's allocations and bytes by phase, for the on-screen overlay.
+ */
+void FormatAllocFrame(const alloc_tracker_t *tracker, char *text, uint64 size);
+
+void LogAllocStats(const alloc_tracker_t *tracker);
+
+#define TETRIS_ALLOC_H
+#endif
@@ -0,0 +1,35 @@
+#include "tetris_arena.h"
+
+void InitArena(arena_t *arena, void *base, uint64 size)
+{
+    arena->base = (uint8 *)base;
+    arena->size = size;
+    arena->used = 0;
+}
+
+void *PushSize(arena_t *arena, uint64 size, uint64 alignment)
+{
+    SDL_assert((alignment & (alignment - 1)) == 0);
+
+    uint64 start = (arena->used + alignment - 1) & ~(alignment - 1);
+
+    if (start + size > arena->size)
+    {
+        SDL_SetError("Arena exhausted: %llu of %llu bytes used, %llu requested",
+                     (unsigned long long)arena->used, (unsigned long long)arena->size, (unsigned long long)size);
+        return nullptr;
+    }
+
+    arena->used = start + size;
+    return SDL_memset(arena->base + start, 0, size);
+}
+
+inline void ResetArena(arena_t *arena)
+{
+    arena->used = 0;
+}
+
+inline uint64 GetArenaRemaining(arena_t *arena)
+{
+    return arena->size - arena->used;
+}
@@ -0,0 +1,36 @@
+#if !defined(TETRIS_ARENA_H)
+
+#include "tetris_typedefs.h"
+
+#define Kilobytes(value) ((value) * 1024ull)
+#define Megabytes(value) (Kilobytes(value) * 1024ull)
+
+#define ARENA_DEFAULT_ALIGNMENT 16
+
+/**
+ * @brief Linear allocator over one fixed block, nothing is freed individually.
+ * @note Reset is O(1): only the used size is rewound.
+ */
+struct arena_t
+{
+    uint8 *base;
+    uint64 size;
+    uint64 used;
+};
+
+void InitArena(arena_t *arena, void *base, uint64 size);
+
+/**
+ * @note Memory is zeroed, returns nullptr when the arena is exhausted.
+ */
+void *PushSize(arena_t *arena, uint64 size, uint64 alignment = ARENA_DEFAULT_ALIGNMENT);
+
+#define PushStruct(arena, type) ((type *)PushSize((arena), sizeof(type), alignof(type)))
+#define PushArray(arena, count, type) ((type *)PushSize((arena), (count) * sizeof(type), alignof(type)))
+
+void ResetArena(arena_t *arena);
+
+uint64 GetArenaRemaining(arena_t *arena);
+
+#define TETRIS_ARENA_H
+#endif
@@ -23,7 +23,7 @@ SDL_Texture *LoadTextureFromFile(SDL_Renderer *renderer, char *file)
     return texture;
 }
 
-bool LoadAssets(SDL_Renderer *renderer, app_assets_t *assets)
+bool LoadTextureAssets(SDL_Renderer *renderer, app_assets_t *assets)
 {
     assets->bgPatternTexture = LoadTextureFromFile(renderer, "res/Pattern01.png");
     assets->borderTexture = LoadTextureFromFile(renderer, "res/Border.png");
@@ -48,11 +48,7 @@ bool LoadAssets(SDL_Renderer *renderer, app_assets_t *assets)
     assets->fxClean[8] = LoadTextureFromFile(renderer, "res/Fx_clean09.png");
     assets->fxCleanCount = 9;
 
-    assets->bgMusic = Mix_LoadMUS("res/music.mp3");
-    assets->gameOverMusic = Mix_LoadWAV("res/game-over.mp3");
-    assets->placeSfx = Mix_LoadWAV("res/place-sfx.mp3");
-
-    if (!assets->bgPatternTexture || !assets->borderTexture || !assets->gridPatternTexture || !assets->bgMusic || !assets->gameOverMusic || !assets->placeSfx)
+    if (!assets->bgPatternTexture || !assets->borderTexture || !assets->gridPatternTexture)
     {
         return false;
     }
@@ -76,12 +72,22 @@ bool LoadAssets(SDL_Renderer *renderer, app_assets_t *assets)
     return true;
 }
 
-bool FreeAssets(app_assets_t *assets)
+bool LoadAssets(SDL_Renderer *renderer, app_assets_t *assets)
 {
-    Mix_FreeMusic(assets->bgMusic);
-    Mix_FreeChunk(assets->gameOverMusic);
-    Mix_FreeChunk(assets->placeSfx);
+    if (!LoadTextureAssets(renderer, assets))
+    {
+        return false;
+    }
 
+    assets->bgMusic = Mix_LoadMUS("res/music.mp3");
+    assets->gameOverMusic = Mix_LoadWAV("res/game-over.mp3");
+    assets->placeSfx = Mix_LoadWAV("res/place-sfx.mp3");
+
+    return assets->bgMusic && assets->gameOverMusic && assets->placeSfx;
+}
+
+void FreeTextureAssets(app_assets_t *assets)
+{
     SDL_DestroyTexture(assets->bgPatternTexture);
     SDL_DestroyTexture(assets->borderTexture);
 
@@ -94,6 +100,14 @@ bool FreeAssets(app_assets_t *assets)
     {
         SDL_DestroyTexture(assets->fxClean[i]);
     }
+}
+
+bool FreeAssets(app_assets_t *assets)
+{
+    Mix_FreeMusic(assets->bgMusic);
+    Mix_FreeChunk(assets->gameOverMusic);
+    Mix_FreeChunk(assets->placeSfx);
+    FreeTextureAssets(assets);
 
     return true;
 }
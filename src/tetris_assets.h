@@ -20,12 +20,25 @@ struct app_assets_t
     Mix_Music *bgMusic;
     Mix_Chunk *gameOverMusic;
     Mix_Chunk *placeSfx;
+
+    /**
+     * @brief SDL_Render calls made with these assets since the caller last zeroed it, for --bench-render.
+     * @note SDL batches them, the backend's own draw calls can be fewer.
+     */
+    uint32 renderCalls;
 };
 
 SDL_Texture *LoadTextureFromFile(SDL_Renderer *renderer, char *file);
 
+/**
+ * @brief Textures only, for renderers that never play sound (e.g. offscreen export).
+ */
+bool LoadTextureAssets(SDL_Renderer *renderer, app_assets_t *assets);
+
 bool LoadAssets(SDL_Renderer *renderer, app_assets_t *assets);
 
+void FreeTextureAssets(app_assets_t *assets);
+
 bool FreeAssets(app_assets_t *assets);
 
 SDL_Texture *GetValueTexture(app_assets_t *assets, uint8 value);
@@ -0,0 +1,120 @@
+#include "tetris_bot.h"
+
+bool DropBotPiece(level_t *level, int32 rotations, int32 x, level_events_t *events)
+{
+    player_t *player = &level->player;
+
+    for (int32 i = 0; i < rotations; ++i)
+    {
+        RotatePlayer(&level->world, player);
+    }
+
+    vec2i_t target{x, player->position.y};
+
+    if (!IsPlayerPositionValid(&level->world, &player->data, target))
+    {
+        return false;
+    }
+
+    player->position = target;
+
+    while (IsPlayerPositionValid(&level->world, &player->data, player->position + vec2i_t{0, 1}))
+    {
+        player->position.y++;
+    }
+
+    LockLevelPlayer(level, events);
+    return !level->gameOver;
+}
+
+void GetBotStackFeatures(world_t *world, real32 *features)
+{
+    int32 heights[WORLD_MAX_WIDTH];
+    int32 holes = 0;
+    int32 bumpiness = 0;
+    int32 height = 0;
+    int32 wells = 0;
+
+    for (int32 x = 0; x < world->size.x; ++x)
+    {
+        heights[x] = 0;
+
+        for (int32 y = 0; y < world->size.y; ++y)
+        {
+            if (!IsValueEmpty(GetWorldValueUnchecked(world, {x, y})))
+            {
+                heights[x] = heights[x] ? heights[x] : world->size.y - y;
+            }
+            else if (heights[x])
+            {
+                holes++;
+            }
+        }
+
+        height += heights[x];
+        bumpiness += x > 0 ? SDL_abs(heights[x] - heights[x - 1]) : 0;
+    }
+
+    for (int32 x = 0; x < world->size.x; ++x)
+    {
+        int32 left = x > 0 ? heights[x - 1] : world->size.y;
+        int32 right = x + 1 < world->size.x ? heights[x + 1] : world->size.y;
+        wells += SDL_max(SDL_min(left, right) - heights[x], 0);
+    }
+
+    features[BOT_FEATURE_HOLES] = (real32)holes;
+    features[BOT_FEATURE_BUMPINESS] = (real32)bumpiness;
+    features[BOT_FEATURE_HEIGHT] = (real32)height;
+    features[BOT_FEATURE_WELLS] = (real32)wells;
+    features[BOT_FEATURE_ROWS] = 0.0f;
+}
+
+real32 GetBotWeightedCost(const bot_weights_t *weights, const real32 *features)
+{
+    real32 cost = 0.0f;
+
+    for (int i = 0; i < BOT_FEATURE_COUNT; ++i)
+    {
+        cost += weights->weights[i] * features[i];
+    }
+
+    return cost;
+}
+
+int32 GetBotStackCost(world_t *world)
+{
+    real32 features[BOT_FEATURE_COUNT];
+    GetBotStackFeatures(world, features);
+    return (int32)GetBotWeightedCost(&kBotDefaultWeights, features);
+}
+
+bot_move_t PickBotMove(level_t *level, const bot_weights_t *weights)
+{
+    real32 bestCost = 0.0f;
+    bool found = false;
+    bot_move_t best{0, 0};
+
+    for (int32 move = 0; move < 4 * (level->world.size.x - BOT_MIN_X); ++move)
+    {
+        bot_move_t candidate{move % 4, move / 4 + BOT_MIN_X};
+        level_t trial;
+        CopyLevel(&trial, level);
+
+        if (DropBotPiece(&trial, candidate.rotations, candidate.x))
+        {
+            real32 features[BOT_FEATURE_COUNT];
+            GetBotStackFeatures(&trial.world, features);
+            features[BOT_FEATURE_ROWS] = (real32)((trial.score - level->score) / SCORE_PER_ROW);
+            real32 cost = GetBotWeightedCost(weights, features);
+
+            if (!found || cost < bestCost)
+            {
+                found = true;
+                bestCost = cost;
+                best = candidate;
+            }
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,81 @@
+#if !defined(TETRIS_BOT_H)
+
+#include "tetris_typedefs.h"
+#include "tetris_level.h"
+
+/**
+ * @brief Leftmost column tried, piece grids can start with empty columns.
+ */
+#define BOT_MIN_X -3
+
+/**
+ * @brief A placement: rotate the active piece, shift it to column x and hard drop it.
+ */
+struct bot_move_t
+{
+    int32 rotations;
+    int32 x;
+};
+
+enum eBotFeature
+{
+    /**
+     * @brief Empty cells with a filled cell somewhere above them.
+     */
+    BOT_FEATURE_HOLES = 0,
+    /**
+     * @brief Sum of height differences between neighbouring columns.
+     */
+    BOT_FEATURE_BUMPINESS,
+    BOT_FEATURE_HEIGHT,
+    /**
+     * @brief Depth of columns lower than both neighbours, walls count as full height.
+     */
+    BOT_FEATURE_WELLS,
+    /**
+     * @brief Rows cleared by the placement, set by the caller.
+     */
+    BOT_FEATURE_ROWS,
+    BOT_FEATURE_COUNT,
+};
+
+static const char *kBotFeatureNames[BOT_FEATURE_COUNT] = {"holes", "bumpiness", "height", "wells", "rows"};
+
+/**
+ * @brief Linear evaluation of a placement, lower cost is better.
+ */
+struct bot_weights_t
+{
+    real32 weights[BOT_FEATURE_COUNT];
+};
+
+/**
+ * @brief The hand-tuned evaluation GetBotStackCost and PickBotMove use.
+ */
+static const bot_weights_t kBotDefaultWeights = {{8.0f, 2.0f, 1.0f, 0.0f, -32.0f}};
+
+/**
+ * @brief Rotates, shifts and drops the active piece, then locks it.
+ * @return False if the piece couldn't be placed or the game ended.
+ */
+bool DropBotPiece(level_t *level, int32 rotations, int32 x, level_events_t *events = nullptr);
+
+/**
+ * @brief Fills every feature but BOT_FEATURE_ROWS, which is left at 0.
+ */
+void GetBotStackFeatures(world_t *world, real32 *features);
+
+real32 GetBotWeightedCost(const bot_weights_t *weights, const real32 *features);
+
+/**
+ * @brief Lower is better: column heights, covered holes and bumpiness with the default weights.
+ */
+int32 GetBotStackCost(world_t *world);
+
+/**
+ * @brief Greedy search over every rotation and column of the active piece.
+ */
+bot_move_t PickBotMove(level_t *level, const bot_weights_t *weights = &kBotDefaultWeights);
+
+#define TETRIS_BOT_H
+#endif
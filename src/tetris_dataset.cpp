@@ -0,0 +1,514 @@
+#include "tetris_dataset.h"
+
+#if defined(SDL_PLATFORM_UNIX) || defined(SDL_PLATFORM_APPLE)
+#define DATASET_USE_MMAP 1
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(dataset_header_t) == 24, "dataset_header_t layout is part of the file format");
+static_assert(sizeof(dataset_block_header_t) == 16, "dataset_block_header_t layout is part of the file format");
+
+/**
+ * @brief Bytes per sample of every column, boards and previews depend on the header.
+ */
+static void GetDatasetColumnSizes(const dataset_header_t *header, uint64 *sizes)
+{
+    sizes[DATASET_COLUMN_BOARDS] = header->boardWords * sizeof(uint64);
+    sizes[DATASET_COLUMN_GAMES] = sizeof(uint32);
+    sizes[DATASET_COLUMN_LOCKS_TO_END] = sizeof(uint32);
+    sizes[DATASET_COLUMN_PIECES] = 1;
+    sizes[DATASET_COLUMN_PREVIEWS] = header->previewCount;
+    sizes[DATASET_COLUMN_ROTATIONS] = 1;
+    sizes[DATASET_COLUMN_XS] = 1;
+    sizes[DATASET_COLUMN_YS] = 1;
+    sizes[DATASET_COLUMN_ROWS_CLEARED] = 1;
+    sizes[DATASET_COLUMN_SOURCES] = 1;
+    sizes[DATASET_COLUMN_OUTCOMES] = 1;
+}
+
+uint64 GetDatasetBlockLayout(const dataset_header_t *header, uint32 count, uint64 *offsets)
+{
+    uint64 sizes[DATASET_COLUMN_COUNT];
+    GetDatasetColumnSizes(header, sizes);
+    uint64 offset = sizeof(dataset_block_header_t);
+
+    for (uint32 column = 0; column < DATASET_COLUMN_COUNT; ++column)
+    {
+        offsets[column] = offset;
+        offset = (offset + sizes[column] * count + 7) & ~7ull;
+    }
+
+    return offset;
+}
+
+/**
+ * @brief Columns are written and mapped in host order.
+ */
+static bool IsDatasetHostSupported()
+{
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    return true;
+#else
+    return SDL_SetError("Datasets are little-endian and mapped in place, this host is big-endian");
+#endif
+}
+
+/**
+ * @brief Hands the gathered blocks to the file in one write.
+ */
+static bool FlushDatasetBuffer(dataset_writer_t *writer)
+{
+    if (writer->bufferUsed && SDL_WriteIO(writer->io, writer->buffer, writer->bufferUsed) != writer->bufferUsed)
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->bytes += writer->bufferUsed;
+    writer->bufferUsed = 0;
+    return true;
+}
+
+/**
+ * @brief Packs the block being filled into the write buffer, columns tight for its sample count.
+ */
+static bool FinishDatasetBlock(dataset_writer_t *writer)
+{
+    if (!writer->blockCount)
+    {
+        return true;
+    }
+
+    uint64 sizes[DATASET_COLUMN_COUNT];
+    uint64 fullOffsets[DATASET_COLUMN_COUNT];
+    uint64 offsets[DATASET_COLUMN_COUNT];
+    GetDatasetColumnSizes(&writer->header, sizes);
+    GetDatasetBlockLayout(&writer->header, writer->header.blockSamples, fullOffsets);
+    uint64 blockSize = GetDatasetBlockLayout(&writer->header, writer->blockCount, offsets);
+
+    if (writer->bufferUsed + blockSize > DATASET_WRITE_BUFFER_SIZE && !FlushDatasetBuffer(writer))
+    {
+        return false;
+    }
+
+    uint8 *block = writer->buffer + writer->bufferUsed;
+    SDL_memset(block, 0, blockSize);
+    dataset_block_header_t *blockHeader = (dataset_block_header_t *)block;
+    blockHeader->magic = DATASET_BLOCK_MAGIC;
+    blockHeader->sampleCount = writer->blockCount;
+    blockHeader->blockSize = blockSize;
+
+    for (uint32 column = 0; column < DATASET_COLUMN_COUNT; ++column)
+    {
+        SDL_memcpy(block + offsets[column], writer->block + fullOffsets[column], sizes[column] * writer->blockCount);
+    }
+
+    writer->bufferUsed += blockSize;
+    writer->blockCount = 0;
+    return true;
+}
+
+bool OpenDatasetWriter(dataset_writer_t *writer, const char *path, vec2i_t worldSize)
+{
+    SDL_zerop(writer);
+
+    if (!IsDatasetHostSupported())
+    {
+        return false;
+    }
+
+    dataset_header_t *header = &writer->header;
+    header->magic = DATASET_MAGIC;
+    header->version = DATASET_VERSION;
+    header->worldWidth = (uint16)worldSize.x;
+    header->worldHeight = (uint16)worldSize.y;
+    header->boardWords = (uint16)((worldSize.x * worldSize.y + 63) / 64);
+    header->previewCount = PIECE_PREVIEW_COUNT;
+    header->blockSamples = DATASET_BLOCK_SAMPLES;
+
+    uint64 offsets[DATASET_COLUMN_COUNT];
+    uint64 blockSize = GetDatasetBlockLayout(header, DATASET_BLOCK_SAMPLES, offsets);
+    SDL_assert(blockSize + sizeof(dataset_header_t) <= DATASET_WRITE_BUFFER_SIZE);
+    writer->block = (uint8 *)SDL_malloc(blockSize);
+    writer->buffer = (uint8 *)SDL_malloc(DATASET_WRITE_BUFFER_SIZE);
+    writer->io = writer->block && writer->buffer ? SDL_IOFromFile(path, "wb") : nullptr;
+
+    if (!writer->io)
+    {
+        SDL_free(writer->block);
+        SDL_free(writer->buffer);
+        SDL_zerop(writer);
+        return false;
+    }
+
+    SDL_memcpy(writer->buffer, header, sizeof(dataset_header_t));
+    writer->bufferUsed = sizeof(dataset_header_t);
+    return true;
+}
+
+bool AppendDatasetSample(dataset_writer_t *writer, const dataset_sample_t *sample)
+{
+    if (writer->failed)
+    {
+        return false;
+    }
+
+    uint64 offsets[DATASET_COLUMN_COUNT];
+    GetDatasetBlockLayout(&writer->header, writer->header.blockSamples, offsets);
+    uint8 *block = writer->block;
+    uint32 i = writer->blockCount;
+    uint32 boardWords = writer->header.boardWords;
+
+    SDL_memcpy((uint64 *)(block + offsets[DATASET_COLUMN_BOARDS]) + i * boardWords, sample->board,
+               boardWords * sizeof(uint64));
+    ((uint32 *)(block + offsets[DATASET_COLUMN_GAMES]))[i] = sample->game;
+    ((uint32 *)(block + offsets[DATASET_COLUMN_LOCKS_TO_END]))[i] = sample->locksToEnd;
+    block[offsets[DATASET_COLUMN_PIECES] + i] = sample->piece;
+    SDL_memcpy(block + offsets[DATASET_COLUMN_PREVIEWS] + i * PIECE_PREVIEW_COUNT, sample->preview,
+               PIECE_PREVIEW_COUNT);
+    block[offsets[DATASET_COLUMN_ROTATIONS] + i] = sample->rotation;
+    block[offsets[DATASET_COLUMN_XS] + i] = (uint8)sample->x;
+    block[offsets[DATASET_COLUMN_YS] + i] = (uint8)sample->y;
+    block[offsets[DATASET_COLUMN_ROWS_CLEARED] + i] = sample->rowsCleared;
+    block[offsets[DATASET_COLUMN_SOURCES] + i] = sample->source;
+    block[offsets[DATASET_COLUMN_OUTCOMES] + i] = sample->outcome;
+
+    writer->samples++;
+
+    if (++writer->blockCount == writer->header.blockSamples)
+    {
+        return FinishDatasetBlock(writer);
+    }
+
+    return true;
+}
+
+bool CloseDatasetWriter(dataset_writer_t *writer)
+{
+    bool success = !writer->failed && FinishDatasetBlock(writer) && FlushDatasetBuffer(writer);
+
+    if (writer->io && !SDL_CloseIO(writer->io))
+    {
+        success = false;
+    }
+
+    SDL_free(writer->block);
+    SDL_free(writer->buffer);
+    writer->io = nullptr;
+    writer->block = nullptr;
+    writer->buffer = nullptr;
+    return success;
+}
+
+/**
+ * @brief Maps path read-only, the whole file stays mapped until CloseDatasetReader.
+ */
+static const uint8 *MapDatasetFile(const char *path, uint64 *size)
+{
+#if defined(DATASET_USE_MMAP)
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        SDL_SetError("Couldn't open %s: %s", path, strerror(errno));
+        return nullptr;
+    }
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        close(fd);
+        SDL_SetError("%s is empty", path);
+        return nullptr;
+    }
+
+    void *base = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        SDL_SetError("Couldn't map %s: %s", path, strerror(errno));
+        return nullptr;
+    }
+
+    /* Blocks are read front to back once, let the kernel read ahead and drop pages behind. */
+    madvise(base, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+    *size = (uint64)fileStat.st_size;
+    return (const uint8 *)base;
+#else
+    (void)path;
+    (void)size;
+    SDL_SetError("Mapping files needs POSIX mmap");
+    return nullptr;
+#endif
+}
+
+bool OpenDatasetReader(dataset_reader_t *reader, const char *path)
+{
+    SDL_zerop(reader);
+
+    if (!IsDatasetHostSupported())
+    {
+        return false;
+    }
+
+    reader->base = MapDatasetFile(path, &reader->size);
+
+    if (!reader->base)
+    {
+        size_t size;
+        reader->base = (const uint8 *)SDL_LoadFile(path, &size);
+        reader->size = size;
+        reader->loaded = true;
+
+        if (!reader->base)
+        {
+            return false;
+        }
+    }
+
+    const dataset_header_t *header = (const dataset_header_t *)reader->base;
+    bool valid = reader->size >= sizeof(dataset_header_t) && header->magic == DATASET_MAGIC &&
+                 header->version == DATASET_VERSION && header->worldWidth && header->worldHeight &&
+                 header->boardWords == (header->worldWidth * header->worldHeight + 63) / 64 &&
+                 header->boardWords <= DATASET_MAX_BOARD_WORDS && header->blockSamples;
+
+    if (!valid)
+    {
+        CloseDatasetReader(reader);
+        return SDL_SetError("%s is not a dataset this version reads", path);
+    }
+
+    reader->header = *header;
+    reader->offset = sizeof(dataset_header_t);
+    return true;
+}
+
+bool NextDatasetBatch(dataset_reader_t *reader, dataset_batch_t *batch)
+{
+    uint64 remaining = reader->size - reader->offset;
+
+    if (!remaining || reader->corrupt)
+    {
+        return false;
+    }
+
+    const uint8 *block = reader->base + reader->offset;
+    const dataset_block_header_t *blockHeader = (const dataset_block_header_t *)block;
+    uint64 offsets[DATASET_COLUMN_COUNT];
+
+    if (remaining < sizeof(dataset_block_header_t) || blockHeader->magic != DATASET_BLOCK_MAGIC ||
+        !blockHeader->sampleCount || blockHeader->sampleCount > reader->header.blockSamples ||
+        blockHeader->blockSize > remaining ||
+        blockHeader->blockSize != GetDatasetBlockLayout(&reader->header, blockHeader->sampleCount, offsets))
+    {
+        reader->corrupt = true;
+        return SDL_SetError("Bad dataset block at byte %llu", (unsigned long long)reader->offset);
+    }
+
+    batch->count = blockHeader->sampleCount;
+    batch->firstSample = reader->samples;
+    batch->boards = (const uint64 *)(block + offsets[DATASET_COLUMN_BOARDS]);
+    batch->games = (const uint32 *)(block + offsets[DATASET_COLUMN_GAMES]);
+    batch->locksToEnd = (const uint32 *)(block + offsets[DATASET_COLUMN_LOCKS_TO_END]);
+    batch->pieces = block + offsets[DATASET_COLUMN_PIECES];
+    batch->previews = block + offsets[DATASET_COLUMN_PREVIEWS];
+    batch->rotations = block + offsets[DATASET_COLUMN_ROTATIONS];
+    batch->xs = (const int8 *)(block + offsets[DATASET_COLUMN_XS]);
+    batch->ys = (const int8 *)(block + offsets[DATASET_COLUMN_YS]);
+    batch->rowsCleared = block + offsets[DATASET_COLUMN_ROWS_CLEARED];
+    batch->sources = block + offsets[DATASET_COLUMN_SOURCES];
+    batch->outcomes = block + offsets[DATASET_COLUMN_OUTCOMES];
+
+    reader->offset += blockHeader->blockSize;
+    reader->samples += batch->count;
+    return true;
+}
+
+void CloseDatasetReader(dataset_reader_t *reader)
+{
+    if (reader->loaded)
+    {
+        SDL_free((void *)reader->base);
+    }
+#if defined(DATASET_USE_MMAP)
+    else if (reader->base)
+    {
+        munmap((void *)reader->base, (size_t)reader->size);
+    }
+#endif
+
+    reader->base = nullptr;
+    reader->size = 0;
+}
+
+void InitDatasetCapture(dataset_capture_t *capture, eDatasetSource source)
+{
+    SDL_zerop(capture);
+    capture->source = (uint8)source;
+}
+
+void FreeDatasetCapture(dataset_capture_t *capture)
+{
+    SDL_free(capture->samples);
+    capture->samples = nullptr;
+    capture->sampleCount = 0;
+    capture->sampleCapacity = 0;
+}
+
+void BeginDatasetPiece(dataset_capture_t *capture, const level_t *level)
+{
+    const world_t *world = &level->world;
+    dataset_sample_t *sample = &capture->pending;
+    capture->hasPending = false;
+
+    if (level->gameOver || !level->player.value || !level->player.data.cellCount)
+    {
+        return;
+    }
+
+    sample->piece = level->player.data.kind;
+
+    SDL_zero(sample->board);
+    int32 cellCount = world->size.x * world->size.y;
+
+    for (int32 i = 0; i < cellCount; ++i)
+    {
+        if (!IsValueEmpty(world->data[i]))
+        {
+            sample->board[i >> 6] |= 1ull << (i & 63);
+        }
+    }
+
+    for (uint32 depth = 0; depth < PIECE_PREVIEW_COUNT; ++depth)
+    {
+        sample->preview[depth] = PeekPieceQueue(&level->pieceQueue, depth).kindId;
+    }
+
+    sample->game = capture->games;
+    sample->source = capture->source;
+    capture->hasPending = true;
+}
+
+/**
+ * @brief Finds the turns and grid position that put the pending piece's cells where the lock wrote them.
+ */
+static bool MatchDatasetLock(dataset_sample_t *sample, int32 worldWidth, const level_events_t *events)
+{
+    vec2i_t cellMin{WORLD_MAX_WIDTH, WORLD_MAX_HEIGHT};
+
+    for (uint32 i = 0; i < events->lockedCellCount; ++i)
+    {
+        cellMin.x = SDL_min(cellMin.x, events->lockedCells[i] % worldWidth);
+        cellMin.y = SDL_min(cellMin.y, events->lockedCells[i] / worldWidth);
+    }
+
+    for (uint32 rotation = 0; rotation < PLAYER_DATA_ROTATION_COUNT; ++rotation)
+    {
+        const player_data_t *rotated = GetPlayerRotation(sample->piece, rotation);
+
+        if (rotated->cellCount != events->lockedCellCount)
+        {
+            continue;
+        }
+
+        vec2i_t gridMin = GetPlayerCell(rotated, 0);
+
+        for (uint32 i = 1; i < rotated->cellCount; ++i)
+        {
+            gridMin.x = SDL_min(gridMin.x, GetPlayerCell(rotated, i).x);
+        }
+
+        vec2i_t position = cellMin - gridMin;
+        bool match = true;
+
+        for (uint32 i = 0; i < events->lockedCellCount && match; ++i)
+        {
+            int32 x = events->lockedCells[i] % worldWidth - position.x;
+            int32 y = events->lockedCells[i] / worldWidth - position.y;
+            match = x >= 0 && x < rotated->dim.x && y >= 0 && y < rotated->dim.y && (rotated->rowMasks[y] >> x & 1);
+        }
+
+        if (match)
+        {
+            sample->rotation = (uint8)rotation;
+            sample->x = (int8)position.x;
+            sample->y = (int8)position.y;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CaptureDatasetLock(dataset_capture_t *capture, const level_t *level, const level_events_t *events)
+{
+    if (!(events->flags & LEVEL_EVENT_PIECE_LOCKED))
+    {
+        return;
+    }
+
+    dataset_sample_t *sample = &capture->pending;
+
+    if (capture->hasPending && !capture->failed)
+    {
+        if (!MatchDatasetLock(sample, level->world.size.x, events))
+        {
+            capture->dropped++;
+        }
+        else
+        {
+            if (capture->sampleCount == capture->sampleCapacity)
+            {
+                uint32 capacity = SDL_max(capture->sampleCapacity * 2, 256u);
+                void *samples = SDL_realloc(capture->samples, capacity * sizeof(dataset_sample_t));
+
+                if (!samples)
+                {
+                    capture->failed = true;
+                    return;
+                }
+
+                capture->samples = (dataset_sample_t *)samples;
+                capture->sampleCapacity = capacity;
+            }
+
+            sample->rowsCleared = (uint8)CountSetBits32(events->clearedRowsMask);
+            capture->samples[capture->sampleCount++] = *sample;
+        }
+    }
+
+    if (events->flags & LEVEL_EVENT_GAME_OVER)
+    {
+        EndDatasetGame(capture, DATASET_OUTCOME_TOPPED_OUT);
+    }
+    else
+    {
+        BeginDatasetPiece(capture, level);
+    }
+}
+
+void EndDatasetGame(dataset_capture_t *capture, eDatasetOutcome outcome)
+{
+    capture->hasPending = false;
+
+    if (capture->sampleCount == capture->gameStart)
+    {
+        return;
+    }
+
+    for (uint32 i = capture->gameStart; i < capture->sampleCount; ++i)
+    {
+        capture->samples[i].locksToEnd = capture->sampleCount - 1 - i;
+        capture->samples[i].outcome = (uint8)outcome;
+    }
+
+    capture->gameStart = capture->sampleCount;
+    capture->games++;
+}
@@ -0,0 +1,260 @@
+#if !defined(TETRIS_DATASET_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+#include "tetris_arena.h"
+#include "tetris_level.h"
+
+#define DATASET_MAGIC SDL_FOURCC('T', 'T', 'D', 'S')
+#define DATASET_BLOCK_MAGIC SDL_FOURCC('T', 'T', 'D', 'B')
+#define DATASET_VERSION 1
+#define DATASET_MAX_BOARD_WORDS (WORLD_MAX_CELL_COUNT / 64)
+/**
+ * @brief Samples per block, a block is the batch a reader gets.
+ */
+#define DATASET_BLOCK_SAMPLES 4096
+/**
+ * @brief Finished blocks are gathered up to this size and written with one call.
+ */
+#define DATASET_WRITE_BUFFER_SIZE Megabytes(4)
+
+enum eDatasetSource
+{
+    DATASET_SOURCE_HUMAN = 0,
+    DATASET_SOURCE_BOT,
+};
+
+enum eDatasetOutcome
+{
+    /**
+     * @brief The game stopped without a top out: a reset, the end of the recording or a lock limit.
+     */
+    DATASET_OUTCOME_CUT = 0,
+    DATASET_OUTCOME_TOPPED_OUT,
+};
+
+/**
+ * @brief One placement in row form, what a capture produces and a writer takes.
+ */
+struct dataset_sample_t
+{
+    /**
+     * @brief Occupancy before the placement, bit y * width + x of the world, 64 cells per word.
+     */
+    uint64 board[DATASET_MAX_BOARD_WORDS];
+    /**
+     * @brief Index of the game in the file.
+     */
+    uint32 game;
+    /**
+     * @brief Samples of the same game after this one.
+     */
+    uint32 locksToEnd;
+    uint8 piece;
+    uint8 preview[PIECE_PREVIEW_COUNT];
+    /**
+     * @brief Turns from the spawn orientation, the fewest that give the placed shape.
+     */
+    uint8 rotation;
+    /**
+     * @brief Where the rotated piece grid ended up, x is the bot_move_t column.
+     */
+    int8 x;
+    int8 y;
+    uint8 rowsCleared;
+    /**
+     * @brief eDatasetSource.
+     */
+    uint8 source;
+    /**
+     * @brief eDatasetOutcome of the game.
+     */
+    uint8 outcome;
+};
+
+/**
+ * @note Little-endian on disk, blocks follow until the end of the file.
+ */
+struct dataset_header_t
+{
+    uint32 magic;
+    uint32 version;
+    uint16 worldWidth;
+    uint16 worldHeight;
+    uint16 boardWords;
+    uint16 previewCount;
+    uint32 blockSamples;
+    uint32 reserved;
+};
+
+/**
+ * @brief Precedes the columns of a block, each column starts 8-byte aligned from the block start.
+ */
+struct dataset_block_header_t
+{
+    uint32 magic;
+    uint32 sampleCount;
+    /**
+     * @brief Header and columns, the next block starts this many bytes after this one.
+     */
+    uint64 blockSize;
+};
+
+/**
+ * @brief Columns in file order.
+ */
+enum eDatasetColumn
+{
+    DATASET_COLUMN_BOARDS = 0,
+    DATASET_COLUMN_GAMES,
+    DATASET_COLUMN_LOCKS_TO_END,
+    DATASET_COLUMN_PIECES,
+    DATASET_COLUMN_PREVIEWS,
+    DATASET_COLUMN_ROTATIONS,
+    DATASET_COLUMN_XS,
+    DATASET_COLUMN_YS,
+    DATASET_COLUMN_ROWS_CLEARED,
+    DATASET_COLUMN_SOURCES,
+    DATASET_COLUMN_OUTCOMES,
+    DATASET_COLUMN_COUNT,
+};
+
+/**
+ * @brief A block in place, every pointer covers count samples.
+ */
+struct dataset_batch_t
+{
+    uint32 count;
+    /**
+     * @brief Index of the first sample in the file.
+     */
+    uint64 firstSample;
+    /**
+     * @brief boardWords per sample.
+     */
+    const uint64 *boards;
+    const uint32 *games;
+    const uint32 *locksToEnd;
+    const uint8 *pieces;
+    /**
+     * @brief previewCount per sample.
+     */
+    const uint8 *previews;
+    const uint8 *rotations;
+    const int8 *xs;
+    const int8 *ys;
+    const uint8 *rowsCleared;
+    const uint8 *sources;
+    const uint8 *outcomes;
+};
+
+/**
+ * @brief Gathers samples into a columnar block, then blocks into a large buffer that is written sequentially.
+ */
+struct dataset_writer_t
+{
+    SDL_IOStream *io;
+    dataset_header_t header;
+    /**
+     * @brief The block being filled, columns laid out as in the file.
+     */
+    uint8 *block;
+    uint32 blockCount;
+    uint8 *buffer;
+    uint64 bufferUsed;
+    uint64 samples;
+    uint64 bytes;
+    bool failed;
+};
+
+/**
+ * @brief Maps a whole file and hands out its blocks as batches, nothing is copied or allocated per sample.
+ */
+struct dataset_reader_t
+{
+    const uint8 *base;
+    uint64 size;
+    /**
+     * @brief The file could not be mapped and was read into memory instead.
+     */
+    bool loaded;
+    dataset_header_t header;
+    uint64 offset;
+    uint64 samples;
+    /**
+     * @brief NextDatasetBatch stopped at a block that doesn't fit the file, see SDL_GetError().
+     */
+    bool corrupt;
+};
+
+/**
+ * @brief Byte offset of every column from the start of a block of count samples.
+ * @return The block size.
+ */
+uint64 GetDatasetBlockLayout(const dataset_header_t *header, uint32 count, uint64 *offsets);
+
+bool OpenDatasetWriter(dataset_writer_t *writer, const char *path, vec2i_t worldSize);
+
+bool AppendDatasetSample(dataset_writer_t *writer, const dataset_sample_t *sample);
+
+/**
+ * @brief Writes the last partial block and closes the file.
+ */
+bool CloseDatasetWriter(dataset_writer_t *writer);
+
+bool OpenDatasetReader(dataset_reader_t *reader, const char *path);
+
+/**
+ * @return False at the end of the file, or with reader->corrupt set at a bad block.
+ */
+bool NextDatasetBatch(dataset_reader_t *reader, dataset_batch_t *batch);
+
+void CloseDatasetReader(dataset_reader_t *reader);
+
+/**
+ * @brief Turns the placements of one game into samples as it is played.
+ * @note Every lock becomes a sample of the board and queue the piece spawned into. The outcome
+ * columns are filled in when the game ends.
+ */
+struct dataset_capture_t
+{
+    uint8 source;
+    dataset_sample_t pending;
+    bool hasPending;
+    /**
+     * @brief Grows with SDL_realloc, freed with FreeDatasetCapture().
+     */
+    dataset_sample_t *samples;
+    uint32 sampleCount;
+    uint32 sampleCapacity;
+    /**
+     * @brief First sample of the game being played.
+     */
+    uint32 gameStart;
+    uint32 games;
+    /**
+     * @brief Locks whose cells didn't match their piece, partly above the top of the world.
+     */
+    uint32 dropped;
+    bool failed;
+};
+
+void InitDatasetCapture(dataset_capture_t *capture, eDatasetSource source);
+
+void FreeDatasetCapture(dataset_capture_t *capture);
+
+/**
+ * @brief Takes the board, the active piece and the preview, call it whenever a new piece is in play.
+ */
+void BeginDatasetPiece(dataset_capture_t *capture, const level_t *level);
+
+/**
+ * @brief Completes the pending sample from the lock, then begins the next piece or ends the game.
+ * @param level After the step that locked.
+ */
+void CaptureDatasetLock(dataset_capture_t *capture, const level_t *level, const level_events_t *events);
+
+void EndDatasetGame(dataset_capture_t *capture, eDatasetOutcome outcome);
+
+#define TETRIS_DATASET_H
+#endif
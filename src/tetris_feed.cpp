@@ -0,0 +1,206 @@
+#include "tetris_feed.h"
+
+#if defined(SDL_PLATFORM_UNIX) || defined(SDL_PLATFORM_APPLE)
+#define FEED_USE_SHM 1
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(FEED_USE_SHM)
+
+bool OpenFeed(feed_t *feed, const char *name)
+{
+    SDL_zerop(feed);
+    SDL_strlcpy(feed->name, name, sizeof(feed->name));
+
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+
+    if (fd < 0)
+    {
+        return SDL_SetError("Couldn't create shared memory %s: %s", name, strerror(errno));
+    }
+
+    if (ftruncate(fd, sizeof(feed_header_t)) != 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        return SDL_SetError("Couldn't size shared memory %s: %s", name, strerror(errno));
+    }
+
+    void *base = mmap(nullptr, sizeof(feed_header_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        shm_unlink(name);
+        return SDL_SetError("Couldn't map shared memory %s: %s", name, strerror(errno));
+    }
+
+    /* ftruncate zero-fills, so every sequence starts even and frameCount at 0. */
+    feed_header_t *header = (feed_header_t *)base;
+    header->magic = FEED_MAGIC;
+    header->version = FEED_VERSION;
+    header->slotCount = FEED_SLOT_COUNT;
+    header->slotSize = sizeof(feed_slot_t);
+    feed->header = header;
+    return true;
+}
+
+void CloseFeed(feed_t *feed)
+{
+    if (feed->header)
+    {
+        munmap(feed->header, sizeof(feed_header_t));
+        shm_unlink(feed->name);
+    }
+
+    feed->header = nullptr;
+}
+
+const feed_header_t *MapFeed(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        SDL_SetError("Couldn't open shared memory %s: %s", name, strerror(errno));
+        return nullptr;
+    }
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 || (uint64)fileStat.st_size < sizeof(feed_header_t))
+    {
+        close(fd);
+        SDL_SetError("Shared memory %s is too small", name);
+        return nullptr;
+    }
+
+    void *base = mmap(nullptr, sizeof(feed_header_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        SDL_SetError("Couldn't map shared memory %s: %s", name, strerror(errno));
+        return nullptr;
+    }
+
+    const feed_header_t *header = (const feed_header_t *)base;
+
+    if (header->magic != FEED_MAGIC || header->version != FEED_VERSION ||
+        header->slotCount != FEED_SLOT_COUNT || header->slotSize != sizeof(feed_slot_t))
+    {
+        munmap(base, sizeof(feed_header_t));
+        SDL_SetError("Shared memory %s has an unknown feed layout", name);
+        return nullptr;
+    }
+
+    return header;
+}
+
+void UnmapFeed(const feed_header_t *header)
+{
+    munmap((void *)header, sizeof(feed_header_t));
+}
+
+#else
+
+bool OpenFeed(feed_t *feed, const char *name)
+{
+    SDL_zerop(feed);
+    return SDL_SetError("The state feed needs POSIX shared memory");
+}
+
+void CloseFeed(feed_t *feed)
+{
+}
+
+const feed_header_t *MapFeed(const char *name)
+{
+    SDL_SetError("The state feed needs POSIX shared memory");
+    return nullptr;
+}
+
+void UnmapFeed(const feed_header_t *header)
+{
+}
+
+#endif
+
+void PublishFeedFrame(feed_t *feed, const level_t *level, uint64 timestampNs)
+{
+    feed_header_t *header = feed->header;
+    uint64 frameIndex = header->frameCount.load(std::memory_order_relaxed);
+    feed_slot_t *slot = &header->slots[frameIndex & (FEED_SLOT_COUNT - 1)];
+    feed_frame_t *frame = &slot->frame;
+
+    uint32 sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    frame->frameIndex = frameIndex;
+    frame->timestampNs = timestampNs;
+    frame->stepMs = level->stepMs;
+    frame->currentStepMs = level->currentStepMs;
+    frame->stepAccumulator = level->stepAccumulator;
+    frame->score = level->score;
+    frame->paused = level->paused;
+    frame->gameOver = level->gameOver;
+
+    frame->worldWidth = level->world.size.x;
+    frame->worldHeight = level->world.size.y;
+    frame->worldHash = level->world.hash;
+    SDL_memcpy(frame->worldCells, level->world.data, level->world.size.x * level->world.size.y);
+
+    frame->playerX = level->player.position.x;
+    frame->playerY = level->player.position.y;
+    frame->playerDimX = level->player.data.dim.x;
+    frame->playerDimY = level->player.data.dim.y;
+    frame->playerValue = level->player.value;
+    SDL_memcpy(frame->playerGrid, level->player.data.grid, level->player.data.dim.x * level->player.data.dim.y);
+
+    for (uint32 i = 0; i < PIECE_PREVIEW_COUNT; ++i)
+    {
+        piece_t piece = PeekPieceQueue(&level->pieceQueue, i);
+        frame->previewKinds[i] = piece.kindId;
+        frame->previewValues[i] = piece.value;
+    }
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    header->frameCount.store(frameIndex + 1, std::memory_order_release);
+}
+
+bool ReadLatestFeedFrame(const feed_header_t *header, feed_frame_t *frame, uint32 *retries)
+{
+    *retries = 0;
+
+    for (;;)
+    {
+        uint64 frameCount = header->frameCount.load(std::memory_order_acquire);
+
+        if (!frameCount)
+        {
+            return false;
+        }
+
+        const feed_slot_t *slot = &header->slots[(frameCount - 1) & (FEED_SLOT_COUNT - 1)];
+        uint32 before = slot->sequence.load(std::memory_order_acquire);
+
+        if (!(before & 1))
+        {
+            SDL_memcpy(frame, &slot->frame, sizeof(feed_frame_t));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot->sequence.load(std::memory_order_relaxed) == before)
+            {
+                return true;
+            }
+        }
+
+        (*retries)++;
+    }
+}
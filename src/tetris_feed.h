@@ -0,0 +1,120 @@
+#if !defined(TETRIS_FEED_H)
+
+#include <atomic>
+#include "tetris_typedefs.h"
+#include "tetris_level.h"
+
+#define FEED_MAGIC SDL_FOURCC('T', 'T', 'F', 'D')
+#define FEED_VERSION 1
+#define FEED_DEFAULT_NAME "/tetris_feed"
+/**
+ * @note Must be a power of two. More slots make it less likely that a slow reader is lapped mid-read.
+ */
+#define FEED_SLOT_COUNT 8
+
+/**
+ * @brief Snapshot of one game for external tools.
+ * @note Native endianness and layout, producer and readers run on the same machine.
+ */
+struct feed_frame_t
+{
+    uint64 frameIndex;
+    /**
+     * @brief SDL_GetCurrentTime() at publish, wall clock so readers in other processes can compare it.
+     */
+    uint64 timestampNs;
+
+    uint64 stepMs;
+    uint64 currentStepMs;
+    uint64 stepAccumulator;
+    uint32 score;
+    uint8 paused;
+    uint8 gameOver;
+    uint8 reserved0[2];
+
+    int32 worldWidth;
+    int32 worldHeight;
+    uint64 worldHash;
+
+    int32 playerX;
+    int32 playerY;
+    int32 playerDimX;
+    int32 playerDimY;
+    uint8 playerValue;
+    uint8 previewKinds[PIECE_PREVIEW_COUNT];
+    uint8 previewValues[PIECE_PREVIEW_COUNT];
+    uint8 reserved1[5];
+
+    uint8 playerGrid[PLAYER_DATA_GRID_MAX_SIZE * PLAYER_DATA_GRID_MAX_SIZE];
+    uint8 worldCells[WORLD_MAX_CELL_COUNT];
+};
+
+/**
+ * @brief Seqlock slot: sequence is odd while the producer writes the frame.
+ */
+struct alignas(64) feed_slot_t
+{
+    std::atomic<uint32> sequence;
+    feed_frame_t frame;
+};
+
+/**
+ * @brief Layout of the shared memory object: this header followed by FEED_SLOT_COUNT slots.
+ * @note The producer never waits for readers and readers never write,
+ * a reader retries when its slot was rewritten while it copied it.
+ */
+struct alignas(64) feed_header_t
+{
+    uint32 magic;
+    uint32 version;
+    uint32 slotCount;
+    uint32 slotSize;
+    /**
+     * @brief Number of frames published, the latest one is in slot (frameCount - 1) % slotCount.
+     */
+    std::atomic<uint64> frameCount;
+    feed_slot_t slots[FEED_SLOT_COUNT];
+};
+
+static_assert(std::atomic<uint32>::is_always_lock_free && std::atomic<uint64>::is_always_lock_free,
+              "feed atomics are shared between processes and must not hide a lock");
+
+/**
+ * @brief Producer side, the shared memory stays mapped for the whole run.
+ */
+struct feed_t
+{
+    feed_header_t *header;
+    char name[64];
+};
+
+/**
+ * @note Creates or truncates the shared memory object name, POSIX only.
+ */
+bool OpenFeed(feed_t *feed, const char *name);
+
+/**
+ * @brief Unmaps and unlinks the shared memory object.
+ */
+void CloseFeed(feed_t *feed);
+
+/**
+ * @brief Writes level straight into the next slot, no locks, no syscalls.
+ */
+void PublishFeedFrame(feed_t *feed, const level_t *level, uint64 timestampNs);
+
+/**
+ * @brief Reader side: maps an existing feed read-only.
+ */
+const feed_header_t *MapFeed(const char *name);
+
+void UnmapFeed(const feed_header_t *header);
+
+/**
+ * @brief Copies the latest consistent frame.
+ * @return False if nothing was published yet.
+ */
+bool ReadLatestFeedFrame(const feed_header_t *header, feed_frame_t *frame, uint32 *retries);
+
+#define TETRIS_FEED_H
+#endif
@@ -25,7 +25,7 @@ struct fx_t
 
 struct fx_pool_t
 {
-    fx_t *fxs[MAX_FS_COUNT];
+    fx_t fxs[MAX_FS_COUNT];
 };
 
 void AddFx(fx_pool_t *fxPool, uint64 tickMs, vec2i_t size, uint8 textureCount, SDL_Texture **textures,
@@ -33,10 +33,9 @@ void AddFx(fx_pool_t *fxPool, uint64 tickMs, vec2i_t size, uint8 textureCount, S
 {
     for (uint8 i = 0; i < MAX_FS_COUNT; ++i)
     {
-        if (!fxPool->fxs[i] || !fxPool->fxs[i]->enabled)
+        if (!fxPool->fxs[i].enabled)
         {
-            fxPool->fxs[i] = (fx_t *)SDL_malloc(sizeof(fx_t));
-            fx_t *fx = fxPool->fxs[i];
+            fx_t *fx = &fxPool->fxs[i];
             fx->enabled = true;
             fx->startTimeMs = tickMs;
             fx->msPerFrame = 100;
@@ -80,12 +79,39 @@ void UpdateFxPool(fx_pool_t *fxPool, uint64 tickMs)
 {
     for (int i = 0; i < MAX_FS_COUNT; ++i)
     {
-        if (fxPool->fxs[i] && fxPool->fxs[i]->enabled)
+        if (fxPool->fxs[i].enabled)
         {
-            UpdateFx(fxPool->fxs[i], tickMs);
+            UpdateFx(&fxPool->fxs[i], tickMs);
         }
     }
 }
 
+/**
+ * @return SDL_RenderTexture calls made.
+ */
+uint32 RenderFxPool(SDL_Renderer *renderer, fx_pool_t *fxPool)
+{
+    uint32 renderCalls = 0;
+
+    for (int i = 0; i < MAX_FS_COUNT; ++i)
+    {
+        fx_t *fx = &fxPool->fxs[i];
+
+        if (fx->enabled)
+        {
+            SDL_FRect rect{
+                fx->startPosition.x + (fx->endPosition.x - fx->startPosition.x) * fx->progress,
+                fx->startPosition.y + (fx->endPosition.y - fx->startPosition.y) * fx->progress,
+                (real32)fx->size.w,
+                (real32)fx->size.h};
+
+            SDL_RenderTexture(renderer, fx->textures[fx->frameCount], nullptr, &rect);
+            renderCalls++;
+        }
+    }
+
+    return renderCalls;
+}
+
 #define TETRIS_FX_H
 #endif
\ No newline at end of file
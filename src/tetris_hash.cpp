@@ -0,0 +1,296 @@
+#include "tetris_hash.h"
+
+#define HASH_PIECE_ROW_COUNT (WORLD_MAX_HEIGHT + PLAYER_DATA_GRID_MAX_SIZE)
+
+struct hash_keys_t
+{
+    uint64 cells[WORLD_MAX_HEIGHT * WORLD_MAX_WIDTH];
+    /* Active piece cells, rows are shifted by PLAYER_DATA_GRID_MAX_SIZE since a spawning piece is above the world. */
+    uint64 pieceCells[HASH_PIECE_ROW_COUNT * WORLD_MAX_WIDTH];
+    uint64 preview[PIECE_PREVIEW_COUNT][PLAYER_DATA_MAX_KIND_COUNT];
+};
+
+static constexpr uint64 NextHashKey(uint64 *state)
+{
+    uint64 z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static constexpr hash_keys_t MakeHashKeys()
+{
+    hash_keys_t keys{};
+    uint64 state = 0x7E7815ull;
+
+    for (uint64 &key : keys.cells)
+    {
+        key = NextHashKey(&state);
+    }
+
+    for (uint64 &key : keys.pieceCells)
+    {
+        key = NextHashKey(&state);
+    }
+
+    for (int depth = 0; depth < PIECE_PREVIEW_COUNT; ++depth)
+    {
+        for (int kind = 0; kind < PLAYER_DATA_KIND_COUNT; ++kind)
+        {
+            keys.preview[depth][kind] = NextHashKey(&state);
+        }
+    }
+
+    /* Kinds past the classic set come last, so the classic keys stay what they were. */
+    for (int depth = 0; depth < PIECE_PREVIEW_COUNT; ++depth)
+    {
+        for (int kind = PLAYER_DATA_KIND_COUNT; kind < PLAYER_DATA_MAX_KIND_COUNT; ++kind)
+        {
+            keys.preview[depth][kind] = NextHashKey(&state);
+        }
+    }
+
+    return keys;
+}
+
+static constexpr hash_keys_t kHashKeys = MakeHashKeys();
+
+inline uint64 GetCellHashKey(vec2i_t position)
+{
+    SDL_assert(position.x >= 0 && position.x < WORLD_MAX_WIDTH);
+    SDL_assert(position.y >= 0 && position.y < WORLD_MAX_HEIGHT);
+    return kHashKeys.cells[position.y * WORLD_MAX_WIDTH + position.x];
+}
+
+uint64 ComputeWorldHash(world_t *world)
+{
+    uint64 hash = 0;
+
+    for (int y = 0; y < world->size.y; ++y)
+    {
+        for (int x = 0; x < world->size.x; ++x)
+        {
+            if (!IsValueEmpty(GetWorldValueUnchecked(world, {x, y})))
+            {
+                hash ^= GetCellHashKey({x, y});
+            }
+        }
+    }
+
+    return hash;
+}
+
+/**
+ * @brief XOR of the keys of the row's cells set in occupancy.
+ */
+static inline uint64 GetRowHashDeltaOfOccupancy(uint32 occupancy, int32 row)
+{
+    uint64 delta = 0;
+
+    while (occupancy)
+    {
+        delta ^= GetCellHashKey({(int32)CountTrailingZeros32(occupancy), row});
+        occupancy &= occupancy - 1;
+    }
+
+    return delta;
+}
+
+template <int32 W>
+uint64 GetRowCopyHashDeltaOfWidth(world_t *world, int32 dstRow, int32 srcRow)
+{
+    if constexpr (W > 0)
+    {
+        return GetRowHashDeltaOfOccupancy(GetRowOccupancyOfWidth<W>(world->data + dstRow * W) ^
+                                              GetRowOccupancyOfWidth<W>(world->data + srcRow * W),
+                                          dstRow);
+    }
+    else
+    {
+        const uint8 *dst = GetWorldRow(world, dstRow);
+        const uint8 *src = GetWorldRow(world, srcRow);
+        uint64 delta = 0;
+
+        for (int x = 0; x < world->size.x; ++x)
+        {
+            if (IsValueEmpty(dst[x]) != IsValueEmpty(src[x]))
+            {
+                delta ^= GetCellHashKey({x, dstRow});
+            }
+        }
+
+        return delta;
+    }
+}
+
+template <int32 W>
+uint64 GetRowClearHashDeltaOfWidth(world_t *world, int32 row)
+{
+    if constexpr (W > 0)
+    {
+        return GetRowHashDeltaOfOccupancy(GetRowOccupancyOfWidth<W>(world->data + row * W), row);
+    }
+    else
+    {
+        const uint8 *cells = GetWorldRow(world, row);
+        uint64 delta = 0;
+
+        for (int x = 0; x < world->size.x; ++x)
+        {
+            if (!IsValueEmpty(cells[x]))
+            {
+                delta ^= GetCellHashKey({x, row});
+            }
+        }
+
+        return delta;
+    }
+}
+
+uint64 GetRowCopyHashDelta(world_t *world, int32 dstRow, int32 srcRow)
+{
+    return GetRowCopyHashDeltaOfWidth<0>(world, dstRow, srcRow);
+}
+
+uint64 GetRowClearHashDelta(world_t *world, int32 row)
+{
+    return GetRowClearHashDeltaOfWidth<0>(world, row);
+}
+
+uint64 HashPlayer(player_t *player)
+{
+    uint64 hash = 0;
+
+    for (uint32 i = 0; i < player->data.cellCount; ++i)
+    {
+        vec2i_t position = player->position + GetPlayerCell(&player->data, i) + vec2i_t{0, PLAYER_DATA_GRID_MAX_SIZE};
+        SDL_assert(position.x >= 0 && position.x < WORLD_MAX_WIDTH);
+        SDL_assert(position.y >= 0 && position.y < HASH_PIECE_ROW_COUNT);
+        hash ^= kHashKeys.pieceCells[position.y * WORLD_MAX_WIDTH + position.x];
+    }
+
+    return hash;
+}
+
+uint64 HashPiecePreview(const piece_queue_t *queue)
+{
+    uint64 hash = 0;
+
+    for (uint32 depth = 0; depth < PIECE_PREVIEW_COUNT; ++depth)
+    {
+        hash ^= kHashKeys.preview[depth][PeekPieceQueue(queue, depth).kindId];
+    }
+
+    return hash;
+}
+
+uint64 HashPosition(world_t *world, player_t *player, const piece_queue_t *queue)
+{
+    return world->hash ^ HashPlayer(player) ^ HashPiecePreview(queue);
+}
+
+bool InitTranspositionTable(transposition_table_t *table, uint64 sizeBytes)
+{
+    uint64 bucketCount = 1;
+
+    while (bucketCount * 2 * sizeof(transposition_bucket_t) <= sizeBytes)
+    {
+        bucketCount *= 2;
+    }
+
+    table->buckets = (transposition_bucket_t *)SDL_aligned_alloc(alignof(transposition_bucket_t),
+                                                                 bucketCount * sizeof(transposition_bucket_t));
+    table->bucketMask = bucketCount - 1;
+
+    if (!table->buckets)
+    {
+        return false;
+    }
+
+    ClearTranspositionTable(table);
+    return true;
+}
+
+void FreeTranspositionTable(transposition_table_t *table)
+{
+    SDL_aligned_free(table->buckets);
+    table->buckets = nullptr;
+}
+
+void ClearTranspositionTable(transposition_table_t *table)
+{
+    for (uint64 i = 0; i <= table->bucketMask; ++i)
+    {
+        for (transposition_entry_t &entry : table->buckets[i].entries)
+        {
+            entry.check.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool ProbeTranspositionTable(transposition_table_t *table, uint64 key, uint64 *data, transposition_stats_t *stats)
+{
+    transposition_bucket_t *bucket = &table->buckets[key & table->bucketMask];
+
+    if (stats)
+    {
+        stats->probes++;
+    }
+
+    for (transposition_entry_t &entry : bucket->entries)
+    {
+        uint64 entryData = entry.data.load(std::memory_order_relaxed);
+
+        if ((entry.check.load(std::memory_order_relaxed) ^ entryData) == key && entryData)
+        {
+            *data = entryData;
+
+            if (stats)
+            {
+                stats->hits++;
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void StoreTranspositionTable(transposition_table_t *table, uint64 key, uint64 data, transposition_stats_t *stats)
+{
+    SDL_assert(data != 0);
+
+    transposition_bucket_t *bucket = &table->buckets[key & table->bucketMask];
+    transposition_entry_t *victim = &bucket->entries[0];
+    uint8 victimPriority = 0xFF;
+
+    for (transposition_entry_t &entry : bucket->entries)
+    {
+        uint64 entryData = entry.data.load(std::memory_order_relaxed);
+        uint64 entryKey = entry.check.load(std::memory_order_relaxed) ^ entryData;
+
+        if (!entryData || entryKey == key)
+        {
+            victim = &entry;
+            victimPriority = 0;
+            break;
+        }
+
+        if ((uint8)entryData < victimPriority)
+        {
+            victim = &entry;
+            victimPriority = (uint8)entryData;
+        }
+    }
+
+    if (stats)
+    {
+        stats->stores++;
+        stats->replacements += victimPriority != 0;
+    }
+
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+}
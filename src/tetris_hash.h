@@ -0,0 +1,97 @@
+#if !defined(TETRIS_HASH_H)
+
+#include <atomic>
+#include "tetris_typedefs.h"
+#include "tetris_world.h"
+#include "tetris_player.h"
+#include "tetris_random.h"
+
+/**
+ * @brief Zobrist key of an occupied world cell.
+ * @note Only occupancy is hashed, values are cosmetic and don't change the position.
+ */
+uint64 GetCellHashKey(vec2i_t position);
+
+/**
+ * @brief Full rehash, world_t::hash is kept up to date incrementally and must always equal it.
+ */
+uint64 ComputeWorldHash(world_t *world);
+
+/**
+ * @brief Hash delta of copying srcRow over dstRow, XORs only the cells whose occupancy changes.
+ */
+uint64 GetRowCopyHashDelta(world_t *world, int32 dstRow, int32 srcRow);
+
+uint64 GetRowClearHashDelta(world_t *world, int32 row);
+
+/**
+ * @brief The row deltas for a world W cells wide, or world->size.x wide when W is 0.
+ */
+template <int32 W>
+uint64 GetRowCopyHashDeltaOfWidth(world_t *world, int32 dstRow, int32 srcRow);
+
+template <int32 W>
+uint64 GetRowClearHashDeltaOfWidth(world_t *world, int32 row);
+
+uint64 HashPlayer(player_t *player);
+
+uint64 HashPiecePreview(const piece_queue_t *queue);
+
+/**
+ * @brief Identity of the board, the active piece and the preview.
+ */
+uint64 HashPosition(world_t *world, player_t *player, const piece_queue_t *queue);
+
+#define TRANSPOSITION_BUCKET_SIZE 4
+
+/**
+ * @brief Lockless entry, key is stored XORed with data so a torn write reads as a miss.
+ */
+struct transposition_entry_t
+{
+    std::atomic<uint64> check;
+    std::atomic<uint64> data;
+};
+
+struct alignas(64) transposition_bucket_t
+{
+    transposition_entry_t entries[TRANSPOSITION_BUCKET_SIZE];
+};
+
+/**
+ * @brief Fixed size table that search threads share without locking.
+ * @note The low byte of the stored data is its replacement priority (e.g. search depth),
+ * the rest is free for the caller.
+ */
+struct transposition_table_t
+{
+    transposition_bucket_t *buckets;
+    uint64 bucketMask;
+};
+
+/**
+ * @brief Per-thread counters, kept outside of the table so threads don't share a cache line.
+ */
+struct transposition_stats_t
+{
+    uint64 probes;
+    uint64 hits;
+    uint64 stores;
+    uint64 replacements;
+};
+
+/**
+ * @note sizeBytes is rounded down to a power of two number of buckets.
+ */
+bool InitTranspositionTable(transposition_table_t *table, uint64 sizeBytes);
+
+void FreeTranspositionTable(transposition_table_t *table);
+
+void ClearTranspositionTable(transposition_table_t *table);
+
+bool ProbeTranspositionTable(transposition_table_t *table, uint64 key, uint64 *data, transposition_stats_t *stats);
+
+void StoreTranspositionTable(transposition_table_t *table, uint64 key, uint64 data, transposition_stats_t *stats);
+
+#define TETRIS_HASH_H
+#endif
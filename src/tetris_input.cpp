@@ -51,4 +51,28 @@ void FlushInput(game_input_t *input)
     input->right.transitionCount = 0;
     input->down.transitionCount = 0;
     input->rotate.transitionCount = 0;
+}
+
+uint16 PackGameInput(const game_input_t *input)
+{
+    uint16 packed = 0;
+
+    for (int i = 0; i < (int)SDL_arraysize(input->buttons); ++i)
+    {
+        const game_input_button_t *button = &input->buttons[i];
+        uint16 transitionCount = SDL_min(button->transitionCount, INPUT_PACKED_MAX_TRANSITIONS);
+        packed |= (uint16)(((button->isDown ? 1 : 0) | (transitionCount << 1)) << (i * INPUT_PACKED_BUTTON_BITS));
+    }
+
+    return packed;
+}
+
+void UnpackGameInput(uint16 packed, game_input_t *input)
+{
+    for (int i = 0; i < (int)SDL_arraysize(input->buttons); ++i)
+    {
+        uint16 bits = (packed >> (i * INPUT_PACKED_BUTTON_BITS)) & ((1 << INPUT_PACKED_BUTTON_BITS) - 1);
+        input->buttons[i].isDown = bits & 1;
+        input->buttons[i].transitionCount = (uint8)(bits >> 1);
+    }
 }
\ No newline at end of file
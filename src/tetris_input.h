@@ -35,5 +35,19 @@ bool WasInputButtonPressedOnce(const game_input_button_t *button);
 
 void FlushInput(game_input_t *input);
 
+#define INPUT_PACKED_BUTTON_BITS 4
+#define INPUT_PACKED_MAX_TRANSITIONS 7
+
+/**
+ * @brief 4 bits per button: isDown and a transition count clamped to 7.
+ * @note The packed form is what versus mode sends, predicts and replays.
+ */
+uint16 PackGameInput(const game_input_t *input);
+
+/**
+ * @note gamepadId is left untouched.
+ */
+void UnpackGameInput(uint16 packed, game_input_t *input);
+
 #define TETRIS_INPUT_H
 #endif
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "tetris_jobs.h"
+
+inline uint64 PackJobRange(uint32 begin, uint32 end)
+{
+    return ((uint64)end << 32) | begin;
+}
+
+static bool TakeJob(job_queue_t *queue, uint32 *index)
+{
+    uint64 range = queue->range.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        uint32 begin = (uint32)range;
+        uint32 end = (uint32)(range >> 32);
+
+        if (begin >= end)
+        {
+            return false;
+        }
+
+        if (queue->range.compare_exchange_weak(range, PackJobRange(begin + 1, end), std::memory_order_acq_rel,
+                                               std::memory_order_acquire))
+        {
+            *index = begin;
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Moves the upper half of victim's range into queue, which must be empty, and takes its first job.
+ */
+static bool StealJobs(job_queue_t *victim, job_queue_t *queue, uint32 *index)
+{
+    uint64 range = victim->range.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        uint32 begin = (uint32)range;
+        uint32 end = (uint32)(range >> 32);
+
+        if (begin >= end)
+        {
+            return false;
+        }
+
+        uint32 middle = begin + (end - begin) / 2;
+
+        if (victim->range.compare_exchange_weak(range, PackJobRange(begin, middle), std::memory_order_acq_rel,
+                                                std::memory_order_acquire))
+        {
+            *index = middle;
+            queue->range.store(PackJobRange(middle + 1, end), std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Runs jobs until no queue has any left. A thread only returns once everything it took
+ * is done, so the batch is complete when every thread has returned.
+ */
+static void WorkOnJobs(job_pool_t *pool, uint32 thread)
+{
+    job_queue_t *queue = &pool->queues[thread];
+    job_thread_stats_t *stats = &pool->stats[thread];
+    uint32 index;
+
+    for (;;)
+    {
+        bool found = TakeJob(queue, &index);
+
+        for (uint32 i = 1; !found && i < pool->threadCount; ++i)
+        {
+            found = StealJobs(&pool->queues[(thread + i) % pool->threadCount], queue, &index);
+            stats->steals += found ? 1 : 0;
+        }
+
+        if (!found)
+        {
+            return;
+        }
+
+        /* Taking a job orders this read after RunJobs published the batch. */
+        pool->function(pool->data, index, thread);
+        stats->executed++;
+    }
+}
+
+static int SDLCALL RunJobWorker(void *data)
+{
+    job_pool_t *pool = (job_pool_t *)data;
+    uint32 thread = pool->nextThread.fetch_add(1);
+    uint64 generation = 0;
+
+    for (;;)
+    {
+        SDL_LockMutex(pool->mutex);
+
+        while (pool->generation == generation && !pool->quit)
+        {
+            SDL_WaitCondition(pool->started, pool->mutex);
+        }
+
+        generation = pool->generation;
+        bool quit = pool->quit;
+        SDL_UnlockMutex(pool->mutex);
+
+        if (quit)
+        {
+            return 0;
+        }
+
+        WorkOnJobs(pool, thread);
+
+        SDL_LockMutex(pool->mutex);
+
+        if (--pool->busyWorkers == 0)
+        {
+            SDL_SignalCondition(pool->finished);
+        }
+
+        SDL_UnlockMutex(pool->mutex);
+    }
+}
+
+bool InitJobPool(job_pool_t *pool, uint32 threadCount)
+{
+    /* The atomics make the pool non-trivial, it is value-initialised in place instead of cleared with memset. */
+    new (pool) job_pool_t{};
+    pool->threadCount = SDL_clamp(threadCount, 1u, (uint32)JOB_MAX_THREADS);
+    pool->mutex = SDL_CreateMutex();
+    pool->started = SDL_CreateCondition();
+    pool->finished = SDL_CreateCondition();
+
+    if (!pool->mutex || !pool->started || !pool->finished)
+    {
+        FreeJobPool(pool);
+        return false;
+    }
+
+    /* Workers number themselves from 1, the caller of RunJobs is thread 0. */
+    pool->nextThread.store(1);
+
+    for (uint32 thread = 1; thread < pool->threadCount; ++thread)
+    {
+        pool->threads[thread] = SDL_CreateThread(RunJobWorker, "jobs", pool);
+
+        if (!pool->threads[thread])
+        {
+            FreeJobPool(pool);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FreeJobPool(job_pool_t *pool)
+{
+    if (pool->mutex)
+    {
+        SDL_LockMutex(pool->mutex);
+        pool->quit = true;
+        SDL_BroadcastCondition(pool->started);
+        SDL_UnlockMutex(pool->mutex);
+    }
+
+    for (uint32 thread = 1; thread < JOB_MAX_THREADS; ++thread)
+    {
+        if (pool->threads[thread])
+        {
+            SDL_WaitThread(pool->threads[thread], nullptr);
+            pool->threads[thread] = nullptr;
+        }
+    }
+
+    SDL_DestroyCondition(pool->finished);
+    SDL_DestroyCondition(pool->started);
+    SDL_DestroyMutex(pool->mutex);
+    pool->finished = nullptr;
+    pool->started = nullptr;
+    pool->mutex = nullptr;
+}
+
+void RunJobs(job_pool_t *pool, job_function_t *function, void *data, uint32 count)
+{
+    pool->function = function;
+    pool->data = data;
+
+    for (uint32 thread = 0; thread < pool->threadCount; ++thread)
+    {
+        uint32 begin = (uint32)((uint64)count * thread / pool->threadCount);
+        uint32 end = (uint32)((uint64)count * (thread + 1) / pool->threadCount);
+        pool->queues[thread].range.store(PackJobRange(begin, end), std::memory_order_release);
+    }
+
+    SDL_LockMutex(pool->mutex);
+    pool->generation++;
+    pool->busyWorkers = pool->threadCount - 1;
+    SDL_BroadcastCondition(pool->started);
+    SDL_UnlockMutex(pool->mutex);
+
+    WorkOnJobs(pool, 0);
+
+    SDL_LockMutex(pool->mutex);
+
+    while (pool->busyWorkers)
+    {
+        SDL_WaitCondition(pool->finished, pool->mutex);
+    }
+
+    SDL_UnlockMutex(pool->mutex);
+}
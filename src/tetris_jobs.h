@@ -0,0 +1,76 @@
+#if !defined(TETRIS_JOBS_H)
+
+#include <atomic>
+#include <new>
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+
+#define JOB_MAX_THREADS 32
+
+/**
+ * @param thread Index of the executing thread, 0 is the thread that called RunJobs.
+ */
+typedef void job_function_t(void *data, uint32 index, uint32 thread);
+
+/**
+ * @brief A thread's share of the current batch: job indices [begin, end) packed as end << 32 | begin.
+ * @note The owner takes from begin, thieves split off the upper half, both with one CAS.
+ */
+struct alignas(64) job_queue_t
+{
+    std::atomic<uint64> range;
+};
+
+struct alignas(64) job_thread_stats_t
+{
+    uint64 executed;
+    /**
+     * @brief Successful steals, each moves half of a victim's remaining range.
+     */
+    uint64 steals;
+};
+
+/**
+ * @brief Fixed set of worker threads running index-parallel batches with work stealing.
+ * @note Every batch is split evenly up front, a thread that runs dry steals half of the
+ * busiest-looking range it finds, so uneven jobs still finish together.
+ */
+struct job_pool_t
+{
+    uint32 threadCount;
+    SDL_Thread *threads[JOB_MAX_THREADS];
+
+    SDL_Mutex *mutex;
+    SDL_Condition *started;
+    SDL_Condition *finished;
+    uint64 generation;
+    /**
+     * @brief Workers still inside the current batch, RunJobs returns at 0 so no worker
+     * can carry a stolen range over into the next batch.
+     */
+    uint32 busyWorkers;
+    bool quit;
+    std::atomic<uint32> nextThread;
+
+    job_function_t *function;
+    void *data;
+
+    job_queue_t queues[JOB_MAX_THREADS];
+    job_thread_stats_t stats[JOB_MAX_THREADS];
+};
+
+/**
+ * @param threadCount Threads working on a batch, the caller included, so threadCount - 1 are started.
+ */
+bool InitJobPool(job_pool_t *pool, uint32 threadCount);
+
+void FreeJobPool(job_pool_t *pool);
+
+/**
+ * @brief Calls function(data, i, thread) for every i in [0, count) and returns once all are done.
+ * @note The calling thread works on the batch too. Not reentrant.
+ */
+void RunJobs(job_pool_t *pool, job_function_t *function, void *data, uint32 count);
+
+#define TETRIS_JOBS_H
+#endif
@@ -0,0 +1,235 @@
+#include "tetris_latency.h"
+
+void InitLatencyTracker(latency_tracker_t *tracker, const char *settings)
+{
+    SDL_zerop(tracker);
+    tracker->minNs = ~0ull;
+    SDL_strlcpy(tracker->settings, settings, sizeof(tracker->settings));
+}
+
+void TagLatencyPress(latency_tracker_t *tracker, uint64 eventNs)
+{
+    if (tracker->pendingCount == LATENCY_MAX_PENDING)
+    {
+        tracker->overflowed++;
+        return;
+    }
+
+    latency_probe_t *probe = &tracker->pending[tracker->pendingCount++];
+    SDL_zerop(probe);
+    uint64 now = SDL_GetTicksNS();
+    /* Events without a timestamp count from the handler. */
+    probe->stageNs[LATENCY_STAGE_EVENT] = eventNs && eventNs <= now ? eventNs : now;
+    probe->stageNs[LATENCY_STAGE_HANDLED] = now;
+}
+
+void ApplyLatencyInput(latency_tracker_t *tracker)
+{
+    uint64 now = SDL_GetTicksNS();
+
+    for (uint32 i = 0; i < tracker->pendingCount; ++i)
+    {
+        latency_probe_t *probe = &tracker->pending[i];
+
+        if (!probe->stageNs[LATENCY_STAGE_APPLIED])
+        {
+            probe->stageNs[LATENCY_STAGE_APPLIED] = now;
+        }
+    }
+}
+
+void ResolveLatencyInput(latency_tracker_t *tracker, bool moved)
+{
+    uint64 now = SDL_GetTicksNS();
+    uint32 kept = 0;
+
+    for (uint32 i = 0; i < tracker->pendingCount; ++i)
+    {
+        latency_probe_t probe = tracker->pending[i];
+
+        if (!probe.stageNs[LATENCY_STAGE_MOVED])
+        {
+            /* The frame flushed the input, a press it didn't act on never will be. */
+            if (!moved || !probe.stageNs[LATENCY_STAGE_APPLIED])
+            {
+                tracker->noEffect++;
+                continue;
+            }
+
+            probe.stageNs[LATENCY_STAGE_MOVED] = now;
+        }
+
+        tracker->pending[kept++] = probe;
+    }
+
+    tracker->pendingCount = kept;
+}
+
+void PresentLatencyFrame(latency_tracker_t *tracker)
+{
+    if (!tracker->pendingCount)
+    {
+        return;
+    }
+
+    uint64 now = SDL_GetTicksNS();
+
+    for (uint32 i = 0; i < tracker->pendingCount; ++i)
+    {
+        latency_probe_t *probe = &tracker->pending[i];
+        probe->stageNs[LATENCY_STAGE_PRESENTED] = now;
+
+        for (uint32 stage = LATENCY_STAGE_HANDLED; stage < LATENCY_STAGE_COUNT; ++stage)
+        {
+            tracker->stageNs[stage] += probe->stageNs[stage] - probe->stageNs[stage - 1];
+        }
+
+        uint64 latencyNs = now - probe->stageNs[LATENCY_STAGE_EVENT];
+        tracker->histogram[SDL_min(latencyNs / LATENCY_BUCKET_NS, (uint64)LATENCY_BUCKET_COUNT - 1)]++;
+        tracker->minNs = SDL_min(tracker->minNs, latencyNs);
+        tracker->maxNs = SDL_max(tracker->maxNs, latencyNs);
+        tracker->count++;
+    }
+
+    tracker->pendingCount = 0;
+}
+
+static Uint64 SDLCALL PushLatencySynthEvents(void *userdata, SDL_TimerID timerID, Uint64 interval)
+{
+    latency_tracker_t *tracker = (latency_tracker_t *)userdata;
+    SDL_Event event;
+    SDL_zero(event);
+    event.key.scancode = (tracker->synthPresses++ & 1) ? SDL_SCANCODE_RIGHT : SDL_SCANCODE_LEFT;
+
+    /* Released right away, a press and release in one frame still counts as a press. */
+    for (uint32 i = 0; i < 2; ++i)
+    {
+        bool down = i == 0;
+        event.type = down ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+        event.key.down = down;
+        event.key.timestamp = SDL_GetTicksNS();
+        SDL_PushEvent(&event);
+    }
+
+    return interval;
+}
+
+bool StartLatencySynth(latency_tracker_t *tracker, uint32 hz)
+{
+    if (!hz)
+    {
+        return SDL_SetError("The synthetic press rate must be above 0");
+    }
+
+    tracker->synthTimer = SDL_AddTimerNS(SDL_NS_PER_SECOND / hz, PushLatencySynthEvents, tracker);
+    return tracker->synthTimer != 0;
+}
+
+void StopLatencySynth(latency_tracker_t *tracker)
+{
+    if (tracker->synthTimer)
+    {
+        SDL_RemoveTimer(tracker->synthTimer);
+        tracker->synthTimer = 0;
+    }
+}
+
+/**
+ * @brief Upper edge of the bucket holding the percentile, the exact maximum for the overflow bucket.
+ */
+static real32 GetLatencyMs(const latency_tracker_t *tracker, uint32 percentile)
+{
+    uint64 rank = (tracker->count * percentile + 99) / 100;
+    uint64 seen = 0;
+
+    for (uint32 bucket = 0; bucket < LATENCY_BUCKET_COUNT - 1; ++bucket)
+    {
+        seen += tracker->histogram[bucket];
+
+        if (rank && seen >= rank)
+        {
+            return (real32)SDL_min((uint64)(bucket + 1) * LATENCY_BUCKET_NS, tracker->maxNs) / 1e6f;
+        }
+    }
+
+    return (real32)tracker->maxNs / 1e6f;
+}
+
+/**
+ * @brief Two lines: the percentiles, then the mean time spent between stages.
+ */
+static void FormatLatencyStats(const latency_tracker_t *tracker, char *summary, char *stages, uint64 size)
+{
+    real64 count = (real64)SDL_max(tracker->count, (uint64)1);
+    SDL_snprintf(summary, size,
+                 "latency (%s): %llu presses, min %.2f, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f ms; "
+                 "%llu without effect, %llu not measured",
+                 tracker->settings, (unsigned long long)tracker->count,
+                 tracker->count ? tracker->minNs / 1e6 : 0.0, GetLatencyMs(tracker, 50), GetLatencyMs(tracker, 95),
+                 GetLatencyMs(tracker, 99), tracker->maxNs / 1e6, (unsigned long long)tracker->noEffect,
+                 (unsigned long long)tracker->overflowed);
+    SDL_snprintf(stages, size, "mean ms: event +%.2f handled +%.2f applied +%.2f moved +%.2f presented",
+                 tracker->stageNs[LATENCY_STAGE_HANDLED] / count / 1e6,
+                 tracker->stageNs[LATENCY_STAGE_APPLIED] / count / 1e6,
+                 tracker->stageNs[LATENCY_STAGE_MOVED] / count / 1e6,
+                 tracker->stageNs[LATENCY_STAGE_PRESENTED] / count / 1e6);
+}
+
+uint32 RenderLatencyOverlay(SDL_Renderer *renderer, const latency_tracker_t *tracker, vec2_t position)
+{
+    char summary[256];
+    char stages[256];
+    FormatLatencyStats(tracker, summary, stages, sizeof(summary));
+
+    const uint32 bucketsPerBar = LATENCY_BUCKET_COUNT / LATENCY_OVERLAY_BARS;
+    const real32 barWidth = 6.0f;
+    const real32 barsHeight = 80.0f;
+    const real32 lineHeight = 12.0f;
+    uint64 bars[LATENCY_OVERLAY_BARS] = {};
+    uint64 tallest = 1;
+
+    for (uint32 bar = 0; bar < LATENCY_OVERLAY_BARS; ++bar)
+    {
+        for (uint32 bucket = bar * bucketsPerBar; bucket < (bar + 1) * bucketsPerBar; ++bucket)
+        {
+            bars[bar] += tracker->histogram[bucket];
+        }
+
+        tallest = SDL_max(tallest, bars[bar]);
+    }
+
+    real32 baseline = position.y + 2.0f * lineHeight + barsHeight;
+    SDL_FRect rects[LATENCY_OVERLAY_BARS];
+
+    for (uint32 bar = 0; bar < LATENCY_OVERLAY_BARS; ++bar)
+    {
+        real32 height = barsHeight * bars[bar] / tallest;
+        rects[bar] = {position.x + bar * barWidth, baseline - height, barWidth - 1.0f, height};
+    }
+
+    char axis[64];
+    SDL_snprintf(axis, sizeof(axis), "0 .. %u ms, the last bar takes slower presses",
+                 (uint32)((uint64)LATENCY_BUCKET_COUNT * LATENCY_BUCKET_NS / 1000000));
+
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    SDL_RenderDebugText(renderer, position.x, position.y, summary);
+    SDL_RenderDebugText(renderer, position.x, position.y + lineHeight, stages);
+    SDL_RenderDebugText(renderer, position.x, baseline + 4.0f, axis);
+    SDL_SetRenderDrawColor(renderer, 0x60, 0xD0, 0xFF, 0xFF);
+    SDL_RenderFillRects(renderer, rects, LATENCY_OVERLAY_BARS);
+    return 4;
+}
+
+void LogLatencyStats(const latency_tracker_t *tracker)
+{
+    if (!tracker->count && !tracker->noEffect)
+    {
+        return;
+    }
+
+    char summary[256];
+    char stages[256];
+    FormatLatencyStats(tracker, summary, stages, sizeof(summary));
+    SDL_Log("%s", summary);
+    SDL_Log("%s", stages);
+}
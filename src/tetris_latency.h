@@ -0,0 +1,139 @@
+#if !defined(TETRIS_LATENCY_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+#include "tetris_math.h"
+
+/**
+ * @brief Press-to-present histogram: 250 us buckets up to 64 ms, the last bucket takes everything slower.
+ */
+#define LATENCY_BUCKET_NS 250000
+#define LATENCY_BUCKET_COUNT 256
+/**
+ * @brief Presses waiting for the frame that shows them, more in flight are not measured.
+ */
+#define LATENCY_MAX_PENDING 32
+#define LATENCY_SYNTH_DEFAULT_HZ 20
+#define LATENCY_SETTINGS_SIZE 64
+/**
+ * @brief Overlay bars, each covers LATENCY_BUCKET_COUNT / LATENCY_OVERLAY_BARS buckets.
+ */
+#define LATENCY_OVERLAY_BARS 64
+
+/**
+ * @brief Where a press is timestamped on its way to the screen.
+ */
+enum eLatencyStage
+{
+    /**
+     * @brief The SDL event timestamp, when the OS reported the press.
+     */
+    LATENCY_STAGE_EVENT = 0,
+    /**
+     * @brief HandleKeyboardEvent or HandleGamepadButtonEvent set the button.
+     */
+    LATENCY_STAGE_HANDLED,
+    /**
+     * @brief The frame's input went into ApplyLevelInput.
+     */
+    LATENCY_STAGE_APPLIED,
+    /**
+     * @brief MovePlayer moved or rotated the piece.
+     */
+    LATENCY_STAGE_MOVED,
+    /**
+     * @brief SDL_RenderPresent of the first frame showing the move returned.
+     */
+    LATENCY_STAGE_PRESENTED,
+    LATENCY_STAGE_COUNT,
+};
+
+struct latency_probe_t
+{
+    uint64 stageNs[LATENCY_STAGE_COUNT];
+};
+
+/**
+ * @brief Follows every movement press through the frame loop and keeps the event to present times.
+ * @note Main thread only, except for synthPresses which the synthetic press timer owns.
+ */
+struct latency_tracker_t
+{
+    latency_probe_t pending[LATENCY_MAX_PENDING];
+    uint32 pendingCount;
+
+    uint64 histogram[LATENCY_BUCKET_COUNT];
+    uint64 count;
+    uint64 minNs;
+    uint64 maxNs;
+    /**
+     * @brief Time from the previous stage, summed over the measured presses.
+     */
+    uint64 stageNs[LATENCY_STAGE_COUNT];
+    /**
+     * @brief Presses that changed nothing: into a wall, while paused or after the game ended.
+     */
+    uint64 noEffect;
+    /**
+     * @brief Presses not measured because LATENCY_MAX_PENDING were in flight.
+     */
+    uint64 overflowed;
+
+    /**
+     * @brief Draw the overlay, toggled by the player.
+     */
+    bool visible;
+    /**
+     * @brief VSync and pacing the numbers were taken with, shown with them.
+     */
+    char settings[LATENCY_SETTINGS_SIZE];
+
+    SDL_TimerID synthTimer;
+    /**
+     * @brief Timer thread only, odd presses go right.
+     */
+    uint32 synthPresses;
+};
+
+void InitLatencyTracker(latency_tracker_t *tracker, const char *settings);
+
+/**
+ * @brief Starts measuring a press.
+ * @param eventNs The SDL event timestamp, SDL_GetTicksNS() based.
+ */
+void TagLatencyPress(latency_tracker_t *tracker, uint64 eventNs);
+
+/**
+ * @brief The pending presses go into this frame's input, call right before the level is stepped.
+ */
+void ApplyLatencyInput(latency_tracker_t *tracker);
+
+/**
+ * @brief Presses applied this frame either wait for the present or, if nothing moved, are dropped.
+ * @param moved LEVEL_EVENT_PLAYER_MOVED was set.
+ */
+void ResolveLatencyInput(latency_tracker_t *tracker, bool moved);
+
+/**
+ * @brief Completes the presses shown by the frame just presented, call after SDL_RenderPresent.
+ */
+void PresentLatencyFrame(latency_tracker_t *tracker);
+
+/**
+ * @brief Pushes a left or right press and release every 1 / hz seconds from SDL's timer thread.
+ * @note The events go through the same queue and handlers as real ones, the piece steps back and forth.
+ */
+bool StartLatencySynth(latency_tracker_t *tracker, uint32 hz);
+
+void StopLatencySynth(latency_tracker_t *tracker);
+
+/**
+ * @brief Percentiles, the stage breakdown and the histogram as bars, drawn from position down.
+ * @return SDL_Render calls made.
+ */
+uint32 RenderLatencyOverlay(SDL_Renderer *renderer, const latency_tracker_t *tracker, vec2_t position);
+
+void LogLatencyStats(const latency_tracker_t *tracker);
+
+#define TETRIS_LATENCY_H
+#endif
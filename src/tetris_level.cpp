@@ -1,5 +1,13 @@
+#include <type_traits>
 #include "tetris_level.h"
 
+static_assert(std::is_trivially_copyable<level_t>::value, "level_t must stay a plain relocatable block");
+
+inline void CopyLevel(level_t *dst, const level_t *src)
+{
+    SDL_memcpy(dst, src, sizeof(level_t));
+}
+
 void ResumeLevel(level_t *level)
 {
     level->paused = false;
@@ -31,9 +39,10 @@ void SetLevelGameOver(level_t *level)
     level->paused = false;
 }
 
-void MovePlayer(world_t *world, player_t *player, game_input_t *input)
+bool MovePlayer(world_t *world, player_t *player, game_input_t *input)
 {
     vec2i_t newPosition = player->position;
+    bool moved = false;
 
     /**
      * @todo Handle holding buttons
@@ -53,15 +62,18 @@ void MovePlayer(world_t *world, player_t *player, game_input_t *input)
     newPosition.x += GetInputButtonDownCount(&input->right);
 #endif
 
-    if (IsPlayerPositionValid(world, &player->data, newPosition))
+    if (newPosition.x != player->position.x && IsPlayerPositionValid(world, &player->data, newPosition))
     {
         player->position = newPosition;
+        moved = true;
     }
 
     if (WasInputButtonPressedOnce(&input->rotate))
     {
-        RotatePlayer(world, player);
+        moved = RotatePlayer(world, player) || moved;
     }
+
+    return moved;
 }
 
 bool CheckGameOver(world_t *world, player_t *player)
@@ -84,36 +96,12 @@ bool CheckGameOver(world_t *world, player_t *player)
 
 uint8 DestroyFilledRows(world_t *world)
 {
-    uint8 destroyedRows = 0;
-
-    for (int8 y = world->size.y - 1; y >= 0; --y)
-    {
-        if (IsWorldRowFilled(world, y))
-        {
-            destroyedRows++;
-
-            /**
-             * @todo Destroy rows after animation
-             */
-
-            for (int8 row = y; row > 0; --row)
-            {
-                for (int x = 0; x < world->size.x; ++x)
-                {
-                    SetWorldValueUnchecked(world, {x, row}, GetWorldValueUnchecked(world, {x, row - 1}));
-                }
-            }
-
-            for (int x = 0; x < world->size.x; ++x)
-            {
-                SetWorldValueUnchecked(world, {x, 0}, 0);
-            }
-
-            y++;
-        }
-    }
-
-    return destroyedRows;
+    /**
+     * @todo Destroy rows after animation
+     */
+    uint32 rowsMask = GetFilledRowsMask(world);
+    RemoveWorldRows(world, rowsMask);
+    return (uint8)CountSetBits32(rowsMask);
 }
 
 void ResetLevel(level_t *level)
@@ -128,7 +116,7 @@ void Restart(level_t *level)
 {
     ResetLevel(level);
     ResetWorld(&level->world);
-    SpawnPlayer(&level->world, &level->player);
+    SpawnLevelPlayer(level);
 
     /**
      * @todo Gamepad LED and Music
@@ -148,17 +136,113 @@ void Restart(level_t *level)
 #endif
 }
 
-void ApplyLevelInput(level_t *level, uint64 dt, game_input_t *input)
+void SpawnLevelPlayer(level_t *level)
+{
+    SpawnPlayer(&level->world, &level->player, PopPieceQueue(&level->pieceQueue));
+}
+
+bool ApplyLevelInput(level_t *level, uint64 dt, game_input_t *input)
 {
+    bool moved = false;
+
     if (!level->paused && !level->gameOver)
     {
-        MovePlayer(&level->world, &level->player, input);
+        moved = MovePlayer(&level->world, &level->player, input);
         level->currentStepMs = input->down.isDown ? MIN_STEP_MS : level->stepMs;
     }
+
+    return moved;
 }
 
-void DoLevelStep(level_t *level, game_input_t *input, uint64 dt)
+static void FinishLevelLock(level_t *level, uint32 clearedRowsMask, level_events_t *events)
 {
+    uint8 destroyedRows = (uint8)CountSetBits32(clearedRowsMask);
+    level->score += destroyedRows * SCORE_PER_ROW;
+    SpawnLevelPlayer(level);
+
+    if (destroyedRows)
+    {
+        level->stepMs = SDL_max(MIN_STEP_MS, level->stepMs - DELTA_STEP_MS);
+    }
+
+    if (CheckGameOver(&level->world, &level->player))
+    {
+        SetLevelGameOver(level);
+    }
+
+    if (events)
+    {
+        events->flags |= LEVEL_EVENT_PIECE_LOCKED;
+        events->flags |= destroyedRows ? LEVEL_EVENT_ROWS_CLEARED : 0;
+        events->flags |= level->gameOver ? LEVEL_EVENT_GAME_OVER : 0;
+        events->clearedRowsMask = clearedRowsMask;
+    }
+}
+
+void LockLevelPlayer(level_t *level, level_events_t *events)
+{
+    world_t *world = &level->world;
+    player_t *player = &level->player;
+
+    if (events)
+    {
+        events->lockedValue = player->value;
+        events->lockedCellCount = 0;
+
+        for (uint32 i = 0; i < player->data.cellCount && player->value; ++i)
+        {
+            vec2i_t position = player->position + GetPlayerCell(&player->data, i);
+
+            if (position.y >= 0 && IsWorldPositionValid(world, position))
+            {
+                events->lockedCells[events->lockedCellCount++] = (uint16)(position.y * world->size.x + position.x);
+            }
+        }
+    }
+
+    SavePlayerInWorld(world, player);
+    uint32 clearedRowsMask = GetFilledRowsMask(world);
+    RemoveWorldRows(world, clearedRowsMask);
+    FinishLevelLock(level, clearedRowsMask, events);
+}
+
+void ReplayLevelLock(level_t *level, const uint16 *cells, uint32 cellCount, uint8 value, uint32 clearedRowsMask)
+{
+    world_t *world = &level->world;
+
+    for (uint32 i = 0; i < cellCount; ++i)
+    {
+        SetWorldValueUnchecked(world, {cells[i] % world->size.x, cells[i] / world->size.x}, value);
+    }
+
+    RemoveWorldRows(world, clearedRowsMask);
+    FinishLevelLock(level, clearedRowsMask, nullptr);
+}
+
+void AddLevelGarbage(level_t *level, int32 count, int32 holeX)
+{
+    player_t *player = &level->player;
+    bool overflow = AddWorldGarbageRows(&level->world, count, LEVEL_GARBAGE_VALUE, holeX);
+
+    while (!IsPlayerPositionValid(&level->world, &player->data, player->position) &&
+           player->position.y > -player->data.dim.y)
+    {
+        player->position.y--;
+    }
+
+    if (overflow || CheckGameOver(&level->world, player))
+    {
+        SetLevelGameOver(level);
+    }
+}
+
+void DoLevelStep(level_t *level, uint64 dt, level_events_t *events)
+{
+    if (events)
+    {
+        events->flags = 0;
+    }
+
     level->stepAccumulator += dt;
 
     if (level->stepAccumulator >= level->currentStepMs)
@@ -175,66 +259,39 @@ void DoLevelStep(level_t *level, game_input_t *input, uint64 dt)
             }
             else
             {
-                // Mix_PlayChannel(SOUND_CHANNEL_SFX, as->assets.placeSfx, 0);
-
-                SavePlayerInWorld(&level->world, &level->player);
-                uint8 destroyedRows = DestroyFilledRows(&level->world);
-                level->score += destroyedRows * SCORE_PER_ROW;
-                SpawnPlayer(&level->world, &level->player);
-
-                if (input->gamepadId)
-                {
-                    SDL_Gamepad *gamepad = SDL_GetGamepadFromID(input->gamepadId);
-
-                    if (gamepad)
-                    {
-                        uint16 strength = destroyedRows ? 0xFFFF : 0x1000;
-                        SDL_RumbleGamepad(gamepad, strength, strength, 500);
-                    }
-                }
-
-                if (destroyedRows)
-                {
-                    level->stepMs = SDL_max(MIN_STEP_MS, level->stepMs - DELTA_STEP_MS);
-                }
-
-                if (CheckGameOver(&level->world, &level->player))
-                {
-                    SetLevelGameOver(level);
-                    // Mix_HaltMusic();
-                    // Mix_PlayChannel(SOUND_CHANNEL_SFX, as->assets.gameOverMusic, 0);
-
-                    if (input->gamepadId)
-                    {
-                        SDL_Gamepad *gamepad = SDL_GetGamepadFromID(input->gamepadId);
-
-                        if (gamepad)
-                        {
-                            SDL_RumbleGamepad(gamepad, 0xFFFF, 0xFFFF, 1000);
-                            SDL_SetGamepadLED(gamepad, 0xFF, 0x00, 0x00);
-                        }
-                    }
-                }
+                LockLevelPlayer(level, events);
             }
         }
     }
 }
 
-void RenderLevel(SDL_Renderer *renderer, app_assets_t *assets, level_t *level, vec2i_t renderSize)
+void RenderBackground(SDL_Renderer *renderer, app_assets_t *assets)
 {
-    world_t *world = &level->world;
-    player_t *player = &level->player;
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xFF);
+    SDL_RenderClear(renderer);
+    SDL_RenderTextureTiled(renderer, assets->bgPatternTexture, nullptr, 2.0f, nullptr);
+    assets->renderCalls += 2;
+}
 
-    vec2_t itemSize{40.0f, 40.0f};
-    vec2_t gridSize{itemSize.w * world->size.x, itemSize.h * world->size.y};
-    vec2_t offset{((real32)renderSize.w - gridSize.w - 20.0f) / 2.0f,
-                  ((real32)renderSize.h - gridSize.h - 20.0f) / 2.0f};
+SDL_FRect GetLevelBoardRect(const world_t *world, vec2i_t renderSize)
+{
+    vec2_t gridSize{LEVEL_ITEM_SIZE * world->size.x, LEVEL_ITEM_SIZE * world->size.y};
 
-    SDL_FRect gridRect{
-        offset.x,
-        offset.y,
+    return SDL_FRect{
+        ((real32)renderSize.w - gridSize.w - 20.0f) / 2.0f,
+        ((real32)renderSize.h - gridSize.h - 20.0f) / 2.0f,
         gridSize.w,
         gridSize.h};
+}
+
+void RenderLevel(SDL_Renderer *renderer, app_assets_t *assets, level_t *level, vec2i_t renderSize)
+{
+    world_t *world = &level->world;
+    player_t *player = &level->player;
+
+    vec2_t itemSize{LEVEL_ITEM_SIZE, LEVEL_ITEM_SIZE};
+    SDL_FRect gridRect = GetLevelBoardRect(world, renderSize);
+    vec2_t offset{gridRect.x, gridRect.y};
 
     SDL_FRect blockTextureSrcRect{
         45.0f,
@@ -244,19 +301,34 @@ void RenderLevel(SDL_Renderer *renderer, app_assets_t *assets, level_t *level, v
 
     real32 gridScale = itemSize.w / 30.0f;
     SDL_RenderTextureTiled(renderer, assets->gridPatternTexture, nullptr, gridScale, &gridRect);
+    assets->renderCalls++;
 
     RenderWorld(renderer, assets, world, offset);
     RenderPlayer(renderer, assets, world, player, offset);
 
-    player_data_t nextPlayerKind = GetPlayerKind(player->nextPlayerKindId);
-    vec2_t nextPlayerSize{
-        itemSize.w * nextPlayerKind.dim.x,
-        itemSize.h * nextPlayerKind.dim.y};
-    vec2_t nextPlayerOffset{
-        (real32)renderSize.w - offset.x + (offset.x - nextPlayerSize.w) / 2.0f,
-        ((real32)renderSize.h - nextPlayerSize.h) / 2.0f,
+    vec2_t previewSize{itemSize.w * 4.0f, 0.0f};
+
+    for (uint32 i = 0; i < PIECE_PREVIEW_COUNT; ++i)
+    {
+        previewSize.h += itemSize.h * (GetPlayerKind(PeekPieceQueue(&level->pieceQueue, i).kindId)->dim.y + 1);
+    }
+
+    vec2_t previewOffset{
+        (real32)renderSize.w - offset.x + (offset.x - previewSize.w) / 2.0f,
+        ((real32)renderSize.h - previewSize.h) / 2.0f,
     };
-    RenderPlayer(renderer, assets, world, &nextPlayerKind, vec2i_t{0, 0}, player->nextPlayerValue, nextPlayerOffset);
+
+    for (uint32 i = 0; i < PIECE_PREVIEW_COUNT; ++i)
+    {
+        piece_t nextPiece = PeekPieceQueue(&level->pieceQueue, i);
+        const player_data_t *nextPlayerKind = GetPlayerKind(nextPiece.kindId);
+        vec2_t nextPlayerOffset{
+            previewOffset.x + (previewSize.w - itemSize.w * nextPlayerKind->dim.x) / 2.0f,
+            previewOffset.y,
+        };
+        RenderPlayer(renderer, assets, world, nextPlayerKind, vec2i_t{0, 0}, nextPiece.value, nextPlayerOffset);
+        previewOffset.y += itemSize.h * (nextPlayerKind->dim.y + 1);
+    }
 
     real32 gridBorderSize = 16.0f;
 
@@ -274,17 +346,21 @@ void RenderLevel(SDL_Renderer *renderer, app_assets_t *assets, level_t *level, v
     SDL_RenderTexture9Grid(renderer, assets->borderTexture, &gridBorderSrcRect,
                            gridBorderSize, gridBorderSize, gridBorderSize, gridBorderSize,
                            1.0f, &gridBorderDestRect);
+    assets->renderCalls++;
 
     if (level->gameOver)
     {
         RenderLevelOverlay(renderer, renderSize, "GAME OVER\nPRESS R TO RESTART");
+        assets->renderCalls += 2;
     }
     else if (level->paused)
     {
         RenderLevelOverlay(renderer, renderSize, "PAUSE\nPRESS P TO RESUME\nPRESS R TO RESTART");
+        assets->renderCalls += 2;
     }
 
     RenderScore(renderer, renderSize, level->score);
+    assets->renderCalls++;
 }
 
 void RenderLevelOverlay(SDL_Renderer *renderer, vec2i_t renderSize, char *message)
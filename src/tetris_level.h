@@ -4,17 +4,60 @@
 #include "tetris_world.h"
 #include "tetris_player.h"
 #include "tetris_input.h"
+#include "tetris_random.h"
 #include "tetris_assets.h"
 
 #define SCORE_PER_ROW 100
 #define MIN_STEP_MS 50
 #define MAX_STEP_MS 500
 #define DELTA_STEP_MS 25
+#define LEVEL_GARBAGE_VALUE PLAYER_VALUE_COUNT
+/**
+ * @brief Size of a world cell on screen in pixels.
+ */
+#define LEVEL_ITEM_SIZE 40.0f
 
+#define LEVEL_MAX_LOCKED_CELLS PLAYER_DATA_MAX_CELLS
+
+enum eLevelEventFlags
+{
+    LEVEL_EVENT_PIECE_LOCKED = 1 << 0,
+    LEVEL_EVENT_ROWS_CLEARED = 1 << 1,
+    LEVEL_EVENT_GAME_OVER = 1 << 2,
+    /**
+     * @brief The frame's input moved or rotated the active piece.
+     */
+    LEVEL_EVENT_PLAYER_MOVED = 1 << 3,
+};
+
+/**
+ * @brief What one step did, for feedback and recording.
+ * @note Kept out of level_t, it isn't game state and must not end up in snapshots.
+ */
+struct level_events_t
+{
+    uint32 flags;
+    /**
+     * @brief Rows removed by the lock, bit y is the row index before removal.
+     */
+    uint32 clearedRowsMask;
+    uint8 lockedValue;
+    uint32 lockedCellCount;
+    /**
+     * @brief World cell indices written by the lock.
+     */
+    uint16 lockedCells[LEVEL_MAX_LOCKED_CELLS];
+};
+
+/**
+ * @brief All state of one game.
+ * @note Holds no pointers, so it can be relocated, copied or snapshotted with one memcpy.
+ */
 struct level_t
 {
     world_t world;
     player_t player;
+    piece_queue_t pieceQueue;
     bool paused;
     bool gameOver;
     uint32 score;
@@ -24,6 +67,8 @@ struct level_t
     uint64 stepAccumulator;
 };
 
+void CopyLevel(level_t *dst, const level_t *src);
+
 void ResumeLevel(level_t *level);
 
 void PauseLevel(level_t *level);
@@ -32,7 +77,10 @@ void ToggleLevelPaused(level_t *level);
 
 void SetLevelGameOver(level_t *level);
 
-void MovePlayer(world_t *world, player_t *player, game_input_t *input);
+/**
+ * @return The piece moved or rotated.
+ */
+bool MovePlayer(world_t *world, player_t *player, game_input_t *input);
 
 bool CheckGameOver(world_t *world, player_t *player);
 
@@ -42,9 +90,44 @@ void ResetLevel(level_t *level);
 
 void Restart(level_t *level);
 
-void ApplyLevelInput(level_t *level, uint64 dt, game_input_t *input);
-
-void DoLevelStep(level_t *level, game_input_t *input, uint64 dt);
+void SpawnLevelPlayer(level_t *level);
+
+/**
+ * @return The input moved or rotated the active piece.
+ */
+bool ApplyLevelInput(level_t *level, uint64 dt, game_input_t *input);
+
+/**
+ * @brief Writes the active piece into the world, removes filled rows and spawns the next piece.
+ * @param events Optional, receives the written cells and removed rows.
+ */
+void LockLevelPlayer(level_t *level, level_events_t *events);
+
+/**
+ * @brief Repeats a lock recorded by LockLevelPlayer without the active piece.
+ * @note Only valid on the exact state the lock was recorded on.
+ */
+void ReplayLevelLock(level_t *level, const uint16 *cells, uint32 cellCount, uint8 value, uint32 clearedRowsMask);
+
+/**
+ * @brief Pushes count garbage rows with a hole at holeX under the stack, the active piece is moved up if needed.
+ */
+void AddLevelGarbage(level_t *level, int32 count, int32 holeX);
+
+/**
+ * @param events Optional, reset at the start of every step.
+ */
+void DoLevelStep(level_t *level, uint64 dt, level_events_t *events);
+
+/**
+ * @brief Clears the target to the tiled background pattern.
+ */
+void RenderBackground(SDL_Renderer *renderer, app_assets_t *assets);
+
+/**
+ * @brief Where RenderLevel draws the world, centered in renderSize.
+ */
+SDL_FRect GetLevelBoardRect(const world_t *world, vec2i_t renderSize);
 
 void RenderLevel(SDL_Renderer *renderer, app_assets_t *assets, level_t *level, vec2i_t renderSize);
 
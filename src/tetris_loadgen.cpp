@@ -0,0 +1,623 @@
+#include "tetris_loadgen.h"
+
+#if defined(SDL_PLATFORM_LINUX)
+#define LOADGEN_USE_EPOLL 1
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#if defined(LOADGEN_USE_EPOLL)
+
+#define LOADGEN_EPOLL_TIMER 0xFFFFFFFFu
+
+static bool SendLoadGenMessage(loadgen_thread_t *thread, loadgen_client_t *client, const void *message, uint32 size)
+{
+    ssize_t sent = send(client->fd, message, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+    /* Messages are a few bytes and the buffer holds thousands, a partial send means the server stopped reading. */
+    if (sent != (ssize_t)size)
+    {
+        return false;
+    }
+
+    thread->stats.bytesOut += size;
+    return true;
+}
+
+static bool SendLoadGenHello(loadgen_thread_t *thread, loadgen_client_t *client)
+{
+    server_hello_t hello{};
+    hello.header.size = SDL_Swap16LE(sizeof(hello));
+    hello.header.type = SERVER_MESSAGE_HELLO;
+    hello.randomizerMode = 1;
+    hello.seed = SDL_Swap64LE(client->seed);
+    return SendLoadGenMessage(thread, client, &hello, sizeof(hello));
+}
+
+static bool ConnectLoadGenClient(loadgen_thread_t *thread, loadgen_client_t *client, const addrinfo *address)
+{
+    const loadgen_config_t *config = &thread->gen->config;
+    int fd;
+
+    /* Blocking connects, the server accepts as fast as they come and the run only starts once all are in. */
+    if (config->unixPath[0])
+    {
+        sockaddr_un unixAddress{};
+        unixAddress.sun_family = AF_UNIX;
+        SDL_strlcpy(unixAddress.sun_path, config->unixPath, sizeof(unixAddress.sun_path));
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        if (fd >= 0 && connect(fd, (sockaddr *)&unixAddress, sizeof(unixAddress)) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    else
+    {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+
+        if (fd >= 0)
+        {
+            int noDelay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        }
+    }
+
+    client->fd = fd;
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u32 = (uint32)(client - thread->clients);
+
+    if (epoll_ctl(thread->epollFd, EPOLL_CTL_ADD, fd, &event) != 0 || !SendLoadGenHello(thread, client))
+    {
+        close(fd);
+        client->fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+static void CloseLoadGenClient(loadgen_thread_t *thread, loadgen_client_t *client)
+{
+    epoll_ctl(thread->epollFd, EPOLL_CTL_DEL, client->fd, nullptr);
+    close(client->fd);
+    client->fd = -1;
+}
+
+/**
+ * @brief Replays the delta's lock on the mirror like ReplayLevelLock, then checks it against the server's hash.
+ */
+static void ApplyLoadGenDelta(loadgen_thread_t *thread, loadgen_client_t *client, const server_delta_t *delta)
+{
+    thread->stats.deltas++;
+
+    if (delta->flags & SERVER_DELTA_LOCKED)
+    {
+        world_t *world = &client->world;
+        uint32 cellCount = SDL_min(delta->lockedCellCount, (uint8)LEVEL_MAX_LOCKED_CELLS);
+
+        for (uint32 i = 0; i < cellCount; ++i)
+        {
+            uint32 cell = SDL_Swap16LE(delta->lockedCells[i]);
+
+            if (cell < (uint32)(world->size.x * world->size.y))
+            {
+                SetWorldValueUnchecked(world, {(int32)cell % world->size.x, (int32)cell / world->size.x},
+                                       delta->lockedValue);
+            }
+        }
+
+        RemoveWorldRows(world, SDL_Swap32LE(delta->clearedRowsMask));
+        thread->stats.locks++;
+        thread->stats.mismatches += world->hash != SDL_Swap64LE(delta->worldHash);
+    }
+
+    if (delta->flags & SERVER_DELTA_GAME_OVER)
+    {
+        thread->stats.games++;
+        client->seed += thread->gen->config.sessions;
+        SendLoadGenHello(thread, client);
+    }
+}
+
+static void HandleLoadGenWelcome(loadgen_thread_t *thread, loadgen_client_t *client, const server_welcome_t *welcome)
+{
+    loadgen_t *gen = thread->gen;
+    uint16 shard = SDL_Swap16LE(welcome->shard);
+    uint16 shardCount = SDL_Swap16LE(welcome->shardCount);
+
+    if (!client->welcomed && shard < LOADGEN_MAX_SHARDS)
+    {
+        SDL_LockMutex(gen->mutex);
+        gen->shardCount = SDL_min((uint32)shardCount, (uint32)LOADGEN_MAX_SHARDS);
+        gen->shardSessions[shard]++;
+        SDL_UnlockMutex(gen->mutex);
+        thread->stats.connected++;
+    }
+
+    client->welcomed = true;
+    client->shard = shard;
+    SetWorldSize(&client->world, {SDL_clamp((int32)welcome->worldWidth, 1, WORLD_MAX_WIDTH),
+                                  SDL_clamp((int32)welcome->worldHeight, 1, WORLD_MAX_HEIGHT)});
+    ResetWorld(&client->world);
+}
+
+static void ReadLoadGenClient(loadgen_thread_t *thread, loadgen_client_t *client)
+{
+    loadgen_t *gen = thread->gen;
+    ssize_t received = recv(client->fd, client->in + client->inSize, LOADGEN_IN_SIZE - client->inSize, MSG_DONTWAIT);
+
+    if (received <= 0)
+    {
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            thread->stats.lost += !SDL_GetAtomicInt(&gen->quit);
+            CloseLoadGenClient(thread, client);
+        }
+
+        return;
+    }
+
+    thread->stats.bytesIn += (uint64)received;
+    client->inSize += (uint32)received;
+    uint32 offset = 0;
+
+    while (client->inSize - offset >= sizeof(server_message_header_t))
+    {
+        alignas(8) uint8 message[sizeof(server_stats_message_t) + sizeof(server_delta_t)];
+        uint32 size = SDL_Swap16LE(((const server_message_header_t *)(client->in + offset))->size);
+
+        if (size < sizeof(server_message_header_t) || size > sizeof(message))
+        {
+            thread->stats.lost++;
+            CloseLoadGenClient(thread, client);
+            return;
+        }
+
+        if (client->inSize - offset < size)
+        {
+            break;
+        }
+
+        SDL_memcpy(message, client->in + offset, size);
+        offset += size;
+
+        switch (((const server_message_header_t *)message)->type)
+        {
+        case SERVER_MESSAGE_WELCOME:
+            HandleLoadGenWelcome(thread, client, (const server_welcome_t *)message);
+            break;
+        case SERVER_MESSAGE_DELTA:
+            ApplyLoadGenDelta(thread, client, (const server_delta_t *)message);
+            break;
+        case SERVER_MESSAGE_STATS:
+        {
+            const server_stats_message_t *stats = (const server_stats_message_t *)message;
+            uint16 shard = SDL_Swap16LE(stats->shard);
+
+            if (shard < LOADGEN_MAX_SHARDS)
+            {
+                SDL_LockMutex(gen->mutex);
+                gen->shardStats[shard] = *stats;
+                gen->shardReported[shard] = true;
+                SDL_UnlockMutex(gen->mutex);
+            }
+
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    client->inSize -= offset;
+    SDL_memmove(client->in, client->in + offset, client->inSize);
+}
+
+/**
+ * @brief A left, right or rotate tap, or soft drop pressed or let go, at random times around the set rate.
+ */
+static void PressLoadGenClient(loadgen_thread_t *thread, loadgen_client_t *client, uint32 ticksPerPress)
+{
+    game_input_t input{};
+    input.down.isDown = client->holdingDown;
+    uint32 choice = NextRandomBelow(&client->random, 4);
+
+    if (choice == 2)
+    {
+        client->holdingDown = !client->holdingDown;
+        SetInputButtonDown(&input.down, client->holdingDown);
+    }
+    else
+    {
+        game_input_button_t *button = &input.buttons[choice];
+        SetInputButtonDown(button, true);
+        SetInputButtonDown(button, false);
+    }
+
+    server_input_t message{};
+    message.header.size = SDL_Swap16LE(sizeof(message));
+    message.header.type = SERVER_MESSAGE_INPUT;
+    message.input = SDL_Swap16LE(PackGameInput(&input));
+
+    if (SendLoadGenMessage(thread, client, &message, sizeof(message)))
+    {
+        thread->stats.inputs++;
+    }
+    else
+    {
+        thread->stats.inputsDropped++;
+    }
+
+    client->nextPressTick = thread->tick + 1 + NextRandomBelow(&client->random, 2 * ticksPerPress);
+}
+
+/**
+ * @brief Asks for the stats of every shard the thread's clients reach that no other thread asked yet.
+ */
+static void RequestLoadGenStats(loadgen_thread_t *thread)
+{
+    loadgen_t *gen = thread->gen;
+    thread->statsRequested = true;
+    server_message_header_t request{SDL_Swap16LE(sizeof(server_message_header_t)), SERVER_MESSAGE_STATS_REQUEST, 0};
+
+    for (uint32 i = 0; i < thread->clientCount; ++i)
+    {
+        loadgen_client_t *client = &thread->clients[i];
+
+        if (client->fd < 0 || !client->welcomed || client->shard >= LOADGEN_MAX_SHARDS)
+        {
+            continue;
+        }
+
+        SDL_LockMutex(gen->mutex);
+        bool ask = !gen->shardRequested[client->shard];
+        gen->shardRequested[client->shard] = true;
+        SDL_UnlockMutex(gen->mutex);
+
+        if (ask)
+        {
+            SendLoadGenMessage(thread, client, &request, sizeof(request));
+        }
+    }
+}
+
+static void TickLoadGenThread(loadgen_thread_t *thread)
+{
+    uint64 expirations;
+
+    if (read(thread->timerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    {
+        return;
+    }
+
+    thread->tick++;
+    loadgen_t *gen = thread->gen;
+    uint32 pressesPerSecond = SDL_max(gen->config.pressesPerSecond, 1u);
+    uint32 ticksPerPress = SDL_max(1000u / (SERVER_TICK_MS * pressesPerSecond), 1u);
+    bool pressing = gen->config.pressesPerSecond && !SDL_GetAtomicInt(&gen->requestStats);
+
+    for (uint32 i = 0; i < thread->clientCount && pressing; ++i)
+    {
+        loadgen_client_t *client = &thread->clients[i];
+
+        if (client->fd >= 0 && client->welcomed && thread->tick >= client->nextPressTick)
+        {
+            PressLoadGenClient(thread, client, ticksPerPress);
+        }
+    }
+
+    if (SDL_GetAtomicInt(&gen->requestStats) && !thread->statsRequested)
+    {
+        RequestLoadGenStats(thread);
+    }
+}
+
+static int SDLCALL RunLoadGenThread(void *data)
+{
+    loadgen_thread_t *thread = (loadgen_thread_t *)data;
+    loadgen_t *gen = thread->gen;
+    epoll_event events[SERVER_EPOLL_EVENTS];
+
+    while (!SDL_GetAtomicInt(&gen->quit))
+    {
+        int count = epoll_wait(thread->epollFd, events, SERVER_EPOLL_EVENTS, -1);
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (events[i].data.u32 == LOADGEN_EPOLL_TIMER)
+            {
+                TickLoadGenThread(thread);
+                continue;
+            }
+
+            loadgen_client_t *client = &thread->clients[events[i].data.u32];
+
+            if (client->fd >= 0)
+            {
+                ReadLoadGenClient(thread, client);
+            }
+        }
+    }
+
+    for (uint32 i = 0; i < thread->clientCount; ++i)
+    {
+        if (thread->clients[i].fd >= 0)
+        {
+            CloseLoadGenClient(thread, &thread->clients[i]);
+        }
+    }
+
+    return 0;
+}
+
+static bool InitLoadGenThread(loadgen_t *gen, loadgen_thread_t *thread, uint32 index, const addrinfo *address)
+{
+    const loadgen_config_t *config = &gen->config;
+    uint32 first = (uint32)((uint64)config->sessions * index / config->threadCount);
+    uint32 last = (uint32)((uint64)config->sessions * (index + 1) / config->threadCount);
+    thread->gen = gen;
+    thread->index = index;
+    thread->clientCount = last - first;
+    thread->clients = PushArray(&gen->arena, thread->clientCount, loadgen_client_t);
+
+    /* Closed on the way out even if this thread fails before connecting them. */
+    for (uint32 i = 0; thread->clients && i < thread->clientCount; ++i)
+    {
+        thread->clients[i].fd = -1;
+    }
+
+    thread->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    thread->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (!thread->clients || thread->epollFd < 0 || thread->timerFd < 0)
+    {
+        return SDL_SetError("Couldn't create load generator thread %u: %s", index, strerror(errno));
+    }
+
+    itimerspec timer{};
+    timer.it_interval.tv_nsec = SERVER_TICK_MS * SDL_NS_PER_MS;
+    timer.it_value = timer.it_interval;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u32 = LOADGEN_EPOLL_TIMER;
+
+    if (timerfd_settime(thread->timerFd, 0, &timer, nullptr) != 0 ||
+        epoll_ctl(thread->epollFd, EPOLL_CTL_ADD, thread->timerFd, &event) != 0)
+    {
+        return SDL_SetError("Couldn't start the load generator timer: %s", strerror(errno));
+    }
+
+    uint32 ticksPerPress = 1000 / (SERVER_TICK_MS * SDL_max(config->pressesPerSecond, 1u));
+
+    for (uint32 i = 0; i < thread->clientCount; ++i)
+    {
+        loadgen_client_t *client = &thread->clients[i];
+        client->seed = config->seed + first + i;
+        SeedRandom(&client->random, client->seed);
+        client->nextPressTick = 1 + NextRandomBelow(&client->random, SDL_max(ticksPerPress, 1u));
+        InitWorld(&client->world);
+
+        if (!ConnectLoadGenClient(thread, client, address))
+        {
+            thread->stats.failed++;
+        }
+    }
+
+    thread->thread = SDL_CreateThread(RunLoadGenThread, "loadgen", thread);
+    return thread->thread != nullptr;
+}
+
+static void AddLoadGenStats(loadgen_stats_t *total, const loadgen_stats_t *stats)
+{
+    total->connected += stats->connected;
+    total->failed += stats->failed;
+    total->lost += stats->lost;
+    total->inputs += stats->inputs;
+    total->inputsDropped += stats->inputsDropped;
+    total->deltas += stats->deltas;
+    total->locks += stats->locks;
+    total->games += stats->games;
+    total->mismatches += stats->mismatches;
+    total->bytesIn += stats->bytesIn;
+    total->bytesOut += stats->bytesOut;
+}
+
+static void LogLoadGenReport(loadgen_t *gen, const loadgen_stats_t *total, real64 seconds)
+{
+    /* A mean hides a shard that took the whole backlog. */
+    uint32 minSessions = ~0u;
+    uint32 maxSessions = 0;
+
+    for (uint32 shard = 0; shard < gen->shardCount; ++shard)
+    {
+        uint32 sessions =
+            gen->shardReported[shard] ? SDL_Swap32LE(gen->shardStats[shard].sessions) : gen->shardSessions[shard];
+        minSessions = SDL_min(minSessions, sessions);
+        maxSessions = SDL_max(maxSessions, sessions);
+
+        if (!gen->shardReported[shard])
+        {
+            SDL_Log("shard%-3u %5u sessions from this run, no stats received", shard, gen->shardSessions[shard]);
+            continue;
+        }
+
+        const server_stats_message_t *stats = &gen->shardStats[shard];
+        SDL_Log("shard%-3u %5u sessions (%5u from this run), %7llu ticks, %llu late, %llu skipped, "
+                "work mean %7.1f us, max %7.1f; jitter p50 %6.1f us, p99 %6.1f, max %7.1f",
+                shard, SDL_Swap32LE(stats->sessions), gen->shardSessions[shard],
+                (unsigned long long)SDL_Swap64LE(stats->ticks), (unsigned long long)SDL_Swap64LE(stats->lateTicks),
+                (unsigned long long)SDL_Swap64LE(stats->skippedTicks), SDL_Swap64LE(stats->meanTickWorkNs) / 1e3,
+                SDL_Swap64LE(stats->maxTickWorkNs) / 1e3, SDL_Swap64LE(stats->jitterP50Ns) / 1e3,
+                SDL_Swap64LE(stats->jitterP99Ns) / 1e3, SDL_Swap64LE(stats->jitterMaxNs) / 1e3);
+    }
+
+    SDL_Log("%llu sessions on %u shards, %.1f per core (min %u, max %u); %llu failed to connect, %llu lost",
+            (unsigned long long)total->connected, gen->shardCount,
+            total->connected / (real64)SDL_max(gen->shardCount, 1u), gen->shardCount ? minSessions : 0, maxSessions,
+            (unsigned long long)total->failed, (unsigned long long)total->lost);
+    SDL_Log("%.0f inputs/s (%llu dropped), %.0f deltas/s, %.2f MB/s in; %llu locks, %llu games, %llu mismatched boards",
+            total->inputs / seconds, (unsigned long long)total->inputsDropped, total->deltas / seconds,
+            total->bytesIn / seconds / 1e6, (unsigned long long)total->locks, (unsigned long long)total->games,
+            (unsigned long long)total->mismatches);
+}
+
+bool RunLoadGen(const loadgen_config_t *config)
+{
+    loadgen_config_t settings = *config;
+    settings.threadCount = SDL_clamp(settings.threadCount, 1u, SDL_max(settings.sessions, 1u));
+    uint64 memorySize = settings.threadCount * (sizeof(loadgen_thread_t) + ARENA_DEFAULT_ALIGNMENT) +
+                        (settings.sessions + settings.threadCount) * sizeof(loadgen_client_t) +
+                        sizeof(loadgen_t) + ARENA_DEFAULT_ALIGNMENT;
+    void *memory = SDL_calloc(1, memorySize);
+
+    if (!memory)
+    {
+        return false;
+    }
+
+    arena_t arena;
+    InitArena(&arena, memory, memorySize);
+    loadgen_t *gen = PushStruct(&arena, loadgen_t);
+    gen->config = settings;
+    gen->arena = arena;
+    gen->mutex = SDL_CreateMutex();
+    gen->threads = PushArray(&gen->arena, settings.threadCount, loadgen_thread_t);
+
+    addrinfo *address = nullptr;
+    bool success = gen->mutex != nullptr;
+
+    if (success && !settings.unixPath[0])
+    {
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        char port[8];
+        SDL_snprintf(port, sizeof(port), "%u", settings.port);
+        success = getaddrinfo(settings.host, port, &hints, &address) == 0 && address;
+
+        if (!success)
+        {
+            SDL_SetError("Couldn't resolve %s", settings.host);
+        }
+    }
+
+    uint64 connectStart = SDL_GetTicksNS();
+    uint32 started = 0;
+
+    for (; success && started < settings.threadCount; ++started)
+    {
+        loadgen_thread_t *thread = &gen->threads[started];
+        thread->epollFd = -1;
+        thread->timerFd = -1;
+        success = InitLoadGenThread(gen, thread, started, address);
+    }
+
+    if (address)
+    {
+        freeaddrinfo(address);
+    }
+
+    SDL_Log("Connected %u sessions in %.2f s over %u threads", settings.sessions,
+            (SDL_GetTicksNS() - connectStart) / 1e9, settings.threadCount);
+    uint64 runStart = SDL_GetTicksNS();
+
+    if (success)
+    {
+        SDL_Delay(settings.seconds * 1000);
+    }
+
+    /* Presses stop here, the stats requests go out on the next tick. */
+    real64 seconds = (SDL_GetTicksNS() - runStart) / 1e9;
+    SDL_SetAtomicInt(&gen->requestStats, 1);
+    uint64 statsDeadline = SDL_GetTicks() + LOADGEN_STATS_TIMEOUT_MS;
+    bool reported = false;
+
+    while (success && !reported && SDL_GetTicks() < statsDeadline)
+    {
+        SDL_Delay(SERVER_TICK_MS);
+        SDL_LockMutex(gen->mutex);
+        reported = gen->shardCount > 0;
+
+        for (uint32 shard = 0; shard < gen->shardCount; ++shard)
+        {
+            reported = reported && gen->shardReported[shard];
+        }
+
+        SDL_UnlockMutex(gen->mutex);
+    }
+
+    SDL_SetAtomicInt(&gen->quit, 1);
+    loadgen_stats_t total{};
+
+    for (uint32 i = 0; i < started; ++i)
+    {
+        loadgen_thread_t *thread = &gen->threads[i];
+
+        if (thread->thread)
+        {
+            SDL_WaitThread(thread->thread, nullptr);
+        }
+
+        for (uint32 c = 0; c < thread->clientCount && !thread->thread; ++c)
+        {
+            if (thread->clients[c].fd >= 0)
+            {
+                close(thread->clients[c].fd);
+            }
+        }
+
+        if (thread->epollFd >= 0)
+        {
+            close(thread->epollFd);
+        }
+
+        if (thread->timerFd >= 0)
+        {
+            close(thread->timerFd);
+        }
+
+        AddLoadGenStats(&total, &thread->stats);
+    }
+
+    if (success)
+    {
+        LogLoadGenReport(gen, &total, seconds);
+    }
+
+    success = success && total.connected > 0 && total.mismatches == 0;
+    SDL_DestroyMutex(gen->mutex);
+    SDL_free(memory);
+    return success;
+}
+
+#else
+
+bool RunLoadGen(const loadgen_config_t *config)
+{
+    return SDL_SetError("The load generator needs epoll, it only runs on Linux");
+}
+
+#endif
@@ -0,0 +1,124 @@
+#if !defined(TETRIS_LOADGEN_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+#include "tetris_arena.h"
+#include "tetris_world.h"
+#include "tetris_random.h"
+#include "tetris_server.h"
+
+#define LOADGEN_DEFAULT_SESSIONS 1000
+#define LOADGEN_DEFAULT_SECONDS 10
+#define LOADGEN_DEFAULT_PRESSES_PER_SECOND 4
+#define LOADGEN_MAX_SHARDS 256
+#define LOADGEN_HOST_SIZE 256
+#define LOADGEN_IN_SIZE Kilobytes(4)
+/**
+ * @brief How long the generator waits for the shards' stats once the run is over.
+ */
+#define LOADGEN_STATS_TIMEOUT_MS 2000
+
+struct loadgen_config_t
+{
+    char host[LOADGEN_HOST_SIZE];
+    uint16 port;
+    /**
+     * @brief Connects here instead of host and port when not empty.
+     */
+    char unixPath[SERVER_UNIX_PATH_SIZE];
+    uint32 sessions;
+    uint32 seconds;
+    uint32 threadCount;
+    uint32 pressesPerSecond;
+    uint64 seed;
+};
+
+/**
+ * @brief One simulated player: a connection, its mirror of the board and its next press.
+ */
+struct loadgen_client_t
+{
+    int fd;
+    bool welcomed;
+    bool holdingDown;
+    uint16 shard;
+    uint32 nextPressTick;
+    uint64 seed;
+    random_t random;
+    world_t world;
+
+    uint32 inSize;
+    uint8 in[LOADGEN_IN_SIZE];
+};
+
+struct loadgen_stats_t
+{
+    uint64 connected;
+    uint64 failed;
+    /**
+     * @brief Connections the server closed during the run.
+     */
+    uint64 lost;
+    uint64 inputs;
+    /**
+     * @brief Inputs not sent because the socket buffer was full.
+     */
+    uint64 inputsDropped;
+    uint64 deltas;
+    uint64 locks;
+    uint64 games;
+    /**
+     * @brief Locks after which the mirrored board's hash didn't match the server's.
+     */
+    uint64 mismatches;
+    uint64 bytesIn;
+    uint64 bytesOut;
+};
+
+struct loadgen_t;
+
+struct loadgen_thread_t
+{
+    loadgen_t *gen;
+    uint32 index;
+    SDL_Thread *thread;
+    int epollFd;
+    int timerFd;
+    loadgen_client_t *clients;
+    uint32 clientCount;
+    uint32 tick;
+    bool statsRequested;
+    loadgen_stats_t stats;
+};
+
+/**
+ * @brief Drives a server with many clients that press random buttons and check every delta.
+ * @note Clients are split across threads, each with its own epoll and tick timer. Linux only.
+ */
+struct loadgen_t
+{
+    loadgen_config_t config;
+    arena_t arena;
+    loadgen_thread_t *threads;
+    SDL_AtomicInt quit;
+    /**
+     * @brief Set once the run is over, each thread then asks the shards it reaches for their stats.
+     */
+    SDL_AtomicInt requestStats;
+
+    SDL_Mutex *mutex;
+    uint32 shardCount;
+    uint32 shardSessions[LOADGEN_MAX_SHARDS];
+    bool shardRequested[LOADGEN_MAX_SHARDS];
+    bool shardReported[LOADGEN_MAX_SHARDS];
+    server_stats_message_t shardStats[LOADGEN_MAX_SHARDS];
+};
+
+/**
+ * @brief Connects config.sessions clients, plays for config.seconds, collects the shards' stats and logs a report.
+ * @return False if no client could connect or a mirrored board went out of sync.
+ */
+bool RunLoadGen(const loadgen_config_t *config);
+
+#define TETRIS_LOADGEN_H
+#endif
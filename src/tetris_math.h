@@ -2,6 +2,10 @@
 
 #include "tetris_typedefs.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 struct vec2i_t
 {
     union
@@ -188,5 +192,25 @@ struct vec2_t
     }
 };
 
+inline int32 CountTrailingZeros32(uint32 value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (int32)index;
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+inline int32 CountSetBits32(uint32 value)
+{
+#if defined(_MSC_VER)
+    return (int32)__popcnt(value);
+#else
+    return __builtin_popcount(value);
+#endif
+}
+
 #define TETRIS_MATH_H
 #endif
@@ -0,0 +1,262 @@
+#include "tetris_metrics.h"
+
+static const char *kMetricsGameEndNames[] = {"game_over", "restart", "edited", "quit"};
+static const char *kMetricsClearNames[METRICS_MAX_CLEAR_ROWS] = {"single", "double", "triple", "tetris"};
+
+void BeginMetricsGame(metrics_session_t *session, const level_t *level, uint64 seed)
+{
+    SDL_zerop(session);
+    session->active = true;
+
+    metrics_game_t *game = &session->game;
+    SDL_Time now;
+    game->startTimeNs = SDL_GetCurrentTime(&now) ? now : 0;
+    game->seed = seed;
+    game->randomizerMode = (uint32)level->pieceQueue.mode;
+    game->steps[game->stepCount++] = {0, 0, (uint32)level->stepMs};
+}
+
+void RecordMetricsFrame(metrics_session_t *session, const level_t *level, const replay_frame_t *frame,
+                        const level_events_t *events, bool playing, uint64 frameNs)
+{
+    if (!session->active)
+    {
+        return;
+    }
+
+    metrics_game_t *game = &session->game;
+
+    if (playing)
+    {
+        game->playMs += frame->dtMs;
+        game->frameCount++;
+        session->frameHistogram[SDL_min(frameNs / METRICS_FRAME_BUCKET_NS, METRICS_FRAME_BUCKET_COUNT - 1)]++;
+        session->frameNsMax = SDL_max(session->frameNsMax, frameNs);
+
+        /* Presses only, a held button isn't an input every frame. */
+        game_input_t input{};
+        UnpackGameInput(frame->input, &input);
+
+        for (int i = 0; i < (int)SDL_arraysize(input.buttons); ++i)
+        {
+            game->inputs += input.buttons[i].transitionCount ? GetInputButtonDownCount(&input.buttons[i]) : 0;
+        }
+    }
+
+    if (!(events->flags & LEVEL_EVENT_PIECE_LOCKED))
+    {
+        return;
+    }
+
+    uint32 rows = (uint32)CountSetBits32(events->clearedRowsMask);
+    game->pieces++;
+    game->lines += rows;
+    game->clears[SDL_min(rows, METRICS_MAX_CLEAR_ROWS)] += rows ? 1 : 0;
+    game->pieceMsMax = SDL_max(game->pieceMsMax, (uint32)(game->playMs - session->lastLockPlayMs));
+    session->lastLockPlayMs = game->playMs;
+
+    if (level->stepMs != game->steps[game->stepCount - 1].stepMs && game->stepCount < METRICS_MAX_STEP_CHANGES)
+    {
+        game->steps[game->stepCount++] = {game->pieces, (uint32)game->playMs, (uint32)level->stepMs};
+    }
+}
+
+/**
+ * @brief Upper edge of the bucket holding the percentile, the exact maximum for the overflow bucket.
+ */
+static real32 GetMetricsFrameMs(const metrics_session_t *session, uint32 percentile)
+{
+    uint64 rank = ((uint64)session->game.frameCount * percentile + 99) / 100;
+    uint64 seen = 0;
+
+    for (uint32 bucket = 0; bucket < METRICS_FRAME_BUCKET_COUNT - 1; ++bucket)
+    {
+        seen += session->frameHistogram[bucket];
+
+        if (rank && seen >= rank)
+        {
+            return (real32)SDL_min((uint64)(bucket + 1) * METRICS_FRAME_BUCKET_NS, session->frameNsMax) / 1e6f;
+        }
+    }
+
+    return (real32)session->frameNsMax / 1e6f;
+}
+
+bool EndMetricsGame(metrics_session_t *session, const level_t *level, eMetricsGameEnd end)
+{
+    if (!session->active)
+    {
+        return false;
+    }
+
+    metrics_game_t *game = &session->game;
+    session->active = false;
+    game->end = (uint32)end;
+    game->score = level->score;
+    game->frameMsP50 = GetMetricsFrameMs(session, 50);
+    game->frameMsP90 = GetMetricsFrameMs(session, 90);
+    game->frameMsP99 = GetMetricsFrameMs(session, 99);
+    game->frameMsMax = (real32)session->frameNsMax / 1e6f;
+    return true;
+}
+
+static bool AppendMetricsLine(char *line, uint32 lineSize, uint32 *length, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = SDL_vsnprintf(line + *length, lineSize - *length, format, args);
+    va_end(args);
+
+    if (written < 0 || (uint32)written >= lineSize - *length)
+    {
+        return false;
+    }
+
+    *length += (uint32)written;
+    return true;
+}
+
+uint32 FormatMetricsGame(const metrics_game_t *game, char *line, uint32 lineSize)
+{
+    real64 playMinutes = game->playMs / 60000.0;
+    uint32 length = 0;
+    bool fits = AppendMetricsLine(
+        line, lineSize, &length,
+        "{\"v\":%d,\"startUnixMs\":%lld,\"seed\":%llu,\"randomizer\":\"%s\",\"end\":\"%s\",\"playMs\":%llu,"
+        "\"score\":%u,\"pieces\":%u,\"lines\":%u,\"clears\":{",
+        METRICS_VERSION, (long long)(game->startTimeNs / 1000000), (unsigned long long)game->seed,
+        game->randomizerMode == PIECE_RANDOMIZER_BAG ? "bag" : "uniform", kMetricsGameEndNames[game->end],
+        (unsigned long long)game->playMs, game->score, game->pieces, game->lines);
+
+    for (uint32 rows = 1; rows <= METRICS_MAX_CLEAR_ROWS; ++rows)
+    {
+        fits = fits && AppendMetricsLine(line, lineSize, &length, "%s\"%s\":%u", rows > 1 ? "," : "",
+                                         kMetricsClearNames[rows - 1], game->clears[rows]);
+    }
+
+    fits = fits && AppendMetricsLine(line, lineSize, &length,
+                                     "},\"piecesPerSecond\":%.3f,\"inputs\":%u,\"inputsPerMinute\":%.1f,"
+                                     "\"pieceMsAvg\":%.1f,\"pieceMsMax\":%u,\"stepMs\":[",
+                                     playMinutes > 0.0 ? game->pieces / (playMinutes * 60.0) : 0.0, game->inputs,
+                                     playMinutes > 0.0 ? game->inputs / playMinutes : 0.0,
+                                     game->pieces ? (real64)game->playMs / game->pieces : 0.0, game->pieceMsMax);
+
+    for (uint32 i = 0; i < game->stepCount; ++i)
+    {
+        const metrics_step_t *step = &game->steps[i];
+        fits = fits && AppendMetricsLine(line, lineSize, &length, "%s{\"piece\":%u,\"playMs\":%u,\"stepMs\":%u}",
+                                         i ? "," : "", step->piece, step->playMs, step->stepMs);
+    }
+
+    fits = fits && AppendMetricsLine(line, lineSize, &length,
+                                     "],\"frames\":%u,\"frameMs\":{\"p50\":%.2f,\"p90\":%.2f,\"p99\":%.2f,\"max\":%.2f}}\n",
+                                     game->frameCount, game->frameMsP50, game->frameMsP90, game->frameMsP99,
+                                     game->frameMsMax);
+    return fits ? length : 0;
+}
+
+static int SDLCALL RunMetricsWriter(void *data)
+{
+    metrics_log_t *log = (metrics_log_t *)data;
+    SDL_LockMutex(log->mutex);
+
+    for (;;)
+    {
+        while (log->queueRead == log->queueWrite && !log->quit)
+        {
+            SDL_WaitCondition(log->changed, log->mutex);
+        }
+
+        /* Quit only once everything queued is on disk. */
+        if (log->queueRead == log->queueWrite)
+        {
+            break;
+        }
+
+        /* The slot stays ours until queueRead moves past it, format and write it unlocked. */
+        const metrics_game_t *game = &log->queue[log->queueRead % METRICS_QUEUE_SIZE];
+        SDL_UnlockMutex(log->mutex);
+
+        uint32 length = FormatMetricsGame(game, log->line, sizeof(log->line));
+
+        if (length && SDL_WriteIO(log->file, log->line, length) == length && SDL_FlushIO(log->file))
+        {
+            log->written++;
+        }
+        else
+        {
+            log->failed++;
+        }
+
+        SDL_LockMutex(log->mutex);
+        log->queueRead++;
+    }
+
+    SDL_UnlockMutex(log->mutex);
+    return 0;
+}
+
+bool OpenMetricsLog(metrics_log_t *log, const char *path)
+{
+    log->file = SDL_IOFromFile(path, "ab");
+    log->mutex = SDL_CreateMutex();
+    log->changed = SDL_CreateCondition();
+    log->thread = (log->file && log->mutex && log->changed) ? SDL_CreateThread(RunMetricsWriter, "metrics", log) : nullptr;
+
+    if (!log->thread)
+    {
+        CloseMetricsLog(log);
+        return false;
+    }
+
+    return true;
+}
+
+void CloseMetricsLog(metrics_log_t *log)
+{
+    if (log->thread)
+    {
+        SDL_LockMutex(log->mutex);
+        log->quit = true;
+        SDL_SignalCondition(log->changed);
+        SDL_UnlockMutex(log->mutex);
+        SDL_WaitThread(log->thread, nullptr);
+        log->thread = nullptr;
+
+        SDL_Log("metrics: %llu games written, %llu dropped, %llu failed", (unsigned long long)log->written,
+                (unsigned long long)log->dropped, (unsigned long long)log->failed);
+    }
+
+    SDL_DestroyCondition(log->changed);
+    SDL_DestroyMutex(log->mutex);
+
+    if (log->file)
+    {
+        SDL_CloseIO(log->file);
+    }
+
+    log->changed = nullptr;
+    log->mutex = nullptr;
+    log->file = nullptr;
+}
+
+bool SubmitMetricsGame(metrics_log_t *log, const metrics_game_t *game)
+{
+    SDL_LockMutex(log->mutex);
+    bool full = log->queueWrite - log->queueRead == METRICS_QUEUE_SIZE;
+
+    if (full)
+    {
+        log->dropped++;
+    }
+    else
+    {
+        log->queue[log->queueWrite % METRICS_QUEUE_SIZE] = *game;
+        log->queueWrite++;
+        log->submitted++;
+        SDL_SignalCondition(log->changed);
+    }
+
+    SDL_UnlockMutex(log->mutex);
+    return !full;
+}
@@ -0,0 +1,158 @@
+#if !defined(TETRIS_METRICS_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+#include "tetris_level.h"
+#include "tetris_replay.h"
+
+#define METRICS_VERSION 1
+#define METRICS_DEFAULT_FILE_NAME "metrics.jsonl"
+/**
+ * @brief Finished games waiting for the writer thread, a game is dropped when all are taken.
+ */
+#define METRICS_QUEUE_SIZE 16
+/**
+ * @brief Singles to tetrises, bigger clears are counted as tetrises.
+ */
+#define METRICS_MAX_CLEAR_ROWS 4
+/**
+ * @brief stepMs only decreases, this fits the whole progression from MAX_STEP_MS to MIN_STEP_MS.
+ */
+#define METRICS_MAX_STEP_CHANGES ((MAX_STEP_MS - MIN_STEP_MS) / DELTA_STEP_MS + 1)
+/**
+ * @brief Frame time histogram: 50 us buckets up to ~100 ms, the last bucket takes everything slower.
+ */
+#define METRICS_FRAME_BUCKET_NS 50000
+#define METRICS_FRAME_BUCKET_COUNT 2048
+#define METRICS_LINE_SIZE 4096
+
+enum eMetricsGameEnd
+{
+    METRICS_GAME_END_GAME_OVER = 0,
+    METRICS_GAME_END_RESTART,
+    /**
+     * @brief A saved game was loaded or the game was rewound.
+     */
+    METRICS_GAME_END_EDITED,
+    METRICS_GAME_END_QUIT,
+};
+
+struct metrics_step_t
+{
+    uint32 piece;
+    uint32 playMs;
+    uint32 stepMs;
+};
+
+/**
+ * @brief One game's record, copied by value into the writer queue.
+ */
+struct metrics_game_t
+{
+    /**
+     * @brief SDL_GetCurrentTime() when the game started.
+     */
+    int64 startTimeNs;
+    uint64 seed;
+    uint32 randomizerMode;
+    uint32 end;
+
+    /**
+     * @brief Time spent unpaused, everything per second or per minute is relative to it.
+     */
+    uint64 playMs;
+    uint32 pieces;
+    uint32 lines;
+    uint32 score;
+    uint32 clears[METRICS_MAX_CLEAR_ROWS + 1];
+    uint32 inputs;
+    uint32 pieceMsMax;
+
+    uint32 stepCount;
+    metrics_step_t steps[METRICS_MAX_STEP_CHANGES];
+
+    uint32 frameCount;
+    real32 frameMsP50;
+    real32 frameMsP90;
+    real32 frameMsP99;
+    real32 frameMsMax;
+};
+
+/**
+ * @brief Game thread side: accumulates the running game, all fixed size.
+ */
+struct metrics_session_t
+{
+    bool active;
+    metrics_game_t game;
+    uint64 lastLockPlayMs;
+    uint64 frameNsMax;
+    uint32 frameHistogram[METRICS_FRAME_BUCKET_COUNT];
+};
+
+/**
+ * @brief Appends finished games to a JSONL file from a background thread.
+ * @note The game thread only takes the mutex to claim a queue slot, the writer never holds it
+ * while formatting or writing, so a slow disk costs dropped games, never frame time.
+ */
+struct metrics_log_t
+{
+    SDL_IOStream *file;
+    SDL_Thread *thread;
+    SDL_Mutex *mutex;
+    SDL_Condition *changed;
+    bool quit;
+
+    metrics_game_t queue[METRICS_QUEUE_SIZE];
+    uint32 queueWrite;
+    uint32 queueRead;
+
+    /* Counted under the mutex. */
+    uint64 submitted;
+    uint64 dropped;
+
+    /* Writer thread only. */
+    uint64 written;
+    uint64 failed;
+    char line[METRICS_LINE_SIZE];
+};
+
+void BeginMetricsGame(metrics_session_t *session, const level_t *level, uint64 seed);
+
+/**
+ * @brief Call once per single-player frame after the step.
+ * @param playing The level was running before and after the frame's commands, paused frames count for nothing.
+ */
+void RecordMetricsFrame(metrics_session_t *session, const level_t *level, const replay_frame_t *frame,
+                        const level_events_t *events, bool playing, uint64 frameNs);
+
+/**
+ * @brief Finishes the running game into its record, no-op if none is running.
+ * @return False if no game was running.
+ */
+bool EndMetricsGame(metrics_session_t *session, const level_t *level, eMetricsGameEnd end);
+
+/**
+ * @brief Opens path for appending and starts the writer thread.
+ */
+bool OpenMetricsLog(metrics_log_t *log, const char *path);
+
+/**
+ * @brief Writes what is still queued, stops the thread and closes the file.
+ */
+void CloseMetricsLog(metrics_log_t *log);
+
+/**
+ * @brief Game thread: queues a copy of game, never waits on the writer.
+ * @return False if the queue is full and the game was dropped.
+ */
+bool SubmitMetricsGame(metrics_log_t *log, const metrics_game_t *game);
+
+/**
+ * @brief Formats one game as a single JSON line with a trailing newline.
+ * @return Length written, 0 if it didn't fit.
+ */
+uint32 FormatMetricsGame(const metrics_game_t *game, char *line, uint32 lineSize);
+
+#define TETRIS_METRICS_H
+#endif
@@ -0,0 +1,184 @@
+#include "tetris_net.h"
+
+#if defined(SDL_PLATFORM_UNIX) || defined(SDL_PLATFORM_APPLE)
+#define NET_USE_POSIX_SOCKETS 1
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#if defined(NET_USE_POSIX_SOCKETS)
+
+bool OpenNetSocket(net_socket_t *socket, uint16 localPort, const char *peerHost, uint16 peerPort)
+{
+    SDL_zerop(socket);
+    socket->fd = -1;
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo *peer = nullptr;
+
+    if (getaddrinfo(peerHost, nullptr, &hints, &peer) != 0 || !peer)
+    {
+        return SDL_SetError("Couldn't resolve %s", peerHost);
+    }
+
+    socket->peerAddress = ((sockaddr_in *)peer->ai_addr)->sin_addr.s_addr;
+    socket->peerPort = htons(peerPort);
+    freeaddrinfo(peer);
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (fd < 0)
+    {
+        return SDL_SetError("Couldn't create socket: %s", strerror(errno));
+    }
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(localPort);
+
+    if (bind(fd, (sockaddr *)&local, sizeof(local)) != 0 ||
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0)
+    {
+        close(fd);
+        return SDL_SetError("Couldn't bind port %u: %s", localPort, strerror(errno));
+    }
+
+    /* A connected probe learns the local address the peer will see without sending anything. */
+    int probe = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in route{};
+    route.sin_family = AF_INET;
+    route.sin_addr.s_addr = socket->peerAddress;
+    route.sin_port = socket->peerPort;
+    socklen_t routeSize = sizeof(route);
+
+    if (probe >= 0 && connect(probe, (sockaddr *)&route, sizeof(route)) == 0 &&
+        getsockname(probe, (sockaddr *)&route, &routeSize) == 0)
+    {
+        socket->localAddress = route.sin_addr.s_addr;
+    }
+
+    if (probe >= 0)
+    {
+        close(probe);
+    }
+
+    socket->fd = fd;
+    socket->localPort = htons(localPort);
+    return true;
+}
+
+void CloseNetSocket(net_socket_t *socket)
+{
+    if (socket->fd >= 0)
+    {
+        close(socket->fd);
+    }
+
+    socket->fd = -1;
+}
+
+bool GetNetLocalPlayer(const net_socket_t *socket, uint32 *player)
+{
+    uint64 local = (uint64)ntohl(socket->localAddress) << 16 | ntohs(socket->localPort);
+    uint64 peer = (uint64)ntohl(socket->peerAddress) << 16 | ntohs(socket->peerPort);
+
+    if (socket->localPort != socket->peerPort)
+    {
+        *player = ntohs(socket->localPort) < ntohs(socket->peerPort) ? 0 : 1;
+        return true;
+    }
+
+    if (!socket->localAddress || local == peer)
+    {
+        return SDL_SetError("Both ends use port %u, give them different ports", ntohs(socket->localPort));
+    }
+
+    *player = local < peer ? 0 : 1;
+    return true;
+}
+
+bool SendNetPacket(net_socket_t *socket, const void *data, uint32 size)
+{
+    sockaddr_in peer{};
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = socket->peerAddress;
+    peer.sin_port = socket->peerPort;
+
+    /* A full send buffer is just another lost datagram, the next packet carries the same inputs. */
+    if (sendto(socket->fd, data, size, 0, (sockaddr *)&peer, sizeof(peer)) < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        return SDL_SetError("Couldn't send: %s", strerror(errno));
+    }
+
+    return true;
+}
+
+int32 ReceiveNetPacket(net_socket_t *socket, void *data, uint32 capacity)
+{
+    for (;;)
+    {
+        sockaddr_in from{};
+        socklen_t fromSize = sizeof(from);
+        ssize_t size = recvfrom(socket->fd, data, capacity, 0, (sockaddr *)&from, &fromSize);
+
+        if (size < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return 0;
+            }
+
+            /* Loopback reports ICMP port unreachable while the peer isn't up yet. */
+            if (errno == ECONNREFUSED || errno == EINTR)
+            {
+                continue;
+            }
+
+            SDL_SetError("Couldn't receive: %s", strerror(errno));
+            return -1;
+        }
+
+        if (from.sin_addr.s_addr == socket->peerAddress && from.sin_port == socket->peerPort)
+        {
+            return (int32)size;
+        }
+    }
+}
+
+#else
+
+bool OpenNetSocket(net_socket_t *socket, uint16 localPort, const char *peerHost, uint16 peerPort)
+{
+    SDL_zerop(socket);
+    socket->fd = -1;
+    return SDL_SetError("Versus mode needs POSIX sockets");
+}
+
+void CloseNetSocket(net_socket_t *socket)
+{
+}
+
+bool GetNetLocalPlayer(const net_socket_t *socket, uint32 *player)
+{
+    return SDL_SetError("Versus mode needs POSIX sockets");
+}
+
+bool SendNetPacket(net_socket_t *socket, const void *data, uint32 size)
+{
+    return SDL_SetError("Versus mode needs POSIX sockets");
+}
+
+int32 ReceiveNetPacket(net_socket_t *socket, void *data, uint32 capacity)
+{
+    return -1;
+}
+
+#endif
@@ -0,0 +1,48 @@
+#if !defined(TETRIS_NET_H)
+
+#include "tetris_typedefs.h"
+
+/**
+ * @brief Non-blocking UDP socket bound to a local port that talks to one peer.
+ * @note POSIX sockets only, OpenNetSocket() fails elsewhere.
+ */
+struct net_socket_t
+{
+    int fd;
+    /**
+     * @note Network byte order.
+     */
+    uint32 peerAddress;
+    uint16 peerPort;
+    /**
+     * @brief The address the route to the peer leaves from, and the bound port.
+     * @note Network byte order.
+     */
+    uint32 localAddress;
+    uint16 localPort;
+};
+
+/**
+ * @param peerHost IPv4 address or host name.
+ */
+bool OpenNetSocket(net_socket_t *socket, uint16 localPort, const char *peerHost, uint16 peerPort);
+
+void CloseNetSocket(net_socket_t *socket);
+
+/**
+ * @brief Picks the same player index on both ends: the lower port is player 0, equal ports go by the lower address.
+ * @note Behind NAT the two ends see different addresses, give them different ports there.
+ * @return False if the ends can't be told apart.
+ */
+bool GetNetLocalPlayer(const net_socket_t *socket, uint32 *player);
+
+bool SendNetPacket(net_socket_t *socket, const void *data, uint32 size);
+
+/**
+ * @brief Receives one datagram from the peer, datagrams from anyone else are dropped.
+ * @return Size of the datagram, 0 if none is pending, -1 on error.
+ */
+int32 ReceiveNetPacket(net_socket_t *socket, void *data, uint32 capacity);
+
+#define TETRIS_NET_H
+#endif
@@ -0,0 +1,260 @@
+#include "tetris_opponent.h"
+
+/**
+ * @brief From a greedy bot with slow hands to a deep search pressing every tick.
+ */
+static const opponent_difficulty_t kOpponentDifficulties[OPPONENT_DIFFICULTY_COUNT] = {
+    {1, 1, 4, 8},
+    {4, 2, 8, 5},
+    {16, 3, 16, 3},
+    {64, 4, 32, 2},
+    {256, PLANNER_MAX_DEPTH, 100, 1},
+};
+
+static int SDLCALL RunOpponentThread(void *data)
+{
+    opponent_t *opponent = (opponent_t *)data;
+    /* Searches are long and few, the frame loop must never wait for a core because of one. */
+    SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    SDL_LockMutex(opponent->mutex);
+
+    for (;;)
+    {
+        while (!opponent->quit && opponent->searchedId == opponent->requestId)
+        {
+            SDL_WaitCondition(opponent->wake, opponent->mutex);
+        }
+
+        if (opponent->quit)
+        {
+            break;
+        }
+
+        uint32 id = opponent->requestId;
+        CopyLevel(&opponent->searchLevel, &opponent->request);
+        opponent->planner.deadlineNs = opponent->requestNs + opponent->difficulty.budgetMs * SDL_NS_PER_MS;
+        opponent->searchedId = id;
+        SDL_SetAtomicInt(&opponent->cancel, 0);
+        SDL_UnlockMutex(opponent->mutex);
+
+        planner_stats_t before = opponent->planner.stats;
+        uint64 start = SDL_GetTicksNS();
+        bot_move_t move = PlanBotMove(&opponent->planner, nullptr, &opponent->searchLevel);
+        uint64 searchNs = SDL_GetTicksNS() - start;
+
+        SDL_LockMutex(opponent->mutex);
+        opponent_stats_t *stats = &opponent->stats;
+        stats->searches++;
+        stats->searchNs += searchNs;
+        stats->maxSearchNs = SDL_max(stats->maxSearchNs, searchNs);
+        stats->plies += opponent->planner.stats.plies - before.plies;
+
+        if (id == opponent->requestId)
+        {
+            stats->stopped += opponent->planner.stats.stopped - before.stopped;
+            opponent->resultMove = move;
+            opponent->resultId = id;
+        }
+        else
+        {
+            stats->discarded++;
+        }
+    }
+
+    SDL_UnlockMutex(opponent->mutex);
+    return 0;
+}
+
+bool StartOpponent(opponent_t *opponent, uint32 difficulty)
+{
+    SDL_zerop(opponent);
+    opponent->difficultyIndex = SDL_clamp(difficulty, 1u, (uint32)OPPONENT_DIFFICULTY_COUNT);
+    opponent->difficulty = kOpponentDifficulties[opponent->difficultyIndex - 1];
+
+    if (!InitPlanner(&opponent->planner, opponent->difficulty.beamWidth, opponent->difficulty.depth))
+    {
+        return false;
+    }
+
+    opponent->planner.cancel = &opponent->cancel;
+    /* No board hashes to this, the first tick posts the first piece. */
+    opponent->planKey = ~0ull;
+    opponent->mutex = SDL_CreateMutex();
+    opponent->wake = SDL_CreateCondition();
+    opponent->thread = opponent->mutex && opponent->wake
+                           ? SDL_CreateThread(RunOpponentThread, "opponent", opponent)
+                           : nullptr;
+
+    if (!opponent->thread)
+    {
+        StopOpponent(opponent);
+        return false;
+    }
+
+    return true;
+}
+
+void StopOpponent(opponent_t *opponent)
+{
+    if (opponent->thread)
+    {
+        SDL_LockMutex(opponent->mutex);
+        opponent->quit = true;
+        SDL_SetAtomicInt(&opponent->cancel, 1);
+        SDL_SignalCondition(opponent->wake);
+        SDL_UnlockMutex(opponent->mutex);
+        SDL_WaitThread(opponent->thread, nullptr);
+        opponent->thread = nullptr;
+    }
+
+    SDL_DestroyCondition(opponent->wake);
+    SDL_DestroyMutex(opponent->mutex);
+    opponent->wake = nullptr;
+    opponent->mutex = nullptr;
+    FreePlanner(&opponent->planner);
+}
+
+/**
+ * @brief Changes whenever the bot's piece or board does: a lock, a cleared row or incoming garbage.
+ */
+static uint64 GetOpponentPlanKey(const level_t *level)
+{
+    return level->world.hash ^ ((uint64)level->pieceQueue.head << 56) ^ (level->gameOver ? 1 : 0);
+}
+
+/**
+ * @brief Hands the level to the search thread, a search still running on an older one is cancelled.
+ */
+static void PostOpponentRequest(opponent_t *opponent, const level_t *level)
+{
+    SDL_LockMutex(opponent->mutex);
+    CopyLevel(&opponent->request, level);
+    opponent->requestNs = SDL_GetTicksNS();
+    opponent->requestId++;
+    SDL_SetAtomicInt(&opponent->cancel, 1);
+    SDL_SignalCondition(opponent->wake);
+    SDL_UnlockMutex(opponent->mutex);
+}
+
+static void PollOpponentResult(opponent_t *opponent)
+{
+    SDL_LockMutex(opponent->mutex);
+
+    if (opponent->resultId == opponent->requestId)
+    {
+        uint64 decisionNs = SDL_GetTicksNS() - opponent->requestNs;
+        /* The search counts turns from the request's orientation, the piece may have turned since it was posted. */
+        const player_data_t *data = &opponent->request.player.data;
+        opponent->plan = opponent->resultMove;
+        opponent->planRotation =
+            data->cellCount ? GetPlayerRotation(data->kind, data->rotation + (uint32)opponent->plan.rotations)->rotation
+                            : 0;
+        opponent->hasPlan = true;
+        opponent->stats.decisions++;
+        opponent->stats.decisionNs += decisionNs;
+        opponent->stats.maxDecisionNs = SDL_max(opponent->stats.maxDecisionNs, decisionNs);
+        opponent->stats.lastDecisionNs = decisionNs;
+    }
+
+    SDL_UnlockMutex(opponent->mutex);
+}
+
+/**
+ * @brief Rotates first, then steps towards the planned column, then holds soft drop.
+ * @note A press is a press and release within the tick, MovePlayer acts on it once.
+ */
+static uint16 GetOpponentPlanInput(opponent_t *opponent, const level_t *level)
+{
+    const player_t *player = &level->player;
+    game_input_t input{};
+
+    bool aligned = false;
+    bool rotated = false;
+
+    if (opponent->hasPlan && player->data.cellCount)
+    {
+        rotated = player->data.rotation == opponent->planRotation;
+        aligned = rotated && player->position.x == opponent->plan.x;
+    }
+
+    /* Soft drop is held from the tick the piece is in place until the plan is gone. */
+    input.down.isDown = opponent->holdingDown;
+    SetInputButtonDown(&input.down, aligned);
+    opponent->holdingDown = aligned;
+
+    if (opponent->hasPlan && player->data.cellCount && !aligned &&
+        opponent->tick - opponent->lastPressTick >= opponent->difficulty.pressTicks)
+    {
+        game_input_button_t *button = !rotated ? &input.rotate
+                                               : (player->position.x < opponent->plan.x ? &input.right : &input.left);
+        SetInputButtonDown(button, true);
+        SetInputButtonDown(button, false);
+        opponent->lastPressTick = opponent->tick;
+    }
+
+    return PackGameInput(&input);
+}
+
+uint16 TickOpponent(opponent_t *opponent, const level_t *level)
+{
+    uint64 start = SDL_GetTicksNS();
+    uint64 key = GetOpponentPlanKey(level);
+    opponent->tick++;
+
+    if (key != opponent->planKey)
+    {
+        opponent->planKey = key;
+        opponent->hasPlan = false;
+
+        if (!level->gameOver)
+        {
+            PostOpponentRequest(opponent, level);
+        }
+    }
+    else if (!opponent->hasPlan && !level->gameOver)
+    {
+        PollOpponentResult(opponent);
+    }
+
+    uint16 input = GetOpponentPlanInput(opponent, level);
+    uint64 tickNs = SDL_GetTicksNS() - start;
+    opponent->stats.ticks++;
+    opponent->stats.tickNs += tickNs;
+    opponent->stats.maxTickNs = SDL_max(opponent->stats.maxTickNs, tickNs);
+    return input;
+}
+
+void FormatOpponentStats(opponent_t *opponent, char *text, uint64 size)
+{
+    opponent_stats_t stats;
+
+    if (opponent->mutex)
+    {
+        SDL_LockMutex(opponent->mutex);
+    }
+
+    stats = opponent->stats;
+
+    if (opponent->mutex)
+    {
+        SDL_UnlockMutex(opponent->mutex);
+    }
+
+    real64 decisions = (real64)SDL_max(stats.decisions, (uint64)1);
+    real64 searches = (real64)SDL_max(stats.searches, (uint64)1);
+    SDL_snprintf(text, size,
+                 "bot %u: %llu moves, decision last %.1f mean %.1f max %.1f ms (budget %u), depth %.1f/%u, "
+                 "%llu cut, %llu discarded; main thread %.1f us/tick, max %.1f us",
+                 opponent->difficultyIndex, (unsigned long long)stats.decisions, stats.lastDecisionNs / 1e6,
+                 stats.decisionNs / decisions / 1e6, stats.maxDecisionNs / 1e6, opponent->difficulty.budgetMs,
+                 stats.plies / searches, opponent->difficulty.depth, (unsigned long long)stats.stopped,
+                 (unsigned long long)stats.discarded,
+                 stats.tickNs / (real64)SDL_max(stats.ticks, (uint64)1) / 1e3, stats.maxTickNs / 1e3);
+}
+
+void LogOpponentStats(opponent_t *opponent)
+{
+    char text[OPPONENT_STATS_SIZE];
+    FormatOpponentStats(opponent, text, sizeof(text));
+    SDL_Log("%s", text);
+}
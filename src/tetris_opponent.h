@@ -0,0 +1,137 @@
+#if !defined(TETRIS_OPPONENT_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+#include "tetris_level.h"
+#include "tetris_input.h"
+#include "tetris_planner.h"
+
+#define OPPONENT_DIFFICULTY_COUNT 5
+#define OPPONENT_DEFAULT_DIFFICULTY 3
+#define OPPONENT_STATS_SIZE 256
+
+/**
+ * @brief How hard the bot thinks and how fast its hands are.
+ */
+struct opponent_difficulty_t
+{
+    uint32 beamWidth;
+    uint32 depth;
+    /**
+     * @brief Per piece, counted from the moment the piece is handed to the search thread.
+     */
+    uint32 budgetMs;
+    /**
+     * @brief Versus ticks between two presses, holding soft drop isn't paced.
+     */
+    uint32 pressTicks;
+};
+
+/**
+ * @brief Counters of the bot's decisions.
+ * @note The search thread writes the search counters under the mutex, the main thread owns the rest.
+ */
+struct opponent_stats_t
+{
+    /* Search thread. */
+    uint64 searches;
+    uint64 searchNs;
+    uint64 maxSearchNs;
+    uint64 plies;
+    /**
+     * @brief Searches the budget cut short of the full depth.
+     */
+    uint64 stopped;
+    /**
+     * @brief Searches whose piece had changed by the time they finished, their move was thrown away.
+     */
+    uint64 discarded;
+
+    /* Main thread. */
+    uint64 decisions;
+    /**
+     * @brief From handing a piece to the search thread to its move showing up on a tick.
+     */
+    uint64 decisionNs;
+    uint64 maxDecisionNs;
+    uint64 lastDecisionNs;
+    uint64 ticks;
+    /**
+     * @brief Time TickOpponent took on the main thread.
+     */
+    uint64 tickNs;
+    uint64 maxTickNs;
+};
+
+/**
+ * @brief A versus player driven by a beam search on its own thread.
+ * @note The main thread never waits for the search: every tick it posts the bot's level when the piece
+ * changed, picks up a finished move if there is one and turns it into button presses.
+ */
+struct opponent_t
+{
+    opponent_difficulty_t difficulty;
+    uint32 difficultyIndex;
+
+    SDL_Thread *thread;
+    SDL_Mutex *mutex;
+    SDL_Condition *wake;
+
+    /* Under the mutex. */
+    bool quit;
+    level_t request;
+    uint64 requestNs;
+    uint32 requestId;
+    uint32 resultId;
+    bot_move_t resultMove;
+
+    /**
+     * @brief Set by the main thread when the running search is stale, cleared by the search thread.
+     */
+    SDL_AtomicInt cancel;
+
+    /* Search thread only. */
+    planner_t planner;
+    level_t searchLevel;
+    uint32 searchedId;
+
+    /* Main thread only. */
+    uint64 planKey;
+    bool hasPlan;
+    bot_move_t plan;
+    /**
+     * @brief The orientation the plan ends in, the plan's rotations are counted from the request's piece.
+     */
+    uint8 planRotation;
+    uint32 tick;
+    uint32 lastPressTick;
+    bool holdingDown;
+
+    opponent_stats_t stats;
+};
+
+/**
+ * @param difficulty 1 to OPPONENT_DIFFICULTY_COUNT.
+ */
+bool StartOpponent(opponent_t *opponent, uint32 difficulty);
+
+/**
+ * @brief Cancels the running search and joins the thread, the stats stay readable.
+ */
+void StopOpponent(opponent_t *opponent);
+
+/**
+ * @brief One versus tick on the main thread.
+ * @return The bot's packed game_input_t for this tick.
+ */
+uint16 TickOpponent(opponent_t *opponent, const level_t *level);
+
+/**
+ * @brief Decision latency, search depth and main thread cost in one line.
+ */
+void FormatOpponentStats(opponent_t *opponent, char *text, uint64 size);
+
+void LogOpponentStats(opponent_t *opponent);
+
+#define TETRIS_OPPONENT_H
+#endif
@@ -0,0 +1,248 @@
+#include <SDL3/SDL_intrin.h>
+#include "tetris_particles.h"
+
+/**
+ * @brief Lock dust by piece value, index 0 is unused.
+ */
+static const SDL_FColor kParticleValueColors[PLAYER_VALUE_COUNT + 1] = {
+    {1.0f, 1.0f, 1.0f, 1.0f},
+    {0.35f, 0.85f, 1.0f, 1.0f},
+    {1.0f, 0.9f, 0.3f, 1.0f},
+    {1.0f, 0.6f, 0.2f, 1.0f},
+    {0.4f, 1.0f, 0.45f, 1.0f},
+    {0.8f, 0.45f, 1.0f, 1.0f},
+    {0.3f, 0.5f, 1.0f, 1.0f},
+    {0.7f, 0.7f, 0.7f, 1.0f},
+};
+
+static const SDL_FColor kParticleLineClearColor = {1.0f, 0.95f, 0.75f, 1.0f};
+
+/**
+ * @brief The position, velocity and life arrays.
+ */
+#define PARTICLE_FIELD_COUNT 6
+
+uint64 GetParticleSystemSize(uint32 capacity)
+{
+    uint64 padded = (capacity + PARTICLE_LANES - 1) & ~(uint64)(PARTICLE_LANES - 1);
+    return PARTICLE_FIELD_COUNT * (padded * sizeof(real32) + PARTICLE_LANES * sizeof(real32)) +
+           capacity * (sizeof(SDL_FColor) + 4 * sizeof(SDL_Vertex) + 6 * sizeof(int)) + 3 * ARENA_DEFAULT_ALIGNMENT;
+}
+
+bool InitParticleSystem(particle_system_t *system, arena_t *arena, uint32 capacity, uint64 seed)
+{
+    SDL_zerop(system);
+    uint32 padded = (capacity + PARTICLE_LANES - 1) & ~(uint32)(PARTICLE_LANES - 1);
+    real32 **fields[PARTICLE_FIELD_COUNT] = {&system->x, &system->y, &system->vx,
+                                             &system->vy, &system->life, &system->fade};
+
+    /* Aligned for the SIMD loads, the padding lanes are updated along with the last live ones. */
+    for (real32 **field : fields)
+    {
+        *field = (real32 *)PushSize(arena, padded * sizeof(real32), PARTICLE_LANES * sizeof(real32));
+
+        if (!*field)
+        {
+            return SDL_SetError("No room for %u particles", capacity);
+        }
+    }
+
+    system->color = PushArray(arena, capacity, SDL_FColor);
+    system->vertices = PushArray(arena, capacity * 4, SDL_Vertex);
+    system->indices = PushArray(arena, capacity * 6, int);
+
+    if (!system->color || !system->vertices || !system->indices)
+    {
+        return SDL_SetError("No room for %u particles", capacity);
+    }
+
+    for (uint32 i = 0; i < capacity; ++i)
+    {
+        int *quad = &system->indices[i * 6];
+        int vertex = (int)i * 4;
+        quad[0] = vertex;
+        quad[1] = vertex + 1;
+        quad[2] = vertex + 2;
+        quad[3] = vertex;
+        quad[4] = vertex + 2;
+        quad[5] = vertex + 3;
+    }
+
+    system->capacity = capacity;
+    system->simd = true;
+    SeedRandom(&system->random, seed);
+    return true;
+}
+
+/**
+ * @return Uniform in [0, 1).
+ */
+inline real32 NextParticleRandom(random_t *random)
+{
+    return (NextRandom(random) >> 8) * (1.0f / 16777216.0f);
+}
+
+uint32 EmitParticles(particle_system_t *system, SDL_FRect area, vec2_t velocity, real32 spread, real32 lifetime,
+                     SDL_FColor color, uint32 count)
+{
+    uint32 emitted = SDL_min(count, system->capacity - system->count);
+    random_t *random = &system->random;
+
+    for (uint32 n = 0; n < emitted; ++n)
+    {
+        uint32 i = system->count++;
+        real32 life = lifetime * (0.5f + 0.5f * NextParticleRandom(random));
+        system->x[i] = area.x + area.w * NextParticleRandom(random);
+        system->y[i] = area.y + area.h * NextParticleRandom(random);
+        system->vx[i] = velocity.x + spread * (2.0f * NextParticleRandom(random) - 1.0f);
+        system->vy[i] = velocity.y + spread * (2.0f * NextParticleRandom(random) - 1.0f);
+        system->life[i] = life;
+        system->fade[i] = 1.0f / life;
+        system->color[i] = color;
+    }
+
+    return emitted;
+}
+
+void EmitLevelParticles(particle_system_t *system, const level_t *level, const level_events_t *events)
+{
+    if (!(events->flags & LEVEL_EVENT_PIECE_LOCKED))
+    {
+        return;
+    }
+
+    int32 width = level->world.size.x;
+    SDL_FColor dust = kParticleValueColors[SDL_min(events->lockedValue, (uint8)PLAYER_VALUE_COUNT)];
+
+    for (uint32 i = 0; i < events->lockedCellCount; ++i)
+    {
+        SDL_FRect bottom{(real32)(events->lockedCells[i] % width), (real32)(events->lockedCells[i] / width) + 0.9f,
+                         1.0f, 0.1f};
+        EmitParticles(system, bottom, vec2_t{0.0f, -2.0f}, 3.0f, 0.5f, dust, PARTICLE_LOCK_PER_CELL);
+    }
+
+    for (uint32 rows = events->clearedRowsMask; rows; rows &= rows - 1)
+    {
+        SDL_FRect row{0.0f, (real32)CountTrailingZeros32(rows), (real32)width, 1.0f};
+        EmitParticles(system, row, vec2_t{0.0f, -6.0f}, 8.0f, 0.9f, kParticleLineClearColor,
+                      PARTICLE_LINE_CLEAR_PER_CELL * (uint32)width);
+    }
+}
+
+static void IntegrateParticlesScalar(particle_system_t *system, uint32 count, real32 dt)
+{
+    for (uint32 i = 0; i < count; ++i)
+    {
+        system->vy[i] += PARTICLE_GRAVITY * dt;
+        system->x[i] += system->vx[i] * dt;
+        system->y[i] += system->vy[i] * dt;
+        system->life[i] -= dt;
+    }
+}
+
+#if defined(SDL_SSE2_INTRINSICS)
+static void IntegrateParticlesSSE2(particle_system_t *system, uint32 count, real32 dt)
+{
+    __m128 step = _mm_set1_ps(dt);
+    __m128 gravity = _mm_set1_ps(PARTICLE_GRAVITY * dt);
+
+    for (uint32 i = 0; i < count; i += PARTICLE_LANES)
+    {
+        __m128 vy = _mm_add_ps(_mm_load_ps(system->vy + i), gravity);
+        _mm_store_ps(system->vy + i, vy);
+        __m128 vx = _mm_load_ps(system->vx + i);
+        _mm_store_ps(system->x + i, _mm_add_ps(_mm_load_ps(system->x + i), _mm_mul_ps(vx, step)));
+        _mm_store_ps(system->y + i, _mm_add_ps(_mm_load_ps(system->y + i), _mm_mul_ps(vy, step)));
+        _mm_store_ps(system->life + i, _mm_sub_ps(_mm_load_ps(system->life + i), step));
+    }
+}
+#endif
+
+#if defined(SDL_NEON_INTRINSICS)
+static void IntegrateParticlesNEON(particle_system_t *system, uint32 count, real32 dt)
+{
+    float32x4_t step = vdupq_n_f32(dt);
+    float32x4_t gravity = vdupq_n_f32(PARTICLE_GRAVITY * dt);
+
+    for (uint32 i = 0; i < count; i += PARTICLE_LANES)
+    {
+        float32x4_t vy = vaddq_f32(vld1q_f32(system->vy + i), gravity);
+        vst1q_f32(system->vy + i, vy);
+        float32x4_t vx = vld1q_f32(system->vx + i);
+        vst1q_f32(system->x + i, vaddq_f32(vld1q_f32(system->x + i), vmulq_f32(vx, step)));
+        vst1q_f32(system->y + i, vaddq_f32(vld1q_f32(system->y + i), vmulq_f32(vy, step)));
+        vst1q_f32(system->life + i, vsubq_f32(vld1q_f32(system->life + i), step));
+    }
+}
+#endif
+
+void UpdateParticles(particle_system_t *system, real32 dt)
+{
+    uint32 count = system->count;
+
+#if defined(SDL_SSE2_INTRINSICS)
+    if (system->simd && SDL_HasSSE2())
+    {
+        IntegrateParticlesSSE2(system, count, dt);
+        count = 0;
+    }
+#elif defined(SDL_NEON_INTRINSICS)
+    if (system->simd && SDL_HasNEON())
+    {
+        IntegrateParticlesNEON(system, count, dt);
+        count = 0;
+    }
+#endif
+
+    IntegrateParticlesScalar(system, count, dt);
+
+    for (uint32 i = 0; i < system->count;)
+    {
+        if (system->life[i] > 0.0f)
+        {
+            ++i;
+            continue;
+        }
+
+        uint32 last = --system->count;
+        system->x[i] = system->x[last];
+        system->y[i] = system->y[last];
+        system->vx[i] = system->vx[last];
+        system->vy[i] = system->vy[last];
+        system->life[i] = system->life[last];
+        system->fade[i] = system->fade[last];
+        system->color[i] = system->color[last];
+    }
+}
+
+uint32 RenderParticles(SDL_Renderer *renderer, particle_system_t *system, SDL_FRect board, vec2i_t worldSize)
+{
+    if (!system->count)
+    {
+        return 0;
+    }
+
+    vec2_t cell{board.w / worldSize.x, board.h / worldSize.y};
+    vec2_t half{PARTICLE_SIZE * cell.w / 2.0f, PARTICLE_SIZE * cell.h / 2.0f};
+
+    for (uint32 i = 0; i < system->count; ++i)
+    {
+        real32 x = board.x + system->x[i] * cell.w;
+        real32 y = board.y + system->y[i] * cell.h;
+        SDL_FColor color = system->color[i];
+        color.a *= SDL_min(system->life[i] * system->fade[i], 1.0f);
+
+        SDL_Vertex *quad = &system->vertices[i * 4];
+        quad[0] = {{x - half.w, y - half.h}, color, {0.0f, 0.0f}};
+        quad[1] = {{x + half.w, y - half.h}, color, {1.0f, 0.0f}};
+        quad[2] = {{x + half.w, y + half.h}, color, {1.0f, 1.0f}};
+        quad[3] = {{x - half.w, y + half.h}, color, {0.0f, 1.0f}};
+    }
+
+    /* Untextured geometry blends with the draw blend mode. */
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometry(renderer, nullptr, system->vertices, (int)system->count * 4, system->indices,
+                       (int)system->count * 6);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    return 1;
+}
@@ -0,0 +1,109 @@
+#if !defined(TETRIS_PARTICLES_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+#include "tetris_math.h"
+#include "tetris_arena.h"
+#include "tetris_random.h"
+#include "tetris_level.h"
+
+/**
+ * @brief Live particles at most, emitting into a full system drops the new ones.
+ */
+#define PARTICLE_MAX_COUNT 32768
+/**
+ * @brief Particles per SIMD step, the arrays are padded to a multiple of it.
+ */
+#define PARTICLE_LANES 4
+/**
+ * @brief Cells per second squared, particles live in world cells with y down.
+ */
+#define PARTICLE_GRAVITY 40.0f
+/**
+ * @brief Quad side in cells.
+ */
+#define PARTICLE_SIZE 0.15f
+/**
+ * @brief Longest update step, frames aren't drawn while the game is idle.
+ */
+#define PARTICLE_MAX_STEP_NS 100000000ull
+#define PARTICLE_LINE_CLEAR_PER_CELL 48
+#define PARTICLE_LOCK_PER_CELL 12
+
+/**
+ * @brief Struct-of-arrays particle storage, updated PARTICLE_LANES at a time and drawn with one
+ * SDL_RenderGeometry call.
+ * @note Dead particles are swap-removed, [0, count) is always dense and unordered.
+ */
+struct particle_system_t
+{
+    real32 *x;
+    real32 *y;
+    real32 *vx;
+    real32 *vy;
+    /**
+     * @brief Seconds left, a particle at or below 0 is removed by the next update.
+     */
+    real32 *life;
+    /**
+     * @brief 1 / the starting life, alpha is life * fade.
+     */
+    real32 *fade;
+    SDL_FColor *color;
+    uint32 count;
+    uint32 capacity;
+
+    /**
+     * @brief Use the SSE2/NEON update, false forces the scalar one.
+     */
+    bool simd;
+    random_t random;
+
+    /**
+     * @brief Four per particle, rebuilt every draw.
+     */
+    SDL_Vertex *vertices;
+    /**
+     * @brief Two triangles per particle, written once by InitParticleSystem.
+     */
+    int *indices;
+};
+
+/**
+ * @brief Arena bytes InitParticleSystem takes, alignment included.
+ */
+uint64 GetParticleSystemSize(uint32 capacity);
+
+/**
+ * @brief Takes the arrays and the vertex and index buffers for capacity particles from arena.
+ */
+bool InitParticleSystem(particle_system_t *system, arena_t *arena, uint32 capacity, uint64 seed);
+
+/**
+ * @brief Spawns count particles at random points of area.
+ * @param area In world cells.
+ * @param spread Random velocity added on both axes, up to this many cells per second either way.
+ * @param lifetime Longest life in seconds, each particle gets between half of it and all of it.
+ * @return Particles spawned, fewer than count when the system fills up.
+ */
+uint32 EmitParticles(particle_system_t *system, SDL_FRect area, vec2_t velocity, real32 spread, real32 lifetime,
+                     SDL_FColor color, uint32 count);
+
+/**
+ * @brief Bursts along cleared rows and dust under the cells of a locked piece.
+ */
+void EmitLevelParticles(particle_system_t *system, const level_t *level, const level_events_t *events);
+
+/**
+ * @brief Moves every particle by dt seconds, then swap-removes the dead ones.
+ */
+void UpdateParticles(particle_system_t *system, real32 dt);
+
+/**
+ * @param board Where the world is drawn, see GetLevelBoardRect.
+ * @return SDL_Render calls made, 1 or 0 with no particles.
+ */
+uint32 RenderParticles(SDL_Renderer *renderer, particle_system_t *system, SDL_FRect board, vec2i_t worldSize);
+
+#define TETRIS_PARTICLES_H
+#endif
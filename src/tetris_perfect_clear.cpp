@@ -0,0 +1,555 @@
+#include "tetris_perfect_clear.h"
+
+/**
+ * @brief Positions counted locally between checks of the shared node budget.
+ */
+#define PERFECT_CLEAR_NODE_BATCH 1024
+
+/**
+ * @brief One job's search state, the moves so far and where its counters go.
+ */
+struct perfect_clear_search_t
+{
+    perfect_clear_solver_t *solver;
+    perfect_clear_memo_entry_t *memo;
+    perfect_clear_stats_t *stats;
+    uint32 branch;
+    uint32 pendingNodes;
+    bot_move_t moves[PERFECT_CLEAR_MAX_PIECES];
+};
+
+bool InitPerfectClearSolver(perfect_clear_solver_t *solver, uint32 threadCount, uint64 maxNodes)
+{
+    solver->threadCount = SDL_clamp(threadCount, 1u, (uint32)JOB_MAX_THREADS);
+    solver->memo = (perfect_clear_memo_entry_t *)SDL_calloc(
+        (size_t)solver->threadCount * PERFECT_CLEAR_MEMO_SIZE, sizeof(perfect_clear_memo_entry_t));
+    solver->generation = 0;
+    solver->maxNodes = maxNodes;
+    solver->stats = {};
+    return solver->memo != nullptr;
+}
+
+void FreePerfectClearSolver(perfect_clear_solver_t *solver)
+{
+    SDL_free(solver->memo);
+    solver->memo = nullptr;
+}
+
+uint32 GetLevelPerfectClearPieces(const level_t *level, const player_data_t **pieces, uint32 maxCount)
+{
+    uint32 count = 0;
+
+    if (count < maxCount)
+    {
+        pieces[count++] = &level->player.data;
+    }
+
+    for (uint32 i = 0; i < PIECE_PREVIEW_COUNT && count < maxCount; ++i)
+    {
+        pieces[count++] = GetPlayerKind(PeekPieceQueue(&level->pieceQueue, i).kindId);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Every distinct rotation of the piece, starting from the one it is in, cut from its compiled row masks.
+ */
+static void BuildPerfectClearPiece(const player_data_t *data, perfect_clear_piece_t *piece)
+{
+    piece->shapeCount = 0;
+
+    for (int32 rotations = 0; rotations < PLAYER_DATA_ROTATION_COUNT && data->cellCount; ++rotations)
+    {
+        const player_data_t *rotated = GetPlayerRotation(data->kind, data->rotation + (uint32)rotations);
+        uint32 columns = 0;
+        int32 minY = rotated->dim.y;
+        int32 maxY = -1;
+
+        for (int32 y = 0; y < rotated->dim.y; ++y)
+        {
+            if (rotated->rowMasks[y])
+            {
+                columns |= rotated->rowMasks[y];
+                minY = SDL_min(minY, y);
+                maxY = y;
+            }
+        }
+
+        perfect_clear_shape_t shape{};
+        shape.gridX = CountTrailingZeros32(columns);
+        shape.height = maxY - minY + 1;
+        shape.rotations = rotations;
+
+        while (columns >> (shape.gridX + shape.width))
+        {
+            shape.width++;
+        }
+
+        for (int32 row = 0; row < shape.height; ++row)
+        {
+            shape.rows[row] = (uint32)rotated->rowMasks[maxY - row] >> shape.gridX;
+        }
+
+        bool duplicate = false;
+
+        for (uint32 i = 0; i < piece->shapeCount && !duplicate; ++i)
+        {
+            const perfect_clear_shape_t *other = &piece->shapes[i];
+            duplicate = other->width == shape.width && other->height == shape.height &&
+                        SDL_memcmp(other->rows, shape.rows, sizeof(shape.rows)) == 0;
+        }
+
+        if (!duplicate)
+        {
+            piece->shapes[piece->shapeCount++] = shape;
+        }
+    }
+}
+
+static bool DoesPerfectClearShapeCollide(const perfect_clear_board_t *board, const perfect_clear_shape_t *shape,
+                                         int32 column, int32 y)
+{
+    for (int32 row = 0; row < shape->height; ++row)
+    {
+        if (y + row < (int32)board->height && (board->rows[y + row] & (shape->rows[row] << column)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Hard drops shape at column from above the board and clears the rows it fills.
+ * @return False if it comes to rest sticking out of the top.
+ */
+static bool PlacePerfectClearShape(const perfect_clear_solver_t *solver, const perfect_clear_board_t *board,
+                                   const perfect_clear_shape_t *shape, int32 column, perfect_clear_board_t *result)
+{
+    int32 y = (int32)board->height;
+
+    while (y > 0 && !DoesPerfectClearShapeCollide(board, shape, column, y - 1))
+    {
+        y--;
+    }
+
+    if (y + shape->height > (int32)board->height)
+    {
+        return false;
+    }
+
+    uint32 fullRow = solver->width == 32 ? ~0u : (1u << solver->width) - 1;
+    *result = {};
+
+    for (uint32 row = 0; row < board->height; ++row)
+    {
+        int32 shapeRow = (int32)row - y;
+        uint32 cells = board->rows[row] | (shapeRow >= 0 && shapeRow < shape->height ? shape->rows[shapeRow] << column : 0);
+
+        if (cells != fullRow)
+        {
+            result->rows[result->height++] = cells;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief A column filled in every remaining row stays filled until the end and no piece can cross it,
+ * so each area between such columns must be filled by whole pieces of its own.
+ */
+static bool CanPerfectClearTile(const perfect_clear_solver_t *solver, const perfect_clear_board_t *board)
+{
+    if (!solver->pieceCells || !board->height)
+    {
+        return true;
+    }
+
+    uint32 fullColumns = ~0u;
+
+    for (uint32 row = 0; row < board->height; ++row)
+    {
+        fullColumns &= board->rows[row];
+    }
+
+    int32 start = 0;
+
+    for (int32 x = 0; x <= solver->width; ++x)
+    {
+        if (x < solver->width && !(fullColumns & (1u << x)))
+        {
+            continue;
+        }
+
+        if (x > start)
+        {
+            uint32 area = ((x == 32 ? 0u : 1u << x) - 1) & ~((1u << start) - 1);
+            uint32 empty = 0;
+
+            for (uint32 row = 0; row < board->height; ++row)
+            {
+                empty += (uint32)CountSetBits32(~board->rows[row] & area);
+            }
+
+            if (empty % solver->pieceCells)
+            {
+                return false;
+            }
+        }
+
+        start = x + 1;
+    }
+
+    return true;
+}
+
+inline uint64 HashPerfectClearPosition(const perfect_clear_board_t *board, uint32 pieceIndex)
+{
+    uint64 hash = ((uint64)board->height << 32) | pieceIndex;
+
+    for (uint32 row = 0; row < board->height; ++row)
+    {
+        hash = (hash ^ board->rows[row]) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+
+    return hash;
+}
+
+static bool ProbePerfectClearMemo(perfect_clear_search_t *search, const perfect_clear_board_t *board,
+                                  uint32 pieceIndex, uint64 hash)
+{
+    uint32 generation = search->solver->generation;
+
+    for (uint32 probe = 0; probe < PERFECT_CLEAR_MEMO_PROBES; ++probe)
+    {
+        const perfect_clear_memo_entry_t *entry = &search->memo[(hash + probe) & (PERFECT_CLEAR_MEMO_SIZE - 1)];
+
+        if (entry->generation == generation && entry->pieceIndex == pieceIndex && entry->height == board->height &&
+            SDL_memcmp(entry->rows, board->rows, sizeof(board->rows)) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Takes a slot from an older solve in the probe window, or evicts the first one.
+ */
+static void StorePerfectClearMemo(perfect_clear_search_t *search, const perfect_clear_board_t *board,
+                                  uint32 pieceIndex, uint64 hash)
+{
+    uint32 generation = search->solver->generation;
+    perfect_clear_memo_entry_t *slot = &search->memo[hash & (PERFECT_CLEAR_MEMO_SIZE - 1)];
+
+    for (uint32 probe = 0; probe < PERFECT_CLEAR_MEMO_PROBES; ++probe)
+    {
+        perfect_clear_memo_entry_t *entry = &search->memo[(hash + probe) & (PERFECT_CLEAR_MEMO_SIZE - 1)];
+
+        if (entry->generation != generation)
+        {
+            slot = entry;
+            break;
+        }
+    }
+
+    SDL_memcpy(slot->rows, board->rows, sizeof(board->rows));
+    slot->generation = generation;
+    slot->height = (uint16)board->height;
+    slot->pieceIndex = (uint16)pieceIndex;
+}
+
+/**
+ * @return False once the node budget is spent or a lower branch has cleared.
+ */
+static bool KeepPerfectClearSearching(perfect_clear_search_t *search)
+{
+    perfect_clear_solver_t *solver = search->solver;
+    search->stats->nodes++;
+
+    if (++search->pendingNodes == PERFECT_CLEAR_NODE_BATCH)
+    {
+        uint64 nodes = solver->nodes.fetch_add(search->pendingNodes, std::memory_order_relaxed) + search->pendingNodes;
+        search->pendingNodes = 0;
+
+        if (solver->maxNodes && nodes > solver->maxNodes)
+        {
+            return false;
+        }
+    }
+
+    return solver->solvedBranch.load(std::memory_order_relaxed) > search->branch;
+}
+
+static ePerfectClearResult SearchPerfectClear(perfect_clear_search_t *search, const perfect_clear_board_t *board,
+                                              uint32 pieceIndex)
+{
+    perfect_clear_solver_t *solver = search->solver;
+
+    if (!board->height)
+    {
+        return PERFECT_CLEAR_SOLVED;
+    }
+
+    if (pieceIndex >= solver->pieceCount)
+    {
+        return PERFECT_CLEAR_IMPOSSIBLE;
+    }
+
+    uint64 hash = HashPerfectClearPosition(board, pieceIndex);
+
+    if (ProbePerfectClearMemo(search, board, pieceIndex, hash))
+    {
+        search->stats->memoHits++;
+        return PERFECT_CLEAR_IMPOSSIBLE;
+    }
+
+    if (!KeepPerfectClearSearching(search))
+    {
+        return PERFECT_CLEAR_GAVE_UP;
+    }
+
+    const perfect_clear_piece_t *piece = &solver->pieces[pieceIndex];
+
+    for (uint32 i = 0; i < piece->shapeCount; ++i)
+    {
+        const perfect_clear_shape_t *shape = &piece->shapes[i];
+
+        for (int32 column = 0; column + shape->width <= solver->width; ++column)
+        {
+            perfect_clear_board_t child;
+
+            if (!PlacePerfectClearShape(solver, board, shape, column, &child))
+            {
+                continue;
+            }
+
+            if (!CanPerfectClearTile(solver, &child))
+            {
+                search->stats->parityCuts++;
+                continue;
+            }
+
+            search->moves[pieceIndex] = {shape->rotations, column - shape->gridX};
+            ePerfectClearResult result = SearchPerfectClear(search, &child, pieceIndex + 1);
+
+            if (result != PERFECT_CLEAR_IMPOSSIBLE)
+            {
+                return result;
+            }
+        }
+    }
+
+    /* Only a fully searched position is known to fail, an interrupted one may still clear. */
+    StorePerfectClearMemo(search, board, pieceIndex, hash);
+    return PERFECT_CLEAR_IMPOSSIBLE;
+}
+
+/**
+ * @brief Job: searches everything below one placement of the first piece.
+ */
+static void SearchPerfectClearBranch(void *data, uint32 index, uint32 thread)
+{
+    perfect_clear_solver_t *solver = (perfect_clear_solver_t *)data;
+
+    /* Jobs still queued once the budget is spent would each count another batch before noticing. */
+    if (solver->maxNodes && solver->nodes.load(std::memory_order_relaxed) > solver->maxNodes)
+    {
+        solver->branchResults[index] = PERFECT_CLEAR_GAVE_UP;
+        return;
+    }
+
+    perfect_clear_search_t search;
+    search.solver = solver;
+    search.memo = &solver->memo[(size_t)thread * PERFECT_CLEAR_MEMO_SIZE];
+    search.stats = &solver->threadStats[thread];
+    search.branch = index;
+    search.pendingNodes = 0;
+    search.moves[0] = solver->branchMoves[index];
+
+    ePerfectClearResult result = SearchPerfectClear(&search, &solver->branchBoards[index], 1);
+    solver->nodes.fetch_add(search.pendingNodes, std::memory_order_relaxed);
+    solver->branchResults[index] = (uint8)result;
+
+    if (result != PERFECT_CLEAR_SOLVED)
+    {
+        return;
+    }
+
+    SDL_memcpy(solver->solutions[index], search.moves, solver->pieceCount * sizeof(bot_move_t));
+    uint32 solved = solver->solvedBranch.load(std::memory_order_relaxed);
+
+    while (index < solved && !solver->solvedBranch.compare_exchange_weak(solved, index, std::memory_order_relaxed))
+    {
+    }
+}
+
+ePerfectClearResult SolvePerfectClear(perfect_clear_solver_t *solver, job_pool_t *jobs, world_t *world,
+                                      const player_data_t **pieces, uint32 pieceCount, uint32 height,
+                                      bot_move_t *moves, uint32 *moveCount)
+{
+    uint64 start = SDL_GetTicksNS();
+    *moveCount = 0;
+    solver->stats.solves++;
+
+    /* Bottom-up rows of the world, and the stack height. */
+    perfect_clear_board_t board{};
+    uint32 filled = 0;
+    uint32 stackHeight = 0;
+    solver->width = world->size.x;
+
+    for (int32 row = 0; row < world->size.y; ++row)
+    {
+        uint32 cells = 0;
+
+        for (int32 x = 0; x < world->size.x; ++x)
+        {
+            cells |= IsValueEmpty(GetWorldValueUnchecked(world, {x, world->size.y - 1 - row})) ? 0u : 1u << x;
+        }
+
+        if (cells)
+        {
+            stackHeight = (uint32)row + 1;
+
+            if (stackHeight > PERFECT_CLEAR_MAX_HEIGHT)
+            {
+                SDL_SetError("The stack is %d rows high, a perfect clear is searched up to %d", row + 1,
+                             PERFECT_CLEAR_MAX_HEIGHT);
+                return PERFECT_CLEAR_GAVE_UP;
+            }
+
+            board.rows[row] = cells;
+            filled += (uint32)CountSetBits32(cells);
+        }
+    }
+
+    board.height = SDL_clamp(SDL_max(height, stackHeight), 0u, (uint32)PERFECT_CLEAR_MAX_HEIGHT);
+    uint32 empty = (uint32)solver->width * board.height - filled;
+
+    /* Each piece adds its cells and nothing is left over, so the pieces used are the prefix that fits exactly. */
+    uint32 cells = 0;
+    uint32 used = 0;
+    solver->pieceCells = 4;
+
+    for (; used < SDL_min(pieceCount, (uint32)PERFECT_CLEAR_MAX_PIECES) && cells < empty; ++used)
+    {
+        BuildPerfectClearPiece(pieces[used], &solver->pieces[used]);
+        uint32 pieceCells = 0;
+
+        for (int32 row = 0; row < solver->pieces[used].shapes[0].height; ++row)
+        {
+            pieceCells += (uint32)CountSetBits32(solver->pieces[used].shapes[0].rows[row]);
+        }
+
+        solver->pieceCells = used == 0 ? pieceCells : (solver->pieceCells == pieceCells ? pieceCells : 0);
+        cells += pieceCells;
+    }
+
+    if (cells < empty && pieceCount > PERFECT_CLEAR_MAX_PIECES)
+    {
+        SDL_SetError("The clear needs more than %d pieces", PERFECT_CLEAR_MAX_PIECES);
+        solver->stats.solveNs += SDL_GetTicksNS() - start;
+        return PERFECT_CLEAR_GAVE_UP;
+    }
+
+    if (cells != empty)
+    {
+        solver->stats.solveNs += SDL_GetTicksNS() - start;
+        return PERFECT_CLEAR_IMPOSSIBLE;
+    }
+
+    if (!empty)
+    {
+        solver->stats.solveNs += SDL_GetTicksNS() - start;
+        return PERFECT_CLEAR_SOLVED;
+    }
+
+    solver->pieceCount = used;
+    solver->generation = solver->generation + 1 ? solver->generation + 1 : 1;
+    solver->solvedBranch.store(UINT32_MAX);
+    solver->nodes.store(0);
+    solver->branchCount = 0;
+
+    if (!CanPerfectClearTile(solver, &board))
+    {
+        solver->stats.parityCuts++;
+        solver->stats.solveNs += SDL_GetTicksNS() - start;
+        return PERFECT_CLEAR_IMPOSSIBLE;
+    }
+
+    const perfect_clear_piece_t *first = &solver->pieces[0];
+
+    for (uint32 i = 0; i < first->shapeCount; ++i)
+    {
+        const perfect_clear_shape_t *shape = &first->shapes[i];
+
+        for (int32 column = 0; column + shape->width <= solver->width; ++column)
+        {
+            perfect_clear_board_t *child = &solver->branchBoards[solver->branchCount];
+
+            if (!PlacePerfectClearShape(solver, &board, shape, column, child))
+            {
+                continue;
+            }
+
+            if (!CanPerfectClearTile(solver, child))
+            {
+                solver->stats.parityCuts++;
+                continue;
+            }
+
+            solver->branchMoves[solver->branchCount++] = {shape->rotations, column - shape->gridX};
+        }
+    }
+
+    for (uint32 thread = 0; thread < solver->threadCount; ++thread)
+    {
+        solver->threadStats[thread] = {};
+    }
+
+    if (jobs)
+    {
+        SDL_assert(jobs->threadCount <= solver->threadCount);
+        RunJobs(jobs, SearchPerfectClearBranch, solver, solver->branchCount);
+    }
+    else
+    {
+        for (uint32 i = 0; i < solver->branchCount; ++i)
+        {
+            SearchPerfectClearBranch(solver, i, 0);
+        }
+    }
+
+    ePerfectClearResult result = PERFECT_CLEAR_IMPOSSIBLE;
+
+    for (uint32 thread = 0; thread < solver->threadCount; ++thread)
+    {
+        solver->stats.nodes += solver->threadStats[thread].nodes;
+        solver->stats.memoHits += solver->threadStats[thread].memoHits;
+        solver->stats.parityCuts += solver->threadStats[thread].parityCuts;
+    }
+
+    uint32 solved = solver->solvedBranch.load();
+
+    if (solved != UINT32_MAX)
+    {
+        SDL_memcpy(moves, solver->solutions[solved], used * sizeof(bot_move_t));
+        *moveCount = used;
+        result = PERFECT_CLEAR_SOLVED;
+    }
+    else
+    {
+        for (uint32 i = 0; i < solver->branchCount; ++i)
+        {
+            result = solver->branchResults[i] == PERFECT_CLEAR_GAVE_UP ? PERFECT_CLEAR_GAVE_UP : result;
+        }
+    }
+
+    solver->stats.solveNs += SDL_GetTicksNS() - start;
+    return result;
+}
@@ -0,0 +1,162 @@
+#if !defined(TETRIS_PERFECT_CLEAR_H)
+
+#include <atomic>
+#include "tetris_typedefs.h"
+#include "tetris_level.h"
+#include "tetris_bot.h"
+#include "tetris_jobs.h"
+
+/**
+ * @brief Rows a perfect clear may span, every filled cell of the world must be below it.
+ */
+#define PERFECT_CLEAR_MAX_HEIGHT 8
+#define PERFECT_CLEAR_MAX_PIECES 32
+/**
+ * @brief Distinct rotations of one piece.
+ */
+#define PERFECT_CLEAR_MAX_SHAPES 4
+/**
+ * @brief Root placements, one job each.
+ */
+#define PERFECT_CLEAR_MAX_BRANCHES (PERFECT_CLEAR_MAX_SHAPES * WORLD_MAX_WIDTH)
+/**
+ * @brief Failed positions remembered per thread, a power of two.
+ */
+#define PERFECT_CLEAR_MEMO_SIZE (1 << 15)
+#define PERFECT_CLEAR_MEMO_PROBES 8
+
+enum ePerfectClearResult
+{
+    PERFECT_CLEAR_SOLVED = 0,
+    /**
+     * @brief The whole tree was searched, no placement sequence of these pieces clears the board.
+     */
+    PERFECT_CLEAR_IMPOSSIBLE,
+    /**
+     * @brief The node budget ran out first.
+     */
+    PERFECT_CLEAR_GAVE_UP,
+};
+
+/**
+ * @brief Bottom rows of the world as bit masks, bit x is column x.
+ * @note rows[0] is the bottom row, rows at and above height are always 0.
+ */
+struct perfect_clear_board_t
+{
+    uint32 rows[PERFECT_CLEAR_MAX_HEIGHT];
+    uint32 height;
+};
+
+/**
+ * @brief One rotation of a piece, rows bottom-up and shifted to column 0.
+ */
+struct perfect_clear_shape_t
+{
+    uint32 rows[PLAYER_DATA_GRID_MAX_SIZE];
+    int32 width;
+    int32 height;
+    /**
+     * @brief Column of the leftmost cell in the rotated grid, bot_move_t::x is the grid's column.
+     */
+    int32 gridX;
+    int32 rotations;
+};
+
+struct perfect_clear_piece_t
+{
+    perfect_clear_shape_t shapes[PERFECT_CLEAR_MAX_SHAPES];
+    uint32 shapeCount;
+};
+
+/**
+ * @brief A position known not to clear with the pieces from pieceIndex on.
+ * @note Entries from older solves are told apart by generation, so nothing is cleared between solves.
+ */
+struct perfect_clear_memo_entry_t
+{
+    uint32 rows[PERFECT_CLEAR_MAX_HEIGHT];
+    uint32 generation;
+    uint16 height;
+    uint16 pieceIndex;
+};
+
+struct perfect_clear_stats_t
+{
+    uint64 solves;
+    uint64 nodes;
+    uint64 memoHits;
+    /**
+     * @brief Positions cut because an area walled off by filled columns can't be tiled by whole pieces.
+     */
+    uint64 parityCuts;
+    uint64 solveNs;
+};
+
+/**
+ * @brief Exhaustive hard-drop search for a placement sequence that leaves the board empty.
+ * @note Root placements run as parallel jobs. The lowest root placement that clears wins and
+ * higher ones stop searching, so the answer doesn't depend on the thread count.
+ */
+struct perfect_clear_solver_t
+{
+    uint32 threadCount;
+    /**
+     * @brief PERFECT_CLEAR_MEMO_SIZE entries per thread.
+     */
+    perfect_clear_memo_entry_t *memo;
+    uint32 generation;
+    uint64 maxNodes;
+
+    /* Current solve. */
+    int32 width;
+    uint32 pieceCount;
+    /**
+     * @brief Cells of every piece when they're all the same size, 0 turns the walled-area cut off.
+     */
+    uint32 pieceCells;
+    perfect_clear_piece_t pieces[PERFECT_CLEAR_MAX_PIECES];
+    uint32 branchCount;
+    perfect_clear_board_t branchBoards[PERFECT_CLEAR_MAX_BRANCHES];
+    bot_move_t branchMoves[PERFECT_CLEAR_MAX_BRANCHES];
+    uint8 branchResults[PERFECT_CLEAR_MAX_BRANCHES];
+    /**
+     * @brief Lowest branch that cleared so far, branches above it give up.
+     */
+    std::atomic<uint32> solvedBranch;
+    std::atomic<uint64> nodes;
+    bot_move_t solutions[PERFECT_CLEAR_MAX_BRANCHES][PERFECT_CLEAR_MAX_PIECES];
+
+    perfect_clear_stats_t threadStats[JOB_MAX_THREADS];
+    perfect_clear_stats_t stats;
+};
+
+/**
+ * @param threadCount Threads of the job pool solves will run on, 1 without one.
+ * @param maxNodes Positions searched per solve before giving up, 0 for no limit.
+ */
+bool InitPerfectClearSolver(perfect_clear_solver_t *solver, uint32 threadCount, uint64 maxNodes);
+
+void FreePerfectClearSolver(perfect_clear_solver_t *solver);
+
+/**
+ * @brief The active piece as it is now, then the preview.
+ * @note Moves are relative to the active piece's current rotation and assume it is still above the stack.
+ * @return Pieces written, at most maxCount.
+ */
+uint32 GetLevelPerfectClearPieces(const level_t *level, const player_data_t **pieces, uint32 maxCount);
+
+/**
+ * @brief Searches placements of pieces in order, each rotated, shifted and hard dropped like DropBotPiece.
+ * @param height Rows to clear, raised to the height of the stack. Pieces never land above it.
+ * @param moves On PERFECT_CLEAR_SOLVED, one placement per piece used.
+ * @param moveCount The leading pieces whose cells add up to the empty cells below height, the only ones
+ * a clear can use. No such prefix means PERFECT_CLEAR_IMPOSSIBLE without a search.
+ * @return PERFECT_CLEAR_GAVE_UP with SDL_GetError() set if the stack is taller than PERFECT_CLEAR_MAX_HEIGHT.
+ */
+ePerfectClearResult SolvePerfectClear(perfect_clear_solver_t *solver, job_pool_t *jobs, world_t *world,
+                                      const player_data_t **pieces, uint32 pieceCount, uint32 height,
+                                      bot_move_t *moves, uint32 *moveCount);
+
+#define TETRIS_PERFECT_CLEAR_H
+#endif
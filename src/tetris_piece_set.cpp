@@ -0,0 +1,351 @@
+#include "tetris_piece_set.h"
+
+SDL_COMPILE_TIME_ASSERT(piece_cell_bits, PLAYER_DATA_GRID_MAX_SIZE <= 16);
+SDL_COMPILE_TIME_ASSERT(piece_rotations, (PLAYER_DATA_ROTATION_COUNT & (PLAYER_DATA_ROTATION_COUNT - 1)) == 0);
+
+static constexpr uint8 kPlayerKind0[4][4] = {
+    {0, 0, 0, 0},
+    {0, 0, 0, 0},
+    {0, 0, 0, 0},
+    {1, 1, 1, 1}};
+
+static constexpr uint8 kPlayerKind1[2][2] = {
+    {1, 1},
+    {1, 1}};
+
+static constexpr uint8 kPlayerKind2[3][3] = {
+    {1, 0, 0},
+    {1, 0, 0},
+    {1, 1, 0}};
+
+static constexpr uint8 kPlayerKind3[3][3] = {
+    {1, 0, 0},
+    {1, 1, 0},
+    {0, 1, 0}};
+
+static constexpr uint8 kPlayerKind4[3][3] = {
+    {0, 0, 0},
+    {1, 1, 1},
+    {0, 1, 0}};
+
+static constexpr uint8 kPlayerKind5[3][3] = {
+    {0, 0, 1},
+    {0, 0, 1},
+    {0, 1, 1}};
+
+static constexpr uint8 kPlayerKind6[3][3] = {
+    {0, 0, 1},
+    {0, 1, 1},
+    {0, 1, 0}};
+
+template <int32 N>
+static constexpr player_data_t MakePlayerData(const uint8 (&kind)[N][N])
+{
+    player_data_t result{};
+    result.dim = {N, N};
+
+    for (int32 y = 0; y < N; ++y)
+    {
+        for (int32 x = 0; x < N; ++x)
+        {
+            result.grid[y * N + x] = kind[y][x];
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Derives cells and rowMasks from dim and grid.
+ * @return False if the shape is empty or has more than PLAYER_DATA_MAX_CELLS cells.
+ */
+static constexpr bool CompilePlayerShape(player_data_t *data)
+{
+    data->cellCount = 0;
+
+    for (int32 y = 0; y < PLAYER_DATA_GRID_MAX_SIZE; ++y)
+    {
+        data->rowMasks[y] = 0;
+    }
+
+    for (int32 y = 0; y < data->dim.y; ++y)
+    {
+        for (int32 x = 0; x < data->dim.x; ++x)
+        {
+            if (data->grid[y * data->dim.x + x])
+            {
+                if (data->cellCount == PLAYER_DATA_MAX_CELLS)
+                {
+                    return false;
+                }
+
+                data->cells[data->cellCount++] = (uint8)(y << 4 | x);
+                data->rowMasks[y] |= (uint16)(1u << x);
+            }
+        }
+    }
+
+    return data->cellCount > 0;
+}
+
+/**
+ * @brief Appends a kind and its rotations, turned the way RotatePlayer used to turn the grid.
+ * @param shape A square grid in spawn orientation.
+ */
+static constexpr bool CompilePieceKind(piece_set_t *set, const char *name, uint32 nameLength, const player_data_t &shape)
+{
+    if (set->kindCount == PLAYER_DATA_MAX_KIND_COUNT)
+    {
+        return false;
+    }
+
+    uint8 kind = (uint8)set->kindCount;
+    player_data_t *rotations = set->rotations[kind];
+    int32 size = shape.dim.x;
+
+    for (uint32 i = 0; i < PIECE_SET_NAME_SIZE; ++i)
+    {
+        set->names[kind][i] = i < nameLength && i < PIECE_SET_NAME_SIZE - 1 ? name[i] : 0;
+    }
+
+    for (uint32 rotation = 0; rotation < PLAYER_DATA_ROTATION_COUNT; ++rotation)
+    {
+        player_data_t *data = &rotations[rotation];
+        *data = player_data_t{};
+        data->dim = shape.dim;
+        data->kind = kind;
+        data->rotation = (uint8)rotation;
+
+        for (int32 i = 0; i < size; ++i)
+        {
+            for (int32 j = 0; j < size; ++j)
+            {
+                if (rotation == 0)
+                {
+                    data->grid[i * size + j] = shape.grid[i * size + j];
+                }
+                else
+                {
+                    data->grid[j * size + size - i - 1] = rotations[rotation - 1].grid[i * size + j];
+                }
+            }
+        }
+
+        if (!CompilePlayerShape(data))
+        {
+            return false;
+        }
+
+        /* A symmetric kind names a repeated grid by its first turn, turning on from either gives the same
+           grids, and a shape matched back from its grid gets the same rotation it was saved with. */
+        for (uint32 earlier = 0; earlier < rotation && data->rotation == rotation; ++earlier)
+        {
+            bool same = true;
+
+            for (int32 i = 0; i < size * size && same; ++i)
+            {
+                same = data->grid[i] == rotations[earlier].grid[i];
+            }
+
+            data->rotation = same ? (uint8)earlier : data->rotation;
+        }
+    }
+
+    set->kindCount++;
+    return true;
+}
+
+static constexpr piece_set_t MakeClassicPieceSet()
+{
+    piece_set_t set{};
+    CompilePieceKind(&set, "I", 1, MakePlayerData(kPlayerKind0));
+    CompilePieceKind(&set, "O", 1, MakePlayerData(kPlayerKind1));
+    CompilePieceKind(&set, "L", 1, MakePlayerData(kPlayerKind2));
+    CompilePieceKind(&set, "S", 1, MakePlayerData(kPlayerKind3));
+    CompilePieceKind(&set, "T", 1, MakePlayerData(kPlayerKind4));
+    CompilePieceKind(&set, "J", 1, MakePlayerData(kPlayerKind5));
+    CompilePieceKind(&set, "Z", 1, MakePlayerData(kPlayerKind6));
+    return set;
+}
+
+static constexpr piece_set_t kClassicPieceSet = MakeClassicPieceSet();
+SDL_COMPILE_TIME_ASSERT(classic_kinds, kClassicPieceSet.kindCount == PLAYER_DATA_KIND_COUNT);
+
+static const piece_set_t *activePieceSet = &kClassicPieceSet;
+
+const piece_set_t *GetClassicPieceSet()
+{
+    return &kClassicPieceSet;
+}
+
+/**
+ * @brief Moves the rows gathered for one kind into a square grid and compiles it.
+ */
+static bool FinishPieceSetKind(piece_set_t *set, const char *name, uint32 nameLength,
+                               const uint8 *rows, int32 rowCount, int32 line)
+{
+    vec2i_t min{PLAYER_DATA_GRID_MAX_SIZE, PLAYER_DATA_GRID_MAX_SIZE};
+    vec2i_t max{-1, -1};
+
+    for (int32 y = 0; y < rowCount; ++y)
+    {
+        for (int32 x = 0; x < PLAYER_DATA_GRID_MAX_SIZE; ++x)
+        {
+            if (rows[y * PLAYER_DATA_GRID_MAX_SIZE + x])
+            {
+                min = {SDL_min(min.x, x), SDL_min(min.y, y)};
+                max = {SDL_max(max.x, x), SDL_max(max.y, y)};
+            }
+        }
+    }
+
+    if (max.x < 0)
+    {
+        return SDL_SetError("Piece set line %d: piece %.*s has no cells", line, (int)nameLength, name);
+    }
+
+    int32 width = max.x - min.x + 1;
+    int32 height = max.y - min.y + 1;
+    int32 size = SDL_max(width, height);
+    player_data_t shape{};
+    shape.dim = {size, size};
+
+    for (int32 y = 0; y < height; ++y)
+    {
+        for (int32 x = 0; x < width; ++x)
+        {
+            shape.grid[(size - height + y) * size + x] = rows[(min.y + y) * PLAYER_DATA_GRID_MAX_SIZE + min.x + x];
+        }
+    }
+
+    if (set->kindCount == PLAYER_DATA_MAX_KIND_COUNT)
+    {
+        return SDL_SetError("Piece set line %d: more than %d pieces", line, PLAYER_DATA_MAX_KIND_COUNT);
+    }
+
+    if (!CompilePieceKind(set, name, nameLength, shape))
+    {
+        return SDL_SetError("Piece set line %d: piece %.*s has more than %d cells", line, (int)nameLength, name,
+                            PLAYER_DATA_MAX_CELLS);
+    }
+
+    return true;
+}
+
+bool ParsePieceSet(piece_set_t *set, const char *text, uint64 size)
+{
+    SDL_zerop(set);
+
+    uint8 rows[PLAYER_DATA_GRID_MAX_SIZE * PLAYER_DATA_GRID_MAX_SIZE];
+    int32 rowCount = 0;
+    const char *name = nullptr;
+    uint32 nameLength = 0;
+    int32 nameLine = 0;
+    int32 line = 0;
+    uint64 offset = 0;
+
+    while (offset < size)
+    {
+        const char *start = text + offset;
+        uint64 length = 0;
+
+        while (offset + length < size && start[length] != '\n')
+        {
+            length++;
+        }
+
+        offset += length + 1;
+        line++;
+
+        while (length && (start[length - 1] == '\r' || start[length - 1] == ' ' || start[length - 1] == '\t'))
+        {
+            length--;
+        }
+
+        if (!length || start[0] == ';')
+        {
+            continue;
+        }
+
+        if (length > 6 && SDL_strncmp(start, "piece ", 6) == 0)
+        {
+            if (name && !FinishPieceSetKind(set, name, nameLength, rows, rowCount, nameLine))
+            {
+                return false;
+            }
+
+            name = start + 6;
+            nameLength = (uint32)(length - 6);
+            nameLine = line;
+            rowCount = 0;
+            SDL_zero(rows);
+            continue;
+        }
+
+        if (!name)
+        {
+            return SDL_SetError("Piece set line %d: rows before the first \"piece <name>\" line", line);
+        }
+
+        if (rowCount == PLAYER_DATA_GRID_MAX_SIZE || length > PLAYER_DATA_GRID_MAX_SIZE)
+        {
+            return SDL_SetError("Piece set line %d: pieces are at most %dx%d", line, PLAYER_DATA_GRID_MAX_SIZE,
+                                PLAYER_DATA_GRID_MAX_SIZE);
+        }
+
+        for (uint64 x = 0; x < length; ++x)
+        {
+            char c = start[x];
+
+            if (c != '#' && c != 'X' && c != '.' && c != ' ')
+            {
+                return SDL_SetError("Piece set line %d: unexpected '%c', cells are '#' or 'X', gaps '.' or ' '",
+                                    line, c);
+            }
+
+            rows[rowCount * PLAYER_DATA_GRID_MAX_SIZE + x] = c == '#' || c == 'X';
+        }
+
+        rowCount++;
+    }
+
+    if (name && !FinishPieceSetKind(set, name, nameLength, rows, rowCount, nameLine))
+    {
+        return false;
+    }
+
+    if (!set->kindCount)
+    {
+        return SDL_SetError("Piece set has no pieces");
+    }
+
+    return true;
+}
+
+bool LoadPieceSet(piece_set_t *set, const char *path)
+{
+    size_t size = 0;
+    char *text = (char *)SDL_LoadFile(path, &size);
+
+    if (!text)
+    {
+        return false;
+    }
+
+    bool result = size <= PIECE_SET_MAX_FILE_SIZE ? ParsePieceSet(set, text, size)
+                                                  : SDL_SetError("Piece set is larger than %d bytes",
+                                                                 (int)PIECE_SET_MAX_FILE_SIZE);
+    SDL_free(text);
+    return result;
+}
+
+const piece_set_t *UsePieceSet(const piece_set_t *set)
+{
+    activePieceSet = set ? set : &kClassicPieceSet;
+    return activePieceSet;
+}
+
+const piece_set_t *GetActivePieceSet()
+{
+    return activePieceSet;
+}
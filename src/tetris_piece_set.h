@@ -0,0 +1,50 @@
+#if !defined(TETRIS_PIECE_SET_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+#include "tetris_arena.h"
+#include "tetris_player.h"
+
+#define PIECE_SET_NAME_SIZE 16
+/**
+ * @brief Piece set files larger than this are refused.
+ */
+#define PIECE_SET_MAX_FILE_SIZE Kilobytes(64)
+
+/**
+ * @brief The piece kinds a game draws from, every rotation compiled up front.
+ * @note Plain data, kinds are spawned and rotated by copying a player_data_t out of rotations.
+ */
+struct piece_set_t
+{
+    uint32 kindCount;
+    char names[PLAYER_DATA_MAX_KIND_COUNT][PIECE_SET_NAME_SIZE];
+    player_data_t rotations[PLAYER_DATA_MAX_KIND_COUNT][PLAYER_DATA_ROTATION_COUNT];
+};
+
+/**
+ * @brief The seven tetrominoes the game always had.
+ */
+const piece_set_t *GetClassicPieceSet();
+
+/**
+ * @brief Parses a piece set from text.
+ * @note A kind starts with a "piece <name>" line, its rows follow with '#' or 'X' for a cell and
+ * '.' or ' ' for a gap. Lines starting with ';' are comments. Shapes are padded to a square grid
+ * on the right and at the top, so they rest on the bottom like the classic ones.
+ */
+bool ParsePieceSet(piece_set_t *set, const char *text, uint64 size);
+
+bool LoadPieceSet(piece_set_t *set, const char *path);
+
+/**
+ * @brief Makes set the one every player and piece queue uses, nullptr goes back to the classic set.
+ * @note The set must outlive its use, it is not copied. Saves, replays and versus peers only
+ * agree when they were made with the same set.
+ */
+const piece_set_t *UsePieceSet(const piece_set_t *set);
+
+const piece_set_t *GetActivePieceSet();
+
+#define TETRIS_PIECE_SET_H
+#endif
@@ -0,0 +1,234 @@
+#include "tetris_planner.h"
+
+inline bot_move_t GetPlannerMove(uint32 move)
+{
+    return bot_move_t{(int32)(move % 4), (int32)(move / 4) + BOT_MIN_X};
+}
+
+bool InitPlanner(planner_t *planner, uint32 beamWidth, uint32 depth)
+{
+    SDL_zerop(planner);
+    planner->beamWidth = SDL_clamp(beamWidth, 1u, (uint32)PLANNER_MAX_BEAM_WIDTH);
+    planner->depth = SDL_clamp(depth, 1u, (uint32)PLANNER_MAX_DEPTH);
+
+    uint32 seenSize = 16;
+
+    while (seenSize < 2 * planner->beamWidth)
+    {
+        seenSize *= 2;
+    }
+
+    planner->seenMask = seenSize - 1;
+    planner->beam = (planner_node_t *)SDL_calloc(planner->beamWidth, sizeof(planner_node_t));
+    planner->nextBeam = (planner_node_t *)SDL_calloc(planner->beamWidth, sizeof(planner_node_t));
+    planner->children = (planner_child_t *)SDL_calloc(planner->beamWidth * PLANNER_MAX_MOVES, sizeof(planner_child_t));
+    planner->ranked = (planner_child_t *)SDL_calloc(planner->beamWidth * PLANNER_MAX_MOVES, sizeof(planner_child_t));
+    planner->seen = (uint64 *)SDL_calloc(seenSize, sizeof(uint64));
+    planner->scratch = (level_t *)SDL_calloc(JOB_MAX_THREADS, sizeof(level_t));
+
+    if (!planner->beam || !planner->nextBeam || !planner->children || !planner->ranked || !planner->seen ||
+        !planner->scratch)
+    {
+        FreePlanner(planner);
+        return false;
+    }
+
+    return true;
+}
+
+void FreePlanner(planner_t *planner)
+{
+    SDL_free(planner->beam);
+    SDL_free(planner->nextBeam);
+    SDL_free(planner->children);
+    SDL_free(planner->ranked);
+    SDL_free(planner->seen);
+    SDL_free(planner->scratch);
+    SDL_zerop(planner);
+}
+
+static bool IsPlannerStopped(const planner_t *planner)
+{
+    return planner->ply > 0 && ((planner->deadlineNs && SDL_GetTicksNS() >= planner->deadlineNs) ||
+                                (planner->cancel && SDL_GetAtomicInt(planner->cancel)));
+}
+
+/**
+ * @brief Job: scores a chunk of PLANNER_CHILDREN_PER_JOB placements, chunks may span beam nodes.
+ */
+static void ExpandPlannerChildren(void *data, uint32 index, uint32 thread)
+{
+    planner_t *planner = (planner_t *)data;
+    uint32 childCount = planner->beamCount * planner->movesPerNode;
+    uint32 end = SDL_min((index + 1) * PLANNER_CHILDREN_PER_JOB, childCount);
+    level_t *trial = &planner->scratch[thread];
+
+    if (IsPlannerStopped(planner))
+    {
+        return;
+    }
+
+    for (uint32 slot = index * PLANNER_CHILDREN_PER_JOB; slot < end; ++slot)
+    {
+        uint32 parent = slot / planner->movesPerNode;
+        uint32 move = slot % planner->movesPerNode;
+        bot_move_t candidate = GetPlannerMove(move);
+        planner_child_t *child = &planner->children[slot];
+        CopyLevel(trial, &planner->beam[parent].level);
+        *child = {SDL_MAX_SINT32, parent, move, 0};
+
+        if (DropBotPiece(trial, candidate.rotations, candidate.x))
+        {
+            int32 rows = (int32)(trial->score - planner->rootScore) / SCORE_PER_ROW;
+            child->cost = GetBotStackCost(&trial->world) - PLANNER_ROW_WEIGHT * rows;
+            child->hash = trial->world.hash;
+        }
+    }
+}
+
+/**
+ * @brief Job: replays one ranked child's move on its parent to build the next beam.
+ */
+static void BuildPlannerNode(void *data, uint32 index, uint32 thread)
+{
+    planner_t *planner = (planner_t *)data;
+    const planner_child_t *child = &planner->ranked[index];
+    const planner_node_t *parent = &planner->beam[child->parent];
+    planner_node_t *node = &planner->nextBeam[index];
+    bot_move_t move = GetPlannerMove(child->move);
+
+    CopyLevel(&node->level, &parent->level);
+    DropBotPiece(&node->level, move.rotations, move.x);
+    node->firstMove = planner->ply == 0 ? move : parent->firstMove;
+}
+
+static void RunPlannerJobs(planner_t *planner, job_pool_t *jobs, job_function_t *function, uint32 count)
+{
+    if (jobs)
+    {
+        RunJobs(jobs, function, planner, count);
+        return;
+    }
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        function(planner, i, 0);
+    }
+}
+
+/**
+ * @brief Cost first, ties by slot so the order never depends on the sort.
+ */
+static int ComparePlannerChildren(const void *a, const void *b)
+{
+    const planner_child_t *childA = (const planner_child_t *)a;
+    const planner_child_t *childB = (const planner_child_t *)b;
+
+    if (childA->cost != childB->cost)
+    {
+        return childA->cost < childB->cost ? -1 : 1;
+    }
+
+    if (childA->parent != childB->parent)
+    {
+        return childA->parent < childB->parent ? -1 : 1;
+    }
+
+    return childA->move < childB->move ? -1 : (childA->move > childB->move ? 1 : 0);
+}
+
+/**
+ * @return False if a cheaper child already reached this board.
+ */
+static bool InsertPlannerSeen(planner_t *planner, uint64 hash)
+{
+    /* 0 marks a free slot, the empty board's hash moves out of its way. */
+    hash = hash ? hash : 1;
+
+    for (uint32 slot = (uint32)hash & planner->seenMask;; slot = (slot + 1) & planner->seenMask)
+    {
+        if (planner->seen[slot] == hash)
+        {
+            return false;
+        }
+
+        if (!planner->seen[slot])
+        {
+            planner->seen[slot] = hash;
+            return true;
+        }
+    }
+}
+
+bot_move_t PlanBotMove(planner_t *planner, job_pool_t *jobs, const level_t *level)
+{
+    uint64 start = SDL_GetTicksNS();
+    bot_move_t best{0, 0};
+
+    planner->movesPerNode = 4 * (uint32)(level->world.size.x - BOT_MIN_X);
+    planner->rootScore = level->score;
+    CopyLevel(&planner->beam[0].level, level);
+    planner->beam[0].firstMove = best;
+    planner->beamCount = 1;
+
+    for (planner->ply = 0; planner->ply < planner->depth; ++planner->ply)
+    {
+        uint32 childCount = planner->beamCount * planner->movesPerNode;
+        RunPlannerJobs(planner, jobs, ExpandPlannerChildren,
+                       (childCount + PLANNER_CHILDREN_PER_JOB - 1) / PLANNER_CHILDREN_PER_JOB);
+
+        /* Some chunks may not have been scored, their slots hold the previous ply's children. */
+        if (IsPlannerStopped(planner))
+        {
+            planner->stats.stopped++;
+            break;
+        }
+
+        planner->stats.nodes += childCount;
+
+        uint32 rankedCount = 0;
+
+        for (uint32 i = 0; i < childCount; ++i)
+        {
+            if (planner->children[i].cost != SDL_MAX_SINT32)
+            {
+                planner->ranked[rankedCount++] = planner->children[i];
+            }
+        }
+
+        /* Every sequence tops out here, keep the best first move of the previous ply. */
+        if (!rankedCount)
+        {
+            break;
+        }
+
+        SDL_qsort(planner->ranked, rankedCount, sizeof(planner_child_t), ComparePlannerChildren);
+        SDL_memset(planner->seen, 0, (planner->seenMask + 1) * sizeof(uint64));
+        uint32 kept = 0;
+
+        for (uint32 i = 0; i < rankedCount && kept < planner->beamWidth; ++i)
+        {
+            if (InsertPlannerSeen(planner, planner->ranked[i].hash))
+            {
+                planner->ranked[kept++] = planner->ranked[i];
+            }
+            else
+            {
+                planner->stats.duplicates++;
+            }
+        }
+
+        RunPlannerJobs(planner, jobs, BuildPlannerNode, kept);
+
+        planner_node_t *beam = planner->beam;
+        planner->beam = planner->nextBeam;
+        planner->nextBeam = beam;
+        planner->beamCount = kept;
+        best = planner->beam[0].firstMove;
+        planner->stats.plies++;
+    }
+
+    planner->stats.searches++;
+    planner->stats.searchNs += SDL_GetTicksNS() - start;
+    return best;
+}
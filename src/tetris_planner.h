@@ -0,0 +1,118 @@
+#if !defined(TETRIS_PLANNER_H)
+
+#include "tetris_typedefs.h"
+#include "tetris_level.h"
+#include "tetris_bot.h"
+#include "tetris_jobs.h"
+
+#define PLANNER_MAX_BEAM_WIDTH 1024
+/**
+ * @brief The active piece plus the visible preview, deeper plies would peek at pieces the player can't see.
+ */
+#define PLANNER_MAX_DEPTH (1 + PIECE_PREVIEW_COUNT)
+#define PLANNER_MAX_MOVES (4 * (WORLD_MAX_WIDTH - BOT_MIN_X))
+/**
+ * @brief Children scored per job, a single root node still fills every thread on the first ply.
+ */
+#define PLANNER_CHILDREN_PER_JOB 4
+/**
+ * @brief Same trade of stack cost against cleared rows as PickBotMove.
+ */
+#define PLANNER_ROW_WEIGHT 32
+
+/**
+ * @brief A placement sequence kept in the beam, with its first move.
+ */
+struct planner_node_t
+{
+    level_t level;
+    bot_move_t firstMove;
+};
+
+/**
+ * @brief Score of one expansion, nodes are only built for the children that make the beam.
+ */
+struct planner_child_t
+{
+    int32 cost;
+    uint32 parent;
+    uint32 move;
+    uint64 hash;
+};
+
+struct planner_stats_t
+{
+    uint64 searches;
+    uint64 nodes;
+    /**
+     * @brief Children dropped from the beam because another path reached the same board.
+     */
+    uint64 duplicates;
+    uint64 searchNs;
+    /**
+     * @brief Plies completed, summed over the searches.
+     */
+    uint64 plies;
+    /**
+     * @brief Searches that ran into the deadline or were cancelled before reaching depth.
+     */
+    uint64 stopped;
+};
+
+/**
+ * @brief Beam search over the active piece and the preview.
+ * @note Every ply expands each beam node's placements as one job, children go to fixed slots,
+ * so the chosen move doesn't depend on the thread count or on scheduling.
+ */
+struct planner_t
+{
+    uint32 beamWidth;
+    uint32 depth;
+
+    /* Current search. */
+    uint32 ply;
+    uint32 rootScore;
+
+    planner_node_t *beam;
+    planner_node_t *nextBeam;
+    uint32 beamCount;
+
+    planner_child_t *children;
+    planner_child_t *ranked;
+    uint32 movesPerNode;
+    uint64 *seen;
+    uint32 seenMask;
+
+    /**
+     * @brief One trial level per job thread.
+     */
+    level_t *scratch;
+    planner_stats_t stats;
+
+    /**
+     * @brief Optional, SDL_GetTicksNS() time at which a search gives up its deeper plies, 0 for none.
+     */
+    uint64 deadlineNs;
+    /**
+     * @brief Optional, another thread sets it to non-zero to stop the running search.
+     */
+    SDL_AtomicInt *cancel;
+};
+
+/**
+ * @param depth Pieces to place per search, clamped to PLANNER_MAX_DEPTH.
+ */
+bool InitPlanner(planner_t *planner, uint32 beamWidth, uint32 depth);
+
+void FreePlanner(planner_t *planner);
+
+/**
+ * @brief Searches from level and returns the first move of the best sequence found.
+ * @param jobs Threads to expand on, nullptr runs on the calling thread.
+ * @note The first ply always completes. A later ply cut short by deadlineNs or cancel is dropped
+ * and the move comes from the last complete one.
+ */
+bot_move_t PlanBotMove(planner_t *planner, job_pool_t *jobs, const level_t *level);
+
+#define TETRIS_PLANNER_H
+#endif
@@ -1,199 +1,138 @@
 #include "tetris_player.h"
-
-static constexpr uint8 kPlayerKind0[4][4] = {
-    {0, 0, 0, 0},
-    {0, 0, 0, 0},
-    {0, 0, 0, 0},
-    {1, 1, 1, 1}};
-
-static constexpr uint8 kPlayerKind1[2][2] = {
-    {1, 1},
-    {1, 1}};
-
-static constexpr uint8 kPlayerKind2[3][3] = {
-    {1, 0, 0},
-    {1, 0, 0},
-    {1, 1, 0}};
-
-static constexpr uint8 kPlayerKind3[3][3] = {
-    {1, 0, 0},
-    {1, 1, 0},
-    {0, 1, 0}};
-
-static constexpr uint8 kPlayerKind4[3][3] = {
-    {0, 0, 0},
-    {1, 1, 1},
-    {0, 1, 0}};
-
-static constexpr uint8 kPlayerKind5[3][3] = {
-    {0, 0, 1},
-    {0, 0, 1},
-    {0, 1, 1}};
-
-static constexpr uint8 kPlayerKind6[3][3] = {
-    {0, 0, 1},
-    {0, 1, 1},
-    {0, 1, 0}};
-
-static player_data_t kPlayerData0 = {
-    {4, 4},
-    (uint8 *)kPlayerKind0};
-
-static player_data_t kPlayerData1 = {
-    {2, 2},
-    (uint8 *)kPlayerKind1};
-
-static player_data_t kPlayerData2 = {
-    {3, 3},
-    (uint8 *)kPlayerKind2};
-
-static player_data_t kPlayerData3 = {
-    {3, 3},
-    (uint8 *)kPlayerKind3};
-
-static player_data_t kPlayerData4 = {
-    {3, 3},
-    (uint8 *)kPlayerKind4};
-
-static player_data_t kPlayerData5 = {
-    {3, 3},
-    (uint8 *)kPlayerKind5};
-
-static player_data_t kPlayerData6 = {
-    {3, 3},
-    (uint8 *)kPlayerKind6};
+#include "tetris_piece_set.h"
 
 bool InitPlayer(player_t *player)
 {
-    player->nextPlayerKindId = SDL_rand(PLAYER_DATA_KIND_COUNT);
-    player->nextPlayerValue = SDL_rand(PLAYER_VALUE_COUNT) + 1;
-    player->data.grid = (uint8 *)SDL_calloc(PLAYER_DATA_GRID_MAX_SIZE * PLAYER_DATA_GRID_MAX_SIZE, sizeof(uint8));
+    SDL_zerop(player);
+    return true;
+}
 
-    return player->data.grid != 0;
+inline vec2i_t GetPlayerCell(const player_data_t *playerData, uint32 index)
+{
+    SDL_assert(index < playerData->cellCount);
+    uint8 cell = playerData->cells[index];
+    return {cell & 15, cell >> 4};
 }
 
-bool IsPlayerPositionValid(world_t *world, player_data_t *playerData, vec2i_t testPosition)
+/**
+ * @note Same checks as IsWorldPositionValid() and GetWorldValueUnchecked(), with the size folded in when known.
+ */
+template <int32 W, int32 H>
+static bool IsPlayerPositionValidOfShape(world_t *world, const player_data_t *playerData, vec2i_t testPosition)
 {
-    for (uint8 y = 0; y < playerData->dim.y; ++y)
+    const int32 width = GetShapeWidth<W, H>(world);
+    const int32 height = GetShapeHeight<W, H>(world);
+
+    for (uint32 i = 0; i < playerData->cellCount; ++i)
     {
-        for (uint8 x = 0; x < playerData->dim.x; ++x)
-        {
-            if (playerData->grid[y * playerData->dim.x + x])
-            {
-                vec2i_t position = testPosition + vec2i_t{x, y};
+        vec2i_t position = testPosition + GetPlayerCell(playerData, i);
 
-                if (!IsWorldPositionValid(world, position) ||
-                    !IsValueEmpty(GetWorldValue(world, position)))
-                {
-                    return false;
-                }
-            }
+        if ((uint32)position.x >= (uint32)width || position.y >= height ||
+            (position.y >= 0 && !IsValueEmpty(world->data[position.y * width + position.x])))
+        {
+            return false;
         }
     }
 
     return true;
 }
 
+bool IsPlayerPositionValid(world_t *world, const player_data_t *playerData, vec2i_t testPosition)
+{
+    return WORLD_SHAPE_CALL(world, IsPlayerPositionValidOfShape, world, playerData, testPosition);
+}
+
 void SavePlayerInWorld(world_t *world, player_t *player)
 {
     if (player->value)
     {
-        for (uint8 y = 0; y < player->data.dim.y; ++y)
+        for (uint32 i = 0; i < player->data.cellCount; ++i)
         {
-            for (uint8 x = 0; x < player->data.dim.x; ++x)
-            {
-                if (player->data.grid[y * player->data.dim.x + x])
-                {
-                    vec2i_t position = player->position + vec2i_t{x, y};
-                    SetWorldValue(world, position, player->value);
-                }
-            }
+            SetWorldValue(world, player->position + GetPlayerCell(&player->data, i), player->value);
         }
     }
 }
 
-void RotatePlayer(world_t *world, player_t *player)
+bool RotatePlayer(world_t *world, player_t *player)
 {
-    uint8 newData[PLAYER_DATA_GRID_MAX_SIZE][PLAYER_DATA_GRID_MAX_SIZE];
-    SDL_assert(player->data.dim.x == player->data.dim.y);
-    SDL_assert(player->data.dim.x <= PLAYER_DATA_GRID_MAX_SIZE);
-    SDL_assert(player->data.dim.y <= PLAYER_DATA_GRID_MAX_SIZE);
-
-    uint8 sqDim = player->data.dim.x;
-
-    for (int i = 0; i < sqDim; ++i)
+    if (!player->data.cellCount)
     {
-        for (int j = 0; j < sqDim; ++j)
-        {
-            newData[j][sqDim - i - 1] = player->data.grid[i * sqDim + j];
-        }
+        return false;
     }
 
-    player_data_t newPlayerData{
-        player->data.dim,
-        (uint8 *)newData};
+    const player_data_t *rotated = GetPlayerRotation(player->data.kind, player->data.rotation + 1u);
 
-    if (IsPlayerPositionValid(world, &newPlayerData, player->position))
+    if (IsPlayerPositionValid(world, rotated, player->position))
     {
-        for (int y = 0; y < player->data.dim.y; ++y)
-        {
-            for (int x = 0; x < player->data.dim.x; ++x)
-            {
-                player->data.grid[y * player->data.dim.x + x] = newData[y][x];
-            }
-        }
+        player->data = *rotated;
+        return true;
     }
+
+    return false;
+}
+
+inline const player_data_t *GetPlayerRotation(uint8 playerKindId, uint32 rotation)
+{
+    const piece_set_t *set = GetActivePieceSet();
+    SDL_assert(playerKindId < set->kindCount);
+    return &set->rotations[playerKindId][rotation & (PLAYER_DATA_ROTATION_COUNT - 1)];
 }
 
-player_data_t GetPlayerKind(uint8 playerKindId)
+inline const player_data_t *GetPlayerKind(uint8 playerKindId)
 {
-    player_data_t allPlayerData[8] = {
-        kPlayerData0,
-        kPlayerData1,
-        kPlayerData2,
-        kPlayerData3,
-        kPlayerData4,
-        kPlayerData5,
-        kPlayerData6,
-    };
-
-    return allPlayerData[playerKindId];
+    return GetPlayerRotation(playerKindId, 0);
 }
 
-void SpawnPlayer(world_t *world, player_t *player)
+uint32 GetPlayerKindCount()
 {
-    player->value = player->nextPlayerValue;
-    uint8 playerKindId = player->nextPlayerKindId;
-    player->nextPlayerKindId = SDL_rand(PLAYER_DATA_KIND_COUNT);
-    player->nextPlayerValue = SDL_rand(PLAYER_VALUE_COUNT) + 1;
+    return GetActivePieceSet()->kindCount;
+}
+
+bool MatchPlayerShape(player_data_t *playerData)
+{
+    if (!playerData->dim.x && !playerData->dim.y)
+    {
+        *playerData = player_data_t{};
+        return true;
+    }
 
-    player_data_t newPlayerData = GetPlayerKind(playerKindId);
-    player->data.dim = newPlayerData.dim;
+    const piece_set_t *set = GetActivePieceSet();
+    int32 area = playerData->dim.x * playerData->dim.y;
 
-    for (int y = 0; y < newPlayerData.dim.y; ++y)
+    for (uint32 kind = 0; kind < set->kindCount; ++kind)
     {
-        for (int x = 0; x < newPlayerData.dim.x; ++x)
+        for (uint32 rotation = 0; rotation < PLAYER_DATA_ROTATION_COUNT; ++rotation)
         {
-            player->data.grid[y * newPlayerData.dim.x + x] = newPlayerData.grid[y * newPlayerData.dim.x + x];
+            const player_data_t *candidate = &set->rotations[kind][rotation];
+
+            if (candidate->dim == playerData->dim && SDL_memcmp(candidate->grid, playerData->grid, area) == 0)
+            {
+                *playerData = *candidate;
+                return true;
+            }
         }
     }
 
+    return false;
+}
+
+void SpawnPlayer(world_t *world, player_t *player, piece_t piece)
+{
+    player->value = piece.value;
+    player->data = *GetPlayerKind(piece.kindId);
     player->position = {(world->size.x - player->data.dim.x) / 2, -player->data.dim.y};
 }
 
 void RenderPlayer(SDL_Renderer *renderer, app_assets_t *assets, world_t *world,
-                  player_data_t *playerData, vec2i_t playerPosition, uint8 playerValue, vec2_t offset)
+                  const player_data_t *playerData, vec2i_t playerPosition, uint8 playerValue, vec2_t offset)
 {
-    for (uint8 y = 0; y < playerData->dim.y; ++y)
+    for (uint32 i = 0; i < playerData->cellCount; ++i)
     {
-        for (uint8 x = 0; x < playerData->dim.x; ++x)
-        {
-            uint8 hasValue = playerData->grid[y * playerData->dim.x + x];
+        vec2i_t position = playerPosition + GetPlayerCell(playerData, i);
 
-            if (hasValue && playerPosition.y + y >= 0)
-            {
-                RenderWorldItem(renderer, assets, world, playerValue, playerPosition + vec2i_t{x, y}, offset);
-            }
+        if (position.y >= 0)
+        {
+            RenderWorldItem(renderer, assets, world, playerValue, position, offset);
         }
     }
 }
@@ -3,15 +3,41 @@
 #include "tetris_typedefs.h"
 #include "tetris_math.h"
 #include "tetris_world.h"
+#include "tetris_random.h"
 
 #define PLAYER_DATA_GRID_MAX_SIZE 16
+/**
+ * @brief Kinds of the classic set, see tetris_piece_set.h for others.
+ */
 #define PLAYER_DATA_KIND_COUNT 7
+#define PLAYER_DATA_MAX_KIND_COUNT 32
+#define PLAYER_DATA_MAX_CELLS 64
+#define PLAYER_DATA_ROTATION_COUNT 4
 #define PLAYER_VALUE_COUNT 7
 
+/**
+ * @brief One rotation of a piece kind as compiled by the active piece set.
+ * @note grid is packed row-major with dim.x stride, dim is always square. cells and rowMasks
+ * hold the same shape, so collision checks cost the cells, not the grid area.
+ */
 struct player_data_t
 {
     vec2i_t dim;
-    uint8 *grid;
+    uint8 grid[PLAYER_DATA_GRID_MAX_SIZE * PLAYER_DATA_GRID_MAX_SIZE];
+    uint8 kind;
+    /**
+     * @brief Quarter turns clockwise from the spawn orientation, the fewest that give this grid.
+     */
+    uint8 rotation;
+    uint8 cellCount;
+    /**
+     * @brief Occupied grid cells in row-major order, y << 4 | x.
+     */
+    uint8 cells[PLAYER_DATA_MAX_CELLS];
+    /**
+     * @brief Bit x of rowMasks[y] is set when grid cell x, y is occupied.
+     */
+    uint16 rowMasks[PLAYER_DATA_GRID_MAX_SIZE];
 };
 
 struct player_t
@@ -19,24 +45,46 @@ struct player_t
     vec2i_t position;
     player_data_t data;
     uint8 value;
-    uint8 nextPlayerKindId;
-    uint8 nextPlayerValue;
 };
 
 bool InitPlayer(player_t *player);
 
-bool IsPlayerPositionValid(world_t *world, player_data_t *playerData, vec2i_t testPosition);
+/**
+ * @return Grid position of the index-th cell.
+ */
+vec2i_t GetPlayerCell(const player_data_t *playerData, uint32 index);
+
+bool IsPlayerPositionValid(world_t *world, const player_data_t *playerData, vec2i_t testPosition);
 
 void SavePlayerInWorld(world_t *world, player_t *player);
 
-void RotatePlayer(world_t *world, player_t *player);
+/**
+ * @return False if the rotated piece doesn't fit, the piece is left as it was.
+ */
+bool RotatePlayer(world_t *world, player_t *player);
+
+/**
+ * @brief The spawn orientation of a kind in the active piece set.
+ */
+const player_data_t *GetPlayerKind(uint8 playerKindId);
+
+/**
+ * @param rotation Quarter turns clockwise, taken modulo PLAYER_DATA_ROTATION_COUNT.
+ */
+const player_data_t *GetPlayerRotation(uint8 playerKindId, uint32 rotation);
+
+uint32 GetPlayerKindCount();
 
-player_data_t GetPlayerKind(uint8 playerKindId);
+/**
+ * @brief Fills kind, rotation, cells and rowMasks from dim and grid, for shapes that come from outside, e.g. a save.
+ * @return False if no kind of the active piece set has this shape. An empty dim is no piece and always matches.
+ */
+bool MatchPlayerShape(player_data_t *playerData);
 
-void SpawnPlayer(world_t *world, player_t *player);
+void SpawnPlayer(world_t *world, player_t *player, piece_t piece);
 
 void RenderPlayer(SDL_Renderer *renderer, app_assets_t *assets, world_t *world,
-                  player_data_t *playerData, vec2i_t playerPosition, uint8 playerValue, vec2_t offset);
+                  const player_data_t *playerData, vec2i_t playerPosition, uint8 playerValue, vec2_t offset);
 
 void RenderPlayer(SDL_Renderer *renderer, app_assets_t *assets, world_t *world,
                   player_t *player, vec2_t offset);
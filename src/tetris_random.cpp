@@ -0,0 +1,150 @@
+#include "tetris_random.h"
+#include "tetris_player.h"
+#include "tetris_piece_set.h"
+
+#define RANDOM_MULTIPLIER 6364136223846793005ull
+#define RANDOM_INCREMENT 1442695040888963407ull
+
+/* Random outputs one batch consumes, see GeneratePieceBatch(). */
+#define PIECE_UNIFORM_BATCH_DRAWS (PIECE_QUEUE_BATCH_SIZE * 2)
+#define PIECE_BAG_BATCH_DRAWS(bagSize) ((bagSize) - 1 + PIECE_QUEUE_BATCH_SIZE)
+
+void SeedRandom(random_t *random, uint64 seed)
+{
+    random->state = 0;
+    NextRandom(random);
+    random->state += seed;
+    NextRandom(random);
+}
+
+inline uint32 NextRandom(random_t *random)
+{
+    uint64 state = random->state;
+    random->state = state * RANDOM_MULTIPLIER + RANDOM_INCREMENT;
+
+    uint32 xorShifted = (uint32)(((state >> 18) ^ state) >> 27);
+    uint32 rotation = (uint32)(state >> 59);
+    return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+}
+
+inline uint32 NextRandomBelow(random_t *random, uint32 bound)
+{
+    return (uint32)(((uint64)NextRandom(random) * bound) >> 32);
+}
+
+/**
+ * @note Composes the LCG step with itself by squaring, see
+ * F. Brown, "Random Number Generation with Arbitrary Stride".
+ */
+void AdvanceRandom(random_t *random, uint64 delta)
+{
+    uint64 multiplier = RANDOM_MULTIPLIER;
+    uint64 increment = RANDOM_INCREMENT;
+    uint64 accMultiplier = 1;
+    uint64 accIncrement = 0;
+
+    while (delta)
+    {
+        if (delta & 1)
+        {
+            accMultiplier *= multiplier;
+            accIncrement = accIncrement * multiplier + increment;
+        }
+
+        increment = (multiplier + 1) * increment;
+        multiplier *= multiplier;
+        delta >>= 1;
+    }
+
+    random->state = accMultiplier * random->state + accIncrement;
+}
+
+static uint32 GetPieceBagSize(const piece_queue_t *queue)
+{
+    return SDL_max((uint32)queue->kindCount, (uint32)PIECE_QUEUE_BATCH_SIZE);
+}
+
+static void GeneratePieceBatch(piece_queue_t *queue)
+{
+    SDL_assert(queue->count + PIECE_QUEUE_BATCH_SIZE <= PIECE_QUEUE_CAPACITY);
+
+    uint8 kinds[PLAYER_DATA_MAX_KIND_COUNT];
+
+    if (queue->mode == PIECE_RANDOMIZER_BAG)
+    {
+        /* A set of other than PIECE_QUEUE_BATCH_SIZE kinds fills the bag round-robin up to a batch,
+           the batch is the front of the shuffled bag. The classic set shuffles exactly its seven. */
+        uint32 bagSize = GetPieceBagSize(queue);
+
+        for (uint32 i = 0; i < bagSize; ++i)
+        {
+            kinds[i] = (uint8)(i % queue->kindCount);
+        }
+
+        for (uint32 i = bagSize - 1; i > 0; --i)
+        {
+            uint32 j = NextRandomBelow(&queue->random, i + 1);
+            uint8 kind = kinds[i];
+            kinds[i] = kinds[j];
+            kinds[j] = kind;
+        }
+    }
+    else
+    {
+        for (uint32 i = 0; i < PIECE_QUEUE_BATCH_SIZE; ++i)
+        {
+            kinds[i] = (uint8)NextRandomBelow(&queue->random, queue->kindCount);
+        }
+    }
+
+    for (uint32 i = 0; i < PIECE_QUEUE_BATCH_SIZE; ++i)
+    {
+        piece_t *piece = &queue->pieces[(queue->head + queue->count) & (PIECE_QUEUE_CAPACITY - 1)];
+        piece->kindId = kinds[i];
+        piece->value = (uint8)NextRandomBelow(&queue->random, PLAYER_VALUE_COUNT) + 1;
+        queue->count++;
+    }
+}
+
+static void FillPieceQueue(piece_queue_t *queue)
+{
+    while (queue->count + PIECE_QUEUE_BATCH_SIZE <= PIECE_QUEUE_CAPACITY)
+    {
+        GeneratePieceBatch(queue);
+    }
+}
+
+void InitPieceQueue(piece_queue_t *queue, uint64 seed, ePieceRandomizerMode mode)
+{
+    SDL_COMPILE_TIME_ASSERT(queue_capacity, (PIECE_QUEUE_CAPACITY & (PIECE_QUEUE_CAPACITY - 1)) == 0);
+    SDL_COMPILE_TIME_ASSERT(queue_preview, PIECE_PREVIEW_COUNT < PIECE_QUEUE_CAPACITY - PIECE_QUEUE_BATCH_SIZE);
+
+    SeedRandom(&queue->random, seed);
+    queue->mode = mode;
+    queue->kindCount = (uint8)GetActivePieceSet()->kindCount;
+    queue->head = 0;
+    queue->count = 0;
+    FillPieceQueue(queue);
+}
+
+inline piece_t PeekPieceQueue(const piece_queue_t *queue, uint32 depth)
+{
+    SDL_assert(depth < queue->count);
+    return queue->pieces[(queue->head + depth) & (PIECE_QUEUE_CAPACITY - 1)];
+}
+
+piece_t PopPieceQueue(piece_queue_t *queue)
+{
+    piece_t result = PeekPieceQueue(queue, 0);
+    queue->head = (queue->head + 1) & (PIECE_QUEUE_CAPACITY - 1);
+    queue->count--;
+    FillPieceQueue(queue);
+    return result;
+}
+
+void JumpPieceQueue(piece_queue_t *queue, uint64 batchCount)
+{
+    uint64 draws = queue->mode == PIECE_RANDOMIZER_BAG ? PIECE_BAG_BATCH_DRAWS(GetPieceBagSize(queue))
+                                                       : PIECE_UNIFORM_BATCH_DRAWS;
+    AdvanceRandom(&queue->random, batchCount * draws);
+}
@@ -0,0 +1,81 @@
+#if !defined(TETRIS_RANDOM_H)
+
+#include "tetris_typedefs.h"
+
+/**
+ * @note Must be a power of two.
+ */
+#define PIECE_QUEUE_CAPACITY 32
+#define PIECE_QUEUE_BATCH_SIZE 7
+#define PIECE_PREVIEW_COUNT 5
+
+/**
+ * @brief PCG32 generator, small enough to live inside every game.
+ */
+struct random_t
+{
+    uint64 state;
+};
+
+void SeedRandom(random_t *random, uint64 seed);
+
+uint32 NextRandom(random_t *random);
+
+/**
+ * @return Value in [0, bound).
+ */
+uint32 NextRandomBelow(random_t *random, uint32 bound);
+
+/**
+ * @brief Skips delta outputs in O(log delta).
+ */
+void AdvanceRandom(random_t *random, uint64 delta);
+
+enum ePieceRandomizerMode
+{
+    PIECE_RANDOMIZER_UNIFORM = 0,
+    PIECE_RANDOMIZER_BAG,
+};
+
+struct piece_t
+{
+    uint8 kindId;
+    uint8 value;
+};
+
+/**
+ * @brief Per-game piece source with a preview ring buffer.
+ * @note Pieces are generated in batches of PIECE_QUEUE_BATCH_SIZE, a batch always
+ * consumes the same amount of random outputs, which makes JumpPieceQueue() exact.
+ */
+struct piece_queue_t
+{
+    random_t random;
+    ePieceRandomizerMode mode;
+    /**
+     * @brief Kinds of the piece set active when the queue was initialised.
+     */
+    uint8 kindCount;
+    uint32 head;
+    uint32 count;
+    piece_t pieces[PIECE_QUEUE_CAPACITY];
+};
+
+void InitPieceQueue(piece_queue_t *queue, uint64 seed, ePieceRandomizerMode mode);
+
+/**
+ * @note depth 0 is the piece that PopPieceQueue() returns next.
+ */
+piece_t PeekPieceQueue(const piece_queue_t *queue, uint32 depth);
+
+piece_t PopPieceQueue(piece_queue_t *queue);
+
+/**
+ * @brief Moves the generator batchCount batches forward without generating them.
+ * @note Already buffered pieces are kept. Used to give parallel games distinct,
+ * reproducible parts of the same seed.
+ */
+void JumpPieceQueue(piece_queue_t *queue, uint64 batchCount);
+
+#define TETRIS_RANDOM_H
+#endif
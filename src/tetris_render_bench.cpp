@@ -0,0 +1,125 @@
+#include "tetris_render_bench.h"
+
+bool InitRenderBench(render_bench_t *bench, arena_t *arena, uint32 frameCount)
+{
+    SDL_zerop(bench);
+    bench->frames = PushArray(arena, frameCount, render_bench_frame_t);
+    bench->sortedNs = PushArray(arena, frameCount, uint64);
+
+    if (!bench->frames || !bench->sortedNs)
+    {
+        return SDL_SetError("No room for %u benchmark frames", frameCount);
+    }
+
+    bench->frameCapacity = frameCount;
+    return true;
+}
+
+void BuildRenderBenchScene(level_t *level, fx_pool_t *fxPool, app_assets_t *assets, vec2i_t renderSize,
+                           uint64 tickMs)
+{
+    world_t *world = &level->world;
+    ResetWorld(world);
+
+    for (int32 y = RENDER_BENCH_EMPTY_ROWS; y < world->size.y; ++y)
+    {
+        for (int32 x = 0; x < world->size.x; ++x)
+        {
+            /* One hole per row, a filled row is one the game would never show. */
+            if (x != y % world->size.x)
+            {
+                SetWorldValue(world, vec2i_t{x, y}, (uint8)((x + y) % assets->blockTextureCount + 1));
+            }
+        }
+    }
+
+    level->player.position = {(world->size.x - level->player.data.dim.x) / 2, 0};
+    level->score = 999999;
+    level->paused = true;
+
+    /* One effect per stack row from the top. */
+    SDL_FRect board = GetLevelBoardRect(world, renderSize);
+    SDL_zerop(fxPool);
+
+    for (int32 i = 0; i < MAX_FS_COUNT; ++i)
+    {
+        vec2i_t position{(int32)board.x, (int32)(board.y + (RENDER_BENCH_EMPTY_ROWS + i) * LEVEL_ITEM_SIZE)};
+        AddFx(fxPool, tickMs, vec2i_t{(int32)board.w, (int32)LEVEL_ITEM_SIZE * 2}, assets->fxCleanCount,
+              assets->fxClean, position, position, RENDER_BENCH_FX_DURATION_MS);
+    }
+}
+
+bool RecordRenderBenchFrame(render_bench_t *bench, uint64 renderNs, uint64 frameNs, uint32 renderCalls)
+{
+    if (bench->frameCount < bench->frameCapacity)
+    {
+        bench->frames[bench->frameCount++] = {renderNs, frameNs, renderCalls};
+    }
+
+    return bench->frameCount == bench->frameCapacity;
+}
+
+static int CompareRenderBenchNs(const void *a, const void *b)
+{
+    uint64 nsA = *(const uint64 *)a;
+    uint64 nsB = *(const uint64 *)b;
+    return nsA < nsB ? -1 : (nsA > nsB ? 1 : 0);
+}
+
+/**
+ * @param times Sorted in place.
+ */
+static void LogRenderBenchTimes(const char *name, uint64 *times, uint32 count)
+{
+    uint64 sum = 0;
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        sum += times[i];
+    }
+
+    SDL_qsort(times, count, sizeof(uint64), CompareRenderBenchNs);
+    SDL_Log("%-7s mean %7.3f ms, p50 %7.3f, p90 %7.3f, p99 %7.3f, max %7.3f", name, sum / 1e6 / count,
+            times[count / 2] / 1e6, times[count * 90 / 100] / 1e6, times[count * 99 / 100] / 1e6,
+            times[count - 1] / 1e6);
+}
+
+void LogRenderBenchStats(render_bench_t *bench, const char *rendererName, vec2i_t renderSize)
+{
+    uint32 count = bench->frameCount;
+
+    if (!count)
+    {
+        return;
+    }
+
+    uint64 renderCalls = 0;
+    uint32 minRenderCalls = bench->frames[0].renderCalls;
+    uint32 maxRenderCalls = 0;
+    uint64 frameNsSum = 0;
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        renderCalls += bench->frames[i].renderCalls;
+        minRenderCalls = SDL_min(minRenderCalls, bench->frames[i].renderCalls);
+        maxRenderCalls = SDL_max(maxRenderCalls, bench->frames[i].renderCalls);
+        frameNsSum += bench->frames[i].frameNs;
+    }
+
+    SDL_Log("bench-render: %u frames at %dx%d on %s, %.1f frames/s, %.1f SDL_Render calls per frame (%u to %u)",
+            count, renderSize.w, renderSize.h, rendererName, count / (SDL_max(frameNsSum, (uint64)1) / 1e9),
+            (real64)renderCalls / count, minRenderCalls, maxRenderCalls);
+    for (uint32 i = 0; i < count; ++i)
+    {
+        bench->sortedNs[i] = bench->frames[i].frameNs;
+    }
+
+    LogRenderBenchTimes("frame", bench->sortedNs, count);
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        bench->sortedNs[i] = bench->frames[i].renderNs;
+    }
+
+    LogRenderBenchTimes("render", bench->sortedNs, count);
+}
@@ -0,0 +1,70 @@
+#if !defined(TETRIS_RENDER_BENCH_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+#include "tetris_arena.h"
+#include "tetris_level.h"
+#include "tetris_fx.h"
+
+#define RENDER_BENCH_DEFAULT_FRAMES 2000
+/**
+ * @brief Rows left empty above the stack, so the active piece is drawn on the board.
+ */
+#define RENDER_BENCH_EMPTY_ROWS 4
+/**
+ * @brief Longer than any run, the effects animate in place and never expire.
+ */
+#define RENDER_BENCH_FX_DURATION_MS (24 * 60 * 60 * 1000)
+
+struct render_bench_frame_t
+{
+    /**
+     * @brief Issuing the frame's SDL_Render calls.
+     */
+    uint64 renderNs;
+    /**
+     * @brief renderNs plus SDL_RenderPresent, with VSync off that's the whole frame.
+     */
+    uint64 frameNs;
+    uint32 renderCalls;
+};
+
+/**
+ * @brief A fixed worst-case scene drawn for a fixed number of frames.
+ */
+struct render_bench_t
+{
+    render_bench_frame_t *frames;
+    /**
+     * @brief One field of every frame, sorted for the percentiles.
+     */
+    uint64 *sortedNs;
+    uint32 frameCount;
+    uint32 frameCapacity;
+};
+
+/**
+ * @brief Takes room for frameCount frames from arena.
+ */
+bool InitRenderBench(render_bench_t *bench, arena_t *arena, uint32 frameCount);
+
+/**
+ * @brief Full board of mixed block textures with a hole per row, the active piece on top of it,
+ * every fx slot playing fxClean and the pause overlay.
+ * @param level Initialised level, its piece queue provides the preview.
+ */
+void BuildRenderBenchScene(level_t *level, fx_pool_t *fxPool, app_assets_t *assets, vec2i_t renderSize,
+                           uint64 tickMs);
+
+/**
+ * @return True once every frame is recorded.
+ */
+bool RecordRenderBenchFrame(render_bench_t *bench, uint64 renderNs, uint64 frameNs, uint32 renderCalls);
+
+/**
+ * @brief Frame time percentiles, render and present split, and SDL_Render calls per frame.
+ */
+void LogRenderBenchStats(render_bench_t *bench, const char *rendererName, vec2i_t renderSize);
+
+#define TETRIS_RENDER_BENCH_H
+#endif
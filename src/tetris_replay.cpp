@@ -0,0 +1,167 @@
+#include "tetris_replay.h"
+
+static_assert(sizeof(replay_header_t) == 24, "replay_header_t layout is part of the file format");
+static_assert(sizeof(replay_frame_t) == 8, "replay_frame_t layout is part of the file format");
+
+bool InitReplay(replay_t *replay, arena_t *arena, uint32 capacity, uint64 seed, ePieceRandomizerMode mode)
+{
+    SDL_zerop(replay);
+    replay->seed = seed;
+    replay->randomizerMode = mode;
+    replay->frames = PushArray(arena, capacity, replay_frame_t);
+
+    if (!replay->frames)
+    {
+        return SDL_SetError("No room for %u replay frames", capacity);
+    }
+
+    replay->frameCapacity = capacity;
+    return true;
+}
+
+replay_frame_t MakeReplayFrame(uint64 dt, const game_input_t *input, uint16 commands)
+{
+    replay_frame_t frame;
+    frame.input = PackGameInput(input);
+    frame.commands = commands;
+    frame.dtMs = (uint32)SDL_min(dt, (uint64)SDL_MAX_UINT32);
+    return frame;
+}
+
+bool AppendReplayFrame(replay_t *replay, const replay_frame_t *frame)
+{
+    if (replay->frameCount == replay->frameCapacity)
+    {
+        return false;
+    }
+
+    replay->frames[replay->frameCount++] = *frame;
+    return true;
+}
+
+bool SaveReplay(const replay_t *replay, const char *path)
+{
+    SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+
+    if (!io)
+    {
+        return false;
+    }
+
+    bool written = SDL_WriteU32LE(io, REPLAY_MAGIC) && SDL_WriteU32LE(io, REPLAY_VERSION) &&
+                   SDL_WriteU64LE(io, replay->seed) && SDL_WriteU32LE(io, (uint32)replay->randomizerMode) &&
+                   SDL_WriteU32LE(io, replay->frameCount);
+
+    for (uint32 i = 0; written && i < replay->frameCount; ++i)
+    {
+        const replay_frame_t *frame = &replay->frames[i];
+        written = SDL_WriteU16LE(io, frame->input) && SDL_WriteU16LE(io, frame->commands) &&
+                  SDL_WriteU32LE(io, frame->dtMs);
+    }
+
+    return SDL_CloseIO(io) && written;
+}
+
+bool LoadReplay(replay_t *replay, const char *path)
+{
+    SDL_zerop(replay);
+
+    size_t size;
+    uint8 *data = (uint8 *)SDL_LoadFile(path, &size);
+
+    if (!data)
+    {
+        return false;
+    }
+
+    replay_header_t header;
+    SDL_memcpy(&header, data, SDL_min(size, sizeof(header)));
+    uint32 frameCount = SDL_Swap32LE(header.frameCount);
+
+    if (size < sizeof(header) || SDL_Swap32LE(header.magic) != REPLAY_MAGIC ||
+        SDL_Swap32LE(header.version) != REPLAY_VERSION || SDL_Swap32LE(header.randomizerMode) > PIECE_RANDOMIZER_BAG ||
+        (size - sizeof(header)) / sizeof(replay_frame_t) < frameCount)
+    {
+        SDL_free(data);
+        return SDL_SetError("%s is not a valid replay", path);
+    }
+
+    replay->frames = (replay_frame_t *)SDL_malloc(SDL_max(frameCount, 1u) * sizeof(replay_frame_t));
+
+    if (!replay->frames)
+    {
+        SDL_free(data);
+        return false;
+    }
+
+    SDL_memcpy(replay->frames, data + sizeof(header), frameCount * sizeof(replay_frame_t));
+    SDL_free(data);
+
+    for (uint32 i = 0; i < frameCount; ++i)
+    {
+        replay_frame_t *frame = &replay->frames[i];
+        frame->input = SDL_Swap16LE(frame->input);
+        frame->commands = SDL_Swap16LE(frame->commands);
+        frame->dtMs = SDL_Swap32LE(frame->dtMs);
+    }
+
+    replay->seed = SDL_Swap64LE(header.seed);
+    replay->randomizerMode = (ePieceRandomizerMode)SDL_Swap32LE(header.randomizerMode);
+    replay->frameCount = frameCount;
+    replay->frameCapacity = frameCount;
+    return true;
+}
+
+void FreeReplay(replay_t *replay)
+{
+    SDL_free(replay->frames);
+    SDL_zerop(replay);
+}
+
+bool StartReplayLevel(const replay_t *replay, level_t *level)
+{
+    /* Same order as SDL_AppInit. */
+    SDL_zerop(level);
+    ResetLevel(level);
+
+    if (!InitWorld(&level->world) || !InitPlayer(&level->player))
+    {
+        return false;
+    }
+
+    InitPieceQueue(&level->pieceQueue, replay->seed, replay->randomizerMode);
+    SpawnLevelPlayer(level);
+    return true;
+}
+
+void ApplyReplayCommands(level_t *level, uint16 commands)
+{
+    if (commands & REPLAY_COMMAND_RESET)
+    {
+        ResetLevel(level);
+    }
+
+    if (commands & REPLAY_COMMAND_TOGGLE_PAUSE)
+    {
+        ToggleLevelPaused(level);
+    }
+
+    if (commands & REPLAY_COMMAND_PAUSE)
+    {
+        PauseLevel(level);
+    }
+}
+
+void StepReplayFrame(level_t *level, const replay_frame_t *frame, level_events_t *events)
+{
+    game_input_t input;
+    SDL_zero(input);
+    UnpackGameInput(frame->input, &input);
+    bool moved = ApplyLevelInput(level, frame->dtMs, &input);
+    DoLevelStep(level, frame->dtMs, events);
+
+    if (events && moved)
+    {
+        events->flags |= LEVEL_EVENT_PLAYER_MOVED;
+    }
+}
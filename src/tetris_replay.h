@@ -0,0 +1,99 @@
+#if !defined(TETRIS_REPLAY_H)
+
+#include "tetris_typedefs.h"
+#include "tetris_arena.h"
+#include "tetris_level.h"
+
+#define REPLAY_MAGIC SDL_FOURCC('T', 'T', 'R', 'P')
+#define REPLAY_VERSION 1
+/**
+ * @brief One hour at 60 frames per second.
+ */
+#define REPLAY_DEFAULT_CAPACITY (60 * 60 * 60)
+
+enum eReplayCommand
+{
+    REPLAY_COMMAND_TOGGLE_PAUSE = 1 << 0,
+    REPLAY_COMMAND_PAUSE = 1 << 1,
+    REPLAY_COMMAND_RESET = 1 << 2,
+};
+
+/**
+ * @note All fields are little-endian on disk, the frames follow the header.
+ */
+struct replay_header_t
+{
+    uint32 magic;
+    uint32 version;
+    uint64 seed;
+    uint32 randomizerMode;
+    uint32 frameCount;
+};
+
+/**
+ * @brief Everything one SDL_AppIterate feeds into the level.
+ */
+struct replay_frame_t
+{
+    /**
+     * @brief PackGameInput() of the frame.
+     */
+    uint16 input;
+    /**
+     * @brief eReplayCommand flags, applied before the input.
+     */
+    uint16 commands;
+    uint32 dtMs;
+};
+
+/**
+ * @brief Seed and per-frame inputs, the level is deterministic so that is a whole game.
+ */
+struct replay_t
+{
+    uint64 seed;
+    ePieceRandomizerMode randomizerMode;
+    replay_frame_t *frames;
+    uint32 frameCount;
+    uint32 frameCapacity;
+};
+
+/**
+ * @brief Takes room for capacity frames from arena.
+ */
+bool InitReplay(replay_t *replay, arena_t *arena, uint32 capacity, uint64 seed, ePieceRandomizerMode mode);
+
+replay_frame_t MakeReplayFrame(uint64 dt, const game_input_t *input, uint16 commands);
+
+/**
+ * @return False once the replay is full.
+ */
+bool AppendReplayFrame(replay_t *replay, const replay_frame_t *frame);
+
+bool SaveReplay(const replay_t *replay, const char *path);
+
+/**
+ * @brief Reads a replay file, the frames are SDL_malloc'ed and freed with FreeReplay().
+ */
+bool LoadReplay(replay_t *replay, const char *path);
+
+void FreeReplay(replay_t *replay);
+
+/**
+ * @brief Fresh level in the state the game starts the replay from.
+ */
+bool StartReplayLevel(const replay_t *replay, level_t *level);
+
+/**
+ * @brief Pause and reset requests of a frame.
+ * @note The game applies its own key presses through this too, so a recording replays exactly.
+ */
+void ApplyReplayCommands(level_t *level, uint16 commands);
+
+/**
+ * @brief Input and time of a frame, after ApplyReplayCommands().
+ */
+void StepReplayFrame(level_t *level, const replay_frame_t *frame, level_events_t *events);
+
+#define TETRIS_REPLAY_H
+#endif
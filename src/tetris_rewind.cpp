@@ -0,0 +1,142 @@
+#include "tetris_rewind.h"
+
+static_assert(sizeof(rewind_delta_t) == 16, "deltas are meant to stay small");
+
+static inline rewind_keyframe_t *GetRewindKeyframe(rewind_t *rewind, uint32 index)
+{
+    SDL_assert(index < rewind->keyframeCount);
+    return &rewind->keyframes[(rewind->keyframeHead + index) % rewind->keyframeCapacity];
+}
+
+static void DropOldestRewindKeyframe(rewind_t *rewind)
+{
+    SDL_assert(rewind->keyframeCount > 0);
+    rewind->keyframeHead = (rewind->keyframeHead + 1) % rewind->keyframeCapacity;
+    rewind->keyframeCount--;
+
+    if (rewind->keyframeCount)
+    {
+        rewind->firstLock = GetRewindKeyframe(rewind, 0)->lock;
+    }
+}
+
+static void PushRewindKeyframe(rewind_t *rewind, uint32 lock, const level_t *level)
+{
+    if (rewind->keyframeCount == rewind->keyframeCapacity)
+    {
+        DropOldestRewindKeyframe(rewind);
+    }
+
+    rewind->keyframeCount++;
+    rewind_keyframe_t *keyframe = GetRewindKeyframe(rewind, rewind->keyframeCount - 1);
+    keyframe->lock = lock;
+    CopyLevel(&keyframe->level, level);
+    rewind->firstLock = GetRewindKeyframe(rewind, 0)->lock;
+}
+
+bool InitRewind(rewind_t *rewind, arena_t *arena, uint64 budgetBytes)
+{
+    SDL_zerop(rewind);
+
+    uint64 groupSize = sizeof(rewind_keyframe_t) + REWIND_KEYFRAME_INTERVAL * sizeof(rewind_delta_t);
+    uint64 keyframeCapacity = budgetBytes / groupSize;
+
+    if (keyframeCapacity < 2)
+    {
+        return SDL_SetError("Rewind budget of %llu bytes is below the minimum of %llu",
+                            (unsigned long long)budgetBytes, (unsigned long long)(2 * groupSize));
+    }
+
+    keyframeCapacity = SDL_min(keyframeCapacity, (uint64)SDL_MAX_UINT32 / REWIND_KEYFRAME_INTERVAL);
+    rewind->keyframeCapacity = (uint32)keyframeCapacity;
+    rewind->deltaCapacity = rewind->keyframeCapacity * REWIND_KEYFRAME_INTERVAL;
+    rewind->keyframes = PushArray(arena, rewind->keyframeCapacity, rewind_keyframe_t);
+    rewind->deltas = PushArray(arena, rewind->deltaCapacity, rewind_delta_t);
+
+    return rewind->keyframes && rewind->deltas;
+}
+
+void ResetRewind(rewind_t *rewind, const level_t *level)
+{
+    rewind->keyframeHead = 0;
+    rewind->keyframeCount = 0;
+    PushRewindKeyframe(rewind, 0, level);
+    rewind->lastLock = 0;
+    rewind->currentLock = 0;
+}
+
+void RecordRewindLock(rewind_t *rewind, const level_t *level, const level_events_t *events)
+{
+    if (rewind->currentLock < rewind->lastLock)
+    {
+        while (GetRewindKeyframe(rewind, rewind->keyframeCount - 1)->lock > rewind->currentLock)
+        {
+            rewind->keyframeCount--;
+        }
+
+        rewind->lastLock = rewind->currentLock;
+    }
+
+    uint32 lock = rewind->lastLock + 1;
+    bool needsKeyframe = events->lockedCellCount > REWIND_DELTA_MAX_CELLS ||
+                         lock - GetRewindKeyframe(rewind, rewind->keyframeCount - 1)->lock >= REWIND_KEYFRAME_INTERVAL;
+
+    while (rewind->keyframeCount > 0 && lock - rewind->firstLock > rewind->deltaCapacity)
+    {
+        DropOldestRewindKeyframe(rewind);
+    }
+
+    rewind_delta_t *delta = &rewind->deltas[lock % rewind->deltaCapacity];
+    delta->clearedRowsMask = events->clearedRowsMask;
+    delta->value = events->lockedValue;
+    delta->cellCount = 0;
+
+    if (events->lockedCellCount <= REWIND_DELTA_MAX_CELLS)
+    {
+        delta->cellCount = (uint8)events->lockedCellCount;
+        SDL_memcpy(delta->cells, events->lockedCells, events->lockedCellCount * sizeof(uint16));
+    }
+
+    if (needsKeyframe || rewind->keyframeCount == 0)
+    {
+        PushRewindKeyframe(rewind, lock, level);
+    }
+
+    rewind->lastLock = lock;
+    rewind->currentLock = lock;
+}
+
+uint32 SeekRewind(rewind_t *rewind, level_t *level, uint32 lock)
+{
+    lock = SDL_clamp(lock, rewind->firstLock, rewind->lastLock);
+
+    /* Nearest keyframe at or before lock, locks grow along the ring. */
+    uint32 low = 0;
+    uint32 high = rewind->keyframeCount - 1;
+
+    while (low < high)
+    {
+        uint32 middle = (low + high + 1) / 2;
+
+        if (GetRewindKeyframe(rewind, middle)->lock <= lock)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    const rewind_keyframe_t *keyframe = GetRewindKeyframe(rewind, low);
+    CopyLevel(level, &keyframe->level);
+
+    for (uint32 replayLock = keyframe->lock + 1; replayLock <= lock; ++replayLock)
+    {
+        const rewind_delta_t *delta = &rewind->deltas[replayLock % rewind->deltaCapacity];
+        ReplayLevelLock(level, delta->cells, delta->cellCount, delta->value, delta->clearedRowsMask);
+    }
+
+    rewind->currentLock = lock;
+    return lock;
+}
@@ -0,0 +1,79 @@
+#if !defined(TETRIS_REWIND_H)
+
+#include "tetris_typedefs.h"
+#include "tetris_arena.h"
+#include "tetris_level.h"
+
+/**
+ * @brief Locks between two keyframes, a seek replays at most this many deltas minus one.
+ */
+#define REWIND_KEYFRAME_INTERVAL 32
+#define REWIND_DELTA_MAX_CELLS 5
+#define REWIND_DEFAULT_BUDGET Megabytes(1)
+
+/**
+ * @brief One lock: the cells SavePlayerInWorld wrote and the rows DestroyFilledRows removed.
+ * @note Locks that write more than REWIND_DELTA_MAX_CELLS cells get a keyframe instead.
+ */
+struct rewind_delta_t
+{
+    uint32 clearedRowsMask;
+    uint8 value;
+    uint8 cellCount;
+    uint16 cells[REWIND_DELTA_MAX_CELLS];
+};
+
+struct rewind_keyframe_t
+{
+    uint32 lock;
+    level_t level;
+};
+
+/**
+ * @brief Bounded history of one game, addressed by lock number (0 is the start of the game).
+ * @note Keyframes and deltas are rings carved from an arena once. The oldest keyframe
+ * and the deltas after it are dropped when either ring is full, so the covered
+ * range is [firstLock, lastLock] and only ever slides forward.
+ */
+struct rewind_t
+{
+    rewind_keyframe_t *keyframes;
+    uint32 keyframeCapacity;
+    uint32 keyframeHead;
+    uint32 keyframeCount;
+
+    rewind_delta_t *deltas;
+    uint32 deltaCapacity;
+
+    uint32 firstLock;
+    uint32 lastLock;
+    /**
+     * @brief Lock the level is currently at, below lastLock after seeking back.
+     */
+    uint32 currentLock;
+};
+
+/**
+ * @brief Splits budgetBytes between keyframes and deltas and pushes both rings on the arena.
+ */
+bool InitRewind(rewind_t *rewind, arena_t *arena, uint64 budgetBytes);
+
+/**
+ * @brief Forgets the history and starts a new one at level.
+ */
+void ResetRewind(rewind_t *rewind, const level_t *level);
+
+/**
+ * @brief Records the lock in events, level must be the state right after it.
+ * @note When the level was rewound, the future past currentLock is discarded first.
+ */
+void RecordRewindLock(rewind_t *rewind, const level_t *level, const level_events_t *events);
+
+/**
+ * @brief Restores the level as it was right after lock, clamped to the covered range.
+ * @return The lock the level is now at.
+ */
+uint32 SeekRewind(rewind_t *rewind, level_t *level, uint32 lock);
+
+#define TETRIS_REWIND_H
+#endif
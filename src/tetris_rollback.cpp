@@ -0,0 +1,239 @@
+#include <stddef.h>
+#include "tetris_rollback.h"
+
+static_assert((ROLLBACK_RING_SIZE & (ROLLBACK_RING_SIZE - 1)) == 0, "ROLLBACK_RING_SIZE must be a power of two");
+static_assert(ROLLBACK_RING_SIZE >= 2 * ROLLBACK_MAX_TICKS + 2 * ROLLBACK_INPUT_DELAY + 2,
+              "the ring must hold both the rollback window and the inputs scheduled ahead");
+static_assert(VERSUS_PLAYER_COUNT == 2, "rollback sessions are between two peers");
+
+#define ROLLBACK_RING_MASK (ROLLBACK_RING_SIZE - 1)
+/* isDown bit of every button, see PackGameInput(). */
+#define ROLLBACK_HELD_INPUT_MASK 0x1111
+
+static inline uint32 GetRemotePlayer(const rollback_t *rollback)
+{
+    return rollback->localPlayer ^ 1;
+}
+
+static void CompareRollbackChecksums(rollback_t *rollback, uint32 tick)
+{
+    const rollback_checksum_t *local = &rollback->localChecksums[tick & ROLLBACK_RING_MASK];
+    const rollback_checksum_t *remote = &rollback->remoteChecksums[tick & ROLLBACK_RING_MASK];
+
+    if (local->tick != tick || remote->tick != tick)
+    {
+        return;
+    }
+
+    rollback->stats.checksumsCompared++;
+
+    if (local->checksum != remote->checksum && rollback->stats.desyncTick == ROLLBACK_NO_TICK)
+    {
+        rollback->stats.desyncTick = tick;
+        SDL_Log("Versus desync at tick %u: %016llx vs %016llx", tick,
+                (unsigned long long)local->checksum, (unsigned long long)remote->checksum);
+    }
+}
+
+static void RecordRollbackChecksum(rollback_t *rollback, uint32 tick, const versus_t *state)
+{
+    rollback_checksum_t *local = &rollback->localChecksums[tick & ROLLBACK_RING_MASK];
+    local->tick = tick;
+    local->checksum = GetVersusChecksum(state);
+    CompareRollbackChecksums(rollback, tick);
+}
+
+bool InitRollback(rollback_t *rollback, uint32 localPlayer, uint64 seed, ePieceRandomizerMode mode)
+{
+    SDL_zerop(rollback);
+
+    if (!InitVersus(&rollback->state, seed, mode))
+    {
+        return false;
+    }
+
+    rollback->localPlayer = localPlayer;
+    /* Nobody has input for the first ticks, they are empty on both sides. */
+    rollback->localInputTick = ROLLBACK_INPUT_DELAY;
+    rollback->remoteInputTick = ROLLBACK_INPUT_DELAY;
+    rollback->rollbackTick = ROLLBACK_NO_TICK;
+    rollback->stats.desyncTick = ROLLBACK_NO_TICK;
+
+    for (int i = 0; i < ROLLBACK_RING_SIZE; ++i)
+    {
+        rollback->localChecksums[i].tick = ROLLBACK_NO_TICK;
+        rollback->remoteChecksums[i].tick = ROLLBACK_NO_TICK;
+    }
+
+    RecordRollbackChecksum(rollback, 0, &rollback->state);
+    return true;
+}
+
+inline bool CanAdvanceRollback(const rollback_t *rollback)
+{
+    return rollback->currentTick < rollback->remoteInputTick + ROLLBACK_MAX_TICKS;
+}
+
+static void SimulateRollbackTick(rollback_t *rollback, uint32 tick)
+{
+    uint32 slot = tick & ROLLBACK_RING_MASK;
+    uint32 remotePlayer = GetRemotePlayer(rollback);
+    CopyVersus(&rollback->saved[slot], &rollback->state);
+
+    if (tick >= rollback->remoteInputTick)
+    {
+        /* Predict that the remote player keeps holding what they held, without new presses. */
+        uint16 lastInput = rollback->inputs[remotePlayer][(rollback->remoteInputTick - 1) & ROLLBACK_RING_MASK];
+        rollback->inputs[remotePlayer][slot] = lastInput & ROLLBACK_HELD_INPUT_MASK;
+    }
+
+    uint16 inputs[VERSUS_PLAYER_COUNT] = {rollback->inputs[0][slot], rollback->inputs[1][slot]};
+    StepVersus(&rollback->state, inputs, nullptr);
+}
+
+bool AdvanceRollback(rollback_t *rollback, uint16 localInput)
+{
+    rollback_stats_t *stats = &rollback->stats;
+
+    if (!CanAdvanceRollback(rollback))
+    {
+        stats->stalls++;
+        return false;
+    }
+
+    uint64 timer = SDL_GetPerformanceCounter();
+    uint32 depth = 0;
+
+    rollback->inputs[rollback->localPlayer][rollback->localInputTick & ROLLBACK_RING_MASK] = localInput;
+    rollback->localInputTick++;
+
+    if (rollback->rollbackTick < rollback->currentTick)
+    {
+        depth = rollback->currentTick - rollback->rollbackTick;
+        CopyVersus(&rollback->state, &rollback->saved[rollback->rollbackTick & ROLLBACK_RING_MASK]);
+
+        for (uint32 tick = rollback->rollbackTick; tick < rollback->currentTick; ++tick)
+        {
+            SimulateRollbackTick(rollback, tick);
+        }
+
+        stats->rollbacks++;
+        stats->resimulatedTicks += depth;
+        stats->maxDepth = SDL_max(stats->maxDepth, depth);
+    }
+
+    rollback->rollbackTick = ROLLBACK_NO_TICK;
+    SimulateRollbackTick(rollback, rollback->currentTick);
+    rollback->currentTick++;
+
+    /* States up to the last tick with both inputs confirmed are final, their checksums can be compared. */
+    uint32 confirmedTick = SDL_min(rollback->remoteInputTick, rollback->currentTick);
+
+    while (rollback->checksumTick < confirmedTick)
+    {
+        uint32 tick = ++rollback->checksumTick;
+        const versus_t *state = tick == rollback->currentTick ? &rollback->state : &rollback->saved[tick & ROLLBACK_RING_MASK];
+        RecordRollbackChecksum(rollback, tick, state);
+    }
+
+    real64 seconds = (real64)(SDL_GetPerformanceCounter() - timer) / (real64)SDL_GetPerformanceFrequency();
+    depth = SDL_min(depth, ROLLBACK_MAX_TICKS);
+    stats->ticks++;
+    stats->depthCounts[depth]++;
+    stats->depthSeconds[depth] += seconds;
+    stats->depthMaxSeconds[depth] = SDL_max(stats->depthMaxSeconds[depth], seconds);
+    return true;
+}
+
+void BuildRollbackPacket(rollback_t *rollback, net_packet_t *packet)
+{
+    uint32 firstTick = rollback->remoteAckTick;
+    uint32 count = SDL_min(rollback->localInputTick - firstTick, (uint32)NET_PACKET_MAX_INPUTS);
+
+    SDL_zerop(packet);
+    packet->magic = SDL_Swap32LE(NET_PACKET_MAGIC);
+    packet->inputTick = SDL_Swap32LE(firstTick);
+    packet->ackTick = SDL_Swap32LE(rollback->remoteInputTick);
+    packet->checksumTick = SDL_Swap32LE(rollback->checksumTick);
+    packet->checksum = SDL_Swap64LE(rollback->localChecksums[rollback->checksumTick & ROLLBACK_RING_MASK].checksum);
+    packet->inputCount = SDL_Swap32LE(count);
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        packet->inputs[i] = SDL_Swap16LE(rollback->inputs[rollback->localPlayer][(firstTick + i) & ROLLBACK_RING_MASK]);
+    }
+}
+
+bool ReadRollbackPacket(rollback_t *rollback, const net_packet_t *packet, uint32 size)
+{
+    uint32 count = size >= offsetof(net_packet_t, inputs) ? SDL_Swap32LE(packet->inputCount) : 0;
+
+    if (size < offsetof(net_packet_t, inputs) || SDL_Swap32LE(packet->magic) != NET_PACKET_MAGIC ||
+        count > NET_PACKET_MAX_INPUTS || size < offsetof(net_packet_t, inputs) + count * sizeof(uint16))
+    {
+        return SDL_SetError("Not a versus packet");
+    }
+
+    uint32 ackTick = SDL_min(SDL_Swap32LE(packet->ackTick), rollback->localInputTick);
+    rollback->remoteAckTick = SDL_max(rollback->remoteAckTick, ackTick);
+
+    uint32 remotePlayer = GetRemotePlayer(rollback);
+    uint32 inputTick = SDL_Swap32LE(packet->inputTick);
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        uint32 tick = inputTick + i;
+
+        if (tick < rollback->remoteInputTick)
+        {
+            continue;
+        }
+
+        if (tick > rollback->remoteInputTick ||
+            tick >= rollback->currentTick + ROLLBACK_RING_SIZE - ROLLBACK_MAX_TICKS)
+        {
+            break;
+        }
+
+        uint16 input = SDL_Swap16LE(packet->inputs[i]);
+        uint16 *slot = &rollback->inputs[remotePlayer][tick & ROLLBACK_RING_MASK];
+
+        if (tick < rollback->currentTick && *slot != input)
+        {
+            rollback->rollbackTick = SDL_min(rollback->rollbackTick, tick);
+        }
+
+        *slot = input;
+        rollback->remoteInputTick++;
+    }
+
+    uint32 checksumTick = SDL_Swap32LE(packet->checksumTick);
+    rollback_checksum_t *remote = &rollback->remoteChecksums[checksumTick & ROLLBACK_RING_MASK];
+    remote->tick = checksumTick;
+    remote->checksum = SDL_Swap64LE(packet->checksum);
+    CompareRollbackChecksums(rollback, checksumTick);
+    return true;
+}
+
+inline bool IsRollbackDesynced(const rollback_t *rollback)
+{
+    return rollback->stats.desyncTick != ROLLBACK_NO_TICK;
+}
+
+void LogRollbackStats(const rollback_stats_t *stats)
+{
+    SDL_Log("%llu ticks, %llu stalls, %llu rollbacks re-simulating %llu ticks, max depth %u, %llu checksums compared%s",
+            (unsigned long long)stats->ticks, (unsigned long long)stats->stalls, (unsigned long long)stats->rollbacks,
+            (unsigned long long)stats->resimulatedTicks, stats->maxDepth, (unsigned long long)stats->checksumsCompared,
+            stats->desyncTick != ROLLBACK_NO_TICK ? ", DESYNCED" : "");
+    SDL_Log("depth   ticks   avg us   max us");
+
+    for (int depth = 0; depth <= ROLLBACK_MAX_TICKS; ++depth)
+    {
+        if (stats->depthCounts[depth])
+        {
+            SDL_Log("%5d %7llu %8.2f %8.2f", depth, (unsigned long long)stats->depthCounts[depth],
+                    stats->depthSeconds[depth] * 1e6 / stats->depthCounts[depth], stats->depthMaxSeconds[depth] * 1e6);
+        }
+    }
+}
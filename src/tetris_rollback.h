@@ -0,0 +1,125 @@
+#if !defined(TETRIS_ROLLBACK_H)
+
+#include "tetris_typedefs.h"
+#include "tetris_versus.h"
+
+/**
+ * @brief How far the simulation may run ahead of the last confirmed remote input.
+ */
+#define ROLLBACK_MAX_TICKS 16
+/**
+ * @brief Local inputs are scheduled this many ticks ahead, which hides small latencies without rollbacks.
+ */
+#define ROLLBACK_INPUT_DELAY 2
+/**
+ * @note Must be a power of two and cover ROLLBACK_MAX_TICKS on both sides of the current tick.
+ */
+#define ROLLBACK_RING_SIZE 64
+#define ROLLBACK_NO_TICK 0xFFFFFFFFu
+
+#define NET_PACKET_MAGIC SDL_FOURCC('T', 'T', 'N', 'P')
+#define NET_PACKET_MAX_INPUTS 32
+
+/**
+ * @brief The only message of the protocol, sent every frame.
+ * @note Carries all local inputs the peer hasn't acknowledged yet, so lost packets need no resend.
+ * All fields are little-endian.
+ */
+struct net_packet_t
+{
+    uint32 magic;
+    /**
+     * @brief Tick of inputs[0].
+     */
+    uint32 inputTick;
+    /**
+     * @brief The sender has all of the receiver's inputs below this tick.
+     */
+    uint32 ackTick;
+    uint32 checksumTick;
+    uint64 checksum;
+    uint32 inputCount;
+    uint16 inputs[NET_PACKET_MAX_INPUTS];
+};
+
+struct rollback_checksum_t
+{
+    uint32 tick;
+    uint64 checksum;
+};
+
+/**
+ * @brief Rollback cost by depth, the measurement the mode is tuned with.
+ */
+struct rollback_stats_t
+{
+    uint64 ticks;
+    uint64 stalls;
+    uint64 rollbacks;
+    uint64 resimulatedTicks;
+    uint32 maxDepth;
+    /**
+     * @brief Count, total and worst time of AdvanceRollback by rollback depth (0 is a plain tick).
+     */
+    uint64 depthCounts[ROLLBACK_MAX_TICKS + 1];
+    real64 depthSeconds[ROLLBACK_MAX_TICKS + 1];
+    real64 depthMaxSeconds[ROLLBACK_MAX_TICKS + 1];
+    uint64 checksumsCompared;
+    uint32 desyncTick;
+};
+
+/**
+ * @brief One side of a rollback session.
+ * @note state is the match at the start of currentTick, saved[t % ROLLBACK_RING_SIZE] is the match
+ * at the start of tick t for the last ROLLBACK_RING_SIZE ticks.
+ */
+struct rollback_t
+{
+    versus_t state;
+    versus_t saved[ROLLBACK_RING_SIZE];
+
+    /**
+     * @brief Packed inputs by player and tick, remote entries at or after remoteInputTick are predictions.
+     */
+    uint16 inputs[VERSUS_PLAYER_COUNT][ROLLBACK_RING_SIZE];
+    uint32 localPlayer;
+
+    uint32 currentTick;
+    uint32 localInputTick;
+    uint32 remoteInputTick;
+    uint32 remoteAckTick;
+    /**
+     * @brief Earliest tick simulated with a wrong prediction, ROLLBACK_NO_TICK if none.
+     */
+    uint32 rollbackTick;
+
+    uint32 checksumTick;
+    rollback_checksum_t localChecksums[ROLLBACK_RING_SIZE];
+    rollback_checksum_t remoteChecksums[ROLLBACK_RING_SIZE];
+
+    rollback_stats_t stats;
+};
+
+bool InitRollback(rollback_t *rollback, uint32 localPlayer, uint64 seed, ePieceRandomizerMode mode);
+
+bool CanAdvanceRollback(const rollback_t *rollback);
+
+/**
+ * @brief Schedules localInput, rolls back and re-simulates if a prediction was wrong, then simulates one tick.
+ * @return False when stalled because the peer is too far behind, nothing is consumed then.
+ */
+bool AdvanceRollback(rollback_t *rollback, uint16 localInput);
+
+void BuildRollbackPacket(rollback_t *rollback, net_packet_t *packet);
+
+/**
+ * @brief Confirms remote inputs and marks a rollback if they differ from what was predicted.
+ */
+bool ReadRollbackPacket(rollback_t *rollback, const net_packet_t *packet, uint32 size);
+
+bool IsRollbackDesynced(const rollback_t *rollback);
+
+void LogRollbackStats(const rollback_stats_t *stats);
+
+#define TETRIS_ROLLBACK_H
+#endif
@@ -0,0 +1,346 @@
+#include <stddef.h>
+#include "tetris_save.h"
+#include "tetris_hash.h"
+
+#if defined(SDL_PLATFORM_UNIX) || defined(SDL_PLATFORM_APPLE)
+#define SAVE_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(save_header_t) == 16, "save_header_t layout is part of the file format");
+static_assert(offsetof(save_level_t, randomState) == 88, "save_level_t layout is part of the file format");
+static_assert(sizeof(save_level_t) == 1448, "save_level_t layout is part of the file format");
+static_assert(sizeof(save_level_t) % 8 == 0, "checkpoint records must stay 8-byte aligned");
+
+static inline uint32 GetSaveChecksum(const save_level_t *save)
+{
+    return SDL_crc32(0, (const uint8 *)save + sizeof(save_header_t), sizeof(save_level_t) - sizeof(save_header_t));
+}
+
+void PackLevelSave(const level_t *level, save_level_t *save)
+{
+    const world_t *world = &level->world;
+    const player_t *player = &level->player;
+    const piece_queue_t *queue = &level->pieceQueue;
+
+    SDL_zerop(save);
+
+    save->stepMs = SDL_Swap64LE(level->stepMs);
+    save->currentStepMs = SDL_Swap64LE(level->currentStepMs);
+    save->stepAccumulator = SDL_Swap64LE(level->stepAccumulator);
+    save->score = SDL_Swap32LE(level->score);
+    save->paused = level->paused;
+    save->gameOver = level->gameOver;
+
+    save->worldWidth = (int32)SDL_Swap32LE((uint32)world->size.x);
+    save->worldHeight = (int32)SDL_Swap32LE((uint32)world->size.y);
+    save->worldHash = SDL_Swap64LE(world->hash);
+
+    save->playerX = (int32)SDL_Swap32LE((uint32)player->position.x);
+    save->playerY = (int32)SDL_Swap32LE((uint32)player->position.y);
+    save->playerDimX = (int32)SDL_Swap32LE((uint32)player->data.dim.x);
+    save->playerDimY = (int32)SDL_Swap32LE((uint32)player->data.dim.y);
+    save->playerValue = player->value;
+
+    save->randomizerMode = SDL_Swap32LE((uint32)queue->mode);
+    save->randomState = SDL_Swap64LE(queue->random.state);
+    save->queueHead = SDL_Swap32LE(queue->head);
+    save->queueCount = SDL_Swap32LE(queue->count);
+
+    for (uint32 i = 0; i < PIECE_QUEUE_CAPACITY; ++i)
+    {
+        save->queueKinds[i] = queue->pieces[i].kindId;
+        save->queueValues[i] = queue->pieces[i].value;
+    }
+
+    SDL_memcpy(save->playerGrid, player->data.grid, sizeof(save->playerGrid));
+    SDL_memcpy(save->worldCells, world->data, sizeof(save->worldCells));
+
+    save->header.magic = SDL_Swap32LE(SAVE_MAGIC);
+    save->header.version = SDL_Swap32LE(SAVE_VERSION);
+    save->header.size = SDL_Swap32LE((uint32)sizeof(save_level_t));
+    save->header.checksum = SDL_Swap32LE(GetSaveChecksum(save));
+}
+
+bool ValidateLevelSave(const save_level_t *save, uint64 availableSize)
+{
+    if (availableSize < sizeof(save_level_t))
+    {
+        return SDL_SetError("Save is truncated");
+    }
+
+    if (SDL_Swap32LE(save->header.magic) != SAVE_MAGIC ||
+        SDL_Swap32LE(save->header.version) != SAVE_VERSION ||
+        SDL_Swap32LE(save->header.size) != sizeof(save_level_t))
+    {
+        return SDL_SetError("Save has an unknown format or version");
+    }
+
+    if (SDL_Swap32LE(save->header.checksum) != GetSaveChecksum(save))
+    {
+        return SDL_SetError("Save checksum mismatch");
+    }
+
+    int32 worldWidth = (int32)SDL_Swap32LE((uint32)save->worldWidth);
+    int32 worldHeight = (int32)SDL_Swap32LE((uint32)save->worldHeight);
+    int32 playerDimX = (int32)SDL_Swap32LE((uint32)save->playerDimX);
+    int32 playerDimY = (int32)SDL_Swap32LE((uint32)save->playerDimY);
+
+    if (worldWidth <= 0 || worldWidth > WORLD_MAX_WIDTH || worldHeight <= 0 || worldHeight > WORLD_MAX_HEIGHT ||
+        playerDimX < 0 || playerDimX > PLAYER_DATA_GRID_MAX_SIZE || playerDimY < 0 || playerDimY > PLAYER_DATA_GRID_MAX_SIZE ||
+        SDL_Swap32LE(save->queueHead) >= PIECE_QUEUE_CAPACITY || SDL_Swap32LE(save->queueCount) > PIECE_QUEUE_CAPACITY ||
+        SDL_Swap32LE(save->randomizerMode) > PIECE_RANDOMIZER_BAG)
+    {
+        return SDL_SetError("Save is out of bounds");
+    }
+
+    /* Only the shapes are saved, they have to come from the piece set being played with. */
+    player_data_t playerData{};
+    playerData.dim = {playerDimX, playerDimY};
+    SDL_memcpy(playerData.grid, save->playerGrid, sizeof(playerData.grid));
+    bool matchesPieceSet = MatchPlayerShape(&playerData);
+
+    for (uint32 i = 0; i < PIECE_QUEUE_CAPACITY && matchesPieceSet; ++i)
+    {
+        matchesPieceSet = save->queueKinds[i] < GetPlayerKindCount();
+    }
+
+    if (!matchesPieceSet)
+    {
+        return SDL_SetError("Save was made with another piece set");
+    }
+
+    /* Values pick block textures, anything past the last one would read out of bounds. */
+    bool valuesInRange = save->playerValue <= PLAYER_VALUE_COUNT;
+
+    for (uint32 i = 0; i < PIECE_QUEUE_CAPACITY && valuesInRange; ++i)
+    {
+        valuesInRange = save->queueValues[i] <= PLAYER_VALUE_COUNT;
+    }
+
+    for (uint32 i = 0; i < WORLD_MAX_CELL_COUNT && valuesInRange; ++i)
+    {
+        valuesInRange = save->worldCells[i] <= PLAYER_VALUE_COUNT;
+    }
+
+    /* Every cell of the active piece must be inside the world's columns, between the spawn margin and the floor. */
+    vec2i_t playerPosition{(int32)SDL_Swap32LE((uint32)save->playerX), (int32)SDL_Swap32LE((uint32)save->playerY)};
+    bool playerInWorld = playerPosition.x >= -PLAYER_DATA_GRID_MAX_SIZE && playerPosition.x <= worldWidth &&
+                         playerPosition.y >= -PLAYER_DATA_GRID_MAX_SIZE && playerPosition.y <= worldHeight;
+
+    for (uint32 i = 0; i < playerData.cellCount && playerInWorld; ++i)
+    {
+        vec2i_t cell = playerPosition + GetPlayerCell(&playerData, i);
+        playerInWorld = cell.x >= 0 && cell.x < worldWidth && cell.y >= -PLAYER_DATA_GRID_MAX_SIZE &&
+                        cell.y < worldHeight;
+    }
+
+    if (!valuesInRange || !playerInWorld)
+    {
+        return SDL_SetError("Save is out of bounds");
+    }
+
+    return true;
+}
+
+void UnpackLevelSave(const save_level_t *save, level_t *level)
+{
+    world_t *world = &level->world;
+    player_t *player = &level->player;
+    piece_queue_t *queue = &level->pieceQueue;
+
+    level->stepMs = SDL_Swap64LE(save->stepMs);
+    level->currentStepMs = SDL_Swap64LE(save->currentStepMs);
+    level->stepAccumulator = SDL_Swap64LE(save->stepAccumulator);
+    level->score = SDL_Swap32LE(save->score);
+    level->paused = save->paused != 0;
+    level->gameOver = save->gameOver != 0;
+
+    SetWorldSize(world, {(int32)SDL_Swap32LE((uint32)save->worldWidth),
+                         (int32)SDL_Swap32LE((uint32)save->worldHeight)});
+    SDL_memcpy(world->data, save->worldCells, sizeof(world->data));
+    /* The stored hash is only written for readers of the file, the board is the truth. */
+    world->hash = ComputeWorldHash(world);
+
+    player->position.x = (int32)SDL_Swap32LE((uint32)save->playerX);
+    player->position.y = (int32)SDL_Swap32LE((uint32)save->playerY);
+    player->data.dim.x = (int32)SDL_Swap32LE((uint32)save->playerDimX);
+    player->data.dim.y = (int32)SDL_Swap32LE((uint32)save->playerDimY);
+    player->value = save->playerValue;
+    SDL_memcpy(player->data.grid, save->playerGrid, sizeof(player->data.grid));
+    /* ValidateLevelSave() made sure the shape is in the active piece set. */
+    MatchPlayerShape(&player->data);
+
+    queue->mode = (ePieceRandomizerMode)SDL_Swap32LE(save->randomizerMode);
+    queue->kindCount = (uint8)GetPlayerKindCount();
+    queue->random.state = SDL_Swap64LE(save->randomState);
+    queue->head = SDL_Swap32LE(save->queueHead);
+    queue->count = SDL_Swap32LE(save->queueCount);
+
+    for (uint32 i = 0; i < PIECE_QUEUE_CAPACITY; ++i)
+    {
+        queue->pieces[i].kindId = save->queueKinds[i];
+        queue->pieces[i].value = save->queueValues[i];
+    }
+}
+
+static bool WriteSaveFile(const char *path, const void *data, uint64 size)
+{
+    char tempPath[1024];
+    SDL_snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    SDL_IOStream *io = SDL_IOFromFile(tempPath, "wb");
+
+    if (!io)
+    {
+        return false;
+    }
+
+    bool written = SDL_WriteIO(io, data, size) == size;
+
+    if (!SDL_CloseIO(io) || !written)
+    {
+        SDL_RemovePath(tempPath);
+        return false;
+    }
+
+    return SDL_RenamePath(tempPath, path);
+}
+
+bool SaveLevel(const level_t *level, const char *path)
+{
+    save_level_t save;
+    PackLevelSave(level, &save);
+    return WriteSaveFile(path, &save, sizeof(save));
+}
+
+bool LoadLevel(level_t *level, const char *path)
+{
+    save_file_t file;
+
+    if (!OpenSaveFile(&file, path))
+    {
+        return false;
+    }
+
+    const save_level_t *save = (const save_level_t *)file.base;
+    bool valid = ValidateLevelSave(save, file.size);
+
+    if (valid)
+    {
+        UnpackLevelSave(save, level);
+    }
+
+    CloseSaveFile(&file);
+    return valid;
+}
+
+bool OpenSaveFile(save_file_t *file, const char *path)
+{
+    SDL_zerop(file);
+
+#if defined(SAVE_USE_MMAP)
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return SDL_SetError("Couldn't open %s", path);
+    }
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        close(fd);
+        return SDL_SetError("Couldn't stat %s", path);
+    }
+
+    void *base = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        return SDL_SetError("Couldn't map %s", path);
+    }
+
+    file->base = base;
+    file->size = (uint64)fileStat.st_size;
+    file->mapped = true;
+#else
+    size_t size;
+    file->base = SDL_LoadFile(path, &size);
+    file->size = size;
+
+    if (!file->base)
+    {
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+void CloseSaveFile(save_file_t *file)
+{
+#if defined(SAVE_USE_MMAP)
+    if (file->mapped)
+    {
+        munmap(file->base, (size_t)file->size);
+    }
+    else
+#endif
+    {
+        SDL_free(file->base);
+    }
+
+    SDL_zerop(file);
+}
+
+bool SaveLevelCheckpoint(const level_t *levels, uint32 count, const char *path)
+{
+    uint64 size = sizeof(save_checkpoint_header_t) + (uint64)count * sizeof(save_level_t);
+    uint8 *buffer = (uint8 *)SDL_malloc(size);
+
+    if (!buffer)
+    {
+        return false;
+    }
+
+    save_checkpoint_header_t *header = (save_checkpoint_header_t *)buffer;
+    header->magic = SDL_Swap32LE(SAVE_CHECKPOINT_MAGIC);
+    header->version = SDL_Swap32LE(SAVE_VERSION);
+    header->count = SDL_Swap32LE(count);
+    header->recordSize = SDL_Swap32LE((uint32)sizeof(save_level_t));
+
+    save_level_t *records = (save_level_t *)(header + 1);
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        PackLevelSave(&levels[i], &records[i]);
+    }
+
+    bool result = WriteSaveFile(path, buffer, size);
+    SDL_free(buffer);
+    return result;
+}
+
+const save_level_t *GetCheckpointRecords(save_file_t *file, uint32 *count)
+{
+    const save_checkpoint_header_t *header = (const save_checkpoint_header_t *)file->base;
+
+    if (file->size < sizeof(save_checkpoint_header_t) ||
+        SDL_Swap32LE(header->magic) != SAVE_CHECKPOINT_MAGIC ||
+        SDL_Swap32LE(header->version) != SAVE_VERSION ||
+        SDL_Swap32LE(header->recordSize) != sizeof(save_level_t) ||
+        file->size < sizeof(save_checkpoint_header_t) + (uint64)SDL_Swap32LE(header->count) * sizeof(save_level_t))
+    {
+        SDL_SetError("Not a checkpoint file");
+        return nullptr;
+    }
+
+    *count = SDL_Swap32LE(header->count);
+    return (const save_level_t *)(header + 1);
+}
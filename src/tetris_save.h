@@ -0,0 +1,112 @@
+#if !defined(TETRIS_SAVE_H)
+
+#include "tetris_typedefs.h"
+#include "tetris_level.h"
+
+#define SAVE_MAGIC SDL_FOURCC('T', 'T', 'R', 'S')
+#define SAVE_CHECKPOINT_MAGIC SDL_FOURCC('T', 'T', 'C', 'K')
+#define SAVE_VERSION 1
+
+/**
+ * @note All multi-byte fields are little-endian, every field is naturally aligned
+ * and the structs have no implicit padding, so a mapped file is used in place.
+ */
+struct save_header_t
+{
+    uint32 magic;
+    uint32 version;
+    uint32 size;
+    /**
+     * @brief CRC32 of everything after the header.
+     */
+    uint32 checksum;
+};
+
+struct save_level_t
+{
+    save_header_t header;
+
+    uint64 stepMs;
+    uint64 currentStepMs;
+    uint64 stepAccumulator;
+    uint32 score;
+    uint8 paused;
+    uint8 gameOver;
+    uint8 reserved0[2];
+
+    int32 worldWidth;
+    int32 worldHeight;
+    uint64 worldHash;
+
+    int32 playerX;
+    int32 playerY;
+    int32 playerDimX;
+    int32 playerDimY;
+    uint8 playerValue;
+    uint8 reserved1[3];
+
+    uint32 randomizerMode;
+    uint64 randomState;
+    uint32 queueHead;
+    uint32 queueCount;
+    uint8 queueKinds[PIECE_QUEUE_CAPACITY];
+    uint8 queueValues[PIECE_QUEUE_CAPACITY];
+
+    uint8 playerGrid[PLAYER_DATA_GRID_MAX_SIZE * PLAYER_DATA_GRID_MAX_SIZE];
+    uint8 worldCells[WORLD_MAX_CELL_COUNT];
+};
+
+/**
+ * @brief Many games in one file: this header followed by count save_level_t records.
+ */
+struct save_checkpoint_header_t
+{
+    uint32 magic;
+    uint32 version;
+    uint32 count;
+    uint32 recordSize;
+};
+
+void PackLevelSave(const level_t *level, save_level_t *save);
+
+/**
+ * @brief Checks magic, version, size, checksum and bounds of a record.
+ * @note The active piece set must have its pieces, the save only keeps their shapes.
+ */
+bool ValidateLevelSave(const save_level_t *save, uint64 availableSize);
+
+/**
+ * @note The save must be validated. Render settings of level are kept.
+ */
+void UnpackLevelSave(const save_level_t *save, level_t *level);
+
+/**
+ * @brief Writes the level with a single write to a temporary file, then renames it over path.
+ */
+bool SaveLevel(const level_t *level, const char *path);
+
+bool LoadLevel(level_t *level, const char *path);
+
+/**
+ * @brief Read-only view of a save file, mapped where the platform allows it.
+ */
+struct save_file_t
+{
+    void *base;
+    uint64 size;
+    bool mapped;
+};
+
+bool OpenSaveFile(save_file_t *file, const char *path);
+
+void CloseSaveFile(save_file_t *file);
+
+bool SaveLevelCheckpoint(const level_t *levels, uint32 count, const char *path);
+
+/**
+ * @brief Validates the checkpoint header, records are then read in place.
+ */
+const save_level_t *GetCheckpointRecords(save_file_t *file, uint32 *count);
+
+#define TETRIS_SAVE_H
+#endif
@@ -0,0 +1,92 @@
+#include "tetris_selfplay.h"
+
+void PlaySelfPlayPiece(level_t *level, random_t *random, level_events_t *events)
+{
+    bot_move_t move{(int32)NextRandomBelow(random, 4), (int32)NextRandomBelow(random, level->world.size.x)};
+
+    if (NextRandomBelow(random, SELFPLAY_RANDOM_MOVE_ONE_IN))
+    {
+        move = PickBotMove(level);
+    }
+
+    events->flags = 0;
+    DropBotPiece(level, move.rotations, move.x, events);
+
+    if (!(events->flags & LEVEL_EVENT_PIECE_LOCKED))
+    {
+        /* The piece didn't fit where the random move put it, lock it where it stands. */
+        LockLevelPlayer(level, events);
+    }
+}
+
+bool RunSelfPlay(uint64 seed, uint32 games, vec2i_t renderSize, selfplay_stats_t *stats)
+{
+    SDL_zerop(stats);
+
+    SDL_Surface *surface = SDL_CreateSurface(renderSize.w, renderSize.h, SDL_PIXELFORMAT_XRGB8888);
+    SDL_Renderer *renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+    level_t *level = (level_t *)SDL_malloc(sizeof(level_t));
+    app_assets_t assets;
+    SDL_zero(assets);
+    bool success = renderer && level && LoadTextureAssets(renderer, &assets);
+
+    random_t random;
+    SeedRandom(&random, seed);
+
+    for (uint32 game = 0; success && game < games; ++game)
+    {
+        SDL_zerop(level);
+        ResetLevel(level);
+
+        if (!InitWorld(&level->world) || !InitPlayer(&level->player))
+        {
+            success = false;
+            break;
+        }
+
+        InitPieceQueue(&level->pieceQueue, seed + game, PIECE_RANDOMIZER_BAG);
+        SpawnLevelPlayer(level);
+
+        for (uint32 lock = 0; lock < SELFPLAY_MAX_LOCKS_PER_GAME && !level->gameOver; ++lock)
+        {
+            uint64 start = SDL_GetTicksNS();
+            level_events_t events;
+            PlaySelfPlayPiece(level, &random, &events);
+
+            uint64 rendered = SDL_GetTicksNS();
+            RenderBackground(renderer, &assets);
+            RenderLevel(renderer, &assets, level, renderSize);
+            SDL_FlushRenderer(renderer);
+
+            stats->simulateNs += rendered - start;
+            stats->renderNs += SDL_GetTicksNS() - rendered;
+            stats->locks++;
+            stats->frames++;
+            stats->rows += CountSetBits32(events.clearedRowsMask);
+        }
+
+        stats->games++;
+    }
+
+    if (!success)
+    {
+        SDL_Log("Couldn't run self-play: %s", SDL_GetError());
+    }
+
+    FreeTextureAssets(&assets);
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(surface);
+    SDL_free(level);
+    return success;
+}
+
+void LogSelfPlayStats(const selfplay_stats_t *stats)
+{
+    real64 simulateSeconds = (real64)SDL_max(stats->simulateNs, 1ull) / 1e9;
+    real64 renderSeconds = (real64)SDL_max(stats->renderNs, 1ull) / 1e9;
+
+    SDL_Log("selfplay: %u games, %llu locks, %llu rows, sim %.1f locks/s (%.2f us/lock), render %.1f frames/s (%.3f ms/frame)",
+            stats->games, (unsigned long long)stats->locks, (unsigned long long)stats->rows,
+            stats->locks / simulateSeconds, simulateSeconds * 1e6 / SDL_max(stats->locks, 1ull),
+            stats->frames / renderSeconds, renderSeconds * 1e3 / SDL_max(stats->frames, 1ull));
+}
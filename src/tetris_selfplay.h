@@ -0,0 +1,49 @@
+#if !defined(TETRIS_SELFPLAY_H)
+
+#include "tetris_typedefs.h"
+#include "tetris_bot.h"
+
+/**
+ * @brief Games are cut here so a strong bot can't turn the workload into one endless game.
+ */
+#define SELFPLAY_MAX_LOCKS_PER_GAME 500
+/**
+ * @brief One move in this many is random, so games differ and stacks get messy enough to end.
+ */
+#define SELFPLAY_RANDOM_MOVE_ONE_IN 16
+
+struct selfplay_stats_t
+{
+    uint32 games;
+    uint64 locks;
+    uint64 rows;
+    uint64 frames;
+    /**
+     * @brief Move search, drops and line clears.
+     */
+    uint64 simulateNs;
+    /**
+     * @brief RenderBackground() + RenderLevel() + flush into the offscreen surface.
+     */
+    uint64 renderNs;
+};
+
+/**
+ * @brief Drops the active piece where the bot wants it, or in one move of SELFPLAY_RANDOM_MOVE_ONE_IN somewhere random.
+ * @note The one step of every self-play game, the PGO training games and exported datasets both use it.
+ */
+void PlaySelfPlayPiece(level_t *level, random_t *random, level_events_t *events);
+
+/**
+ * @brief Headless bot games: simulation plus one software rendered frame per lock, no window or audio.
+ * @note This is the workload the PGO build trains on, see cmake/pgo.cmake.
+ */
+bool RunSelfPlay(uint64 seed, uint32 games, vec2i_t renderSize, selfplay_stats_t *stats);
+
+/**
+ * @note cmake/pgo.cmake parses this line, keep the "sim <n> locks/s" and "render <n> frames/s" fields.
+ */
+void LogSelfPlayStats(const selfplay_stats_t *stats);
+
+#define TETRIS_SELFPLAY_H
+#endif
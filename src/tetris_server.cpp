@@ -0,0 +1,950 @@
+#include "tetris_server.h"
+
+#if defined(SDL_PLATFORM_LINUX)
+#define SERVER_USE_EPOLL 1
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+SDL_COMPILE_TIME_ASSERT(server_hello_layout, sizeof(server_hello_t) == 16);
+SDL_COMPILE_TIME_ASSERT(server_delta_layout, SERVER_DELTA_HEADER_SIZE == 32);
+SDL_COMPILE_TIME_ASSERT(server_stats_layout, sizeof(server_stats_message_t) == 96);
+SDL_COMPILE_TIME_ASSERT(server_session_in, SERVER_SESSION_IN_SIZE >= sizeof(server_hello_t));
+
+/**
+ * @brief Per shard: the shard, its sessions, the free list, the active list and its index.
+ */
+static uint64 GetServerShardMemorySize(uint32 sessions)
+{
+    return sizeof(server_shard_t) + ARENA_DEFAULT_ALIGNMENT +
+           sessions * sizeof(server_session_t) + ARENA_DEFAULT_ALIGNMENT +
+           3 * (sessions * sizeof(uint32) + ARENA_DEFAULT_ALIGNMENT);
+}
+
+uint64 GetServerMemorySize(const server_config_t *config)
+{
+    return config->shardCount * GetServerShardMemorySize(config->sessionsPerShard);
+}
+
+uint64 GetServerJitterNs(const server_shard_stats_t *stats, uint32 percent)
+{
+    uint64 count = 0;
+
+    for (uint32 bucket = 0; bucket < SERVER_JITTER_BUCKET_COUNT; ++bucket)
+    {
+        count += stats->jitterHistogram[bucket];
+    }
+
+    uint64 target = (count * percent + 99) / 100;
+    uint64 seen = 0;
+
+    for (uint32 bucket = 0; bucket < SERVER_JITTER_BUCKET_COUNT && target; ++bucket)
+    {
+        seen += stats->jitterHistogram[bucket];
+
+        if (seen >= target)
+        {
+            return SDL_min((uint64)(bucket + 1) * SERVER_JITTER_BUCKET_NS, stats->maxJitterNs);
+        }
+    }
+
+    return stats->maxJitterNs;
+}
+
+static void AddServerStats(server_shard_stats_t *total, const server_shard_stats_t *stats)
+{
+    total->sessions += stats->sessions;
+    total->peakSessions += stats->peakSessions;
+    total->accepted += stats->accepted;
+    total->closed += stats->closed;
+    total->dropped += stats->dropped;
+    total->ticks += stats->ticks;
+    total->lateTicks += stats->lateTicks;
+    total->skippedTicks += stats->skippedTicks;
+    total->tickWorkNs += stats->tickWorkNs;
+    total->maxTickWorkNs = SDL_max(total->maxTickWorkNs, stats->maxTickWorkNs);
+    total->maxJitterNs = SDL_max(total->maxJitterNs, stats->maxJitterNs);
+    total->deltas += stats->deltas;
+    total->bytesIn += stats->bytesIn;
+    total->bytesOut += stats->bytesOut;
+
+    for (uint32 bucket = 0; bucket < SERVER_JITTER_BUCKET_COUNT; ++bucket)
+    {
+        total->jitterHistogram[bucket] += stats->jitterHistogram[bucket];
+    }
+}
+
+void GetServerStats(server_t *server, server_shard_stats_t *total, server_shard_stats_t *perShard)
+{
+    SDL_zerop(total);
+
+    for (uint32 i = 0; server->shards && i < server->config.shardCount; ++i)
+    {
+        server_shard_t *shard = &server->shards[i];
+        server_shard_stats_t stats;
+        SDL_LockMutex(shard->publishMutex);
+        stats = shard->published;
+        SDL_UnlockMutex(shard->publishMutex);
+        AddServerStats(total, &stats);
+
+        if (perShard)
+        {
+            perShard[i] = stats;
+        }
+    }
+}
+
+static void LogServerShardStats(const char *name, const server_shard_stats_t *stats)
+{
+    SDL_Log("%-6s %5u sessions (peak %5u), %7llu ticks, %llu late, %llu skipped, work mean %7.1f us, max %7.1f; "
+            "jitter p50 %6.1f us, p99 %6.1f, max %7.1f; %llu deltas, %.1f MB out, %llu dropped",
+            name, stats->sessions, stats->peakSessions, (unsigned long long)stats->ticks,
+            (unsigned long long)stats->lateTicks, (unsigned long long)stats->skippedTicks,
+            stats->tickWorkNs / (real64)SDL_max(stats->ticks, (uint64)1) / 1e3, stats->maxTickWorkNs / 1e3,
+            GetServerJitterNs(stats, 50) / 1e3, GetServerJitterNs(stats, 99) / 1e3, stats->maxJitterNs / 1e3,
+            (unsigned long long)stats->deltas, stats->bytesOut / 1e6, (unsigned long long)stats->dropped);
+}
+
+void LogServerStats(server_t *server)
+{
+    server_shard_stats_t total;
+    server_shard_stats_t perShard[256];
+    uint32 shardCount = SDL_min(server->config.shardCount, (uint32)SDL_arraysize(perShard));
+    GetServerStats(server, &total, shardCount == server->config.shardCount ? perShard : nullptr);
+
+    /* A mean hides a shard that took the whole backlog, the spread is only known with every shard's stats. */
+    bool perShardKnown = shardCount == server->config.shardCount;
+    uint32 minSessions = perShardKnown ? ~0u : 0;
+    uint32 maxSessions = perShardKnown ? 0 : total.sessions;
+
+    for (uint32 i = 0; i < shardCount && perShardKnown; ++i)
+    {
+        char name[16];
+        SDL_snprintf(name, sizeof(name), "shard%u", i);
+        LogServerShardStats(name, &perShard[i]);
+        minSessions = SDL_min(minSessions, perShard[i].sessions);
+        maxSessions = SDL_max(maxSessions, perShard[i].sessions);
+    }
+
+    LogServerShardStats("total", &total);
+    SDL_Log("%u sessions on %u shards, %.1f per core (min %u, max %u)", total.sessions, server->config.shardCount,
+            total.sessions / (real64)SDL_max(server->config.shardCount, 1u), minSessions, maxSessions);
+}
+
+#if defined(SERVER_USE_EPOLL)
+
+/**
+ * @brief epoll data: the timer, a listener with its fd, or a session's generation and slot.
+ */
+#define SERVER_EPOLL_TIMER (1ull << 63)
+#define SERVER_EPOLL_LISTENER (1ull << 62)
+#define SERVER_EPOLL_GENERATION_MASK 0x3FFFFFFFu
+#define SERVER_PUBLISH_TICKS 64
+
+/**
+ * @brief The clock timerfd runs on, SDL_GetTicksNS() may use another one.
+ */
+static uint64 GetServerClockNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64)now.tv_sec * SDL_NS_PER_SECOND + (uint64)now.tv_nsec;
+}
+
+static uint64 GetServerSessionTag(const server_session_t *session, uint32 slot)
+{
+    return (uint64)(session->generation & SERVER_EPOLL_GENERATION_MASK) << 32 | slot;
+}
+
+static void SetServerListening(server_shard_t *shard, bool listening)
+{
+    server_t *server = shard->server;
+    int fds[] = {server->tcpFd, server->unixFd};
+
+    for (uint32 i = 0; i < SDL_arraysize(fds) && shard->listening != listening; ++i)
+    {
+        if (fds[i] < 0)
+        {
+            continue;
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.u64 = SERVER_EPOLL_LISTENER | (uint32)fds[i];
+        epoll_ctl(shard->epollFd, listening ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fds[i], &event);
+    }
+
+    shard->listening = listening;
+}
+
+/**
+ * @brief Room in the pool and not a batch past an even share, the least loaded shard always qualifies.
+ */
+static bool IsServerShardAccepting(server_shard_t *shard)
+{
+    server_t *server = shard->server;
+    uint32 share = (uint32)SDL_GetAtomicInt(&server->sessions) / server->config.shardCount;
+    return shard->freeCount && shard->activeCount < share + SERVER_ACCEPT_BATCH;
+}
+
+static void UpdateServerListening(server_shard_t *shard)
+{
+    bool accepting = IsServerShardAccepting(shard);
+
+    if (accepting != shard->listening)
+    {
+        SetServerListening(shard, accepting);
+    }
+}
+
+static void CloseServerSession(server_shard_t *shard, uint32 slot, bool dropped)
+{
+    server_session_t *session = &shard->sessions[slot];
+    epoll_ctl(shard->epollFd, EPOLL_CTL_DEL, session->fd, nullptr);
+    close(session->fd);
+    session->fd = -1;
+    session->generation++;
+
+    uint32 index = shard->activeIndex[slot];
+    uint32 last = shard->active[--shard->activeCount];
+    shard->active[index] = last;
+    shard->activeIndex[last] = index;
+    shard->freeSlots[shard->freeCount++] = slot;
+
+    shard->stats.sessions--;
+    shard->stats.closed++;
+    shard->stats.dropped += dropped;
+    SDL_AddAtomicInt(&shard->server->sessions, -1);
+    UpdateServerListening(shard);
+}
+
+static void OpenServerSession(server_shard_t *shard, int fd)
+{
+    uint32 slot = shard->freeSlots[--shard->freeCount];
+    server_session_t *session = &shard->sessions[slot];
+    uint32 generation = session->generation;
+    SDL_zerop(session);
+    session->fd = fd;
+    session->generation = generation;
+    session->id = shard->nextSessionId++ * shard->server->config.shardCount + shard->index;
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = GetServerSessionTag(session, slot);
+
+    if (epoll_ctl(shard->epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        close(fd);
+        session->fd = -1;
+        shard->freeSlots[shard->freeCount++] = slot;
+        return;
+    }
+
+    shard->activeIndex[slot] = shard->activeCount;
+    shard->active[shard->activeCount++] = slot;
+    shard->stats.accepted++;
+    shard->stats.sessions++;
+    SDL_AddAtomicInt(&shard->server->sessions, 1);
+    shard->stats.peakSessions = SDL_max(shard->stats.peakSessions, shard->stats.sessions);
+}
+
+/**
+ * @brief Takes at most a batch, so a backlog that woke one shard is spread over the ones under their share.
+ */
+static void AcceptServerSessions(server_shard_t *shard, int listenFd)
+{
+    for (uint32 i = 0; i < SERVER_ACCEPT_BATCH && IsServerShardAccepting(shard); ++i)
+    {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0)
+        {
+            /* Another shard took it, or the backlog is empty. */
+            break;
+        }
+
+        /* Deltas are small and due now, fails harmlessly on Unix sockets. */
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        OpenServerSession(shard, fd);
+    }
+
+    UpdateServerListening(shard);
+}
+
+/**
+ * @brief Once a tick, a backlog left by a shard that reached its share doesn't wake the others by itself.
+ */
+static void PollServerListeners(server_shard_t *shard)
+{
+    server_t *server = shard->server;
+    int fds[] = {server->tcpFd, server->unixFd};
+    UpdateServerListening(shard);
+
+    for (uint32 i = 0; i < SDL_arraysize(fds) && shard->listening; ++i)
+    {
+        if (fds[i] >= 0)
+        {
+            AcceptServerSessions(shard, fds[i]);
+        }
+    }
+}
+
+static bool QueueServerMessage(server_session_t *session, const void *message, uint32 size)
+{
+    if (session->outSize + size > SERVER_SESSION_OUT_SIZE)
+    {
+        return false;
+    }
+
+    SDL_memcpy(session->out + session->outSize, message, size);
+    session->outSize += size;
+    return true;
+}
+
+/**
+ * @return False if the session was closed.
+ */
+static bool FlushServerSession(server_shard_t *shard, uint32 slot)
+{
+    server_session_t *session = &shard->sessions[slot];
+    uint32 sent = 0;
+
+    while (sent < session->outSize)
+    {
+        ssize_t written = send(session->fd, session->out + sent, session->outSize - sent, MSG_NOSIGNAL);
+
+        if (written < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+
+            CloseServerSession(shard, slot, false);
+            return false;
+        }
+
+        sent += (uint32)written;
+    }
+
+    shard->stats.bytesOut += sent;
+    session->outSize -= sent;
+    SDL_memmove(session->out, session->out + sent, session->outSize);
+
+    /* Only ask for writability while there is something waiting, it would fire on every wait otherwise. */
+    bool wantWrite = session->outSize > 0;
+
+    if (wantWrite != session->writeArmed)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN | (wantWrite ? EPOLLOUT : 0);
+        event.data.u64 = GetServerSessionTag(session, slot);
+        epoll_ctl(shard->epollFd, EPOLL_CTL_MOD, session->fd, &event);
+        session->writeArmed = wantWrite;
+    }
+
+    return true;
+}
+
+static void InitServerMessageHeader(server_message_header_t *header, uint32 size, uint8 type)
+{
+    header->size = SDL_Swap16LE((uint16)size);
+    header->type = type;
+    header->reserved = 0;
+}
+
+static bool StartServerGame(server_shard_t *shard, server_session_t *session, const server_hello_t *hello)
+{
+    level_t *level = &session->level;
+    ResetLevel(level);
+
+    if (!InitWorld(&level->world) || !InitPlayer(&level->player))
+    {
+        return false;
+    }
+
+    ePieceRandomizerMode mode = hello->randomizerMode ? PIECE_RANDOMIZER_BAG : PIECE_RANDOMIZER_UNIFORM;
+    InitPieceQueue(&level->pieceQueue, SDL_Swap64LE(hello->seed), mode);
+    SpawnLevelPlayer(level);
+    level->currentStepMs = level->stepMs;
+    session->input = game_input_t{};
+    session->sentPiece = false;
+    session->playing = true;
+
+    server_welcome_t welcome{};
+    InitServerMessageHeader(&welcome.header, sizeof(welcome), SERVER_MESSAGE_WELCOME);
+    welcome.sessionId = SDL_Swap32LE(session->id);
+    welcome.shard = SDL_Swap16LE((uint16)shard->index);
+    welcome.shardCount = SDL_Swap16LE((uint16)shard->server->config.shardCount);
+    welcome.worldWidth = (uint8)level->world.size.x;
+    welcome.worldHeight = (uint8)level->world.size.y;
+    welcome.tickMs = SDL_Swap16LE(SERVER_TICK_MS);
+    return QueueServerMessage(session, &welcome, sizeof(welcome));
+}
+
+/**
+ * @brief Presses received during a tick add up, the last held state wins, like frames of game_input_t.
+ */
+static void MergeServerInput(game_input_t *input, uint16 packed)
+{
+    game_input_t received{};
+    UnpackGameInput(packed, &received);
+
+    for (uint32 i = 0; i < SDL_arraysize(input->buttons); ++i)
+    {
+        game_input_button_t *button = &input->buttons[i];
+        button->transitionCount = (uint8)SDL_min(button->transitionCount + received.buttons[i].transitionCount, 255);
+        button->isDown = received.buttons[i].isDown;
+    }
+}
+
+static bool QueueServerStats(server_shard_t *shard, server_session_t *session)
+{
+    const server_shard_stats_t *stats = &shard->stats;
+    server_stats_message_t message{};
+    InitServerMessageHeader(&message.header, sizeof(message), SERVER_MESSAGE_STATS);
+    message.shard = SDL_Swap16LE((uint16)shard->index);
+    message.shardCount = SDL_Swap16LE((uint16)shard->server->config.shardCount);
+    message.sessions = SDL_Swap32LE(stats->sessions);
+    message.peakSessions = SDL_Swap32LE(stats->peakSessions);
+    message.ticks = SDL_Swap64LE(stats->ticks);
+    message.lateTicks = SDL_Swap64LE(stats->lateTicks);
+    message.skippedTicks = SDL_Swap64LE(stats->skippedTicks);
+    message.meanTickWorkNs = SDL_Swap64LE(stats->tickWorkNs / SDL_max(stats->ticks, (uint64)1));
+    message.maxTickWorkNs = SDL_Swap64LE(stats->maxTickWorkNs);
+    message.jitterP50Ns = SDL_Swap64LE(GetServerJitterNs(stats, 50));
+    message.jitterP99Ns = SDL_Swap64LE(GetServerJitterNs(stats, 99));
+    message.jitterMaxNs = SDL_Swap64LE(stats->maxJitterNs);
+    message.deltas = SDL_Swap64LE(stats->deltas);
+    message.bytesOut = SDL_Swap64LE(stats->bytesOut);
+    return QueueServerMessage(session, &message, sizeof(message));
+}
+
+/**
+ * @return False if the message is malformed or its reply doesn't fit.
+ */
+static bool HandleServerMessage(server_shard_t *shard, server_session_t *session, const uint8 *data, uint32 size)
+{
+    const server_message_header_t *header = (const server_message_header_t *)data;
+
+    switch (header->type)
+    {
+    case SERVER_MESSAGE_HELLO:
+        return size == sizeof(server_hello_t) && StartServerGame(shard, session, (const server_hello_t *)data);
+    case SERVER_MESSAGE_INPUT:
+        if (size != sizeof(server_input_t))
+        {
+            return false;
+        }
+
+        MergeServerInput(&session->input, SDL_Swap16LE(((const server_input_t *)data)->input));
+        return true;
+    case SERVER_MESSAGE_STATS_REQUEST:
+        return size == sizeof(server_message_header_t) && QueueServerStats(shard, session);
+    default:
+        return false;
+    }
+}
+
+static void ReadServerSession(server_shard_t *shard, uint32 slot)
+{
+    server_session_t *session = &shard->sessions[slot];
+    ssize_t received = recv(session->fd, session->in + session->inSize, SERVER_SESSION_IN_SIZE - session->inSize, 0);
+
+    if (received <= 0)
+    {
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            CloseServerSession(shard, slot, false);
+        }
+
+        return;
+    }
+
+    shard->stats.bytesIn += (uint64)received;
+    session->inSize += (uint32)received;
+    uint32 offset = 0;
+
+    while (session->inSize - offset >= sizeof(server_message_header_t))
+    {
+        uint32 size = SDL_Swap16LE(((const server_message_header_t *)(session->in + offset))->size);
+
+        if (size < sizeof(server_message_header_t) || size > SERVER_SESSION_IN_SIZE)
+        {
+            CloseServerSession(shard, slot, true);
+            return;
+        }
+
+        if (session->inSize - offset < size)
+        {
+            break;
+        }
+
+        /* Messages aren't aligned in the stream, handle a copy. */
+        alignas(8) uint8 message[SERVER_SESSION_IN_SIZE];
+        SDL_memcpy(message, session->in + offset, size);
+
+        if (!HandleServerMessage(shard, session, message, size))
+        {
+            CloseServerSession(shard, slot, true);
+            return;
+        }
+
+        offset += size;
+    }
+
+    session->inSize -= offset;
+    SDL_memmove(session->in, session->in + offset, session->inSize);
+
+    if (session->outSize)
+    {
+        FlushServerSession(shard, slot);
+    }
+}
+
+/**
+ * @brief One tick of one game, queues a delta if the piece or the board changed.
+ * @return False if the client is too far behind to take the delta.
+ */
+static bool StepServerSession(server_shard_t *shard, server_session_t *session)
+{
+    if (!session->playing)
+    {
+        return true;
+    }
+
+    level_t *level = &session->level;
+    level_events_t events;
+    ApplyLevelInput(level, SERVER_TICK_MS, &session->input);
+    DoLevelStep(level, SERVER_TICK_MS, &events);
+    FlushInput(&session->input);
+
+    const player_t *player = &level->player;
+    bool locked = (events.flags & LEVEL_EVENT_PIECE_LOCKED) != 0;
+    bool moved = !session->sentPiece || session->sentX != player->position.x || session->sentY != player->position.y ||
+                 session->sentKind != player->data.kind || session->sentRotation != player->data.rotation;
+
+    if (!locked && !moved && !level->gameOver)
+    {
+        return true;
+    }
+
+    server_delta_t delta;
+    uint32 cellCount = locked ? events.lockedCellCount : 0;
+    uint32 size = (uint32)SERVER_DELTA_HEADER_SIZE + cellCount * sizeof(uint16);
+    InitServerMessageHeader(&delta.header, size, SERVER_MESSAGE_DELTA);
+    delta.tick = SDL_Swap32LE((uint32)shard->tick);
+    delta.worldHash = SDL_Swap64LE(level->world.hash);
+    delta.score = SDL_Swap32LE(level->score);
+    delta.playerX = (int8)player->position.x;
+    delta.playerY = (int8)player->position.y;
+    delta.kind = player->data.kind;
+    delta.rotation = player->data.rotation;
+    delta.flags = (locked ? SERVER_DELTA_LOCKED : 0) | (level->gameOver ? SERVER_DELTA_GAME_OVER : 0);
+    delta.lockedValue = events.lockedValue;
+    delta.lockedCellCount = (uint8)cellCount;
+    delta.reserved = 0;
+    delta.clearedRowsMask = SDL_Swap32LE(locked ? events.clearedRowsMask : 0);
+
+    for (uint32 i = 0; i < cellCount; ++i)
+    {
+        delta.lockedCells[i] = SDL_Swap16LE(events.lockedCells[i]);
+    }
+
+    session->sentPiece = true;
+    session->sentX = (int8)player->position.x;
+    session->sentY = (int8)player->position.y;
+    session->sentKind = player->data.kind;
+    session->sentRotation = player->data.rotation;
+    /* The game over delta is the last one, a new hello starts the next game. */
+    session->playing = !level->gameOver;
+    shard->stats.deltas++;
+    return QueueServerMessage(session, &delta, size);
+}
+
+static void RunServerTick(server_shard_t *shard)
+{
+    shard->tick++;
+
+    /* Backwards, closing swaps the last session into the slot just visited. */
+    for (uint32 i = shard->activeCount; i-- > 0;)
+    {
+        uint32 slot = shard->active[i];
+
+        if (!StepServerSession(shard, &shard->sessions[slot]))
+        {
+            CloseServerSession(shard, slot, true);
+        }
+    }
+
+    for (uint32 i = shard->activeCount; i-- > 0;)
+    {
+        uint32 slot = shard->active[i];
+
+        if (shard->sessions[slot].outSize)
+        {
+            FlushServerSession(shard, slot);
+        }
+    }
+
+    shard->stats.ticks++;
+}
+
+/**
+ * @brief Runs every tick that came due, a shard that fell far behind skips ahead instead of bursting.
+ */
+static void HandleServerTimer(server_shard_t *shard)
+{
+    uint64 expirations;
+
+    if (read(shard->timerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    {
+        return;
+    }
+
+    uint64 now = GetServerClockNs();
+    uint64 periodNs = SERVER_TICK_MS * SDL_NS_PER_MS;
+    uint64 dueTick = (now - shard->startNs) / periodNs;
+
+    if (dueTick <= shard->tick)
+    {
+        return;
+    }
+
+    uint64 jitterNs = now - (shard->startNs + (shard->tick + 1) * periodNs);
+    server_shard_stats_t *stats = &shard->stats;
+    stats->jitterHistogram[SDL_min(jitterNs / SERVER_JITTER_BUCKET_NS, (uint64)SERVER_JITTER_BUCKET_COUNT - 1)]++;
+    stats->maxJitterNs = SDL_max(stats->maxJitterNs, jitterNs);
+    uint64 dueCount = dueTick - shard->tick;
+
+    if (dueCount > 1)
+    {
+        stats->lateTicks++;
+    }
+
+    if (dueCount > SERVER_MAX_CATCHUP_TICKS)
+    {
+        stats->skippedTicks += dueCount - SERVER_MAX_CATCHUP_TICKS;
+        shard->tick = dueTick - SERVER_MAX_CATCHUP_TICKS;
+    }
+
+    while (shard->tick < dueTick)
+    {
+        RunServerTick(shard);
+    }
+
+    uint64 workNs = GetServerClockNs() - now;
+    stats->tickWorkNs += workNs;
+    stats->maxTickWorkNs = SDL_max(stats->maxTickWorkNs, workNs);
+
+    if (shard->tick % SERVER_PUBLISH_TICKS < dueCount)
+    {
+        SDL_LockMutex(shard->publishMutex);
+        shard->published = shard->stats;
+        SDL_UnlockMutex(shard->publishMutex);
+    }
+}
+
+/**
+ * @brief Keeps the shard on one of the cores the process may use, so its sessions stay in that core's caches.
+ */
+static void PinServerShard(server_shard_t *shard)
+{
+    cpu_set_t allowed;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || !CPU_COUNT(&allowed))
+    {
+        return;
+    }
+
+    int32 target = (int32)(shard->index % (uint32)CPU_COUNT(&allowed));
+
+    for (int32 cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &allowed) && target-- == 0)
+        {
+            cpu_set_t pinned;
+            CPU_ZERO(&pinned);
+            CPU_SET(cpu, &pinned);
+            sched_setaffinity(0, sizeof(pinned), &pinned);
+            return;
+        }
+    }
+}
+
+static int SDLCALL RunServerShard(void *data)
+{
+    server_shard_t *shard = (server_shard_t *)data;
+    server_t *server = shard->server;
+    PinServerShard(shard);
+    epoll_event events[SERVER_EPOLL_EVENTS];
+
+    /* The timer wakes the loop every tick, so quit is seen within one. */
+    while (!SDL_GetAtomicInt(&server->quit))
+    {
+        int count = epoll_wait(shard->epollFd, events, SERVER_EPOLL_EVENTS, -1);
+
+        for (int i = 0; i < count; ++i)
+        {
+            uint64 tag = events[i].data.u64;
+
+            if (tag == SERVER_EPOLL_TIMER)
+            {
+                HandleServerTimer(shard);
+                PollServerListeners(shard);
+                continue;
+            }
+
+            if (tag & SERVER_EPOLL_LISTENER)
+            {
+                if (shard->listening)
+                {
+                    AcceptServerSessions(shard, (int)(uint32)tag);
+                }
+
+                continue;
+            }
+
+            uint32 slot = (uint32)tag;
+            server_session_t *session = &shard->sessions[slot];
+
+            /* Closed earlier in this batch, maybe reused since. */
+            if (session->fd < 0 || (session->generation & SERVER_EPOLL_GENERATION_MASK) != (uint32)(tag >> 32))
+            {
+                continue;
+            }
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+            {
+                CloseServerSession(shard, slot, false);
+                continue;
+            }
+
+            if ((events[i].events & EPOLLOUT) && !FlushServerSession(shard, slot))
+            {
+                continue;
+            }
+
+            if (events[i].events & EPOLLIN)
+            {
+                ReadServerSession(shard, slot);
+            }
+        }
+    }
+
+    while (shard->activeCount)
+    {
+        CloseServerSession(shard, shard->active[shard->activeCount - 1], false);
+    }
+
+    SDL_LockMutex(shard->publishMutex);
+    shard->published = shard->stats;
+    SDL_UnlockMutex(shard->publishMutex);
+    return 0;
+}
+
+static int OpenServerListener(const server_config_t *config, bool unixSocket)
+{
+    int fd = socket(unixSocket ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        SDL_SetError("Couldn't create socket: %s", strerror(errno));
+        return -1;
+    }
+
+    int bound;
+
+    if (unixSocket)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        SDL_strlcpy(address.sun_path, config->unixPath, sizeof(address.sun_path));
+        /* A socket file left by an earlier run would make bind fail. */
+        unlink(config->unixPath);
+        bound = bind(fd, (sockaddr *)&address, sizeof(address));
+    }
+    else
+    {
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(config->port);
+        bound = bind(fd, (sockaddr *)&address, sizeof(address));
+    }
+
+    if (bound != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        SDL_SetError("Couldn't listen on %s: %s", unixSocket ? config->unixPath : "the TCP port", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool InitServerShard(server_t *server, server_shard_t *shard, uint32 index)
+{
+    uint32 capacity = server->config.sessionsPerShard;
+    shard->server = server;
+    shard->index = index;
+    shard->sessions = PushArray(&server->arena, capacity, server_session_t);
+    shard->freeSlots = PushArray(&server->arena, capacity, uint32);
+    shard->active = PushArray(&server->arena, capacity, uint32);
+    shard->activeIndex = PushArray(&server->arena, capacity, uint32);
+
+    if (!shard->sessions || !shard->freeSlots || !shard->active || !shard->activeIndex)
+    {
+        return SDL_SetError("Server memory is too small for %u sessions per shard", capacity);
+    }
+
+    /* Low slots first, a lightly loaded shard keeps its sessions close together. */
+    for (uint32 slot = 0; slot < capacity; ++slot)
+    {
+        shard->sessions[slot].fd = -1;
+        shard->freeSlots[slot] = capacity - 1 - slot;
+    }
+
+    shard->freeCount = capacity;
+    shard->publishMutex = SDL_CreateMutex();
+    shard->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    shard->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (!shard->publishMutex || shard->epollFd < 0 || shard->timerFd < 0)
+    {
+        return SDL_SetError("Couldn't create shard %u: %s", index, strerror(errno));
+    }
+
+    /* Absolute times, so ticks stay on the schedule however late one was handled. */
+    uint64 periodNs = SERVER_TICK_MS * SDL_NS_PER_MS;
+    shard->startNs = GetServerClockNs();
+    itimerspec timer{};
+    timer.it_interval.tv_nsec = (long)periodNs;
+    timer.it_value.tv_sec = (time_t)((shard->startNs + periodNs) / SDL_NS_PER_SECOND);
+    timer.it_value.tv_nsec = (long)((shard->startNs + periodNs) % SDL_NS_PER_SECOND);
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = SERVER_EPOLL_TIMER;
+
+    if (timerfd_settime(shard->timerFd, TFD_TIMER_ABSTIME, &timer, nullptr) != 0 ||
+        epoll_ctl(shard->epollFd, EPOLL_CTL_ADD, shard->timerFd, &event) != 0)
+    {
+        return SDL_SetError("Couldn't start the tick timer of shard %u: %s", index, strerror(errno));
+    }
+
+    SetServerListening(shard, true);
+    shard->thread = SDL_CreateThread(RunServerShard, "server shard", shard);
+    return shard->thread != nullptr;
+}
+
+bool StartServer(server_t *server, const server_config_t *config, void *memory)
+{
+    SDL_zerop(server);
+    server->config = *config;
+    server->tcpFd = -1;
+    server->unixFd = -1;
+    InitArena(&server->arena, memory, GetServerMemorySize(config));
+
+    if (!config->shardCount || !config->sessionsPerShard)
+    {
+        return SDL_SetError("The server needs at least one shard and one session per shard");
+    }
+
+    server->tcpFd = OpenServerListener(config, false);
+    server->unixFd = config->unixPath[0] ? OpenServerListener(config, true) : -1;
+    server->shards = PushArray(&server->arena, config->shardCount, server_shard_t);
+    bool success = server->tcpFd >= 0 && (!config->unixPath[0] || server->unixFd >= 0) && server->shards;
+
+    /* The memory is zeroed, shards a failed start never reaches must not look like they own descriptor 0. */
+    for (uint32 i = 0; server->shards && i < config->shardCount; ++i)
+    {
+        server->shards[i].epollFd = -1;
+        server->shards[i].timerFd = -1;
+    }
+
+    for (uint32 i = 0; success && i < config->shardCount; ++i)
+    {
+        success = InitServerShard(server, &server->shards[i], i);
+    }
+
+    if (!success)
+    {
+        StopServer(server);
+    }
+
+    return success;
+}
+
+void StopServer(server_t *server)
+{
+    SDL_SetAtomicInt(&server->quit, 1);
+
+    for (uint32 i = 0; server->shards && i < server->config.shardCount; ++i)
+    {
+        server_shard_t *shard = &server->shards[i];
+
+        if (shard->thread)
+        {
+            SDL_WaitThread(shard->thread, nullptr);
+            shard->thread = nullptr;
+        }
+
+        if (shard->epollFd >= 0)
+        {
+            close(shard->epollFd);
+        }
+
+        if (shard->timerFd >= 0)
+        {
+            close(shard->timerFd);
+        }
+
+        /* Nothing publishes any more, the last stats stay readable without the lock. */
+        SDL_DestroyMutex(shard->publishMutex);
+        shard->publishMutex = nullptr;
+        shard->epollFd = -1;
+        shard->timerFd = -1;
+    }
+
+    if (server->tcpFd >= 0)
+    {
+        close(server->tcpFd);
+    }
+
+    if (server->unixFd >= 0)
+    {
+        close(server->unixFd);
+        unlink(server->config.unixPath);
+    }
+
+    server->tcpFd = -1;
+    server->unixFd = -1;
+}
+
+#else
+
+bool StartServer(server_t *server, const server_config_t *config, void *memory)
+{
+    SDL_zerop(server);
+    server->config = *config;
+    return SDL_SetError("The game server needs epoll, it only runs on Linux");
+}
+
+void StopServer(server_t *server)
+{
+}
+
+#endif
@@ -0,0 +1,306 @@
+#if !defined(TETRIS_SERVER_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+#include "tetris_arena.h"
+#include "tetris_level.h"
+#include "tetris_input.h"
+
+#define SERVER_DEFAULT_PORT 7400
+#define SERVER_DEFAULT_SESSIONS_PER_SHARD 1024
+#define SERVER_TICK_MS 16
+/**
+ * @brief Ticks a late shard simulates to catch up, anything older is skipped and counted.
+ */
+#define SERVER_MAX_CATCHUP_TICKS 4
+#define SERVER_EPOLL_EVENTS 256
+/**
+ * @brief Connections a shard accepts per wakeup, and how far past an even share of the sessions it may go.
+ */
+#define SERVER_ACCEPT_BATCH 4
+/**
+ * @brief Unparsed client bytes kept per session, more than a few messages means a broken client.
+ */
+#define SERVER_SESSION_IN_SIZE 256
+/**
+ * @brief Unsent deltas kept per session, a client that falls this far behind is dropped.
+ */
+#define SERVER_SESSION_OUT_SIZE Kilobytes(4)
+/**
+ * @brief Tick start jitter histogram: 20 us buckets up to about 10 ms, the last bucket takes everything later.
+ */
+#define SERVER_JITTER_BUCKET_NS 20000
+#define SERVER_JITTER_BUCKET_COUNT 512
+#define SERVER_UNIX_PATH_SIZE 108
+
+/**
+ * @brief Message types of the stream protocol, every message starts with a server_message_header_t.
+ * @note All fields are little-endian.
+ */
+enum eServerMessage
+{
+    /**
+     * @brief Client: starts a game, or restarts it, with server_hello_t.
+     */
+    SERVER_MESSAGE_HELLO = 1,
+    /**
+     * @brief Client: a packed game_input_t, merged with the others received during the tick.
+     */
+    SERVER_MESSAGE_INPUT,
+    /**
+     * @brief Client: asks for the shard's server_stats_message_t.
+     */
+    SERVER_MESSAGE_STATS_REQUEST,
+    /**
+     * @brief Server: answers a hello, the client's mirror starts from an empty world.
+     */
+    SERVER_MESSAGE_WELCOME,
+    /**
+     * @brief Server: what one tick changed, sent only on ticks that changed something.
+     */
+    SERVER_MESSAGE_DELTA,
+    SERVER_MESSAGE_STATS,
+};
+
+enum eServerDeltaFlags
+{
+    SERVER_DELTA_LOCKED = 1 << 0,
+    SERVER_DELTA_GAME_OVER = 1 << 1,
+};
+
+struct server_message_header_t
+{
+    /**
+     * @brief Whole message, header included.
+     */
+    uint16 size;
+    uint8 type;
+    uint8 reserved;
+};
+
+struct server_hello_t
+{
+    server_message_header_t header;
+    uint8 randomizerMode;
+    uint8 reserved[3];
+    uint64 seed;
+};
+
+struct server_input_t
+{
+    server_message_header_t header;
+    uint16 input;
+    uint8 reserved[2];
+};
+
+struct server_welcome_t
+{
+    server_message_header_t header;
+    uint32 sessionId;
+    uint16 shard;
+    uint16 shardCount;
+    uint8 worldWidth;
+    uint8 worldHeight;
+    uint16 tickMs;
+};
+
+/**
+ * @brief The active piece as it is after the tick, and the cells a lock wrote.
+ * @note A client mirrors the board by writing lockedCells with lockedValue, then removing clearedRowsMask
+ * like RemoveWorldRows, worldHash is the Zobrist hash it should end up with. Only lockedCellCount cells are sent.
+ */
+struct server_delta_t
+{
+    server_message_header_t header;
+    uint32 tick;
+    uint64 worldHash;
+    uint32 score;
+    int8 playerX;
+    int8 playerY;
+    uint8 kind;
+    uint8 rotation;
+    uint8 flags;
+    uint8 lockedValue;
+    uint8 lockedCellCount;
+    uint8 reserved;
+    uint32 clearedRowsMask;
+    uint16 lockedCells[LEVEL_MAX_LOCKED_CELLS];
+};
+
+#define SERVER_DELTA_HEADER_SIZE offsetof(server_delta_t, lockedCells)
+
+struct server_stats_message_t
+{
+    server_message_header_t header;
+    uint16 shard;
+    uint16 shardCount;
+    uint32 sessions;
+    uint32 peakSessions;
+    uint64 ticks;
+    uint64 lateTicks;
+    uint64 skippedTicks;
+    uint64 meanTickWorkNs;
+    uint64 maxTickWorkNs;
+    uint64 jitterP50Ns;
+    uint64 jitterP99Ns;
+    uint64 jitterMaxNs;
+    uint64 deltas;
+    uint64 bytesOut;
+};
+
+/**
+ * @brief One client's game.
+ * @note Lives in its shard's pool and is only touched by the shard's thread.
+ */
+struct server_session_t
+{
+    int fd;
+    /**
+     * @brief Bumped when the slot is freed, epoll events carry it so a stale one is ignored.
+     */
+    uint32 generation;
+    uint32 id;
+    bool playing;
+    bool writeArmed;
+
+    level_t level;
+    game_input_t input;
+
+    bool sentPiece;
+    int8 sentX;
+    int8 sentY;
+    uint8 sentKind;
+    uint8 sentRotation;
+
+    uint32 inSize;
+    uint8 in[SERVER_SESSION_IN_SIZE];
+    uint32 outSize;
+    uint8 out[SERVER_SESSION_OUT_SIZE];
+};
+
+struct server_shard_stats_t
+{
+    uint32 sessions;
+    uint32 peakSessions;
+    uint64 accepted;
+    uint64 closed;
+    /**
+     * @brief Sessions closed because their client stopped reading or sent garbage.
+     */
+    uint64 dropped;
+
+    uint64 ticks;
+    /**
+     * @brief Timer wake-ups that found more than one tick due.
+     */
+    uint64 lateTicks;
+    uint64 skippedTicks;
+    /**
+     * @brief Simulating, encoding and writing one tick for all of the shard's sessions.
+     */
+    uint64 tickWorkNs;
+    uint64 maxTickWorkNs;
+    /**
+     * @brief From a tick's scheduled time to its simulation starting.
+     */
+    uint64 jitterHistogram[SERVER_JITTER_BUCKET_COUNT];
+    uint64 maxJitterNs;
+
+    uint64 deltas;
+    uint64 bytesIn;
+    uint64 bytesOut;
+};
+
+struct server_t;
+
+/**
+ * @brief One core's event loop: its own epoll, tick timer and session pool.
+ */
+struct server_shard_t
+{
+    server_t *server;
+    uint32 index;
+    SDL_Thread *thread;
+    int epollFd;
+    int timerFd;
+    bool listening;
+
+    server_session_t *sessions;
+    uint32 *freeSlots;
+    uint32 freeCount;
+    /**
+     * @brief Slots in use, in no particular order, a closed one is swapped with the last.
+     */
+    uint32 *active;
+    uint32 *activeIndex;
+    uint32 activeCount;
+    uint32 nextSessionId;
+
+    uint64 startNs;
+    uint64 tick;
+    server_shard_stats_t stats;
+
+    /**
+     * @brief A copy of stats the shard refreshes about once a second for the main thread.
+     */
+    SDL_Mutex *publishMutex;
+    server_shard_stats_t published;
+};
+
+struct server_config_t
+{
+    uint32 shardCount;
+    uint32 sessionsPerShard;
+    uint16 port;
+    /**
+     * @brief Also listens on this Unix socket path when not empty.
+     */
+    char unixPath[SERVER_UNIX_PATH_SIZE];
+};
+
+/**
+ * @brief Sessions are sharded across one event loop per core, each with a fixed tick.
+ * @note Both listeners are in every shard's epoll with EPOLLEXCLUSIVE, so one idle shard takes each
+ * connection and a full one steps out until a slot frees. All memory comes from arena up front.
+ * Linux only, StartServer() fails elsewhere.
+ */
+struct server_t
+{
+    server_config_t config;
+    arena_t arena;
+    int tcpFd;
+    int unixFd;
+    SDL_AtomicInt quit;
+    /**
+     * @brief Open sessions over all shards, a shard stops accepting once it is a batch past its share.
+     */
+    SDL_AtomicInt sessions;
+    server_shard_t *shards;
+};
+
+/**
+ * @return Bytes StartServer needs for config's shards and sessions.
+ */
+uint64 GetServerMemorySize(const server_config_t *config);
+
+/**
+ * @param memory GetServerMemorySize(config) bytes, owned by the caller.
+ */
+bool StartServer(server_t *server, const server_config_t *config, void *memory);
+
+void StopServer(server_t *server);
+
+/**
+ * @brief Adds up the shards' published stats, perShard gets config.shardCount entries if not nullptr.
+ */
+void GetServerStats(server_t *server, server_shard_stats_t *total, server_shard_stats_t *perShard);
+
+/**
+ * @return Tick start jitter at percent of the ticks, in ns.
+ */
+uint64 GetServerJitterNs(const server_shard_stats_t *stats, uint32 percent);
+
+void LogServerStats(server_t *server);
+
+#define TETRIS_SERVER_H
+#endif
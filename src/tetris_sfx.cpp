@@ -0,0 +1,201 @@
+#include "tetris_sfx.h"
+
+#define SFX_FRAME_SIZE (SFX_CHANNELS * sizeof(float))
+
+static const SDL_AudioSpec kSfxSpec = {SFX_FORMAT, SFX_CHANNELS, SFX_FREQUENCY};
+
+bool InitSfxSound(sfx_t *sfx, eSfxSound sound, const Mix_Chunk *chunk)
+{
+    SDL_AudioSpec chunkSpec;
+
+    if (!chunk || !Mix_QuerySpec(&chunkSpec.freq, &chunkSpec.format, &chunkSpec.channels))
+    {
+        return SDL_SetError("No decoded chunk for sound %d", sound);
+    }
+
+    uint8 *data = nullptr;
+    int size = 0;
+
+    if (!SDL_ConvertAudioSamples(&chunkSpec, chunk->abuf, (int)chunk->alen, &kSfxSpec, &data, &size))
+    {
+        return false;
+    }
+
+    sfx->sounds[sound].samples = (float *)data;
+    sfx->sounds[sound].frameCount = (uint32)size / SFX_FRAME_SIZE;
+    return true;
+}
+
+static void SDLCALL FillSfxStream(void *userdata, SDL_AudioStream *stream, int additionalAmount, int totalAmount)
+{
+    sfx_t *sfx = (sfx_t *)userdata;
+    int32 frames = additionalAmount / (int32)SFX_FRAME_SIZE;
+    sfx->stats.callbacks++;
+
+    /* Nothing is queued while no sound plays, the device mixes silence for this stream. */
+    while (frames > 0)
+    {
+        uint32 count = (uint32)SDL_min(frames, SFX_MIX_FRAMES);
+
+        if (!MixSfx(sfx, sfx->mixBuffer, count))
+        {
+            break;
+        }
+
+        SDL_PutAudioStreamData(stream, sfx->mixBuffer, (int)(count * SFX_FRAME_SIZE));
+        frames -= (int32)count;
+    }
+}
+
+bool OpenSfx(sfx_t *sfx, SDL_AudioDeviceID device)
+{
+    sfx->stream = SDL_CreateAudioStream(&kSfxSpec, &kSfxSpec);
+
+    if (!sfx->stream)
+    {
+        return false;
+    }
+
+    SDL_AudioSpec deviceSpec;
+
+    if (!SDL_SetAudioStreamGetCallback(sfx->stream, FillSfxStream, sfx) || !SDL_BindAudioStream(device, sfx->stream) ||
+        !SDL_GetAudioDeviceFormat(device, &deviceSpec, &sfx->stats.deviceFrames))
+    {
+        SDL_DestroyAudioStream(sfx->stream);
+        sfx->stream = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void CloseSfx(sfx_t *sfx)
+{
+    /* Destroying the stream unbinds it, the callback can't run after this. */
+    SDL_DestroyAudioStream(sfx->stream);
+    sfx->stream = nullptr;
+
+    for (int i = 0; i < SFX_SOUND_COUNT; ++i)
+    {
+        SDL_free(sfx->sounds[i].samples);
+        sfx->sounds[i].samples = nullptr;
+        sfx->sounds[i].frameCount = 0;
+    }
+}
+
+void PlaySfx(sfx_t *sfx, eSfxSound sound)
+{
+    uint32 write = sfx->queueWrite.load(std::memory_order_relaxed);
+    uint32 read = sfx->queueRead.load(std::memory_order_acquire);
+    sfx->stats.triggers++;
+
+    if (write - read == SFX_QUEUE_SIZE)
+    {
+        sfx->stats.dropped++;
+        return;
+    }
+
+    sfx->queue[write & (SFX_QUEUE_SIZE - 1)] = {(uint32)sound, SDL_GetTicksNS()};
+    sfx->queueWrite.store(write + 1, std::memory_order_release);
+}
+
+static void StartSfxVoices(sfx_t *sfx)
+{
+    uint64 now = SDL_GetTicksNS();
+    uint32 read = sfx->queueRead.load(std::memory_order_relaxed);
+    uint32 write = sfx->queueWrite.load(std::memory_order_acquire);
+
+    for (; read != write; ++read)
+    {
+        const sfx_trigger_t *trigger = &sfx->queue[read & (SFX_QUEUE_SIZE - 1)];
+
+        if (!sfx->sounds[trigger->sound].frameCount)
+        {
+            continue;
+        }
+
+        uint64 pickupNs = now - trigger->triggerNs;
+        sfx->stats.pickupNsSum += pickupNs;
+        sfx->stats.pickupNsMax = SDL_max(sfx->stats.pickupNsMax, pickupNs);
+        sfx->stats.started++;
+
+        uint32 slot = sfx->voiceCount;
+
+        if (slot == SFX_MAX_VOICES)
+        {
+            /* Steal the voice that has played the longest. */
+            slot = 0;
+
+            for (uint32 i = 1; i < sfx->voiceCount; ++i)
+            {
+                slot = sfx->voices[i].position > sfx->voices[slot].position ? i : slot;
+            }
+
+            sfx->stats.stolen++;
+        }
+        else
+        {
+            sfx->voiceCount++;
+        }
+
+        sfx->voices[slot] = {trigger->sound, 0};
+    }
+
+    sfx->queueRead.store(read, std::memory_order_release);
+}
+
+bool MixSfx(sfx_t *sfx, float *out, uint32 frameCount)
+{
+    StartSfxVoices(sfx);
+
+    if (!sfx->voiceCount)
+    {
+        return false;
+    }
+
+    SDL_memset(out, 0, frameCount * SFX_FRAME_SIZE);
+
+    for (uint32 i = 0; i < sfx->voiceCount;)
+    {
+        sfx_voice_t *voice = &sfx->voices[i];
+        const sfx_sound_t *sound = &sfx->sounds[voice->sound];
+        uint32 count = SDL_min(sound->frameCount - voice->position, frameCount);
+        const float *samples = sound->samples + voice->position * SFX_CHANNELS;
+
+        for (uint32 sample = 0; sample < count * SFX_CHANNELS; ++sample)
+        {
+            out[sample] += samples[sample];
+        }
+
+        voice->position += count;
+
+        if (voice->position == sound->frameCount)
+        {
+            *voice = sfx->voices[--sfx->voiceCount];
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    for (uint32 sample = 0; sample < frameCount * SFX_CHANNELS; ++sample)
+    {
+        out[sample] = SDL_clamp(out[sample], -1.0f, 1.0f);
+    }
+
+    return true;
+}
+
+void LogSfxStats(const sfx_t *sfx)
+{
+    const sfx_stats_t *stats = &sfx->stats;
+    real64 pickupMs = stats->started ? (real64)stats->pickupNsSum / stats->started / 1e6 : 0.0;
+    real64 deviceMs = stats->deviceFrames * 1000.0 / SFX_FREQUENCY;
+
+    SDL_Log("sfx: %llu triggers, %llu dropped, %llu voices stolen, %llu callbacks",
+            (unsigned long long)stats->triggers, (unsigned long long)stats->dropped, (unsigned long long)stats->stolen,
+            (unsigned long long)stats->callbacks);
+    SDL_Log("sfx latency: event to mix %.2f ms average, %.2f ms worst, + %d frame device buffer %.2f ms = ~%.2f ms to audible",
+            pickupMs, stats->pickupNsMax / 1e6, stats->deviceFrames, deviceMs, pickupMs + deviceMs);
+}
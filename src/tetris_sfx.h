@@ -0,0 +1,122 @@
+#if !defined(TETRIS_SFX_H)
+
+#include <atomic>
+#include <SDL3/SDL.h>
+#include <SDL3_mixer/SDL_mixer.h>
+#include "tetris_typedefs.h"
+
+/**
+ * @brief Device format opened in SDL_AppInit, sounds are converted to it once at load.
+ */
+#define SFX_FORMAT SDL_AUDIO_F32
+#define SFX_CHANNELS 2
+#define SFX_FREQUENCY 44100
+/**
+ * @brief Requested device buffer, 5.8 ms at 44.1 kHz.
+ */
+#define SFX_DEVICE_SAMPLE_FRAMES 256
+#define SFX_MIX_FRAMES 256
+#define SFX_MAX_VOICES 16
+/**
+ * @note Must be a power of two.
+ */
+#define SFX_QUEUE_SIZE 64
+
+enum eSfxSound
+{
+    SFX_SOUND_PLACE = 0,
+    SFX_SOUND_GAME_OVER,
+    SFX_SOUND_COUNT,
+};
+
+/**
+ * @brief Interleaved SFX_CHANNELS float frames at SFX_FREQUENCY.
+ */
+struct sfx_sound_t
+{
+    float *samples;
+    uint32 frameCount;
+};
+
+struct sfx_trigger_t
+{
+    uint32 sound;
+    uint64 triggerNs;
+};
+
+struct sfx_voice_t
+{
+    uint32 sound;
+    uint32 position;
+};
+
+/**
+ * @note triggers and dropped are counted by the game thread, the rest by the audio thread.
+ * Read them once the stream is destroyed.
+ */
+struct sfx_stats_t
+{
+    uint64 triggers;
+    uint64 dropped;
+    uint64 started;
+    uint64 stolen;
+    uint64 callbacks;
+    uint64 pickupNsSum;
+    uint64 pickupNsMax;
+    /**
+     * @brief Sample frames the device buffers after the stream, part of the audible latency.
+     */
+    int32 deviceFrames;
+};
+
+/**
+ * @brief Sound effects mixed on the audio thread into one SDL_AudioStream bound to the game's device.
+ * @note The game thread only pushes triggers into a single-producer single-consumer ring,
+ * it never locks, allocates or waits on the audio thread.
+ */
+struct sfx_t
+{
+    SDL_AudioStream *stream;
+    sfx_sound_t sounds[SFX_SOUND_COUNT];
+
+    sfx_trigger_t queue[SFX_QUEUE_SIZE];
+    std::atomic<uint32> queueWrite;
+    std::atomic<uint32> queueRead;
+
+    /* Audio thread only. */
+    sfx_voice_t voices[SFX_MAX_VOICES];
+    uint32 voiceCount;
+    float mixBuffer[SFX_MIX_FRAMES * SFX_CHANNELS];
+    sfx_stats_t stats;
+};
+
+/**
+ * @brief Converts a chunk decoded by the mixer to the sfx format.
+ */
+bool InitSfxSound(sfx_t *sfx, eSfxSound sound, const Mix_Chunk *chunk);
+
+/**
+ * @brief Creates the stream and binds it to device, sounds can be added before or after.
+ */
+bool OpenSfx(sfx_t *sfx, SDL_AudioDeviceID device);
+
+/**
+ * @brief Destroys the stream and frees the sounds.
+ */
+void CloseSfx(sfx_t *sfx);
+
+/**
+ * @brief Game thread: queues a sound, dropped if the audio thread is SFX_QUEUE_SIZE triggers behind.
+ */
+void PlaySfx(sfx_t *sfx, eSfxSound sound);
+
+/**
+ * @brief Audio thread: starts queued sounds and mixes frameCount frames of all voices into out.
+ * @return False if nothing is playing, out is left untouched then.
+ */
+bool MixSfx(sfx_t *sfx, float *out, uint32 frameCount);
+
+void LogSfxStats(const sfx_t *sfx);
+
+#define TETRIS_SFX_H
+#endif
@@ -0,0 +1,105 @@
+#include <type_traits>
+#include "tetris_versus.h"
+
+static_assert(std::is_trivially_copyable<versus_t>::value, "versus_t is saved and restored every tick");
+
+bool InitVersus(versus_t *versus, uint64 seed, ePieceRandomizerMode mode)
+{
+    SDL_zerop(versus);
+
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+    {
+        level_t *level = &versus->levels[i];
+        ResetLevel(level);
+
+        if (!InitWorld(&level->world) || !InitPlayer(&level->player))
+        {
+            return false;
+        }
+
+        InitPieceQueue(&level->pieceQueue, seed, mode);
+        SpawnLevelPlayer(level);
+        level->currentStepMs = level->stepMs;
+    }
+
+    SeedRandom(&versus->garbageRandom, seed ^ 0x6A7BA6Eull);
+    return true;
+}
+
+inline void CopyVersus(versus_t *dst, const versus_t *src)
+{
+    SDL_memcpy(dst, src, sizeof(versus_t));
+}
+
+bool IsVersusOver(const versus_t *versus)
+{
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+    {
+        if (versus->levels[i].gameOver)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void StepVersus(versus_t *versus, const uint16 inputs[VERSUS_PLAYER_COUNT], level_events_t *events)
+{
+    level_events_t localEvents[VERSUS_PLAYER_COUNT];
+    events = events ? events : localEvents;
+
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+    {
+        events[i].flags = 0;
+    }
+
+    if (IsVersusOver(versus))
+    {
+        return;
+    }
+
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+    {
+        level_t *level = &versus->levels[i];
+        game_input_t input{};
+        UnpackGameInput(inputs[i], &input);
+        ApplyLevelInput(level, VERSUS_TICK_MS, &input);
+        DoLevelStep(level, VERSUS_TICK_MS, &events[i]);
+    }
+
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+    {
+        int32 garbageRows = CountSetBits32(events[i].clearedRowsMask) - 1;
+
+        if ((events[i].flags & LEVEL_EVENT_ROWS_CLEARED) && garbageRows > 0)
+        {
+            level_t *target = &versus->levels[(i + 1) % VERSUS_PLAYER_COUNT];
+            AddLevelGarbage(target, garbageRows, NextRandomBelow(&versus->garbageRandom, target->world.size.x));
+        }
+    }
+
+    versus->tick++;
+}
+
+static inline uint64 MixVersusChecksum(uint64 checksum, uint64 value)
+{
+    checksum ^= value + 0x9E3779B97F4A7C15ull + (checksum << 6) + (checksum >> 2);
+    return checksum;
+}
+
+uint64 GetVersusChecksum(const versus_t *versus)
+{
+    uint64 checksum = MixVersusChecksum(versus->tick, versus->garbageRandom.state);
+
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; ++i)
+    {
+        level_t *level = (level_t *)&versus->levels[i];
+        checksum = MixVersusChecksum(checksum, HashPosition(&level->world, &level->player, &level->pieceQueue));
+        checksum = MixVersusChecksum(checksum, level->pieceQueue.random.state);
+        checksum = MixVersusChecksum(checksum, ((uint64)level->score << 32) | (uint32)level->stepMs);
+        checksum = MixVersusChecksum(checksum, (level->stepAccumulator << 2) | (level->gameOver << 1) | level->paused);
+    }
+
+    return checksum;
+}
@@ -0,0 +1,45 @@
+#if !defined(TETRIS_VERSUS_H)
+
+#include "tetris_typedefs.h"
+#include "tetris_level.h"
+
+#define VERSUS_PLAYER_COUNT 2
+/**
+ * @brief Versus mode runs on a fixed tick so both peers simulate exactly the same steps.
+ */
+#define VERSUS_TICK_MS 16
+
+/**
+ * @brief Both games of a versus match, stepped together from one packed input per player.
+ * @note Trivially copyable like level_t, saving and restoring it is a memcpy.
+ */
+struct versus_t
+{
+    level_t levels[VERSUS_PLAYER_COUNT];
+    random_t garbageRandom;
+    uint32 tick;
+};
+
+/**
+ * @note Both players get the same piece sequence.
+ */
+bool InitVersus(versus_t *versus, uint64 seed, ePieceRandomizerMode mode);
+
+void CopyVersus(versus_t *dst, const versus_t *src);
+
+bool IsVersusOver(const versus_t *versus);
+
+/**
+ * @brief One tick of both games, clearing two or more rows sends all but one of them as garbage.
+ * @param events Optional, one per player.
+ */
+void StepVersus(versus_t *versus, const uint16 inputs[VERSUS_PLAYER_COUNT], level_events_t *events);
+
+/**
+ * @brief Cheap digest of everything that decides the future of the match.
+ * @note Built on the incremental Zobrist hashes, so it costs a few hundred nanoseconds per tick.
+ */
+uint64 GetVersusChecksum(const versus_t *versus);
+
+#define TETRIS_VERSUS_H
+#endif
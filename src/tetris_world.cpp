@@ -1,11 +1,49 @@
 #include "tetris_world.h"
+#include "tetris_hash.h"
+
+static_assert(WORLD_MAX_HEIGHT <= 32, "row masks are uint32");
 
 bool InitWorld(world_t *world)
 {
-    world->size = {16, 24};
-    world->data = (uint8 *)SDL_calloc(world->size.x * world->size.y, sizeof(uint8));
+    SetWorldSize(world, {16, 24});
     world->itemRenderSize = {40.0f, 40.0f};
-    return world->data != 0;
+    ResetWorld(world);
+    return true;
+}
+
+void SetWorldSize(world_t *world, vec2i_t size)
+{
+    SDL_assert(size.x > 0 && size.x <= WORLD_MAX_WIDTH && size.y > 0 && size.y <= WORLD_MAX_HEIGHT);
+    world->size = size;
+    world->shape = GetWorldShapeForSize(size);
+}
+
+eWorldShape GetWorldShapeForSize(vec2i_t size)
+{
+    if (size.x == 10 && size.y == 20)
+    {
+        return WORLD_SHAPE_10X20;
+    }
+
+    if (size.x == 16 && size.y == 24)
+    {
+        return WORLD_SHAPE_16X24;
+    }
+
+    return WORLD_SHAPE_GENERIC;
+}
+
+const char *GetWorldShapeName(eWorldShape shape)
+{
+    switch (shape)
+    {
+    case WORLD_SHAPE_10X20:
+        return "10x20";
+    case WORLD_SHAPE_16X24:
+        return "16x24";
+    default:
+        return "generic";
+    }
 }
 
 /**
@@ -51,7 +89,14 @@ inline void SetWorldValueUnchecked(world_t *world, vec2i_t position, uint8 value
 {
     if (position.y >= 0)
     {
-        world->data[position.y * world->size.x + position.x] = value;
+        uint8 *cell = &world->data[position.y * world->size.x + position.x];
+
+        if (IsValueEmpty(*cell) != IsValueEmpty(value))
+        {
+            world->hash ^= GetCellHashKey(position);
+        }
+
+        *cell = value;
     }
 }
 
@@ -68,30 +113,166 @@ inline bool IsValueEmpty(uint8 value)
     return value == 0;
 }
 
-bool IsWorldRowFilled(world_t *world, uint8 row)
+/**
+ * @note Tests 8 cells at a time for a zero byte, the last read may overlap the one before.
+ */
+template <int32 W>
+static inline bool IsRowFilledOfWidth(const uint8 *row)
 {
-    for (int x = 0; x < world->size.x; ++x)
+    static_assert(W >= 8, "rows are read 8 cells at a time");
+    uint64 emptyBytes = 0;
+
+    for (int32 x = 0; x < W; x += 8)
     {
-        if (IsValueEmpty(GetWorldValue(world, {x, row})))
+        uint64 cells;
+        SDL_memcpy(&cells, row + (x + 8 <= W ? x : W - 8), sizeof(cells));
+        emptyBytes |= (cells - 0x0101010101010101ull) & ~cells & 0x8080808080808080ull;
+    }
+
+    return !emptyBytes;
+}
+
+template <int32 W, int32 H>
+static uint32 GetFilledRowsMaskOfShape(world_t *world)
+{
+    uint32 rowsMask = 0;
+
+    if constexpr (W > 0)
+    {
+        for (int32 y = 0; y < H; ++y)
         {
-            return false;
+            rowsMask |= (uint32)IsRowFilledOfWidth<W>(world->data + y * W) << y;
         }
     }
+    else
+    {
+        const world_kernels_t *kernels = GetActiveWorldKernels();
 
-    return true;
+        for (int32 y = 0; y < world->size.y; ++y)
+        {
+            if (kernels->isRowFilled(GetWorldRow(world, y), world->size.x))
+            {
+                rowsMask |= 1u << y;
+            }
+        }
+    }
+
+    return rowsMask;
 }
 
-void ResetWorld(world_t *world)
+template <int32 W, int32 H>
+static void RemoveWorldRowsOfShape(world_t *world, uint32 rowsMask)
 {
-    for (int y = 0; y < world->size.y; ++y)
+    const world_kernels_t *kernels = GetActiveWorldKernels();
+    const int32 width = GetShapeWidth<W, H>(world);
+    int32 dstRow = GetShapeHeight<W, H>(world) - 1;
+
+    for (int32 srcRow = dstRow; srcRow >= 0; --srcRow)
     {
-        for (int x = 0; x < world->size.x; ++x)
+        if (rowsMask & (1u << srcRow))
         {
-            SetWorldValueUnchecked(world, {x, y}, 0);
+            continue;
+        }
+
+        if (dstRow != srcRow)
+        {
+            world->hash ^= GetRowCopyHashDeltaOfWidth<W>(world, dstRow, srcRow);
+
+            if constexpr (W > 0)
+            {
+                SDL_memcpy(world->data + dstRow * W, world->data + srcRow * W, W);
+            }
+            else
+            {
+                kernels->copyRow(GetWorldRow(world, dstRow), GetWorldRow(world, srcRow), width);
+            }
         }
+
+        dstRow--;
+    }
+
+    for (; dstRow >= 0; --dstRow)
+    {
+        world->hash ^= GetRowClearHashDeltaOfWidth<W>(world, dstRow);
+
+        if constexpr (W > 0)
+        {
+            SDL_memset(world->data + dstRow * W, 0, W);
+        }
+        else
+        {
+            kernels->clearCells(GetWorldRow(world, dstRow), width);
+        }
+    }
+}
+
+template <int32 W, int32 H>
+static bool IsWorldRowFilledOfShape(world_t *world, int32 row)
+{
+    if constexpr (W > 0)
+    {
+        return IsRowFilledOfWidth<W>(world->data + row * W);
+    }
+    else
+    {
+        return GetActiveWorldKernels()->isRowFilled(GetWorldRow(world, row), world->size.x);
+    }
+}
+
+bool IsWorldRowFilled(world_t *world, uint8 row)
+{
+    SDL_assert(row < world->size.y);
+    return WORLD_SHAPE_CALL(world, IsWorldRowFilledOfShape, world, row);
+}
+
+inline uint8 *GetWorldRow(world_t *world, int32 row)
+{
+    return world->data + row * world->size.x;
+}
+
+uint32 GetFilledRowsMask(world_t *world)
+{
+    return WORLD_SHAPE_CALL(world, GetFilledRowsMaskOfShape, world);
+}
+
+void RemoveWorldRows(world_t *world, uint32 rowsMask)
+{
+    if (rowsMask)
+    {
+        WORLD_SHAPE_CALL(world, RemoveWorldRowsOfShape, world, rowsMask);
     }
 }
 
+bool AddWorldGarbageRows(world_t *world, int32 count, uint8 value, int32 holeX)
+{
+    const world_kernels_t *kernels = GetActiveWorldKernels();
+    uint16 indices[WORLD_MAX_CELL_COUNT];
+    count = SDL_min(count, world->size.y);
+    bool overflow = kernels->compactCells(world->data, count * world->size.x, indices) > 0;
+
+    for (int32 y = 0; y < world->size.y - count; ++y)
+    {
+        world->hash ^= GetRowCopyHashDelta(world, y, y + count);
+        kernels->copyRow(GetWorldRow(world, y), GetWorldRow(world, y + count), world->size.x);
+    }
+
+    for (int32 y = world->size.y - count; y < world->size.y; ++y)
+    {
+        for (int32 x = 0; x < world->size.x; ++x)
+        {
+            SetWorldValueUnchecked(world, {x, y}, x == holeX ? 0 : value);
+        }
+    }
+
+    return overflow;
+}
+
+void ResetWorld(world_t *world)
+{
+    GetActiveWorldKernels()->clearCells(world->data, world->size.x * world->size.y);
+    world->hash = 0;
+}
+
 void RenderWorldItem(SDL_Renderer *renderer, app_assets_t *assets, world_t *world,
                      uint8 value, vec2i_t position, vec2_t offset)
 {
@@ -112,18 +293,28 @@ void RenderWorldItem(SDL_Renderer *renderer, app_assets_t *assets, world_t *worl
             world->itemRenderSize.h};
 
         SDL_RenderTexture(renderer, blockTexture, &blockTextureSrcRect, &rect);
+        assets->renderCalls++;
     }
 }
 
-void RenderWorld(SDL_Renderer *renderer, app_assets_t *assets, world_t *world, vec2_t offset)
+/**
+ * @note The SIMD kernels already scan the cells fastest, the compiled width turns the index split into multiplies.
+ */
+template <int32 W, int32 H>
+static void RenderWorldOfShape(SDL_Renderer *renderer, app_assets_t *assets, world_t *world, vec2_t offset)
 {
-    for (int itemY = 0; itemY < world->size.y; ++itemY)
+    const int32 width = GetShapeWidth<W, H>(world);
+    uint16 indices[WORLD_MAX_CELL_COUNT];
+    int32 count = GetActiveWorldKernels()->compactCells(world->data, width * GetShapeHeight<W, H>(world), indices);
+
+    for (int32 i = 0; i < count; ++i)
     {
-        for (int itemX = 0; itemX < world->size.x; ++itemX)
-        {
-            uint8 value = world->data[itemY * world->size.x + itemX];
-            vec2i_t position{itemX, itemY};
-            RenderWorldItem(renderer, assets, world, value, position, offset);
-        }
+        vec2i_t position{indices[i] % width, indices[i] / width};
+        RenderWorldItem(renderer, assets, world, world->data[indices[i]], position, offset);
     }
+}
+
+void RenderWorld(SDL_Renderer *renderer, app_assets_t *assets, world_t *world, vec2_t offset)
+{
+    WORLD_SHAPE_CALL(world, RenderWorldOfShape, renderer, assets, world, offset);
 }
\ No newline at end of file
@@ -3,22 +3,104 @@
 #include "tetris_typedefs.h"
 #include "tetris_math.h"
 #include "tetris_assets.h"
+#include "tetris_world_kernels.h"
+
+#define WORLD_MAX_WIDTH 32
+#define WORLD_MAX_HEIGHT 32
+#define WORLD_MAX_CELL_COUNT (WORLD_MAX_WIDTH * WORLD_MAX_HEIGHT)
+
+/**
+ * @brief Board sizes the engine loops are compiled for, picked from the size by SetWorldSize().
+ * @note WORLD_SHAPE_GENERIC reads world_t::size at runtime and works for any size.
+ */
+enum eWorldShape
+{
+    WORLD_SHAPE_GENERIC = 0,
+    WORLD_SHAPE_10X20,
+    WORLD_SHAPE_16X24,
+    WORLD_SHAPE_COUNT,
+};
 
 struct world_t
 {
     vec2_t itemRenderSize;
 
     vec2i_t size;
+    /**
+     * @brief eWorldShape matching size, zeroed memory runs the generic loops.
+     */
+    uint32 shape;
+    /**
+     * @brief Zobrist hash of occupied cells, kept up to date by every write.
+     */
+    uint64 hash;
     /**
      * @brief The world data.
-     * @note The data is stored in a row-major order.
+     * @note The data is stored in a row-major order with size.x stride.
      * If Y is negative, the value must be 0 without checking data.
+     * Stored inline so a world can be copied and relocated as a plain block.
      */
-    uint8 *data;
+    uint8 data[WORLD_MAX_CELL_COUNT];
 };
 
+/**
+ * @brief Calls function<W, H>(...) compiled for the world's shape, function<0, 0> is the generic one.
+ */
+#define WORLD_SHAPE_CALL(world, function, ...)                            \
+    ((world)->shape == WORLD_SHAPE_16X24   ? function<16, 24>(__VA_ARGS__) \
+     : (world)->shape == WORLD_SHAPE_10X20 ? function<10, 20>(__VA_ARGS__) \
+                                           : function<0, 0>(__VA_ARGS__))
+
+/**
+ * @return W, or world->size.x when W is 0.
+ */
+template <int32 W, int32 H>
+inline int32 GetShapeWidth(const world_t *world)
+{
+    return W ? W : world->size.x;
+}
+
+template <int32 W, int32 H>
+inline int32 GetShapeHeight(const world_t *world)
+{
+    return H ? H : world->size.y;
+}
+
+/**
+ * @return Bit x set when cell x of the row is occupied, for a compiled width of at least 8 cells.
+ * @note Reads 8 cells at a time, the last read may overlap the one before.
+ */
+template <int32 W>
+inline uint32 GetRowOccupancyOfWidth(const uint8 *row)
+{
+    static_assert(W >= 8 && W <= 32, "rows are read 8 cells at a time into a uint32");
+    uint32 occupancy = 0;
+
+    for (int32 x = 0; x < W; x += 8)
+    {
+        int32 offset = x + 8 <= W ? x : W - 8;
+        uint64 cells;
+        SDL_memcpy(&cells, row + offset, sizeof(cells));
+        /* Top bit of each occupied byte, then gathered into the top byte in cell order. */
+        uint64 occupied = (((cells & 0x7F7F7F7F7F7F7F7Full) + 0x7F7F7F7F7F7F7F7Full) | cells) & 0x8080808080808080ull;
+        occupancy |= (uint32)(((occupied >> 7) * 0x0102040810204080ull) >> 56) << offset;
+    }
+
+    return occupancy;
+}
+
 bool InitWorld(world_t *world);
 
+/**
+ * @brief Sets the size and the loops compiled for it, if any.
+ * @note Doesn't touch the cells, call ResetWorld() for a new board.
+ */
+void SetWorldSize(world_t *world, vec2i_t size);
+
+eWorldShape GetWorldShapeForSize(vec2i_t size);
+
+const char *GetWorldShapeName(eWorldShape shape);
+
 /**
  * @note Negative Y valid and always empty.
  */
@@ -39,6 +121,24 @@ bool IsValueEmpty(uint8 value);
 
 bool IsWorldRowFilled(world_t *world, uint8 row);
 
+uint8 *GetWorldRow(world_t *world, int32 row);
+
+/**
+ * @brief Bit y is set when row y is filled.
+ */
+uint32 GetFilledRowsMask(world_t *world);
+
+/**
+ * @brief Removes the rows set in rowsMask and shifts the rows above down in one bottom-up pass.
+ */
+void RemoveWorldRows(world_t *world, uint32 rowsMask);
+
+/**
+ * @brief Shifts the world up by count rows and fills the bottom ones with value, except holeX.
+ * @return True if occupied cells were pushed out of the top.
+ */
+bool AddWorldGarbageRows(world_t *world, int32 count, uint8 value, int32 holeX);
+
 void ResetWorld(world_t *world);
 
 void RenderWorldItem(SDL_Renderer *renderer, app_assets_t *assets, world_t *world,
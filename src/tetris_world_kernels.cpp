@@ -0,0 +1,354 @@
+#include <SDL3/SDL_intrin.h>
+#include "tetris_world_kernels.h"
+#include "tetris_math.h"
+
+static bool IsRowFilledScalar(const uint8 *row, int32 width)
+{
+    for (int32 x = 0; x < width; ++x)
+    {
+        if (!row[x])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void CopyRowScalar(uint8 *dst, const uint8 *src, int32 width)
+{
+    for (int32 x = 0; x < width; ++x)
+    {
+        dst[x] = src[x];
+    }
+}
+
+static void ClearCellsScalar(uint8 *cells, int32 count)
+{
+    for (int32 i = 0; i < count; ++i)
+    {
+        cells[i] = 0;
+    }
+}
+
+static int32 CompactCellsScalar(const uint8 *cells, int32 count, uint16 *indices)
+{
+    int32 result = 0;
+
+    for (int32 i = 0; i < count; ++i)
+    {
+        if (cells[i])
+        {
+            indices[result++] = (uint16)i;
+        }
+    }
+
+    return result;
+}
+
+static const world_kernels_t kWorldKernelsScalar = {
+    "scalar",
+    IsRowFilledScalar,
+    CopyRowScalar,
+    ClearCellsScalar,
+    CompactCellsScalar};
+
+#if defined(SDL_SSE2_INTRINSICS)
+static bool IsRowFilledSSE2(const uint8 *row, int32 width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int32 x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i cells = _mm_loadu_si128((const __m128i *)(row + x));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(cells, zero)))
+        {
+            return false;
+        }
+    }
+
+    return IsRowFilledScalar(row + x, width - x);
+}
+
+static void CopyRowSSE2(uint8 *dst, const uint8 *src, int32 width)
+{
+    int32 x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_loadu_si128((const __m128i *)(src + x)));
+    }
+
+    CopyRowScalar(dst + x, src + x, width - x);
+}
+
+static void ClearCellsSSE2(uint8 *cells, int32 count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int32 i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        _mm_storeu_si128((__m128i *)(cells + i), zero);
+    }
+
+    ClearCellsScalar(cells + i, count - i);
+}
+
+static int32 CompactCellsSSE2(const uint8 *cells, int32 count, uint16 *indices)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int32 result = 0;
+    int32 i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(cells + i));
+        uint32 mask = ~(uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero)) & 0xFFFF;
+
+        while (mask)
+        {
+            indices[result++] = (uint16)(i + CountTrailingZeros32(mask));
+            mask &= mask - 1;
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        if (cells[i])
+        {
+            indices[result++] = (uint16)i;
+        }
+    }
+
+    return result;
+}
+
+static const world_kernels_t kWorldKernelsSSE2 = {
+    "sse2",
+    IsRowFilledSSE2,
+    CopyRowSSE2,
+    ClearCellsSSE2,
+    CompactCellsSSE2};
+#endif
+
+#if defined(SDL_AVX2_INTRINSICS)
+static bool SDL_TARGETING("avx2") IsRowFilledAVX2(const uint8 *row, int32 width)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int32 x = 0;
+
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i cells = _mm256_loadu_si256((const __m256i *)(row + x));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(cells, zero)))
+        {
+            return false;
+        }
+    }
+
+    return IsRowFilledSSE2(row + x, width - x);
+}
+
+static void SDL_TARGETING("avx2") CopyRowAVX2(uint8 *dst, const uint8 *src, int32 width)
+{
+    int32 x = 0;
+
+    for (; x + 32 <= width; x += 32)
+    {
+        _mm256_storeu_si256((__m256i *)(dst + x), _mm256_loadu_si256((const __m256i *)(src + x)));
+    }
+
+    CopyRowSSE2(dst + x, src + x, width - x);
+}
+
+static void SDL_TARGETING("avx2") ClearCellsAVX2(uint8 *cells, int32 count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int32 i = 0;
+
+    for (; i + 32 <= count; i += 32)
+    {
+        _mm256_storeu_si256((__m256i *)(cells + i), zero);
+    }
+
+    ClearCellsSSE2(cells + i, count - i);
+}
+
+static int32 SDL_TARGETING("avx2") CompactCellsAVX2(const uint8 *cells, int32 count, uint16 *indices)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int32 result = 0;
+    int32 i = 0;
+
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(cells + i));
+        uint32 mask = ~(uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, zero));
+
+        while (mask)
+        {
+            indices[result++] = (uint16)(i + CountTrailingZeros32(mask));
+            mask &= mask - 1;
+        }
+    }
+
+    int32 tailCount = CompactCellsSSE2(cells + i, count - i, indices + result);
+
+    for (int32 t = result; t < result + tailCount; ++t)
+    {
+        indices[t] += (uint16)i;
+    }
+
+    return result + tailCount;
+}
+
+static const world_kernels_t kWorldKernelsAVX2 = {
+    "avx2",
+    IsRowFilledAVX2,
+    CopyRowAVX2,
+    ClearCellsAVX2,
+    CompactCellsAVX2};
+#endif
+
+#if defined(SDL_NEON_INTRINSICS)
+static inline bool HasAnyLaneNEON(uint8x16_t v)
+{
+    uint64x2_t lanes = vreinterpretq_u64_u8(v);
+    return (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) != 0;
+}
+
+static bool IsRowFilledNEON(const uint8 *row, int32 width)
+{
+    int32 x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        uint8x16_t cells = vld1q_u8(row + x);
+
+        if (HasAnyLaneNEON(vceqq_u8(cells, vdupq_n_u8(0))))
+        {
+            return false;
+        }
+    }
+
+    return IsRowFilledScalar(row + x, width - x);
+}
+
+static void CopyRowNEON(uint8 *dst, const uint8 *src, int32 width)
+{
+    int32 x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        vst1q_u8(dst + x, vld1q_u8(src + x));
+    }
+
+    CopyRowScalar(dst + x, src + x, width - x);
+}
+
+static void ClearCellsNEON(uint8 *cells, int32 count)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    int32 i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        vst1q_u8(cells + i, zero);
+    }
+
+    ClearCellsScalar(cells + i, count - i);
+}
+
+/**
+ * @note NEON has no movemask, so empty chunks are skipped wholesale
+ * and the rest are scanned bytewise.
+ */
+static int32 CompactCellsNEON(const uint8 *cells, int32 count, uint16 *indices)
+{
+    int32 result = 0;
+    int32 i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        if (HasAnyLaneNEON(vld1q_u8(cells + i)))
+        {
+            for (int32 j = i; j < i + 16; ++j)
+            {
+                if (cells[j])
+                {
+                    indices[result++] = (uint16)j;
+                }
+            }
+        }
+    }
+
+    for (; i < count; ++i)
+    {
+        if (cells[i])
+        {
+            indices[result++] = (uint16)i;
+        }
+    }
+
+    return result;
+}
+
+static const world_kernels_t kWorldKernelsNEON = {
+    "neon",
+    IsRowFilledNEON,
+    CopyRowNEON,
+    ClearCellsNEON,
+    CompactCellsNEON};
+#endif
+
+static const world_kernels_t *activeWorldKernels = &kWorldKernelsScalar;
+
+const world_kernels_t *GetWorldKernels(eWorldKernelsKind kind)
+{
+    switch (kind)
+    {
+    case WORLD_KERNELS_SCALAR:
+        return &kWorldKernelsScalar;
+#if defined(SDL_SSE2_INTRINSICS)
+    case WORLD_KERNELS_SSE2:
+        return SDL_HasSSE2() ? &kWorldKernelsSSE2 : nullptr;
+#endif
+#if defined(SDL_AVX2_INTRINSICS)
+    case WORLD_KERNELS_AVX2:
+        return SDL_HasAVX2() ? &kWorldKernelsAVX2 : nullptr;
+#endif
+#if defined(SDL_NEON_INTRINSICS)
+    case WORLD_KERNELS_NEON:
+        return SDL_HasNEON() ? &kWorldKernelsNEON : nullptr;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const world_kernels_t *InitWorldKernels()
+{
+    activeWorldKernels = &kWorldKernelsScalar;
+
+    for (int kind = WORLD_KERNELS_COUNT - 1; kind > WORLD_KERNELS_SCALAR; --kind)
+    {
+        const world_kernels_t *kernels = GetWorldKernels((eWorldKernelsKind)kind);
+
+        if (kernels)
+        {
+            activeWorldKernels = kernels;
+            break;
+        }
+    }
+
+    return activeWorldKernels;
+}
+
+inline const world_kernels_t *GetActiveWorldKernels()
+{
+    return activeWorldKernels;
+}
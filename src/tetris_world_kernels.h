@@ -0,0 +1,53 @@
+#if !defined(TETRIS_WORLD_KERNELS_H)
+
+#include <SDL3/SDL.h>
+#include "tetris_typedefs.h"
+
+/**
+ * @brief Kernels over the byte-per-cell world plane.
+ * @note Every implementation must produce identical results, only speed differs.
+ * The best one for the running CPU is picked once by InitWorldKernels().
+ */
+struct world_kernels_t
+{
+    const char *name;
+
+    /**
+     * @return True when none of the width cells is empty.
+     */
+    bool (*isRowFilled)(const uint8 *row, int32 width);
+
+    /**
+     * @note Rows must not overlap.
+     */
+    void (*copyRow)(uint8 *dst, const uint8 *src, int32 width);
+
+    void (*clearCells)(uint8 *cells, int32 count);
+
+    /**
+     * @brief Writes indices of non-empty cells into indices.
+     * @return Number of written indices.
+     */
+    int32 (*compactCells)(const uint8 *cells, int32 count, uint16 *indices);
+};
+
+enum eWorldKernelsKind
+{
+    WORLD_KERNELS_SCALAR = 0,
+    WORLD_KERNELS_SSE2,
+    WORLD_KERNELS_AVX2,
+    WORLD_KERNELS_NEON,
+    WORLD_KERNELS_COUNT,
+};
+
+/**
+ * @note Returns nullptr if the kind is not compiled in or not supported by the CPU.
+ */
+const world_kernels_t *GetWorldKernels(eWorldKernelsKind kind);
+
+const world_kernels_t *InitWorldKernels();
+
+const world_kernels_t *GetActiveWorldKernels();
+
+#define TETRIS_WORLD_KERNELS_H
+#endif
@@ -0,0 +1,362 @@
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <SDL3_mixer/SDL_mixer.h>
+
+#include "../tetris_typedefs.h"
+#include "../tetris_math.h"
+#include "../tetris_arena.cpp"
+#include "../tetris_world_kernels.cpp"
+#include "../tetris_world.cpp"
+#include "../tetris_random.cpp"
+#include "../tetris_piece_set.cpp"
+#include "../tetris_player.cpp"
+#include "../tetris_hash.cpp"
+#include "../tetris_input.cpp"
+#include "../tetris_assets.cpp"
+#include "../tetris_level.cpp"
+#include "../tetris_replay.cpp"
+#include "../tetris_bot.cpp"
+#include "../tetris_jobs.cpp"
+#include "../tetris_selfplay.cpp"
+#include "../tetris_dataset.cpp"
+
+/**
+ * @brief Sessions converted per RunJobs, their samples are held until written in input order.
+ */
+#define DATASET_EXPORT_BATCH_JOBS 64
+
+/**
+ * @brief Recorded human games first, then generated bot games, one job each.
+ */
+struct dataset_export_t
+{
+    char **replayPaths;
+    uint32 replayCount;
+    uint64 botSeed;
+    uint32 firstJob;
+    dataset_capture_t *captures;
+    level_t *levels;
+    /**
+     * @brief Replays that didn't load, the job's capture stays empty.
+     */
+    std::atomic<uint32> failedReplays;
+};
+
+static void CaptureDatasetReplay(dataset_export_t *exporter, const char *path, level_t *level,
+                                 dataset_capture_t *capture)
+{
+    replay_t replay;
+
+    if (!LoadReplay(&replay, path) || !StartReplayLevel(&replay, level))
+    {
+        SDL_Log("Skipping %s: %s", path, SDL_GetError());
+        exporter->failedReplays++;
+        return;
+    }
+
+    BeginDatasetPiece(capture, level);
+
+    for (uint32 i = 0; i < replay.frameCount && !capture->failed; ++i)
+    {
+        const replay_frame_t *frame = &replay.frames[i];
+
+        /* A reset only clears the level flags, the next game starts from the board the last one left. */
+        if (frame->commands & REPLAY_COMMAND_RESET)
+        {
+            EndDatasetGame(capture, DATASET_OUTCOME_CUT);
+        }
+
+        ApplyReplayCommands(level, frame->commands);
+
+        if (frame->commands & REPLAY_COMMAND_RESET)
+        {
+            BeginDatasetPiece(capture, level);
+        }
+
+        level_events_t events;
+        StepReplayFrame(level, frame, &events);
+        CaptureDatasetLock(capture, level, &events);
+    }
+
+    EndDatasetGame(capture, DATASET_OUTCOME_CUT);
+    FreeReplay(&replay);
+}
+
+/**
+ * @brief The self-play game: bot moves with a random one mixed in, cut at SELFPLAY_MAX_LOCKS_PER_GAME.
+ */
+static void CaptureDatasetBotGame(uint64 seed, level_t *level, dataset_capture_t *capture)
+{
+    SDL_zerop(level);
+    ResetLevel(level);
+
+    if (!InitWorld(&level->world) || !InitPlayer(&level->player))
+    {
+        capture->failed = true;
+        return;
+    }
+
+    random_t random;
+    SeedRandom(&random, seed);
+    InitPieceQueue(&level->pieceQueue, seed, PIECE_RANDOMIZER_BAG);
+    SpawnLevelPlayer(level);
+    BeginDatasetPiece(capture, level);
+
+    for (uint32 lock = 0; lock < SELFPLAY_MAX_LOCKS_PER_GAME && !level->gameOver && !capture->failed; ++lock)
+    {
+        level_events_t events;
+        PlaySelfPlayPiece(level, &random, &events);
+        CaptureDatasetLock(capture, level, &events);
+    }
+
+    EndDatasetGame(capture, DATASET_OUTCOME_CUT);
+}
+
+/**
+ * @brief Job: converts one session into its own capture.
+ */
+static void CaptureDatasetJob(void *data, uint32 index, uint32 thread)
+{
+    dataset_export_t *exporter = (dataset_export_t *)data;
+    uint32 job = exporter->firstJob + index;
+    dataset_capture_t *capture = &exporter->captures[index];
+    level_t *level = &exporter->levels[thread];
+
+    if (job < exporter->replayCount)
+    {
+        InitDatasetCapture(capture, DATASET_SOURCE_HUMAN);
+        CaptureDatasetReplay(exporter, exporter->replayPaths[job], level, capture);
+    }
+    else
+    {
+        InitDatasetCapture(capture, DATASET_SOURCE_BOT);
+        CaptureDatasetBotGame(exporter->botSeed + (job - exporter->replayCount), level, capture);
+    }
+}
+
+static int RunDatasetExport(const char *outPath, char **replayPaths, uint32 replayCount, uint32 botGames,
+                            uint64 seed, uint32 threadCount)
+{
+    dataset_export_t exporter;
+    exporter.replayPaths = replayPaths;
+    exporter.replayCount = replayCount;
+    exporter.botSeed = seed;
+    exporter.failedReplays = 0;
+    exporter.captures = (dataset_capture_t *)SDL_calloc(DATASET_EXPORT_BATCH_JOBS, sizeof(dataset_capture_t));
+    exporter.levels = (level_t *)SDL_calloc(JOB_MAX_THREADS, sizeof(level_t));
+    job_pool_t *jobs = (job_pool_t *)SDL_calloc(1, sizeof(job_pool_t));
+    world_t world;
+    dataset_writer_t writer;
+
+    if (!exporter.captures || !exporter.levels || !jobs || !InitJobPool(jobs, threadCount) || !InitWorld(&world) ||
+        !OpenDatasetWriter(&writer, outPath, world.size))
+    {
+        SDL_Log("Couldn't start the export: %s", SDL_GetError());
+        return 1;
+    }
+
+    uint32 jobCount = replayCount + botGames;
+    uint32 games = 0;
+    uint32 dropped = 0;
+    bool success = true;
+    uint64 start = SDL_GetTicksNS();
+    uint64 writeNs = 0;
+
+    for (uint32 first = 0; first < jobCount && success; first += DATASET_EXPORT_BATCH_JOBS)
+    {
+        uint32 count = SDL_min(jobCount - first, (uint32)DATASET_EXPORT_BATCH_JOBS);
+        exporter.firstJob = first;
+        RunJobs(jobs, CaptureDatasetJob, &exporter, count);
+        uint64 written = SDL_GetTicksNS();
+
+        /* Written in input order, so a file doesn't depend on the thread count. */
+        for (uint32 i = 0; i < count; ++i)
+        {
+            dataset_capture_t *capture = &exporter.captures[i];
+
+            if (capture->failed)
+            {
+                SDL_Log("Ran out of memory capturing session %u", first + i);
+                success = false;
+            }
+
+            for (uint32 s = 0; s < capture->sampleCount && success; ++s)
+            {
+                capture->samples[s].game += games;
+                success = AppendDatasetSample(&writer, &capture->samples[s]);
+            }
+
+            games += capture->games;
+            dropped += capture->dropped;
+            FreeDatasetCapture(capture);
+        }
+
+        writeNs += SDL_GetTicksNS() - written;
+    }
+
+    uint64 written = SDL_GetTicksNS();
+    success = CloseDatasetWriter(&writer) && success;
+    writeNs += SDL_GetTicksNS() - written;
+    real64 seconds = SDL_max((real64)(SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND, 1e-9);
+
+    if (!success)
+    {
+        SDL_Log("Couldn't write %s: %s", outPath, SDL_GetError());
+    }
+
+    SDL_Log("%s: %llu samples from %u games (%u replays, %u failed, %u bot games), %u locks dropped, %.1f MB",
+            outPath, (unsigned long long)writer.samples, games, replayCount, exporter.failedReplays.load(), botGames,
+            dropped, writer.bytes / 1048576.0);
+    SDL_Log("%.0f samples/s on %u threads, %.1f%% of the time writing", writer.samples / seconds, threadCount,
+            100.0 * writeNs / SDL_NS_PER_SECOND / seconds);
+
+    FreeJobPool(jobs);
+    SDL_free(jobs);
+    SDL_free(exporter.levels);
+    SDL_free(exporter.captures);
+    return success ? 0 : 1;
+}
+
+static int RunDatasetRead(const char *path)
+{
+    dataset_reader_t reader;
+
+    if (!OpenDatasetReader(&reader, path))
+    {
+        SDL_Log("Couldn't open %s: %s", path, SDL_GetError());
+        return 1;
+    }
+
+    uint32 boardWords = reader.header.boardWords;
+    uint64 batches = 0;
+    uint64 filledCells = 0;
+    uint64 rows = 0;
+    uint64 toppedOut = 0;
+    uint64 bySource[2] = {};
+    uint32 games = 0;
+    uint64 start = SDL_GetTicksNS();
+    dataset_batch_t batch;
+
+    /* Touches every column, so the rate is what a training loop reading the same fields would see. */
+    while (NextDatasetBatch(&reader, &batch))
+    {
+        batches++;
+
+        for (uint64 i = 0; i < (uint64)batch.count * boardWords; ++i)
+        {
+            filledCells += CountSetBits32((uint32)batch.boards[i]) + CountSetBits32((uint32)(batch.boards[i] >> 32));
+        }
+
+        for (uint32 i = 0; i < batch.count; ++i)
+        {
+            rows += batch.rowsCleared[i];
+            toppedOut += batch.outcomes[i] == DATASET_OUTCOME_TOPPED_OUT;
+            bySource[batch.sources[i] ? 1 : 0]++;
+            games = SDL_max(games, batch.games[i] + 1);
+        }
+    }
+
+    real64 seconds = SDL_max((real64)(SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND, 1e-9);
+    uint64 samples = SDL_max(reader.samples, 1ull);
+    SDL_Log("%s: %llu samples (%llu human, %llu bot) in %llu batches from %u games, %s", path,
+            (unsigned long long)reader.samples, (unsigned long long)bySource[0], (unsigned long long)bySource[1],
+            (unsigned long long)batches, games, reader.loaded ? "loaded" : "mapped");
+    SDL_Log("%.1f filled cells per board, %.3f rows per lock, %.1f%% from games that topped out",
+            (real64)filledCells / samples, (real64)rows / samples, 100.0 * toppedOut / samples);
+    SDL_Log("%.0f samples/s, %.1f MB/s", reader.samples / seconds, reader.size / 1048576.0 / seconds);
+
+    bool corrupt = reader.corrupt;
+
+    if (corrupt)
+    {
+        SDL_Log("Stopped early: %s", SDL_GetError());
+    }
+
+    CloseDatasetReader(&reader);
+    return corrupt ? 1 : 0;
+}
+
+static void LogDatasetUsage()
+{
+    SDL_Log("Usage: tetris_dataset export --out path [--threads n] [--bot games] [--seed n] [replays...]");
+    SDL_Log("       tetris_dataset read path");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        LogDatasetUsage();
+        return 1;
+    }
+
+    if (!SDL_Init(0))
+    {
+        SDL_Log("Couldn't init sdl: %s", SDL_GetError());
+        return 1;
+    }
+
+    InitWorldKernels();
+    int result = 1;
+
+    if (SDL_strcmp(argv[1], "read") == 0 && argc == 3)
+    {
+        result = RunDatasetRead(argv[2]);
+    }
+    else if (SDL_strcmp(argv[1], "export") == 0)
+    {
+        const char *outPath = nullptr;
+        uint32 threadCount = (uint32)SDL_GetNumLogicalCPUCores();
+        uint32 botGames = 0;
+        uint64 seed = 1;
+        char **replayPaths = (char **)SDL_calloc(argc, sizeof(char *));
+        uint32 replayCount = 0;
+        bool usage = !replayPaths;
+
+        for (int i = 2; i < argc && !usage; ++i)
+        {
+            if (SDL_strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            {
+                outPath = argv[++i];
+            }
+            else if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            {
+                threadCount = (uint32)SDL_atoi(argv[++i]);
+            }
+            else if (SDL_strcmp(argv[i], "--bot") == 0 && i + 1 < argc)
+            {
+                botGames = (uint32)SDL_atoi(argv[++i]);
+            }
+            else if (SDL_strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            {
+                seed = SDL_strtoull(argv[++i], nullptr, 10);
+            }
+            else if (argv[i][0] == '-')
+            {
+                usage = true;
+            }
+            else
+            {
+                replayPaths[replayCount++] = argv[i];
+            }
+        }
+
+        if (usage || !outPath || !(replayCount + botGames))
+        {
+            LogDatasetUsage();
+        }
+        else
+        {
+            result = RunDatasetExport(outPath, replayPaths, replayCount, botGames, seed, threadCount);
+        }
+
+        SDL_free(replayPaths);
+    }
+    else
+    {
+        LogDatasetUsage();
+    }
+
+    SDL_Quit();
+    return result;
+}
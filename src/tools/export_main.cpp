@@ -0,0 +1,432 @@
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <SDL3_mixer/SDL_mixer.h>
+
+#include "../tetris_typedefs.h"
+#include "../tetris_math.h"
+#include "../tetris_arena.cpp"
+#include "../tetris_world_kernels.cpp"
+#include "../tetris_world.cpp"
+#include "../tetris_random.cpp"
+#include "../tetris_piece_set.cpp"
+#include "../tetris_player.cpp"
+#include "../tetris_hash.cpp"
+#include "../tetris_fx.h"
+#include "../tetris_input.cpp"
+#include "../tetris_assets.cpp"
+#include "../tetris_level.cpp"
+#include "../tetris_replay.cpp"
+
+#define EXPORT_MAX_THREADS 16
+/**
+ * @brief Frames in flight: one being rendered, the rest queued or being encoded.
+ */
+#define EXPORT_MAX_SLOTS (EXPORT_MAX_THREADS + 2)
+#define EXPORT_SCRIPT_FRAME_MS 16
+/**
+ * @brief Frames kept after a scripted game ends, so the clip shows the game over screen.
+ */
+#define EXPORT_SCRIPT_TAIL_FRAMES 60
+
+enum eExportFormat
+{
+    EXPORT_FORMAT_PNG = 0,
+    EXPORT_FORMAT_BMP,
+    EXPORT_FORMAT_RAW,
+};
+
+/**
+ * @brief An offscreen target with its own software renderer, so a frame can be encoded
+ * while the next ones render into other slots.
+ */
+struct export_slot_t
+{
+    SDL_Surface *surface;
+    SDL_Renderer *renderer;
+    app_assets_t assets;
+    uint32 frameIndex;
+};
+
+struct export_queue_t
+{
+    uint32 slots[EXPORT_MAX_SLOTS];
+    uint32 head;
+    uint32 count;
+};
+
+/**
+ * @brief Slots cycle free -> rendered by the main thread -> ready -> encoded by a worker -> free.
+ * @note Raw output has one worker so frames reach the file in order.
+ */
+struct export_pipeline_t
+{
+    SDL_Mutex *mutex;
+    SDL_Condition *changed;
+    export_queue_t freeSlots;
+    export_queue_t readySlots;
+    bool finished;
+    bool failed;
+
+    eExportFormat format;
+    const char *outPath;
+    SDL_IOStream *rawOutput;
+    uint64 encodeNs;
+
+    export_slot_t slots[EXPORT_MAX_SLOTS];
+    uint32 slotCount;
+};
+
+static void PushExportQueue(export_queue_t *queue, uint32 slot)
+{
+    queue->slots[(queue->head + queue->count++) % EXPORT_MAX_SLOTS] = slot;
+}
+
+static uint32 PopExportQueue(export_queue_t *queue)
+{
+    uint32 slot = queue->slots[queue->head];
+    queue->head = (queue->head + 1) % EXPORT_MAX_SLOTS;
+    queue->count--;
+    return slot;
+}
+
+static bool WriteExportSlot(export_pipeline_t *pipeline, export_slot_t *slot)
+{
+    SDL_Surface *surface = slot->surface;
+    char path[1024];
+
+    switch (pipeline->format)
+    {
+    case EXPORT_FORMAT_PNG:
+        SDL_snprintf(path, sizeof(path), "%s/frame_%06u.png", pipeline->outPath, slot->frameIndex);
+        return IMG_SavePNG(surface, path);
+    case EXPORT_FORMAT_BMP:
+        SDL_snprintf(path, sizeof(path), "%s/frame_%06u.bmp", pipeline->outPath, slot->frameIndex);
+        return SDL_SaveBMP(surface, path);
+    case EXPORT_FORMAT_RAW:
+    {
+        uint64 rowSize = (uint64)surface->w * SDL_BYTESPERPIXEL(surface->format);
+
+        if ((uint64)surface->pitch == rowSize)
+        {
+            return SDL_WriteIO(pipeline->rawOutput, surface->pixels, rowSize * surface->h) == rowSize * surface->h;
+        }
+
+        for (int y = 0; y < surface->h; ++y)
+        {
+            if (SDL_WriteIO(pipeline->rawOutput, (uint8 *)surface->pixels + y * surface->pitch, rowSize) != rowSize)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+    }
+
+    return false;
+}
+
+static int SDLCALL RunExportWorker(void *data)
+{
+    export_pipeline_t *pipeline = (export_pipeline_t *)data;
+
+    for (;;)
+    {
+        SDL_LockMutex(pipeline->mutex);
+
+        while (!pipeline->readySlots.count && !pipeline->finished)
+        {
+            SDL_WaitCondition(pipeline->changed, pipeline->mutex);
+        }
+
+        if (!pipeline->readySlots.count)
+        {
+            SDL_UnlockMutex(pipeline->mutex);
+            return 0;
+        }
+
+        uint32 slotIndex = PopExportQueue(&pipeline->readySlots);
+        SDL_UnlockMutex(pipeline->mutex);
+
+        uint64 start = SDL_GetTicksNS();
+        bool written = WriteExportSlot(pipeline, &pipeline->slots[slotIndex]);
+
+        if (!written)
+        {
+            SDL_Log("Couldn't write frame %u: %s", pipeline->slots[slotIndex].frameIndex, SDL_GetError());
+        }
+
+        SDL_LockMutex(pipeline->mutex);
+        pipeline->encodeNs += SDL_GetTicksNS() - start;
+        pipeline->failed = pipeline->failed || !written;
+        PushExportQueue(&pipeline->freeSlots, slotIndex);
+        SDL_BroadcastCondition(pipeline->changed);
+        SDL_UnlockMutex(pipeline->mutex);
+    }
+}
+
+static bool InitExportPipeline(export_pipeline_t *pipeline, vec2i_t size, uint32 slotCount)
+{
+    pipeline->mutex = SDL_CreateMutex();
+    pipeline->changed = SDL_CreateCondition();
+
+    if (!pipeline->mutex || !pipeline->changed)
+    {
+        return false;
+    }
+
+    for (uint32 i = 0; i < slotCount; ++i)
+    {
+        export_slot_t *slot = &pipeline->slots[i];
+        slot->surface = SDL_CreateSurface(size.w, size.h, SDL_PIXELFORMAT_XRGB8888);
+        slot->renderer = slot->surface ? SDL_CreateSoftwareRenderer(slot->surface) : nullptr;
+
+        if (!slot->renderer || !LoadTextureAssets(slot->renderer, &slot->assets))
+        {
+            return false;
+        }
+
+        pipeline->slotCount++;
+        PushExportQueue(&pipeline->freeSlots, i);
+    }
+
+    return true;
+}
+
+static void FreeExportPipeline(export_pipeline_t *pipeline)
+{
+    for (uint32 i = 0; i < pipeline->slotCount; ++i)
+    {
+        FreeTextureAssets(&pipeline->slots[i].assets);
+        SDL_DestroyRenderer(pipeline->slots[i].renderer);
+        SDL_DestroySurface(pipeline->slots[i].surface);
+    }
+
+    SDL_DestroyCondition(pipeline->changed);
+    SDL_DestroyMutex(pipeline->mutex);
+}
+
+/**
+ * @brief Human-like input for scripted games: buttons flip now and then and are held in between.
+ */
+static void BuildScriptReplay(replay_t *replay, uint64 seed, uint32 frameCount)
+{
+    replay->frames = (replay_frame_t *)SDL_calloc(frameCount, sizeof(replay_frame_t));
+    replay->frameCount = replay->frames ? frameCount : 0;
+    replay->frameCapacity = replay->frameCount;
+    replay->seed = seed;
+    replay->randomizerMode = PIECE_RANDOMIZER_BAG;
+
+    random_t random;
+    SeedRandom(&random, seed * 31 + 7);
+    game_input_t input;
+    SDL_zero(input);
+
+    for (uint32 i = 0; i < replay->frameCount; ++i)
+    {
+        for (int button = 0; button < (int)SDL_arraysize(input.buttons); ++button)
+        {
+            if (NextRandomBelow(&random, 12) == 0)
+            {
+                SetInputButtonDown(&input.buttons[button], !input.buttons[button].isDown);
+            }
+        }
+
+        replay->frames[i] = MakeReplayFrame(EXPORT_SCRIPT_FRAME_MS, &input, 0);
+        FlushInput(&input);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *replayPath = nullptr;
+    const char *outPath = "export";
+    eExportFormat format = EXPORT_FORMAT_PNG;
+    vec2i_t size{1920, 1080};
+    uint32 threadCount = (uint32)SDL_max(SDL_GetNumLogicalCPUCores() - 1, 1);
+    uint32 every = 1;
+    uint64 scriptSeed = 0;
+    uint32 scriptSeconds = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (SDL_strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            ++i;
+            format = SDL_strcmp(argv[i], "raw") == 0   ? EXPORT_FORMAT_RAW
+                     : SDL_strcmp(argv[i], "bmp") == 0 ? EXPORT_FORMAT_BMP
+                                                       : EXPORT_FORMAT_PNG;
+        }
+        else if (SDL_strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            char *end;
+            size.w = (int32)SDL_strtol(argv[++i], &end, 10);
+            size.h = *end == 'x' ? (int32)SDL_strtol(end + 1, nullptr, 10) : 0;
+        }
+        else if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threadCount = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--every") == 0 && i + 1 < argc)
+        {
+            every = (uint32)SDL_max(SDL_atoi(argv[++i]), 1);
+        }
+        else if (SDL_strcmp(argv[i], "--script") == 0 && i + 2 < argc)
+        {
+            scriptSeed = SDL_strtoull(argv[++i], nullptr, 10);
+            scriptSeconds = (uint32)SDL_atoi(argv[++i]);
+        }
+        else
+        {
+            replayPath = argv[i];
+        }
+    }
+
+    if ((!replayPath && !scriptSeconds) || size.w <= 0 || size.h <= 0)
+    {
+        SDL_Log("Usage: tetris_export (<replay.ttrp> | --script <seed> <seconds>) [--out path] [--format png|bmp|raw]"
+                " [--size WxH] [--threads n] [--every n]");
+        return 1;
+    }
+
+    threadCount = format == EXPORT_FORMAT_RAW ? 1 : SDL_clamp(threadCount, 1u, (uint32)EXPORT_MAX_THREADS);
+
+    replay_t replay;
+    SDL_zero(replay);
+
+    if (replayPath && !LoadReplay(&replay, replayPath))
+    {
+        SDL_Log("Couldn't load replay: %s", SDL_GetError());
+        return 1;
+    }
+
+    if (!replayPath)
+    {
+        BuildScriptReplay(&replay, scriptSeed, scriptSeconds * 1000 / EXPORT_SCRIPT_FRAME_MS);
+    }
+
+    level_t *level = (level_t *)SDL_malloc(sizeof(level_t));
+    export_pipeline_t *pipeline = (export_pipeline_t *)SDL_calloc(1, sizeof(export_pipeline_t));
+
+    if (!level || !pipeline)
+    {
+        return 1;
+    }
+
+    InitWorldKernels();
+    pipeline->format = format;
+    pipeline->outPath = outPath;
+
+    if (format == EXPORT_FORMAT_RAW)
+    {
+        pipeline->rawOutput = SDL_IOFromFile(outPath, "wb");
+    }
+    else if (!SDL_CreateDirectory(outPath))
+    {
+        pipeline->failed = true;
+    }
+
+    if ((format == EXPORT_FORMAT_RAW && !pipeline->rawOutput) || pipeline->failed ||
+        !InitExportPipeline(pipeline, size, threadCount + 2) || !StartReplayLevel(&replay, level))
+    {
+        SDL_Log("Couldn't start export: %s", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Thread *threads[EXPORT_MAX_THREADS];
+
+    for (uint32 i = 0; i < threadCount; ++i)
+    {
+        threads[i] = SDL_CreateThread(RunExportWorker, "export", pipeline);
+
+        if (!threads[i])
+        {
+            SDL_Log("Couldn't start export worker: %s", SDL_GetError());
+            return 1;
+        }
+    }
+
+    uint64 start = SDL_GetTicksNS();
+    uint64 renderNs = 0;
+    uint64 waitNs = 0;
+    uint64 gameMs = 0;
+    uint32 simulated = 0;
+    uint32 exported = 0;
+    uint32 tailFrames = 0;
+
+    for (uint32 i = 0; i < replay.frameCount && tailFrames < EXPORT_SCRIPT_TAIL_FRAMES; ++i, ++simulated)
+    {
+        const replay_frame_t *frame = &replay.frames[i];
+        ApplyReplayCommands(level, frame->commands);
+        StepReplayFrame(level, frame, nullptr);
+        gameMs += frame->dtMs;
+        tailFrames += (!replayPath && level->gameOver) ? 1 : 0;
+
+        if (i % every)
+        {
+            continue;
+        }
+
+        uint64 waitStart = SDL_GetTicksNS();
+        SDL_LockMutex(pipeline->mutex);
+
+        while (!pipeline->freeSlots.count)
+        {
+            SDL_WaitCondition(pipeline->changed, pipeline->mutex);
+        }
+
+        uint32 slotIndex = PopExportQueue(&pipeline->freeSlots);
+        SDL_UnlockMutex(pipeline->mutex);
+
+        uint64 renderStart = SDL_GetTicksNS();
+        waitNs += renderStart - waitStart;
+
+        export_slot_t *slot = &pipeline->slots[slotIndex];
+        slot->frameIndex = exported++;
+        RenderBackground(slot->renderer, &slot->assets);
+        RenderLevel(slot->renderer, &slot->assets, level, size);
+        SDL_FlushRenderer(slot->renderer);
+        renderNs += SDL_GetTicksNS() - renderStart;
+
+        SDL_LockMutex(pipeline->mutex);
+        PushExportQueue(&pipeline->readySlots, slotIndex);
+        SDL_BroadcastCondition(pipeline->changed);
+        SDL_UnlockMutex(pipeline->mutex);
+    }
+
+    SDL_LockMutex(pipeline->mutex);
+    pipeline->finished = true;
+    SDL_BroadcastCondition(pipeline->changed);
+    SDL_UnlockMutex(pipeline->mutex);
+
+    for (uint32 i = 0; i < threadCount; ++i)
+    {
+        SDL_WaitThread(threads[i], nullptr);
+    }
+
+    real64 seconds = (real64)(SDL_GetTicksNS() - start) / 1e9;
+    bool failed = pipeline->failed || (pipeline->rawOutput && !SDL_CloseIO(pipeline->rawOutput));
+
+    SDL_Log("Exported %u frames of %dx%d to %s in %.2f s: %.1f frames/s, %.1fx real time", exported, size.w, size.h,
+            outPath, seconds, exported / seconds, (real64)gameMs / 1000.0 / seconds);
+    SDL_Log("render %.2f ms/frame on the main thread, %.2f ms/frame waiting for a free slot, encode %.2f ms/frame on %u workers",
+            renderNs / 1e6 / SDL_max(exported, 1u), waitNs / 1e6 / SDL_max(exported, 1u),
+            pipeline->encodeNs / 1e6 / SDL_max(exported, 1u), threadCount);
+
+    if (format == EXPORT_FORMAT_RAW)
+    {
+        SDL_Log("Encode with: ffmpeg -f rawvideo -pixel_format bgr0 -video_size %dx%d -framerate %.2f -i %s clip.mp4",
+                size.w, size.h, 1000.0 * SDL_max(simulated, 1u) / (SDL_max(gameMs, 1ull) * every), outPath);
+    }
+
+    FreeExportPipeline(pipeline);
+    FreeReplay(&replay);
+    SDL_free(pipeline);
+    SDL_free(level);
+    SDL_Quit();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <SDL3_mixer/SDL_mixer.h>
+
+#include "../tetris_typedefs.h"
+#include "../tetris_math.h"
+#include "../tetris_random.cpp"
+#include "../tetris_piece_set.cpp"
+#include "../tetris_feed.cpp"
+
+#define FEED_READER_INTERVAL_MS 100
+
+/**
+ * @brief Prints the latest frame of a running game as text: board, active piece (@), preview and timing.
+ */
+static void PrintFeedFrame(const feed_frame_t *frame, uint32 retries, real64 ageMs, real64 framesPerSecond)
+{
+    char line[WORLD_MAX_WIDTH + 1];
+
+    SDL_Log("frame %llu (%.0f fps), %.2f ms old, %u retries, score %u, step %llu/%llu ms%s%s",
+            (unsigned long long)frame->frameIndex, framesPerSecond, ageMs, retries, frame->score,
+            (unsigned long long)frame->stepAccumulator, (unsigned long long)frame->currentStepMs,
+            frame->paused ? ", paused" : "", frame->gameOver ? ", game over" : "");
+
+    for (int32 y = 0; y < frame->worldHeight; ++y)
+    {
+        for (int32 x = 0; x < frame->worldWidth; ++x)
+        {
+            int32 pieceX = x - frame->playerX;
+            int32 pieceY = y - frame->playerY;
+            bool isPiece = pieceX >= 0 && pieceX < frame->playerDimX && pieceY >= 0 && pieceY < frame->playerDimY &&
+                           frame->playerGrid[pieceY * frame->playerDimX + pieceX];
+            uint8 value = frame->worldCells[y * frame->worldWidth + x];
+            line[x] = isPiece ? '@' : value ? (char)('0' + value) : '.';
+        }
+
+        line[frame->worldWidth] = '\0';
+        SDL_Log("|%s|", line);
+    }
+
+    char preview[PIECE_PREVIEW_COUNT * 2 + 1];
+
+    for (uint32 i = 0; i < PIECE_PREVIEW_COUNT; ++i)
+    {
+        preview[i * 2] = (char)('0' + frame->previewKinds[i]);
+        preview[i * 2 + 1] = ' ';
+    }
+
+    preview[PIECE_PREVIEW_COUNT * 2] = '\0';
+    SDL_Log("next kinds: %s", preview);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = FEED_DEFAULT_NAME;
+    bool once = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (SDL_strcmp(argv[i], "--once") == 0)
+        {
+            once = true;
+        }
+        else
+        {
+            name = argv[i];
+        }
+    }
+
+    const feed_header_t *header = MapFeed(name);
+
+    if (!header)
+    {
+        SDL_Log("Couldn't map feed: %s", SDL_GetError());
+        return 1;
+    }
+
+    feed_frame_t frame;
+    uint64 lastFrameIndex = 0;
+    uint64 lastTicks = SDL_GetTicksNS();
+
+    do
+    {
+        uint32 retries;
+
+        if (ReadLatestFeedFrame(header, &frame, &retries))
+        {
+            SDL_Time now;
+            SDL_GetCurrentTime(&now);
+            uint64 ticks = SDL_GetTicksNS();
+            real64 framesPerSecond = (real64)(frame.frameIndex - lastFrameIndex) * 1e9 / (real64)SDL_max(ticks - lastTicks, 1ull);
+            lastFrameIndex = frame.frameIndex;
+            lastTicks = ticks;
+
+            PrintFeedFrame(&frame, retries, (real64)(now - (SDL_Time)frame.timestampNs) / 1e6, framesPerSecond);
+        }
+        else
+        {
+            SDL_Log("Waiting for the first frame");
+        }
+
+        if (!once)
+        {
+            SDL_Delay(FEED_READER_INTERVAL_MS);
+        }
+    } while (!once);
+
+    UnmapFeed(header);
+    return 0;
+}
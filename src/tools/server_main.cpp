@@ -0,0 +1,258 @@
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <SDL3_mixer/SDL_mixer.h>
+
+#include "../tetris_typedefs.h"
+#include "../tetris_math.h"
+#include "../tetris_arena.cpp"
+#include "../tetris_world_kernels.cpp"
+#include "../tetris_world.cpp"
+#include "../tetris_random.cpp"
+#include "../tetris_piece_set.cpp"
+#include "../tetris_player.cpp"
+#include "../tetris_hash.cpp"
+#include "../tetris_input.cpp"
+#include "../tetris_assets.cpp"
+#include "../tetris_level.cpp"
+#include "../tetris_server.cpp"
+#include "../tetris_loadgen.cpp"
+
+#if defined(SDL_PLATFORM_LINUX)
+#include <sys/resource.h>
+#endif
+
+/**
+ * @brief How often a running server logs its stats.
+ */
+#define SERVER_LOG_INTERVAL_MS 10000
+
+static void LogServerUsage()
+{
+    SDL_Log("usage: tetris_server serve [--port <port>] [--unix <path>] [--shards <n>] [--sessions <per shard>] "
+            "[--seconds <n>]");
+    SDL_Log("       tetris_server load [--host <host>] [--port <port>] [--unix <path>] [--sessions <n>] "
+            "[--seconds <n>] [--threads <n>] [--presses <per second>] [--seed <n>] [--self [--shards <n>]]");
+}
+
+/**
+ * @brief Every session is a socket, thousands of them need more than the usual 1024 descriptors.
+ */
+static void RaiseServerFileLimit()
+{
+#if defined(SDL_PLATFORM_LINUX)
+    rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+}
+
+static void *StartServerWithMemory(server_t *server, const server_config_t *config)
+{
+    void *memory = SDL_calloc(1, GetServerMemorySize(config));
+
+    if (!memory || !StartServer(server, config, memory))
+    {
+        SDL_Log("Couldn't start the server: %s", SDL_GetError());
+        SDL_free(memory);
+        return nullptr;
+    }
+
+    SDL_Log("Serving %u sessions per shard on %u shards, port %u%s%s, %.1f MB", config->sessionsPerShard,
+            config->shardCount, config->port, config->unixPath[0] ? " and " : "", config->unixPath,
+            GetServerMemorySize(config) / 1e6);
+    return memory;
+}
+
+/**
+ * @brief Serves until Ctrl-C, or for seconds if not 0.
+ */
+static int RunServe(const server_config_t *config, uint32 seconds)
+{
+    server_t server;
+    void *memory = StartServerWithMemory(&server, config);
+
+    if (!memory)
+    {
+        return 1;
+    }
+
+    uint64 end = seconds ? SDL_GetTicks() + seconds * 1000ull : 0;
+    uint64 nextLog = SDL_GetTicks() + SERVER_LOG_INTERVAL_MS;
+    bool running = true;
+
+    while (running && (!end || SDL_GetTicks() < end))
+    {
+        SDL_Event event;
+
+        /* SDL turns SIGINT and SIGTERM into a quit event. */
+        while (SDL_WaitEventTimeout(&event, 100))
+        {
+            running = running && event.type != SDL_EVENT_QUIT;
+        }
+
+        if (SDL_GetTicks() >= nextLog)
+        {
+            LogServerStats(&server);
+            nextLog += SERVER_LOG_INTERVAL_MS;
+        }
+    }
+
+    StopServer(&server);
+    LogServerStats(&server);
+    SDL_free(memory);
+    return 0;
+}
+
+static int RunLoad(const loadgen_config_t *config, bool self, server_config_t *serverConfig)
+{
+    server_t server;
+    void *memory = nullptr;
+
+    if (self)
+    {
+        serverConfig->port = config->port;
+        SDL_strlcpy(serverConfig->unixPath, config->unixPath, sizeof(serverConfig->unixPath));
+        /* Connections don't spread perfectly evenly, leave each shard room for twice its share. */
+        uint32 share = (config->sessions + serverConfig->shardCount - 1) / serverConfig->shardCount;
+        serverConfig->sessionsPerShard = SDL_max(SDL_min(2 * share, config->sessions), 1u);
+        memory = StartServerWithMemory(&server, serverConfig);
+
+        if (!memory)
+        {
+            return 1;
+        }
+    }
+
+    bool success = RunLoadGen(config);
+
+    if (!success)
+    {
+        SDL_Log("Load run failed: %s", SDL_GetError());
+    }
+
+    if (memory)
+    {
+        StopServer(&server);
+        SDL_free(memory);
+    }
+
+    return success ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        LogServerUsage();
+        return 1;
+    }
+
+    if (!SDL_Init(SDL_INIT_EVENTS))
+    {
+        SDL_Log("Couldn't init sdl: %s", SDL_GetError());
+        return 1;
+    }
+
+    InitWorldKernels();
+    RaiseServerFileLimit();
+
+    bool serve = SDL_strcmp(argv[1], "serve") == 0;
+    bool load = SDL_strcmp(argv[1], "load") == 0;
+    bool usage = !serve && !load;
+    bool self = false;
+    uint32 seconds = serve ? 0 : LOADGEN_DEFAULT_SECONDS;
+    uint32 sessions = serve ? SERVER_DEFAULT_SESSIONS_PER_SHARD : LOADGEN_DEFAULT_SESSIONS;
+
+    server_config_t serverConfig{};
+    serverConfig.shardCount = (uint32)SDL_GetNumLogicalCPUCores();
+    serverConfig.port = SERVER_DEFAULT_PORT;
+
+    loadgen_config_t loadConfig{};
+    SDL_strlcpy(loadConfig.host, "127.0.0.1", sizeof(loadConfig.host));
+    loadConfig.port = SERVER_DEFAULT_PORT;
+    loadConfig.threadCount = (uint32)SDL_GetNumLogicalCPUCores();
+    loadConfig.pressesPerSecond = LOADGEN_DEFAULT_PRESSES_PER_SECOND;
+    loadConfig.seed = 1;
+    const char *unixPath = "";
+
+    for (int i = 2; i < argc && !usage; ++i)
+    {
+        if (SDL_strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+        {
+            serverConfig.port = (uint16)SDL_atoi(argv[++i]);
+            loadConfig.port = serverConfig.port;
+        }
+        else if (SDL_strcmp(argv[i], "--unix") == 0 && i + 1 < argc)
+        {
+            unixPath = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--shards") == 0 && i + 1 < argc)
+        {
+            serverConfig.shardCount = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--sessions") == 0 && i + 1 < argc)
+        {
+            sessions = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            seconds = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (load && SDL_strcmp(argv[i], "--host") == 0 && i + 1 < argc)
+        {
+            SDL_strlcpy(loadConfig.host, argv[++i], sizeof(loadConfig.host));
+        }
+        else if (load && SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            loadConfig.threadCount = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (load && SDL_strcmp(argv[i], "--presses") == 0 && i + 1 < argc)
+        {
+            loadConfig.pressesPerSecond = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (load && SDL_strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            loadConfig.seed = SDL_strtoull(argv[++i], nullptr, 10);
+        }
+        else if (load && SDL_strcmp(argv[i], "--self") == 0)
+        {
+            self = true;
+        }
+        else
+        {
+            usage = true;
+        }
+    }
+
+    if (SDL_strlen(unixPath) >= SERVER_UNIX_PATH_SIZE || !serverConfig.shardCount || !sessions)
+    {
+        usage = true;
+    }
+
+    int result = 1;
+
+    if (usage)
+    {
+        LogServerUsage();
+    }
+    else if (serve)
+    {
+        serverConfig.sessionsPerShard = sessions;
+        SDL_strlcpy(serverConfig.unixPath, unixPath, sizeof(serverConfig.unixPath));
+        result = RunServe(&serverConfig, seconds);
+    }
+    else
+    {
+        loadConfig.sessions = sessions;
+        loadConfig.seconds = seconds;
+        SDL_strlcpy(loadConfig.unixPath, unixPath, sizeof(loadConfig.unixPath));
+        result = RunLoad(&loadConfig, self, &serverConfig);
+    }
+
+    SDL_Quit();
+    return result;
+}
@@ -0,0 +1,510 @@
+#include <stddef.h>
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <SDL3_mixer/SDL_mixer.h>
+
+#include "../tetris_typedefs.h"
+#include "../tetris_math.h"
+#include "../tetris_arena.cpp"
+#include "../tetris_world_kernels.cpp"
+#include "../tetris_world.cpp"
+#include "../tetris_random.cpp"
+#include "../tetris_piece_set.cpp"
+#include "../tetris_player.cpp"
+#include "../tetris_hash.cpp"
+#include "../tetris_input.cpp"
+#include "../tetris_assets.cpp"
+#include "../tetris_level.cpp"
+#include "../tetris_bot.cpp"
+#include "../tetris_jobs.cpp"
+
+#define TUNE_CHECKPOINT_MAGIC SDL_FOURCC('T', 'T', 'T', 'N')
+#define TUNE_CHECKPOINT_VERSION 1
+#define TUNE_DEFAULT_CHECKPOINT "tune.ttck"
+#define TUNE_MAX_POPULATION 1024
+/**
+ * @brief Games per job: enough to amortise the job, few enough that stealing balances a generation.
+ */
+#define TUNE_GAMES_PER_JOB 8
+#define TUNE_INITIAL_SIGMA 8.0f
+/**
+ * @brief Extra variance added each generation, max(5 - generation / 10, 0), keeps the
+ * distribution from collapsing onto an early elite.
+ */
+#define TUNE_NOISE_START 5.0f
+#define TUNE_NOISE_DECAY 0.1f
+
+/**
+ * @brief Cross-entropy tuner state, written after every generation.
+ * @note Little-endian, naturally aligned, no implicit padding. A run only resumes with the
+ * settings it was started with, so scores stay comparable across restarts.
+ */
+struct tune_checkpoint_t
+{
+    uint32 magic;
+    uint32 version;
+    /**
+     * @brief CRC32 of everything after this field.
+     */
+    uint32 checksum;
+    uint32 featureCount;
+
+    uint32 population;
+    uint32 elite;
+    uint32 games;
+    uint32 pieces;
+    uint64 seed;
+    uint32 randomizerMode;
+    uint32 generation;
+    uint64 randomState;
+
+    uint64 totalGames;
+    uint64 totalNs;
+
+    real32 mean[BOT_FEATURE_COUNT];
+    real32 sigma[BOT_FEATURE_COUNT];
+    real32 best[BOT_FEATURE_COUNT];
+    real32 bestScore;
+    uint32 reserved;
+};
+
+static_assert(offsetof(tune_checkpoint_t, featureCount) == 12, "tune_checkpoint_t layout is part of the file format");
+static_assert(sizeof(tune_checkpoint_t) % 8 == 0, "tune_checkpoint_t must not have tail padding");
+
+struct tune_candidate_t
+{
+    bot_weights_t weights;
+    real32 score;
+    uint32 toppedOut;
+};
+
+/**
+ * @brief One generation's games, results land in per-job slots so they don't depend on scheduling.
+ */
+struct tune_batch_t
+{
+    const tune_checkpoint_t *state;
+    tune_candidate_t *candidates;
+    uint32 jobsPerCandidate;
+    uint32 *jobRows;
+    uint32 *jobToppedOut;
+    /**
+     * @brief One game per job thread.
+     */
+    level_t *levels;
+};
+
+/**
+ * @brief Job: plays TUNE_GAMES_PER_JOB fixed-seed games with one candidate's weights.
+ */
+static void PlayTuneGames(void *data, uint32 index, uint32 thread)
+{
+    tune_batch_t *batch = (tune_batch_t *)data;
+    const tune_checkpoint_t *state = batch->state;
+    const bot_weights_t *weights = &batch->candidates[index / batch->jobsPerCandidate].weights;
+    level_t *level = &batch->levels[thread];
+    uint32 firstGame = (index % batch->jobsPerCandidate) * TUNE_GAMES_PER_JOB;
+    uint32 rows = 0;
+    uint32 toppedOut = 0;
+
+    for (uint32 game = firstGame; game < SDL_min(firstGame + TUNE_GAMES_PER_JOB, state->games); ++game)
+    {
+        ResetLevel(level);
+        InitWorld(&level->world);
+        InitPlayer(&level->player);
+        /* Game i uses the same pieces for every candidate of every generation. */
+        InitPieceQueue(&level->pieceQueue, state->seed + game, (ePieceRandomizerMode)state->randomizerMode);
+        SpawnLevelPlayer(level);
+
+        for (uint32 piece = 0; piece < state->pieces && !level->gameOver; ++piece)
+        {
+            bot_move_t move = PickBotMove(level, weights);
+            level_events_t events;
+            events.flags = 0;
+
+            if (!DropBotPiece(level, move.rotations, move.x, &events) && !(events.flags & LEVEL_EVENT_PIECE_LOCKED))
+            {
+                LockLevelPlayer(level, &events);
+            }
+
+            rows += CountSetBits32(events.clearedRowsMask);
+        }
+
+        toppedOut += level->gameOver ? 1 : 0;
+    }
+
+    batch->jobRows[index] = rows;
+    batch->jobToppedOut[index] = toppedOut;
+}
+
+static uint32 GetTuneChecksum(const tune_checkpoint_t *state)
+{
+    size_t offset = offsetof(tune_checkpoint_t, featureCount);
+    return SDL_crc32(0, (const uint8 *)state + offset, sizeof(tune_checkpoint_t) - offset);
+}
+
+/**
+ * @brief Converts every field between native and little-endian order, its own inverse.
+ */
+static void SwapTuneCheckpoint(tune_checkpoint_t *state)
+{
+    uint32 *words[] = {&state->magic, &state->version, &state->checksum, &state->featureCount, &state->population,
+                       &state->elite, &state->games, &state->pieces, &state->randomizerMode, &state->generation};
+    uint64 *longs[] = {&state->seed, &state->randomState, &state->totalGames, &state->totalNs};
+
+    for (uint32 *word : words)
+    {
+        *word = SDL_Swap32LE(*word);
+    }
+
+    for (uint64 *value : longs)
+    {
+        *value = SDL_Swap64LE(*value);
+    }
+
+    for (int i = 0; i < BOT_FEATURE_COUNT; ++i)
+    {
+        state->mean[i] = SDL_SwapFloatLE(state->mean[i]);
+        state->sigma[i] = SDL_SwapFloatLE(state->sigma[i]);
+        state->best[i] = SDL_SwapFloatLE(state->best[i]);
+    }
+
+    state->bestScore = SDL_SwapFloatLE(state->bestScore);
+}
+
+/**
+ * @brief Writes a temporary file and renames it over path, a crash never leaves half a checkpoint.
+ */
+static bool SaveTuneCheckpoint(const tune_checkpoint_t *state, const char *path)
+{
+    tune_checkpoint_t file = *state;
+    file.magic = TUNE_CHECKPOINT_MAGIC;
+    file.version = TUNE_CHECKPOINT_VERSION;
+    file.featureCount = BOT_FEATURE_COUNT;
+    file.reserved = 0;
+    SwapTuneCheckpoint(&file);
+    file.checksum = SDL_Swap32LE(GetTuneChecksum(&file));
+
+    char tempPath[1024];
+    SDL_snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+    if (!SDL_SaveFile(tempPath, &file, sizeof(file)))
+    {
+        return false;
+    }
+
+    return SDL_RenamePath(tempPath, path);
+}
+
+static bool LoadTuneCheckpoint(tune_checkpoint_t *state, const char *path)
+{
+    size_t size;
+    tune_checkpoint_t *file = (tune_checkpoint_t *)SDL_LoadFile(path, &size);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    bool valid = size == sizeof(tune_checkpoint_t) && SDL_Swap32LE(file->magic) == TUNE_CHECKPOINT_MAGIC &&
+                 SDL_Swap32LE(file->version) == TUNE_CHECKPOINT_VERSION &&
+                 SDL_Swap32LE(file->featureCount) == BOT_FEATURE_COUNT &&
+                 SDL_Swap32LE(file->checksum) == GetTuneChecksum(file);
+
+    if (valid)
+    {
+        *state = *file;
+        SwapTuneCheckpoint(state);
+    }
+
+    SDL_free(file);
+    return valid || SDL_SetError("%s is not a valid tuner checkpoint", path);
+}
+
+/**
+ * @brief Standard normal sample, Box-Muller on two PCG outputs.
+ */
+static real32 NextTuneGaussian(random_t *random)
+{
+    real64 u1 = (NextRandom(random) + 1.0) / 4294967296.0;
+    real64 u2 = NextRandom(random) / 4294967296.0;
+    return (real32)(SDL_sqrt(-2.0 * SDL_log(u1)) * SDL_cos(2.0 * SDL_PI_D * u2));
+}
+
+/**
+ * @brief Best score first, ties by weights order so sorting is deterministic.
+ */
+static int CompareTuneCandidates(const void *a, const void *b)
+{
+    const tune_candidate_t *candidateA = (const tune_candidate_t *)a;
+    const tune_candidate_t *candidateB = (const tune_candidate_t *)b;
+
+    if (candidateA->score != candidateB->score)
+    {
+        return candidateA->score > candidateB->score ? -1 : 1;
+    }
+
+    return SDL_memcmp(&candidateA->weights, &candidateB->weights, sizeof(bot_weights_t));
+}
+
+static void LogTuneWeights(const char *prefix, const real32 *weights)
+{
+    char line[256];
+    int length = 0;
+
+    for (int i = 0; i < BOT_FEATURE_COUNT; ++i)
+    {
+        length += SDL_snprintf(line + length, sizeof(line) - length, "%s%s %.2f", i ? ", " : "", kBotFeatureNames[i],
+                               weights[i]);
+    }
+
+    SDL_Log("%s%s", prefix, line);
+}
+
+int main(int argc, char **argv)
+{
+    tune_checkpoint_t settings;
+    SDL_zero(settings);
+    settings.population = 48;
+    settings.elite = 12;
+    settings.games = 1000;
+    settings.pieces = 250;
+    settings.seed = 1;
+    settings.randomizerMode = PIECE_RANDOMIZER_UNIFORM;
+
+    const char *checkpointPath = TUNE_DEFAULT_CHECKPOINT;
+    uint32 generations = 20;
+    uint32 threadCount = (uint32)SDL_GetNumLogicalCPUCores();
+    bool fresh = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (SDL_strcmp(argv[i], "--population") == 0 && i + 1 < argc)
+        {
+            settings.population = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--elite") == 0 && i + 1 < argc)
+        {
+            settings.elite = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+        {
+            settings.games = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--pieces") == 0 && i + 1 < argc)
+        {
+            settings.pieces = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            settings.seed = SDL_strtoull(argv[++i], nullptr, 10);
+        }
+        else if (SDL_strcmp(argv[i], "--bag") == 0)
+        {
+            settings.randomizerMode = PIECE_RANDOMIZER_BAG;
+        }
+        else if (SDL_strcmp(argv[i], "--generations") == 0 && i + 1 < argc)
+        {
+            generations = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threadCount = (uint32)SDL_atoi(argv[++i]);
+        }
+        else if (SDL_strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            checkpointPath = argv[++i];
+        }
+        else if (SDL_strcmp(argv[i], "--fresh") == 0)
+        {
+            fresh = true;
+        }
+        else
+        {
+            SDL_Log("Usage: tetris_tune [--population n] [--elite n] [--games n] [--pieces n] [--seed n] [--bag]"
+                    " [--generations n] [--threads n] [--checkpoint path] [--fresh]");
+            SDL_Log("--generations counts the generations to run now, a resumed run adds them to the checkpoint's");
+            return 1;
+        }
+    }
+
+    if (!settings.population || settings.population > TUNE_MAX_POPULATION || !settings.elite ||
+        settings.elite > settings.population || !settings.games || !settings.pieces)
+    {
+        SDL_Log("Need 0 < elite <= population <= %d and at least one game and piece", TUNE_MAX_POPULATION);
+        return 1;
+    }
+
+    if (!SDL_Init(0))
+    {
+        SDL_Log("Couldn't init sdl: %s", SDL_GetError());
+        return 1;
+    }
+
+    InitWorldKernels();
+
+    tune_checkpoint_t state = settings;
+    random_t random;
+
+    if (!fresh && SDL_GetPathInfo(checkpointPath, nullptr))
+    {
+        if (!LoadTuneCheckpoint(&state, checkpointPath))
+        {
+            SDL_Log("Couldn't resume: %s, pass --fresh to start over", SDL_GetError());
+            return 1;
+        }
+
+        if (state.population != settings.population || state.elite != settings.elite ||
+            state.games != settings.games || state.pieces != settings.pieces || state.seed != settings.seed ||
+            state.randomizerMode != settings.randomizerMode)
+        {
+            SDL_Log("%s was started with other settings (population %u, elite %u, games %u, pieces %u, seed %llu),"
+                    " pass them again or --fresh", checkpointPath, state.population, state.elite, state.games,
+                    state.pieces, (unsigned long long)state.seed);
+            return 1;
+        }
+
+        random.state = state.randomState;
+        SDL_Log("Resuming %s at generation %u, best %.2f rows per game", checkpointPath, state.generation,
+                state.bestScore);
+    }
+    else
+    {
+        /* Start around the hand-tuned weights. */
+        SeedRandom(&random, settings.seed);
+
+        for (int i = 0; i < BOT_FEATURE_COUNT; ++i)
+        {
+            state.mean[i] = kBotDefaultWeights.weights[i];
+            state.sigma[i] = TUNE_INITIAL_SIGMA;
+            state.best[i] = kBotDefaultWeights.weights[i];
+        }
+
+        state.bestScore = -1.0f;
+    }
+
+    tune_batch_t batch;
+    batch.state = &state;
+    batch.jobsPerCandidate = (state.games + TUNE_GAMES_PER_JOB - 1) / TUNE_GAMES_PER_JOB;
+    uint32 jobCount = state.population * batch.jobsPerCandidate;
+    batch.candidates = (tune_candidate_t *)SDL_calloc(state.population, sizeof(tune_candidate_t));
+    batch.jobRows = (uint32 *)SDL_calloc(jobCount, sizeof(uint32));
+    batch.jobToppedOut = (uint32 *)SDL_calloc(jobCount, sizeof(uint32));
+    batch.levels = (level_t *)SDL_calloc(JOB_MAX_THREADS, sizeof(level_t));
+    job_pool_t *jobs = (job_pool_t *)SDL_calloc(1, sizeof(job_pool_t));
+
+    if (!batch.candidates || !batch.jobRows || !batch.jobToppedOut || !batch.levels || !jobs ||
+        !InitJobPool(jobs, threadCount))
+    {
+        SDL_Log("Couldn't start the tuner: %s", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Log("Tuning on %u threads: population %u, elite %u, %u games of up to %u pieces per candidate",
+            jobs->threadCount, state.population, state.elite, state.games, state.pieces);
+    bool success = true;
+
+    for (uint32 run = 0; run < generations; ++run)
+    {
+        for (uint32 i = 0; i < state.population; ++i)
+        {
+            for (int f = 0; f < BOT_FEATURE_COUNT; ++f)
+            {
+                batch.candidates[i].weights.weights[f] = state.mean[f] + state.sigma[f] * NextTuneGaussian(&random);
+            }
+        }
+
+        uint64 start = SDL_GetTicksNS();
+        RunJobs(jobs, PlayTuneGames, &batch, jobCount);
+        uint64 elapsedNs = SDL_GetTicksNS() - start;
+
+        uint32 toppedOut = 0;
+
+        for (uint32 i = 0; i < state.population; ++i)
+        {
+            tune_candidate_t *candidate = &batch.candidates[i];
+            uint64 rows = 0;
+            candidate->toppedOut = 0;
+
+            for (uint32 job = i * batch.jobsPerCandidate; job < (i + 1) * batch.jobsPerCandidate; ++job)
+            {
+                rows += batch.jobRows[job];
+                candidate->toppedOut += batch.jobToppedOut[job];
+            }
+
+            candidate->score = (real32)((real64)rows / state.games);
+            toppedOut += candidate->toppedOut;
+        }
+
+        SDL_qsort(batch.candidates, state.population, sizeof(tune_candidate_t), CompareTuneCandidates);
+
+        /* Refit the distribution to the elite, with decaying extra noise. */
+        real32 noise = SDL_max(TUNE_NOISE_START - TUNE_NOISE_DECAY * state.generation, 0.0f);
+        real32 eliteScore = 0.0f;
+
+        for (int f = 0; f < BOT_FEATURE_COUNT; ++f)
+        {
+            real64 mean = 0.0;
+            real64 variance = 0.0;
+
+            for (uint32 i = 0; i < state.elite; ++i)
+            {
+                mean += batch.candidates[i].weights.weights[f];
+            }
+
+            mean /= state.elite;
+
+            for (uint32 i = 0; i < state.elite; ++i)
+            {
+                real64 delta = batch.candidates[i].weights.weights[f] - mean;
+                variance += delta * delta;
+            }
+
+            state.mean[f] = (real32)mean;
+            state.sigma[f] = (real32)SDL_sqrt(variance / state.elite + noise);
+        }
+
+        for (uint32 i = 0; i < state.elite; ++i)
+        {
+            eliteScore += batch.candidates[i].score / state.elite;
+        }
+
+        if (batch.candidates[0].score > state.bestScore)
+        {
+            state.bestScore = batch.candidates[0].score;
+            SDL_memcpy(state.best, batch.candidates[0].weights.weights, sizeof(state.best));
+        }
+
+        uint64 games = (uint64)state.population * state.games;
+        state.generation++;
+        state.randomState = random.state;
+        state.totalGames += games;
+        state.totalNs += elapsedNs;
+
+        SDL_Log("generation %u: best %.2f, elite %.2f rows per game, %.1f%% topped out, %.0f games/s",
+                state.generation, batch.candidates[0].score, eliteScore, 100.0 * toppedOut / games,
+                games / (elapsedNs / 1e9));
+
+        if (!SaveTuneCheckpoint(&state, checkpointPath))
+        {
+            SDL_Log("Couldn't write checkpoint %s: %s", checkpointPath, SDL_GetError());
+            success = false;
+            break;
+        }
+    }
+
+    LogTuneWeights("mean: ", state.mean);
+    LogTuneWeights("best: ", state.best);
+    SDL_Log("best %.2f rows per game; %llu games in %.1f s over %u generations: %.0f games/s",
+            state.bestScore, (unsigned long long)state.totalGames, state.totalNs / 1e9, state.generation,
+            state.totalNs ? state.totalGames / (state.totalNs / 1e9) : 0.0);
+
+    FreeJobPool(jobs);
+    SDL_free(jobs);
+    SDL_free(batch.levels);
+    SDL_free(batch.jobToppedOut);
+    SDL_free(batch.jobRows);
+    SDL_free(batch.candidates);
+    SDL_Quit();
+    return success ? 0 : 1;
+}